@@ -6,6 +6,8 @@
 #include "windows_hdr.h"
 #elif defined(EROIL_LINUX)
 #include <semaphore.h>
+#include <time.h>
+#include <errno.h>
 #endif
 
 
@@ -81,6 +83,19 @@ struct RecvLabel {
             sem_wait(sem);
         }
     }
+
+    bool timed_wait() {
+        if (sem != nullptr) {
+            timespec ts{};
+            clock_gettime(CLOCK_REALTIME, &ts);
+            ts.tv_sec += 10;
+            while (sem_timedwait(sem, &ts) != 0) {
+                if (errno != EINTR) return false;
+            }
+            return true;
+        }
+        return false;
+    }
 };
 
 inline RecvLabel make_recv_label(int id, int size) {
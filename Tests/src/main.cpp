@@ -38,6 +38,22 @@ int main(int argc, char** argv) {
 
     print::set_id(id);
 
+    // a second argument runs one of the standalone tests instead of the network sim
+    const std::string test = argc >= 3 ? argv[2] : "";
+    if (test == "contention") {
+        return recv_contention_test(id);
+    }
+    if (test == "copy_bench") {
+        copy_benchmark_test();
+        return 0;
+    }
+    if (test == "codec") {
+        return broadcast_codec_test();
+    }
+    if (test == "reconcile") {
+        return label_reconcile_test(argc >= 4 ? std::stoi(argv[3]) : 3888);
+    }
+
     int num_nodes = get_node_count();
     (void)num_nodes;
 
@@ -6,6 +6,8 @@
 #include <thread>
 #include <chrono>
 #include <fstream>
+#include <algorithm>
+#include <random>
 
 #include "safe_print.h"
 #include <eROIL/eroil_cpp.h>
@@ -13,6 +15,9 @@
 #include "labels.h"
 #include "scenario/scenario.h"
 #include "randomizer/randomizer.h"
+#include "memory/copy.h"
+#include "memory/crc32c.h"
+#include "manager/broadcast_codec.h"
 
 inline int timed_test(int id) {
 
@@ -49,6 +54,281 @@ inline int timed_test(int id) {
     return 0;
 }
 
+inline int recv_contention_test(int id) {
+    // dispatcher vs polling app thread on one recv handle
+    // node 0 floods a label, node 1 spins on recv_count()/recv_dismiss() while the
+    // socket/shm dispatcher delivers into the same handle. slow or stalled polls mean
+    // the app is waiting on deliveries (or the other way around)
+    constexpr int LABEL = 0;
+    constexpr uint32_t SLOTS = 8;
+    constexpr auto RUN_TIME = std::chrono::seconds(10);
+
+    bool success = init_manager(id);
+    if (!success) {
+        ERR_PRINT("manager init failed");
+        return 1;
+    }
+
+    if (id == 0) {
+        auto send = std::make_shared<SendLabel>(make_send_label(LABEL, KILOBYTE, 0));
+        auto handle = open_send_label(send->id, send->buf.get(), send->size, 1, nullptr, nullptr, 0);
+        std::this_thread::sleep_for(std::chrono::milliseconds(3000));
+
+        int count = 0;
+        const auto end = std::chrono::steady_clock::now() + RUN_TIME + std::chrono::seconds(2);
+        while (std::chrono::steady_clock::now() < end) {
+            count += 1;
+            std::memcpy(send->buf.get(), &count, sizeof(count));
+            send_label(handle, nullptr, 0, 0, 0);
+            std::this_thread::sleep_for(std::chrono::microseconds(20));
+        }
+        LOG("contention test sent ", count, " labels");
+        close_send_label(handle);
+    }
+
+    if (id == 1) {
+        auto buf = std::make_unique<std::byte[]>(KILOBYTE * SLOTS);
+        auto handle = open_recv_label(LABEL, buf.get(), KILOBYTE, SLOTS, nullptr, nullptr, nullptr, 0, 0);
+
+        // wait for the first delivery so we only time while the dispatcher is busy
+        while (recv_count(handle) == 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+
+        uint64_t polls = 0;
+        uint64_t msgs = 0;
+        uint64_t slow_polls = 0; // took longer than 10us
+        int64_t max_poll_ns = 0;
+        const auto start = std::chrono::steady_clock::now();
+        const auto end = start + RUN_TIME;
+        while (true) {
+            const auto t0 = std::chrono::steady_clock::now();
+            if (t0 >= end) break;
+
+            const uint32_t n = recv_count(handle);
+            if (n > 0) {
+                recv_dismiss(handle, n);
+                msgs += n;
+            }
+
+            const int64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - t0).count();
+            max_poll_ns = std::max(max_poll_ns, ns);
+            if (ns > 10000) slow_polls += 1;
+            polls += 1;
+        }
+
+        const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+        LOG("contention test: polls=", polls, " polls_per_ms=", polls / static_cast<uint64_t>(elapsed),
+            " msgs=", msgs, " slow_polls=", slow_polls, " max_poll_us=", max_poll_ns / 1000);
+        close_recv_label(handle);
+    }
+
+    return 0;
+}
+
+inline void copy_benchmark_test() {
+    // memcpy vs the eROIL payload copy engine per size class, no manager needed
+    // rotate through a working set much larger than the caches so every copy starts cold,
+    // which is what a label written by one process and read by another looks like
+    constexpr size_t WORKING_SET = 64 * 1024 * 1024;
+    constexpr size_t SIZES[] = { 4 * 1024, 64 * 1024, 256 * 1024, 1024 * 1024, 4 * 1024 * 1024 };
+    constexpr size_t BYTES_PER_RUN = 2ull * 1024 * 1024 * 1024;
+
+    auto src = std::make_unique<std::byte[]>(WORKING_SET);
+    auto dst = std::make_unique<std::byte[]>(WORKING_SET);
+    std::memset(src.get(), 0x5a, WORKING_SET);
+    std::memset(dst.get(), 0, WORKING_SET);
+
+    auto run = [&](size_t size, auto&& fn) {
+        const size_t slots = WORKING_SET / size;
+        const size_t iters = BYTES_PER_RUN / size;
+        const auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < iters; ++i) {
+            const size_t off = (i % slots) * size;
+            fn(dst.get() + off, src.get() + off, size);
+        }
+        const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+        return ns <= 0 ? 0.0 : static_cast<double>(iters * size) / static_cast<double>(ns); // bytes per ns == GB/s
+    };
+
+    // checksummed sends fold the crc into the copy, overhead is relative to the copy alone
+    volatile uint32_t sink = 0;
+    LOG("copy benchmark, stream kernel=", eroil::mem::copy_kernel_name(), " threshold=", eroil::mem::STREAM_THRESHOLD,
+        " crc32c=", eroil::mem::crc32c_hw() ? "sse4.2" : "software");
+    for (size_t size : SIZES) {
+        const double plain = run(size, [](void* d, const void* s, size_t n) { std::memcpy(d, s, n); });
+        const double out = run(size, [](void* d, const void* s, size_t n) { eroil::mem::copy_out(d, s, n); });
+        const double crc = run(size, [&](void*, const void* s, size_t n) { sink = eroil::mem::crc32c(s, n); });
+        const double out_crc = run(size, [&](void* d, const void* s, size_t n) { sink = eroil::mem::copy_out_crc32c(d, s, n); });
+        const double in_crc = run(size, [&](void* d, const void* s, size_t n) { sink = eroil::mem::copy_crc32c(d, s, n); });
+        const double out_overhead = out_crc <= 0.0 ? 0.0 : (out / out_crc - 1.0) * 100.0;
+        const double in_overhead = in_crc <= 0.0 ? 0.0 : (plain / in_crc - 1.0) * 100.0;
+        LOG("  size=", size / 1024, "KB memcpy=", plain, "GB/s copy_out=", out, "GB/s crc32c=", crc, "GB/s");
+        LOG("    copy_out+crc32c=", out_crc, "GB/s (", out_overhead, "%) memcpy+crc32c=", in_crc, "GB/s (", in_overhead, "%)");
+    }
+}
+
+inline int broadcast_codec_test() {
+    // discovery bodies arrive from the network, decode must round trip good ones and
+    // refuse anything that would hand diff/apply an unsorted or duplicated label list
+    using namespace eroil;
+    int failures = 0;
+    auto check = [&](bool ok, const char* what) {
+        if (!ok) {
+            ERR_PRINT("broadcast codec test failed", what);
+            ++failures;
+        }
+    };
+    auto same = [](const std::vector<io::LabelInfo>& a, const std::vector<io::LabelInfo>& b, bool ids_only) {
+        if (a.size() != b.size()) return false;
+        for (size_t i = 0; i < a.size(); ++i) {
+            if (a[i].label != b[i].label) return false;
+            if (!ids_only && (a[i].size != b[i].size || a[i].flags != b[i].flags)) return false;
+        }
+        return true;
+    };
+    auto info = [](Label label, uint32_t size, uint32_t flags) {
+        io::LabelInfo li;
+        li.label = label;
+        li.size = size;
+        li.flags = flags;
+        return li;
+    };
+
+    io::BroadcastMessage full;
+    full.send_labels.gen = 7;
+    full.send_labels.labels = { info(0, 64, 0), info(1, 128, 1), info(5000, 4096, 0), info(INT32_MAX, 1, 3) };
+    full.recv_labels.gen = 1ull << 40;
+    full.recv_labels.labels = { info(3, 8, 0) };
+    const std::vector<std::byte> full_body = io::encode_full(full);
+    io::BroadcastMessage full_out;
+    check(io::decode_full(full_body.data(), full_body.size(), full_out), "full decode");
+    check(full_out.send_labels.gen == full.send_labels.gen && full_out.recv_labels.gen == full.recv_labels.gen, "full gens");
+    check(same(full_out.send_labels.labels, full.send_labels.labels, false), "full send labels");
+    check(same(full_out.recv_labels.labels, full.recv_labels.labels, false), "full recv labels");
+    check(!io::decode_full(full_body.data(), full_body.size() - 1, full_out), "truncated full accepted");
+
+    std::vector<std::byte> trailing = full_body;
+    trailing.push_back(std::byte{0});
+    check(!io::decode_full(trailing.data(), trailing.size(), full_out), "trailing bytes accepted");
+
+    io::BroadcastDelta delta;
+    delta.base_gen = 3;
+    delta.gen = 4;
+    delta.added = { info(2, 16, 0), info(9, 32, 2) };
+    delta.removed = { info(4, 0, 0), info(100000, 0, 0) };
+    const std::vector<std::byte> delta_body = io::encode_delta(delta);
+    io::BroadcastDelta delta_out;
+    check(io::decode_delta(delta_body.data(), delta_body.size(), delta_out), "delta decode");
+    check(delta_out.base_gen == 3 && delta_out.gen == 4, "delta gens");
+    check(same(delta_out.added, delta.added, false) && same(delta_out.removed, delta.removed, true), "delta labels");
+
+    io::BroadcastResync resync;
+    resync.target = 12;
+    const std::vector<std::byte> resync_body = io::encode_resync(resync);
+    io::BroadcastResync resync_out;
+    check(io::decode_resync(resync_body.data(), resync_body.size(), resync_out) && resync_out.target == 12, "resync");
+
+    // hand built removed lists: base_gen 0, gen 1, no added, then the ids as raw gaps
+    auto removed_body = [](std::initializer_list<uint64_t> gaps) {
+        std::vector<std::byte> body = { std::byte{0}, std::byte{1}, std::byte{0}, static_cast<std::byte>(gaps.size()) };
+        for (uint64_t gap : gaps) {
+            while (gap >= 0x80) {
+                body.push_back(static_cast<std::byte>((gap & 0x7F) | 0x80));
+                gap >>= 7;
+            }
+            body.push_back(static_cast<std::byte>(gap));
+        }
+        return body;
+    };
+    const std::vector<std::byte> first_zero = removed_body({ 0, 1 });
+    check(io::decode_delta(first_zero.data(), first_zero.size(), delta_out), "label 0 first refused");
+    const std::vector<std::byte> dup = removed_body({ 5, 0 });
+    check(!io::decode_delta(dup.data(), dup.size(), delta_out), "duplicate label accepted");
+    const std::vector<std::byte> past_max = removed_body({ INT32_MAX, 1 });
+    check(!io::decode_delta(past_max.data(), past_max.size(), delta_out), "label past max accepted");
+    const std::vector<std::byte> wraps = removed_body({ 5, UINT32_MAX });
+    check(!io::decode_delta(wraps.data(), wraps.size(), delta_out), "wrapping gap accepted");
+    const std::vector<std::byte> wide = removed_body({ 1ull << 32 });
+    check(!io::decode_delta(wide.data(), wide.size(), delta_out), "gap over 32 bits accepted");
+
+    LOG("broadcast codec test done, failures=", failures);
+    return failures == 0 ? 0 : 1;
+}
+
+inline int label_reconcile_test(const int seed) {
+    // a delta from diff_labels, sent through the codec and applied on top of the old list,
+    // must land on exactly the new list. lists are random subsets of a small label range
+    // so adds, removes and size changes all show up every round
+    using namespace eroil;
+    constexpr int ROUNDS = 2000;
+    constexpr Label RANGE = 512;
+    std::mt19937 rng(static_cast<uint32_t>(seed));
+    auto random_list = [&]() {
+        std::vector<io::LabelInfo> labels;
+        const uint32_t keep = rng() % 100;
+        for (Label label = 0; label < RANGE; ++label) {
+            if (rng() % 100 >= keep) continue;
+            io::LabelInfo info;
+            info.label = label;
+            info.size = 1 + rng() % 4;
+            info.flags = rng() % 2;
+            labels.push_back(info);
+        }
+        return labels;
+    };
+    auto same = [](const std::vector<io::LabelInfo>& a, const std::vector<io::LabelInfo>& b) {
+        if (a.size() != b.size()) return false;
+        for (size_t i = 0; i < a.size(); ++i) {
+            if (a[i].label != b[i].label || a[i].size != b[i].size || a[i].flags != b[i].flags) return false;
+        }
+        return true;
+    };
+
+    int failures = 0;
+    for (int round = 0; round < ROUNDS; ++round) {
+        const std::vector<io::LabelInfo> before = random_list();
+        const std::vector<io::LabelInfo> after = random_list();
+
+        io::BroadcastDelta delta;
+        delta.base_gen = static_cast<uint64_t>(round);
+        delta.gen = static_cast<uint64_t>(round) + 1;
+        io::diff_labels(before, after, delta.added, delta.removed);
+
+        std::vector<io::LabelInfo> direct = before;
+        io::apply_labels(direct, delta.added, delta.removed);
+
+        const std::vector<std::byte> body = io::encode_delta(delta);
+        io::BroadcastDelta decoded;
+        std::vector<io::LabelInfo> sent = before;
+        const bool decode_ok = io::decode_delta(body.data(), body.size(), decoded);
+        if (decode_ok) io::apply_labels(sent, decoded.added, decoded.removed);
+
+        if (!same(direct, after) || !decode_ok || !same(sent, after)) {
+            ERR_PRINT("label reconcile test failed, seed=", seed, " round=", round,
+                      " before=", before.size(), " after=", after.size(), " decode_ok=", decode_ok);
+            ++failures;
+        }
+    }
+
+    // a label both added and removed cannot come from diff_labels, decode refuses it
+    io::BroadcastDelta overlap;
+    io::LabelInfo info;
+    info.label = 42;
+    info.size = 8;
+    overlap.added = { info };
+    overlap.removed = { info };
+    const std::vector<std::byte> body = io::encode_delta(overlap);
+    io::BroadcastDelta decoded;
+    if (io::decode_delta(body.data(), body.size(), decoded)) {
+        ERR_PRINT("label reconcile test failed, delta adding and removing the same label was accepted");
+        ++failures;
+    }
+
+    LOG("label reconcile test done, seed=", seed, " rounds=", ROUNDS, " failures=", failures);
+    return failures == 0 ? 0 : 1;
+}
+
 inline void generate_specific_scenario(const int seed, int num_nodes, const bool detailed) {
     PRINT("generating scenario for seed: ", seed);
     auto scenario = generate_test_scenario(seed, num_nodes);
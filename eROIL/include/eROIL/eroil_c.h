@@ -62,6 +62,7 @@ void NAE_Receive_Idle(void* iHandle);
 void NAE_Receive_Resume(void* iHandle);
 void NAE_Receive_Reset(void* iHandle);
 void NAE_Receive_Redirect(void* iHandle);
+void* NAE_Receive_Buffer(void* iHandle);
 int NAE_Get_Message_Label(void* pIosb);
 int NAE_Get_Message_Status(void* pIosb);
 int NAE_Get_Message_Size(void* pIosb);
@@ -57,6 +57,8 @@ void recv_idle(void* handle);
 void recv_resume(void* handle);
 void recv_reset(void* handle);
 void recv_redirect(void* handle);
+// slots of a label opened with a null buf (shm arena), otherwise the buf it was opened with
+void* recv_buffer(void* handle);
 
 //
 // queries
@@ -1,4 +1,5 @@
 #include "address.h"
+#include <array>
 #include <fstream>
 #include <iostream>
 #include <sstream>
@@ -8,6 +9,8 @@
 
 namespace eroil::addr {
     static std::unordered_map<NodeId, NodeAddress> address_book;
+    static std::array<NodeId, MAX_NODES> gateways{};
+    static bool gateways_used = false;
 
     std::vector<std::vector<std::string>> parse_csv_file(const std::string& path) {
         std::vector<std::vector<std::string>> rows;
@@ -48,8 +51,8 @@ namespace eroil::addr {
         // build addr book
         for (std::vector<std::string> row : csv_rows) {
             const NodeId id = static_cast<NodeId>(std::stoi(row[0]));
-            if (id <= INVALID_NODE) {
-                ERR_PRINT("foudn invalid node, skipping");
+            if (id <= INVALID_NODE || id >= MAX_NODES) {
+                ERR_PRINT("found invalid nodeid=", id, " (ids run 0..", MAX_NODES - 1, "), skipping");
                 continue;
             }
 
@@ -93,6 +96,16 @@ namespace eroil::addr {
             }
         }
 
+        // every node knows every hosts gateway without asking, the lowest id on the ip
+        gateways.fill(INVALID_NODE);
+        for (const auto& [id, addr] : address_book) {
+            NodeId gateway = id;
+            for (const auto& [other_id, other] : address_book) {
+                if (other.ip == addr.ip && other_id < gateway) gateway = other_id;
+            }
+            gateways[static_cast<size_t>(id)] = gateway;
+        }
+
         return true;
     }
 
@@ -110,6 +123,8 @@ namespace eroil::addr {
 
     PeerSet get_peer_set(NodeId my_id) {
         PeerSet sets{};
+        sets.gateway = gateway_of(my_id);
+        const bool is_gateway = sets.gateway == my_id;
         for (const auto& [id, info] : get_address_book()) {
             switch (info.kind) {
                 case addr::RouteKind::Self: // fallthrough, send labels to ourselves via shm
@@ -118,6 +133,8 @@ namespace eroil::addr {
                      break; 
                 }
                 case addr::RouteKind::Socket: {
+                    // hosts are linked gateway to gateway only
+                    if (gateways_used && (!is_gateway || gateway_of(id) != id)) break;
                     sets.remote.push_back(info);
                     if (id < my_id) {
                         sets.remote_connect_to.push_back(info);
@@ -133,6 +150,25 @@ namespace eroil::addr {
         return sets;
     }
 
+    void use_host_gateways(NodeId my_id) {
+        LOG("remote traffic goes through host gateways, ours is nodeid=", gateway_of(my_id));
+        gateways_used = true;
+    }
+
+    bool host_gateways() noexcept {
+        return gateways_used;
+    }
+
+    NodeId gateway_of(NodeId id) noexcept {
+        if (id <= INVALID_NODE || id >= MAX_NODES) return INVALID_NODE;
+        return gateways[static_cast<size_t>(id)];
+    }
+
+    NodeId relay_hop(NodeId my_id, NodeId dst_id) noexcept {
+        const NodeId mine = gateway_of(my_id);
+        return mine == my_id ? gateway_of(dst_id) : mine;
+    }
+
     void all_shm_address_book() {
         LOG("TEST MODE: making shm only address book");
         
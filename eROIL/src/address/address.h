@@ -22,14 +22,22 @@ namespace eroil::addr {
 
     struct PeerSet {
         std::vector<addr::NodeAddress> local;
-        std::vector<addr::NodeAddress> remote;
+        std::vector<addr::NodeAddress> remote;              // with host gateways, only the other gateways and only on ours
         std::vector<addr::NodeAddress> remote_connect_to;
+        NodeId gateway = INVALID_NODE;                      // of our host
     };
 
     bool init_address_book(NodeId my_id);
     const std::unordered_map<NodeId, NodeAddress>& get_address_book();
     NodeAddress get_address(NodeId id);
     PeerSet get_peer_set(NodeId my_id);
+
+    // nodes sharing an ip are a host, its lowest node id is the hosts gateway. with host gateways in
+    // use only gateways connect to other hosts, everyone elses remote traffic goes through their own
+    void use_host_gateways(NodeId my_id);
+    bool host_gateways() noexcept;
+    NodeId gateway_of(NodeId id) noexcept;          // INVALID_NODE when id is not in the address book
+    NodeId relay_hop(NodeId my_id, NodeId dst_id) noexcept;  // next node on the way to a node on another host
     
     // set up test-mode address book
     void all_shm_address_book();
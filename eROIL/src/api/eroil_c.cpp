@@ -190,6 +190,10 @@ void NAE_Receive_Redirect(void* iHandle) {
     eroil::recv_redirect(static_cast<eroil::hndl::RecvHandle*>(iHandle));
 }
 
+void* NAE_Receive_Buffer(void* iHandle) {
+    return static_cast<void*>(eroil::recv_buffer(static_cast<eroil::hndl::RecvHandle*>(iHandle)));
+}
+
 int NAE_Get_Message_Label(void* pIosb) {
     int32_t label = eroil::get_msg_label(
         static_cast<eroil::iosb::Iosb*>(pIosb)
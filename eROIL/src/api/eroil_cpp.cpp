@@ -121,6 +121,10 @@ void recv_redirect(void* handle) {
     eroil::recv_redirect(static_cast<eroil::hndl::RecvHandle*>(handle));
 }
 
+void* recv_buffer(void* handle) {
+    return static_cast<void*>(eroil::recv_buffer(static_cast<eroil::hndl::RecvHandle*>(handle)));
+}
+
 std::int32_t get_msg_label(void* iosb) {
     return eroil::get_msg_label(static_cast<eroil::iosb::Iosb*>(iosb));
 }
@@ -164,4 +168,4 @@ void write_event_log() {
 void write_event_log(const char* directory) {
     std::string dir = std::string(directory);
     eroil::write_event_log(dir);
-}
\ No newline at end of file
+}
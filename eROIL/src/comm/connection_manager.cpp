@@ -1,4 +1,6 @@
 #include "connection_manager.h"
+#include <algorithm>
+#include <cstring>
 #include <thread>
 #include <chrono>
 #include "safe_print.h"
@@ -17,39 +19,129 @@ namespace eroil::comm {
         }
     }
 
-    ConnectionManager::ConnectionManager(NodeId id, rt::Router& router) : 
-        m_id(id),
+    ConnectionManager::ConnectionManager(const cfg::ManagerConfig& cfg, rt::Router& router) : 
+        m_id(cfg.id),
+        m_backend(cfg.socket_backend),
         m_router(router), 
         m_tcp_server{},
+        m_zerocopy(cfg.tcp_zerocopy),
+        m_shm_checksum(cfg.shm_checksum),
+        m_shm_ring_size(cfg.shm_ring_size),
+        m_tcp_stripes(std::clamp<uint32_t>(cfg.tcp_stripes, 1, MAX_TCP_STRIPES)),
+        m_zc{},
+        m_mcast{cfg.mcast_data.enabled ? std::make_shared<wrk::McastData>(router, cfg.id, cfg.mcast_data, cfg.mcast_cfg) : nullptr},
         m_local_sender{},
-        m_remote_sender{},
-        m_shm_recvr{router, id},
-        m_sock_recvrs{} {}
+        m_remote_senders{},
+        m_mcast_sender{},
+        m_uring_sender{nullptr},
+        m_relay{addr::host_gateways() && addr::gateway_of(cfg.id) == cfg.id ?
+                std::make_unique<wrk::HostRelay>(router, cfg.id, [this](std::shared_ptr<io::SendJob> job) { dispatch(job); }) : nullptr},
+        m_shm_recvr{router, cfg.id, cfg.shm_ring_max_size, cfg.shm_stuck_writer_ms, m_relay.get()},
+        m_heartbeat{router, cfg.id, cfg.heartbeat_interval_ms, cfg.heartbeat_miss_limit, [this](NodeId id, const std::shared_ptr<sock::TCPClient>& client) { drop_remote_peer(id, client); }},
+        m_reactor{router, cfg.id, cfg.socket_io_threads, &m_zc, m_mcast.get(), m_relay.get(), &m_heartbeat},
+        m_connector{cfg.id, cfg.tcp_stripes, [this](NodeId id, std::vector<std::shared_ptr<sock::TCPClient>> clients) { return adopt_remote_peer(id, std::move(clients)); }},
+        m_pending_stripes{},
+        m_connect_nonce{static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count())} {
+        // a sender thread per stripe, a large frame going out on one never holds up the others
+        m_router.set_tcp_stripes(m_tcp_stripes);
+        for (uint32_t stripe = 0; stripe < m_tcp_stripes; ++stripe) {
+            m_remote_senders.push_back(std::make_unique<wrk::SendWorker<wrk::TcpSendPlan>>(
+                wrk::TcpSendPlan{ &m_zc, cfg.tcp_zerocopy_threshold }));
+        }
+    }
+
+    ConnectionManager::~ConnectionManager() {
+        // drops peers through the reactor and connector, stop it before either goes away
+        m_heartbeat.stop();
+
+        // the router may hold the data plane past us, its threads must not outlive the router
+        m_mcast_sender.stop();
+        if (m_mcast != nullptr) {
+            m_mcast->stop();
+        }
+    }
 
     bool ConnectionManager::start() {
+        // io_uring is opt in and needs kernel support, otherwise stay on the regular socket path
+        bool use_uring = false;
+        if (m_backend == cfg::SocketBackend::IoUring) {
+            use_uring = sock::Uring::supported();
+            if (!use_uring) {
+                LOG("io_uring socket backend requested but not supported here, falling back to poller");
+            }
+        }
+
+        // zero copy completions are reaped by the poller reactor, the io_uring path always copies
+        if (m_zerocopy && use_uring) {
+            LOG("tcp zero copy is not used with the io_uring socket backend");
+            m_zerocopy = false;
+        }
+
         // start sender thread workers
         m_local_sender.start();
-        m_remote_sender.start();
+        if (use_uring) {
+            m_uring_sender = std::make_unique<wrk::UringSendWorker>();
+            if (!m_uring_sender->start()) {
+                LOG("io_uring send worker failed to start, falling back to blocking socket sends");
+                m_uring_sender.reset();
+            }
+        }
+        if (m_uring_sender == nullptr) {
+            for (auto& sender : m_remote_senders) {
+                sender->start();
+            }
+        } else if (m_tcp_stripes > 1) {
+            LOG("io_uring send worker serves all ", m_tcp_stripes, " tcp stripes from one thread");
+        }
 
-        // open shm recv block
-        if (!m_router.open_recv_shm(m_id)) {
+        // labels enough remote nodes listen for go out once on the multicast data plane
+        if (m_mcast != nullptr) {
+            if (m_mcast->start()) {
+                m_mcast_sender.start();
+                m_router.set_mcast(m_mcast);
+            } else {
+                LOG("multicast data plane failed to start, remote labels stay on their sockets");
+            }
+        }
+
+        // split peers into local and remote
+        addr::PeerSet peers = addr::get_peer_set(m_id);
+
+        // open shm recv block, one lane for every local node that writes to us (ourselves included)
+        const size_t local_writers = std::max<size_t>(peers.local.size(), 1);
+        if (local_writers > SHM_MAX_LANES) {
+            ERR_PRINT("more local peers than shm lanes, only the first ", SHM_MAX_LANES, " to connect can send to us over shm");
+        }
+        const uint32_t lanes = static_cast<uint32_t>(std::min<size_t>(local_writers, SHM_MAX_LANES));
+        if (!m_router.open_recv_shm(m_id, m_shm_ring_size, lanes)) {
             ERR_PRINT(" CRITICAL! unable to open recv shm block, manager ini failure");
             return false;
         }
         LOG("shm recv block created, starting shm recv worker");
         m_shm_recvr.start();
 
+        // time to full mesh is measured from here
+        m_remote_peers = peers.remote;
+        m_mesh_start = std::chrono::steady_clock::now();
+
+        // socket recv io threads, peers are handed to it as connections are made
+        if (!m_reactor.start(use_uring)) {
+            ERR_PRINT(" CRITICAL! unable to start socket reactor, manager ini failure");
+            return false;
+        }
+
         // tcp server listener thread
         std::thread([this]() { run_tcp_server(); }).detach();
 
-        // split peers into local and remote
-        addr::PeerSet peers = addr::get_peer_set(m_id);
-
-        // connect to peers with a id < ours
-        initial_remote_connection(peers.remote_connect_to);
+        // connect to peers with a id < ours, all at once and retried until they are up
+        if (!m_connector.start(peers.remote_connect_to)) {
+            ERR_PRINT(" CRITICAL! unable to start peer connector, manager ini failure");
+            return false;
+        }
 
-        // start monitor thread
-        std::thread([this]() { remote_connection_monitor(); }).detach();
+        // peers are pinged and dropped when they go silent, the monitor thread only reports
+        m_heartbeat.start(peers.remote);
+        std::thread([this]() { stats_monitor(); }).detach();
 
         // open local peers shared memory blocks
         spawn_local_shm_opener(peers.local);
@@ -57,36 +149,6 @@ namespace eroil::comm {
         return true;
     }
 
-    void ConnectionManager::initial_remote_connection(std::vector<addr::NodeAddress> remote_peers) {
-        // attempt to connect to remote peers a few times
-        // if this fails and exit, monitor thread will continue trying
-        const int32_t max_attempts = 5;
-        const int32_t expected = static_cast<int32_t>(remote_peers.size());
-        for (int32_t attempts = 0; attempts < max_attempts; ++attempts) {
-            int32_t connected = 0;
-            for (const addr::NodeAddress& info : remote_peers) {
-                if (m_router.get_socket(info.id) != nullptr) {
-                    connected += 1;
-                    continue;
-                }
-                
-                if (connect_to_remote_peer(info)) {
-                    connected += 1;
-                }
-            }
-
-            // if we found all peers we expected to connect to, we're done
-            if (connected >= expected) {
-                LOG("connected to ", connected, " out of ", expected, " expected remote peers");
-                break;
-            }
-
-            if (attempts + 1 < max_attempts) {
-                std::this_thread::sleep_for(std::chrono::milliseconds(1 * 1000));
-            }
-        }
-    }
-
     void ConnectionManager::spawn_local_shm_opener(std::vector<addr::NodeAddress> local_peers) {
         // this continues trying every 5 seconds until it finds all expected local shared memory blocks
         // incase someone joins the party late
@@ -98,9 +160,10 @@ namespace eroil::comm {
                 for (const addr::NodeAddress& info : local_peers) {
                     if (m_router.get_send_shm(info.id) != nullptr) continue;
 
-                    if (m_router.open_send_shm(info.id)) {
+                    if (m_router.open_send_shm(m_id, info.id, m_shm_checksum)) {
                         LOG("established shm send block to nodeid=", info.id);
                         found += 1;
+                        transport_up(info.id);
                     } else {
                         LOG("shm send block to nodeid=", info.id, " does not yet exist, cannot open");
                     }
@@ -121,45 +184,83 @@ namespace eroil::comm {
             return; 
         }
 
-        if (job->local_recvrs.empty() && job->remote_recvrs.empty()) {
+        // same host mailbox readers are served right here, once for all of them
+        if (job->mailbox != nullptr) {
+            io::LabelHeader hdr;
+            std::memcpy(&hdr, job->send_buffer.data.get(), sizeof(hdr));
+            const std::byte* payload = job->send_buffer.data.get() + sizeof(hdr);
+            if (!job->mailbox->write(m_id, hdr.recv_offset, payload, job->send_buffer.data_size)) {
+                ERR_PRINT("mailbox write failed for label=", label);
+                evtlog::warn(elog_kind::MailboxWriteFailed, elog_cat::Shm, label);
+                ++job->local_failure_count;
+            }
+        }
+
+        // same host arena subscribers get the callers payload written straight into their slots
+        if (!job->arenas.empty()) {
+            io::LabelHeader hdr;
+            std::memcpy(&hdr, job->send_buffer.data.get(), sizeof(hdr));
+            const std::byte* payload = job->send_buffer.src_payload;
+            if (payload == nullptr) payload = job->send_buffer.data.get() + sizeof(hdr);
+
+            for (const std::shared_ptr<shm::ShmArena>& arena : job->arenas) {
+                if (arena == nullptr || !arena->publish(label, m_id, hdr.recv_offset, payload, job->send_buffer.data_size)) {
+                    ERR_PRINT("arena write failed for label=", label);
+                    evtlog::warn(elog_kind::ArenaWriteFailed, elog_cat::Shm, label);
+                    ++job->local_failure_count;
+                }
+            }
+        }
+        job->send_buffer.src_payload = nullptr; // caller's buffer is theirs again once we return
+
+        // the wrapped frame for the host gateways holds on to the job until it is out, not the other way around
+        std::shared_ptr<io::SendJob> relay = std::move(job->relay);
+        if (job->local_recvrs.empty() && job->remote_recvrs.empty() && job->mcast_recvrs.empty() && relay == nullptr) {
             job->finalize_send_iosb();
             return;
         }
 
+        dispatch(job);
+        if (relay != nullptr) {
+            dispatch(relay);
+        }
+    }
+
+    void ConnectionManager::dispatch(const std::shared_ptr<io::SendJob>& job) {
         if (!job->local_recvrs.empty()) {
             m_local_sender.enqueue(job);
         }
 
         if (!job->remote_recvrs.empty()) {
-            m_remote_sender.enqueue(job);
+            if (m_uring_sender != nullptr) {
+                m_uring_sender->enqueue(job);
+            } else {
+                m_remote_senders[job->stripe % m_remote_senders.size()]->enqueue(job);
+            }
         }
-    }
 
-    void ConnectionManager::start_remote_recv_worker(NodeId peer_id) {
-        // if we find a worker that already exists, we cannot stop them unless we know
-        // the socket has also been closed. The assumption is someone already did the clean up 
-        // (closing socket, stopping worker and deleting worker) before calling this function. 
-        // So finding an existing worker for the peer is a error state
-        auto it = m_sock_recvrs.find(peer_id);
-        if (it != m_sock_recvrs.end()) {
-            ERR_PRINT("attempted replace an existing worker, this can cause a deadlock. no worker started to nodeid=", peer_id);
-            return;
+        if (!job->mcast_recvrs.empty()) {
+            m_mcast_sender.enqueue(job);
         }
+    }
 
-        auto [w_it, _] = m_sock_recvrs.emplace(
-            peer_id,
-            std::make_unique<wrk::SocketRecvWorker>(m_router, m_id, peer_id)
-        );
-        w_it->second->start();
+    void ConnectionManager::transport_up(NodeId id) {
+        if (m_on_transport_up) m_on_transport_up(id);
     }
 
-    void ConnectionManager::stop_remote_recv_worker(NodeId from_id) {
-        auto it = m_sock_recvrs.find(from_id);
-        if (it != m_sock_recvrs.end()) {
-            // this call has a thread.join(), if we see a "blocks forever" this may be the cause
-            it->second->stop();
-            m_sock_recvrs.erase(it);
+    void ConnectionManager::check_full_mesh() {
+        if (m_remote_peers.empty() || m_mesh_logged.load(std::memory_order_acquire)) return;
+
+        for (const addr::NodeAddress& info : m_remote_peers) {
+            std::shared_ptr<sock::TCPClient> socket = m_router.get_socket(info.id);
+            if (socket == nullptr || !socket->is_connected()) return;
         }
+
+        // the accept thread and the peer connector can both land the last socket
+        if (m_mesh_logged.exchange(true, std::memory_order_acq_rel)) return;
+        const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - m_mesh_start).count();
+        LOG("full remote mesh of ", m_remote_peers.size(), " peers up after ", elapsed, "ms");
     }
 
     void ConnectionManager::run_tcp_server() {
@@ -209,133 +310,179 @@ namespace eroil::comm {
                 client->disconnect();
                 continue;
             }
+
+            io::ConnectBody body{};
+            if (!accept_stripe(client.get(), hdr, body)) {
+                client->disconnect();
+                continue;
+            }
             
             client->set_destination_id(hdr.source_id);
-            m_router.upsert_socket(
-                hdr.source_id,
-                std::move(client)
-            );
-            start_remote_recv_worker(hdr.source_id);
-            LOG("established tcp connection to node: ", hdr.source_id);
-            evtlog::info(elog_kind::NewConnection, elog_cat::TCPServer, hdr.source_id);
-        }
-    }
-
-    void ConnectionManager::remote_connection_monitor() {
-        LOG("remote peers to monitor thread starts");
-        addr::PeerSet peers = addr::get_peer_set(m_id);
-        if (peers.remote.empty()) {
-            LOG("no remote peers to monitor, remote peer monitor thread exits");
-            return;
-        }
+            try_enable_zerocopy(client.get());
 
-        while (true) {
-            EvtMark mark(elog_cat::SocketMonitor);
-            for (const addr::NodeAddress& info : peers.remote) {
-                std::shared_ptr<sock::TCPClient> socket = m_router.get_socket(info.id);
-                if (socket == nullptr) {
-                    // if connection does not exist, connect
-                    evtlog::info(elog_kind::Connect, elog_cat::SocketMonitor);
-                    connect_to_remote_peer(info);
-                } else {
-                    // otherwise check socket connected
-                    evtlog::info(elog_kind::Ping, elog_cat::SocketMonitor);
-                    ping_remote_peer(info, socket);
+            // a stripe of a newer attempt means the older one was given up, its stripes go
+            PendingStripes& pending = m_pending_stripes[hdr.source_id];
+            if (pending.nonce != body.nonce || pending.socks.size() != body.stripes) {
+                for (const auto& stale : pending.socks) {
+                    if (stale != nullptr) stale->disconnect();
                 }
+                pending.nonce = body.nonce;
+                pending.socks.assign(body.stripes, nullptr);
             }
-            
-            // sleep for 5 seconds
-            std::this_thread::sleep_for(std::chrono::milliseconds(5 * 1000));
+            if (pending.socks[body.stripe] != nullptr) {
+                pending.socks[body.stripe]->disconnect();
+            }
+            pending.socks[body.stripe] = std::move(client);
+
+            const bool whole = std::all_of(pending.socks.begin(), pending.socks.end(), [](const auto& sock) { return sock != nullptr; });
+            if (!whole) continue;
+
+            std::vector<std::shared_ptr<sock::TCPClient>> clients = std::move(pending.socks);
+            m_pending_stripes.erase(hdr.source_id);
+            register_remote_peer(hdr.source_id, std::move(clients));
+            evtlog::info(elog_kind::NewConnection, elog_cat::TCPServer, hdr.source_id);
         }
     }
 
-    bool ConnectionManager::connect_to_remote_peer(addr::NodeAddress peer_info) {
-        // do not attempt connection to ID's greater than ours, they'll connect to us
-        if (peer_info.id >= m_id) return false;
+    bool ConnectionManager::accept_stripe(sock::TCPClient* client, const io::LabelHeader& hdr, io::ConnectBody& body) {
+        if (hdr.label_size != sizeof(body)) {
+            ERR_PRINT("tcp server recvd connect without a stripe from nodeid=", hdr.source_id);
+            evtlog::warn(elog_kind::InvalidHeader, elog_cat::TCPServer, hdr.source_id);
+            return false;
+        }
 
-        // attempt connection
-        LOG("attempt connection to nodeid=", peer_info.id, " ip=", peer_info.ip, ":", peer_info.port);
-        auto client = std::make_shared<sock::TCPClient>();
-        sock::SockResult result = client->open_and_connect(peer_info.ip.c_str(), peer_info.port);
+        sock::SockResult result = client->recv_all(&body, sizeof(body));
         if (result.code != sock::SockErr::None) {
-            LOG("connection to nodeid=", peer_info.id, " failed");
-            //print_socket_result(result);
-            evtlog::info(elog_kind::ConnectionFailed, elog_cat::SocketMonitor, peer_info.id);
+            ERR_PRINT("tcp server had an error recving the stripe of nodeid=", hdr.source_id);
+            evtlog::warn(elog_kind::ConnectionFailed, elog_cat::TCPServer, hdr.source_id);
+            print_socket_result(result);
             return false;
         }
 
-        // send them a notice of who we are
-        if (!send_id(client.get())) {
-            ERR_PRINT("send ID failed unexpectedly during connection attempt");
-            evtlog::warn(elog_kind::SendFailed, elog_cat::SocketMonitor, peer_info.id);
+        if (body.stripes == 0 || body.stripes > MAX_TCP_STRIPES || body.stripe >= body.stripes) {
+            ERR_PRINT("tcp server recvd invalid stripe=", body.stripe, " of ", body.stripes, " from nodeid=", hdr.source_id);
+            evtlog::warn(elog_kind::InvalidHeader, elog_cat::TCPServer, hdr.source_id);
             return false;
         }
-
-        // set the peer id for this socket, and replace socket 
-        // in registry with this socket
-        // NOTE: when replacing a socket, we assume that someone before us has 
-        // handled closing the socket and killing the socket recv worker for that socket
-        client->set_destination_id(peer_info.id);
-        m_router.upsert_socket(
-            peer_info.id, 
-            std::move(client)
-        );
-        start_remote_recv_worker(peer_info.id);
-
-        LOG("established tcp connection to nodeid=", peer_info.id);
-        evtlog::info(elog_kind::NewConnection, elog_cat::SocketMonitor, peer_info.id);
         return true;
     }
 
-    void ConnectionManager::ping_remote_peer(addr::NodeAddress peer_info, std::shared_ptr<sock::TCPClient> client) {
-        if (client->get_destination_id() != peer_info.id) {
-            ERR_PRINT("got mismatching IDs for socket and info, socket list corrupted");
+    void ConnectionManager::stats_monitor() {
+        LOG("stats monitor thread starts");
+        if (m_remote_peers.empty()) {
+            LOG("no remote peers to report on, stats monitor thread exits");
             return;
         }
 
-        // if connected, everything is fine
-        if (client->is_connected()) {
-            bool connected = send_ping(client.get());
-            if (connected) return;
+        // stats roughly once a minute
+        while (true) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(60 * 1000));
+
+            EvtMark mark(elog_cat::SocketMonitor);
+            m_reactor.log_stats();
+            m_connector.log_stats();
+            m_heartbeat.log_stats();
+            if (m_uring_sender != nullptr) {
+                m_uring_sender->log_stats();
+            }
+            if (m_zerocopy) {
+                m_zc.log_stats();
+            }
+            if (mcast_data()) {
+                m_mcast->log_stats();
+            }
+            if (m_relay != nullptr) {
+                m_relay->log_stats();
+            }
+        }
+    }
+
+    bool ConnectionManager::adopt_remote_peer(NodeId id, std::vector<std::shared_ptr<sock::TCPClient>> clients) {
+        // send them a notice of who we are on every stripe, the nonce ties the stripes into one set
+        io::ConnectBody body{};
+        body.nonce = m_connect_nonce.fetch_add(1, std::memory_order_relaxed);
+        body.stripes = static_cast<uint32_t>(clients.size());
+        for (uint32_t stripe = 0; stripe < body.stripes; ++stripe) {
+            body.stripe = stripe;
+            if (!send_id(clients[stripe].get(), body)) {
+                ERR_PRINT("send ID failed unexpectedly during connection attempt");
+                evtlog::warn(elog_kind::SendFailed, elog_cat::PeerConnector, id);
+                return false;
+            }
+            clients[stripe]->set_destination_id(id);
+            try_enable_zerocopy(clients[stripe].get());
+        }
+
+        register_remote_peer(id, std::move(clients));
+        evtlog::info(elog_kind::NewConnection, elog_cat::PeerConnector, id);
+        return true;
+    }
+
+    void ConnectionManager::register_remote_peer(NodeId id, std::vector<std::shared_ptr<sock::TCPClient>> clients) {
+        // replace the sockets in registry with these
+        // NOTE: when replacing a socket, we assume that someone before us has
+        // handled closing the old socket, the reactor swaps its registration over
+        const uint32_t stripes = static_cast<uint32_t>(clients.size());
+        m_router.upsert_sockets(id, clients);
+        for (uint32_t stripe = 0; stripe < stripes; ++stripe) {
+            m_reactor.add_peer(id, std::move(clients[stripe]), stripe);
         }
 
-        // do socket disconnect logic, this wont do anything if already disconnected
-        client->disconnect();
-        LOG("found dead socket to nodeid=", peer_info.id);
-        evtlog::info(elog_kind::DeadSocketFound, elog_cat::SocketMonitor, peer_info.id);
+        LOG("established tcp connection to nodeid=", id, ", stripes=", stripes);
+        transport_up(id);
+        check_full_mesh();
+    }
+
+    void ConnectionManager::drop_remote_peer(NodeId id, const std::shared_ptr<sock::TCPClient>& client) {
+        // already replaced by a fresh connection, nothing to drop
+        if (m_router.get_socket(id) != client) return;
 
-        // if worker is still listening to dead socket, stop and erase them
-        stop_remote_recv_worker(peer_info.id);
+        // pull the sockets out of the reactor before closing them so their handles
+        // cannot be confused with a new socket that reuses them
+        m_reactor.remove_peer(id);
 
-        // do connection logic
-        connect_to_remote_peer(peer_info);
+        // do socket disconnect logic, this wont do anything if already disconnected.
+        // a send blocked on the dead peer returns with an error
+        for (const auto& stripe : m_router.get_sockets(id)) {
+            stripe->disconnect();
+        }
+        LOG("found dead socket to nodeid=", id);
+        evtlog::info(elog_kind::DeadSocketFound, elog_cat::SocketMonitor, id);
+
+        // ours to dial again, otherwise they reconnect to us
+        if (id < m_id) {
+            m_connector.redial(id);
+        }
     }
 
-    bool ConnectionManager::send_id(sock::TCPClient* sock) {
+    bool ConnectionManager::send_id(sock::TCPClient* sock, const io::ConnectBody& body) {
         // send them a notice of who we are
-        io::LabelHeader hdr{};
-        hdr.magic = MAGIC_NUM;
-        hdr.version = VERSION;
-        hdr.source_id = m_id;
-        hdr.flags = static_cast<uint16_t>(io::LabelFlag::Connect);
-        hdr.label = 0;
-        hdr.label_size = 0;
-
-        sock::SockResult err = sock->send_all(&hdr, sizeof(hdr));
+        struct {
+            io::LabelHeader hdr;
+            io::ConnectBody body;
+        } frame{};
+        static_assert(sizeof(frame) == sizeof(io::LabelHeader) + sizeof(io::ConnectBody));
+
+        frame.hdr.magic = MAGIC_NUM;
+        frame.hdr.version = VERSION;
+        frame.hdr.source_id = m_id;
+        frame.hdr.flags = static_cast<uint16_t>(io::LabelFlag::Connect);
+        frame.hdr.label = 0;
+        frame.hdr.label_size = sizeof(io::ConnectBody);
+        frame.body = body;
+
+        sock::SockResult err = sock->send_all(&frame, sizeof(frame));
         return map_sock_failures(err.code);
     }
 
-    bool ConnectionManager::send_ping(sock::TCPClient* sock) {
-        // send ping header
-        io::LabelHeader hdr{};
-        hdr.magic = MAGIC_NUM;
-        hdr.version = VERSION,
-        hdr.source_id = m_id,
-        hdr.flags = static_cast<uint16_t>(io::LabelFlag::Ping),
-        hdr.label = 0,
-        hdr.label_size = 0;
-
-        sock::SockResult err = sock->send_all(&hdr, sizeof(hdr));
-        return map_sock_failures(err.code);
+    void ConnectionManager::try_enable_zerocopy(sock::TCPClient* sock) {
+        if (!m_zerocopy) return;
+
+        // not fatal, the socket just keeps copying
+        sock::SockResult result = sock->enable_zerocopy();
+        if (!result.ok()) {
+            LOG("could not enable zero copy sends on socket to nodeid=", sock->get_destination_id());
+            print_socket_result(result);
+        }
     }
-}
\ No newline at end of file
+}
@@ -1,13 +1,23 @@
 #pragma once
 #include <unordered_map>
+#include <atomic>
+#include <chrono>
 #include <memory>
 #include <vector>
+#include <functional>
 #include "address/address.h"
+#include "config/config.h"
 #include "router/router.h"
 #include "socket/tcp_socket.h"
 #include "workers/send_worker.h"
-#include "workers/socket_recv_worker.h"
+#include "workers/socket_reactor.h"
+#include "workers/uring_send_worker.h"
+#include "workers/zerocopy_tracker.h"
 #include "workers/shm_recv_worker.h"
+#include "workers/mcast_data.h"
+#include "workers/host_relay.h"
+#include "workers/peer_connector.h"
+#include "workers/heartbeat.h"
 #include "workers/send_plan.h"
 #include "types/const_types.h"
 #include "macros.h"
@@ -16,35 +26,69 @@ namespace eroil::comm {
 
     class ConnectionManager {
         private:
+            // stripes of one dial attempt accepted so far, registered once all of them arrived
+            struct PendingStripes {
+                uint64_t nonce = 0;
+                std::vector<std::shared_ptr<sock::TCPClient>> socks{};
+            };
+
             NodeId m_id;
+            cfg::SocketBackend m_backend;
             rt::Router& m_router;
             sock::TCPServer m_tcp_server;
+            bool m_zerocopy;
+            bool m_shm_checksum;
+            size_t m_shm_ring_size;
+            uint32_t m_tcp_stripes;
+            wrk::ZeroCopyTracker m_zc;
+            std::shared_ptr<wrk::McastData> m_mcast;    // null unless manager.cfg mcast_data=true
 
             wrk::SendWorker<wrk::ShmSendPlan> m_local_sender;
-            wrk::SendWorker<wrk::TcpSendPlan> m_remote_sender;
+            std::vector<std::unique_ptr<wrk::SendWorker<wrk::TcpSendPlan>>> m_remote_senders;   // one per tcp stripe
+            wrk::SendWorker<wrk::McastSendPlan> m_mcast_sender;
+            std::unique_ptr<wrk::UringSendWorker> m_uring_sender; // replaces m_remote_senders on the io_uring backend
+            std::unique_ptr<wrk::HostRelay> m_relay;    // null unless we are a host gateway
             wrk::ShmRecvWorker m_shm_recvr;
-            std::unordered_map<NodeId, std::unique_ptr<wrk::SocketRecvWorker>> m_sock_recvrs;
+            wrk::Heartbeat m_heartbeat;
+            wrk::SocketReactor m_reactor;
+            wrk::PeerConnector m_connector;
+            std::function<void(NodeId)> m_on_transport_up;
+            std::unordered_map<NodeId, PendingStripes> m_pending_stripes;  // only touched by the tcp server thread
+            std::atomic<uint64_t> m_connect_nonce;
+
+            std::vector<addr::NodeAddress> m_remote_peers;
+            std::chrono::steady_clock::time_point m_mesh_start{};
+            std::atomic<bool> m_mesh_logged{false};
 
         public:
-            ConnectionManager(NodeId id, rt::Router& router);
-            ~ConnectionManager() = default;
+            ConnectionManager(const cfg::ManagerConfig& cfg, rt::Router& router);
+            ~ConnectionManager();
 
             EROIL_NO_COPY(ConnectionManager)
             EROIL_NO_MOVE(ConnectionManager)
 
+            // called from the connection threads each time a shm send block or socket to a node comes up,
+            // set before start()
+            void set_transport_up_callback(std::function<void(NodeId)> fn) { m_on_transport_up = std::move(fn); }
+
             bool start();
             void enqueue_send(handle_uid uid, Label label, io::SendBuf send_buf);
-            void start_remote_recv_worker(NodeId from_id);
-            void stop_remote_recv_worker(NodeId from_id);
+
+            // we listen on the multicast data plane, remote publishers may send our labels there
+            bool mcast_data() const noexcept { return m_mcast != nullptr && m_mcast->running(); }
 
         private:
-            void initial_remote_connection(std::vector<addr::NodeAddress> remote_peers);
             void spawn_local_shm_opener(std::vector<addr::NodeAddress> local_peers);
             void run_tcp_server();
-            void remote_connection_monitor();
-            bool connect_to_remote_peer(addr::NodeAddress peer_info);
-            void ping_remote_peer(addr::NodeAddress peer_info, std::shared_ptr<sock::TCPClient> client);
-            bool send_id(sock::TCPClient* sock);
-            bool send_ping(sock::TCPClient* sock);
+            void stats_monitor();
+            bool accept_stripe(sock::TCPClient* client, const io::LabelHeader& hdr, io::ConnectBody& body);
+            bool adopt_remote_peer(NodeId id, std::vector<std::shared_ptr<sock::TCPClient>> clients);
+            void register_remote_peer(NodeId id, std::vector<std::shared_ptr<sock::TCPClient>> clients);
+            void drop_remote_peer(NodeId id, const std::shared_ptr<sock::TCPClient>& client);
+            bool send_id(sock::TCPClient* sock, const io::ConnectBody& body);
+            void try_enable_zerocopy(sock::TCPClient* sock);
+            void transport_up(NodeId id);
+            void check_full_mesh();
+            void dispatch(const std::shared_ptr<io::SendJob>& job);
     };
 }
\ No newline at end of file
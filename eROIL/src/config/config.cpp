@@ -3,6 +3,7 @@
 #include <fstream>
 #include <filesystem>
 #include <unordered_map>
+#include <algorithm>
 #include "safe_print.h"
 
 namespace eroil::cfg {
@@ -68,6 +69,130 @@ namespace eroil::cfg {
             cfg.mcast_cfg.reuse_addr = kv["mcast_reuse_addr"] == "true";
         }
 
+        // get socket io config
+        if (kv.count("socket_io_threads")) {
+            int threads = std::stoi(kv["socket_io_threads"]);
+            cfg.socket_io_threads = static_cast<size_t>(std::clamp(threads, 1, 16));
+        }
+        if (kv.count("socket_backend")) {
+            if (kv["socket_backend"] == "io_uring") {
+                cfg.socket_backend = SocketBackend::IoUring;
+            }
+        }
+        if (kv.count("tcp_zerocopy")) {
+            cfg.tcp_zerocopy = kv["tcp_zerocopy"] == "true";
+        }
+        if (kv.count("tcp_zerocopy_threshold")) {
+            int threshold = std::stoi(kv["tcp_zerocopy_threshold"]);
+            cfg.tcp_zerocopy_threshold = static_cast<size_t>(std::max(threshold, 4096));
+        }
+        if (kv.count("tcp_stripes")) {
+            int stripes = std::stoi(kv["tcp_stripes"]);
+            cfg.tcp_stripes = static_cast<uint32_t>(std::clamp(stripes, 1, static_cast<int>(MAX_TCP_STRIPES)));
+        }
+
+        // get checksum config
+        if (kv.count("shm_checksum")) {
+            cfg.shm_checksum = kv["shm_checksum"] == "true";
+        }
+        if (kv.count("tcp_checksum")) {
+            cfg.tcp_checksum = kv["tcp_checksum"] == "true";
+        }
+
+        // get shm ring size config, "auto" starts small and lets the recv worker grow it
+        constexpr int min_mb = static_cast<int>(SHM_MIN_BLOCK_SIZE / MEGABYTE);
+        constexpr int max_mb = static_cast<int>(SHM_MAX_BLOCK_SIZE / MEGABYTE);
+        bool auto_ring = false;
+        if (kv.count("shm_ring_size_mb")) {
+            if (kv["shm_ring_size_mb"] == "auto") {
+                auto_ring = true;
+                cfg.shm_ring_size = SHM_MIN_BLOCK_SIZE;
+                cfg.shm_ring_max_size = SHM_BLOCK_SIZE;
+            } else {
+                int mb = std::stoi(kv["shm_ring_size_mb"]);
+                cfg.shm_ring_size = static_cast<size_t>(std::clamp(mb, min_mb, max_mb)) * MEGABYTE;
+            }
+        }
+        if (kv.count("shm_ring_max_mb")) {
+            int mb = std::stoi(kv["shm_ring_max_mb"]);
+            if (mb <= 0) {
+                cfg.shm_ring_max_size = auto_ring ? SHM_BLOCK_SIZE : 0;
+            } else {
+                cfg.shm_ring_max_size = static_cast<size_t>(std::clamp(mb, min_mb, max_mb)) * MEGABYTE;
+            }
+        }
+        if (cfg.shm_ring_max_size != 0 && cfg.shm_ring_max_size < cfg.shm_ring_size) {
+            cfg.shm_ring_max_size = cfg.shm_ring_size;
+        }
+        if (kv.count("shm_stuck_writer_ms")) {
+            int ms = std::stoi(kv["shm_stuck_writer_ms"]);
+            cfg.shm_stuck_writer_ms = static_cast<uint32_t>(std::clamp(ms, 1, 10 * 1000));
+        }
+
+        // get latest value mailbox config for OVERWRITE subscribers
+        if (kv.count("shm_mailbox")) {
+            cfg.shm_mailbox = kv["shm_mailbox"] == "true";
+        }
+
+        // get shm arena size config, subscriber slots publishers on this host write directly
+        if (kv.count("shm_arena_mb")) {
+            int mb = std::stoi(kv["shm_arena_mb"]);
+            if (mb > 0) {
+                constexpr int arena_min_mb = static_cast<int>(SHM_MIN_ARENA_SIZE / MEGABYTE);
+                constexpr int arena_max_mb = static_cast<int>(SHM_MAX_ARENA_SIZE / MEGABYTE);
+                cfg.shm_arena_size = static_cast<size_t>(std::clamp(mb, arena_min_mb, arena_max_mb)) * MEGABYTE;
+            }
+        }
+
+        // get label capacity, discovery messages grow with it instead of being capped
+        if (kv.count("max_labels")) {
+            int labels = std::stoi(kv["max_labels"]);
+            cfg.max_labels = static_cast<uint32_t>(std::clamp(labels, 1, static_cast<int>(MAX_LABELS_LIMIT)));
+        }
+
+        // get route manifest config, discovery then only confirms the routes it lists
+        if (kv.count("route_manifest")) {
+            cfg.route_manifest = kv["route_manifest"] == "true";
+        }
+
+        // get multicast data plane config
+        if (kv.count("mcast_data")) {
+            cfg.mcast_data.enabled = kv["mcast_data"] == "true";
+        }
+        if (kv.count("mcast_data_group_ip")) {
+            cfg.mcast_data.group_ip = kv["mcast_data_group_ip"].c_str();
+        }
+        if (kv.count("mcast_data_groups")) {
+            int groups = std::stoi(kv["mcast_data_groups"]);
+            cfg.mcast_data.groups = static_cast<uint32_t>(std::clamp(groups, 1, 256));
+        }
+        if (kv.count("mcast_data_port")) {
+            cfg.mcast_data.port = static_cast<uint16_t>(std::stoi(kv["mcast_data_port"]));
+        }
+        if (kv.count("mcast_data_min_subscribers")) {
+            int subscribers = std::stoi(kv["mcast_data_min_subscribers"]);
+            cfg.mcast_data.min_subscribers = static_cast<uint32_t>(std::clamp(subscribers, 1, static_cast<int>(MAX_NODES)));
+        }
+        if (kv.count("mcast_data_retain")) {
+            int retain = std::stoi(kv["mcast_data_retain"]);
+            cfg.mcast_data.retain = static_cast<uint32_t>(std::clamp(retain, 1, 1024));
+        }
+
+        // get host gateway config
+        if (kv.count("host_gateway")) {
+            cfg.host_gateway = kv["host_gateway"] == "true";
+        }
+
+        // get heartbeat config, a dead peer is noticed after interval * miss limit
+        if (kv.count("heartbeat_interval_ms")) {
+            int ms = std::stoi(kv["heartbeat_interval_ms"]);
+            cfg.heartbeat_interval_ms = static_cast<uint32_t>(std::clamp(ms, 10, 1000));
+        }
+        if (kv.count("heartbeat_miss_limit")) {
+            int misses = std::stoi(kv["heartbeat_miss_limit"]);
+            cfg.heartbeat_miss_limit = static_cast<uint32_t>(std::clamp(misses, 2, 100));
+        }
+
         return cfg;
     }
 }
@@ -10,6 +10,11 @@ namespace eroil::cfg {
         TestMode_Sim_Network       // sets half of nodes found in peer_ips.cfg to socket, other half to shared memory
     };
 
+    enum class SocketBackend {
+        Poll,       // non-blocking sockets driven by epoll (linux) / WSAPoll (windows)
+        IoUring     // linux only, falls back to Poll when the kernel does not support it
+    };
+
     // udp mcast configuration
     struct UdpMcastConfig {
         std::string group_ip = "239.255.0.1"; // admin scope...which may not work
@@ -20,11 +25,40 @@ namespace eroil::cfg {
         bool reuse_addr = true;
     };
 
+    // multicast data plane, a label with enough remote subscribers listening is sent once to a group
+    // instead of once per socket. bind ip, ttl, loopback and reuse follow the discovery socket
+    struct McastDataConfig {
+        bool enabled = false;
+        std::string group_ip = "239.255.1.0";   // first group, labels hash onto groups consecutive addresses
+        uint32_t groups = 16;
+        uint16_t port = 30002;
+        uint32_t min_subscribers = 2;   // labels with fewer multicast subscribers stay on their sockets
+        uint32_t retain = 16;           // frames kept per label to resend on a nack
+    };
+
     // manager configuration
     struct ManagerConfig {
         NodeId id = 0;
         ManagerMode mode = ManagerMode::Normal;
         UdpMcastConfig mcast_cfg{};
+        size_t socket_io_threads = 2; // io threads servicing remote peer sockets
+        SocketBackend socket_backend = SocketBackend::Poll;
+        bool tcp_zerocopy = false;              // MSG_ZEROCOPY for large remote sends (linux, poll backend)
+        size_t tcp_zerocopy_threshold = 65536;  // frames smaller than this are always copied
+        uint32_t tcp_stripes = 1;               // tcp connections per remote peer, bulk labels get their own
+        bool shm_checksum = false;              // crc32c per shm record, a bad record is skipped instead of flushing the block
+        bool tcp_checksum = false;              // crc32c per socket frame, a bad frame is dropped
+        size_t shm_ring_size = SHM_BLOCK_SIZE;  // size of this nodes shm recv block
+        size_t shm_ring_max_size = 0;           // recv worker doubles the ring up to this when it fills, 0 = fixed size
+        uint32_t shm_stuck_writer_ms = 50;      // an arena slot left uncommitted this long is skipped
+        bool shm_mailbox = false;               // OVERWRITE subscribers read a per label shm mailbox instead of the ring
+        size_t shm_arena_size = 0;              // shm block for subscribers opened with a null buf, 0 = disabled
+        uint32_t max_labels = DEFAULT_MAX_LABELS;   // distinct labels this node may open to send, and to recv
+        bool route_manifest = false;            // subscribe the nodes etc/routes.cfg lists without waiting on discovery
+        McastDataConfig mcast_data{};
+        bool host_gateway = false;              // remote traffic goes once per host through its gateway node, Normal mode only
+        uint32_t heartbeat_interval_ms = 50;    // ping every remote peer this often
+        uint32_t heartbeat_miss_limit = 4;      // a peer silent for this many intervals is dropped and redialed
     };
 
     ManagerConfig get_manager_cfg(int id);
@@ -0,0 +1,74 @@
+#include "route_manifest.h"
+#include <fstream>
+#include <sstream>
+#include "safe_print.h"
+
+namespace eroil::cfg {
+    static bool parse_int(const std::string& text, long long& out) {
+        try {
+            size_t used = 0;
+            out = std::stoll(text, &used);
+            return used == text.size();
+        } catch (...) {
+            return false;
+        }
+    }
+
+    // node ids within a column are separated by ';'
+    static bool parse_nodes(const std::string& text, std::vector<NodeId>& out) {
+        std::stringstream ss(text);
+        std::string cell;
+        while (std::getline(ss, cell, ';')) {
+            if (cell.empty()) continue;
+            long long id = 0;
+            if (!parse_int(cell, id) || id <= INVALID_NODE || id >= MAX_NODES) return false;
+            out.push_back(static_cast<NodeId>(id));
+        }
+        return true;
+    }
+
+    std::vector<ManifestRoute> load_route_manifest(const std::string& path) {
+        std::vector<ManifestRoute> routes;
+
+        std::ifstream file(path);
+        if (!file.is_open()) {
+            ERR_PRINT("could not open file ", path);
+            return routes;
+        }
+
+        LOG("reading ", path);
+        std::string line;
+        size_t line_num = 0;
+        while (std::getline(file, line)) {
+            line_num += 1;
+            if (line.empty() || line.rfind("#", 0) == 0) continue;
+
+            std::vector<std::string> columns;
+            std::stringstream ss(line);
+            std::string cell;
+            while (std::getline(ss, cell, ',')) {
+                columns.push_back(cell);
+            }
+            if (columns.size() == 3) columns.emplace_back(); // no subscribers yet
+
+            ManifestRoute route{};
+            long long label = 0;
+            long long size = 0;
+            if (columns.size() != 4 ||
+                !parse_int(columns[0], label) || label <= INVALID_LABEL || label > INT32_MAX ||
+                !parse_int(columns[1], size) || size <= 0 || size > static_cast<long long>(MAX_LABEL_SIZE) ||
+                !parse_nodes(columns[2], route.publishers) ||
+                !parse_nodes(columns[3], route.subscribers)) {
+                ERR_PRINT("route manifest line ", line_num, " is not label,size,publishers,subscribers, skipping");
+                continue;
+            }
+
+            route.label = static_cast<Label>(label);
+            route.size = static_cast<uint32_t>(size);
+            routes.push_back(std::move(route));
+        }
+
+        LOG("route manifest lists ", routes.size(), " labels");
+        return routes;
+    }
+}
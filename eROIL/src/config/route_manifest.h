@@ -0,0 +1,17 @@
+#pragma once
+#include <string>
+#include <vector>
+#include "types/const_types.h"
+
+namespace eroil::cfg {
+    // one row of etc/routes.cfg, the fixed label topology known ahead of time
+    struct ManifestRoute {
+        Label label = INVALID_LABEL;
+        uint32_t size = 0;
+        std::vector<NodeId> publishers{};   // empty means any node may publish it
+        std::vector<NodeId> subscribers{};
+    };
+
+    // rows that did not parse are reported and skipped, a missing file gives no routes
+    std::vector<ManifestRoute> load_route_manifest(const std::string& path);
+}
@@ -39,6 +39,13 @@ namespace eroil::evtlog {
         BlockNotInitialized,
         BlockCorruption,
         LabelTooLarge,
+        ChecksumMismatch,
+        ShmRingGrown,
+        MailboxWriteFailed,
+        ArenaWriteFailed,
+        ArenaTicketSkipped,
+        McastGap,
+        McastResend,
 
         // subsribers / publishers
         AddLocalSendSubscriber,
@@ -46,6 +53,8 @@ namespace eroil::evtlog {
         RemoveLocalSendSubscriber,
         RemoveRemoteSendSubscriber,
         DuplicateLabel,
+        DeltaGap,
+        ManifestMismatch,
 
         // socket
         Connect,
@@ -56,6 +65,7 @@ namespace eroil::evtlog {
         NewConnection,
         Reconnected,
         DeadSocketFound,
+        ConnectTimedOut,
     };
 
     enum class Severity : std::uint8_t { Info, Warning, Error, Critical };
@@ -69,10 +79,13 @@ namespace eroil::evtlog {
         Worker,
         SendWorker,
         ShmRecvWorker,
-        SocketRecvWorker,
+        SocketReactor,
         Broadcast, 
         SocketMonitor, 
-        TCPServer 
+        TCPServer,
+        McastData,
+        PeerConnector,
+        Heartbeat
     };
 
     // 20 bytes payload keeps record at 48 bytes (on typical packing).
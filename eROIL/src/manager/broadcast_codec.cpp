@@ -0,0 +1,231 @@
+#include "broadcast_codec.h"
+#include <cstring>
+#include <limits>
+#include <utility>
+
+namespace eroil::io {
+    namespace {
+        constexpr size_t MAX_VARINT_BYTES = 10;     // 64 bit value, 7 bits per byte
+        constexpr size_t MAX_LABEL_BYTES = 15;      // three 32 bit varints
+
+        void put_varint(std::vector<std::byte>& out, uint64_t value) {
+            while (value >= 0x80) {
+                out.push_back(static_cast<std::byte>((value & 0x7F) | 0x80));
+                value >>= 7;
+            }
+            out.push_back(static_cast<std::byte>(value));
+        }
+
+        // ids go out sorted, each as the distance from the previous
+        void put_labels(std::vector<std::byte>& out, const std::vector<LabelInfo>& labels, const bool ids_only) {
+            put_varint(out, labels.size());
+            uint32_t prev = 0;
+            for (const LabelInfo& info : labels) {
+                const uint32_t id = static_cast<uint32_t>(info.label);
+                put_varint(out, id - prev);
+                prev = id;
+                if (ids_only) continue;
+                put_varint(out, info.size);
+                put_varint(out, info.flags);
+            }
+        }
+
+        class Reader {
+            private:
+                const std::byte* m_pos;
+                const std::byte* m_end;
+
+            public:
+                Reader(const std::byte* body, size_t size) : m_pos{body}, m_end{body + size} {}
+
+                bool done() const noexcept { return m_pos == m_end; }
+                size_t remaining() const noexcept { return static_cast<size_t>(m_end - m_pos); }
+
+                bool varint(uint64_t& value) noexcept {
+                    value = 0;
+                    for (size_t i = 0; i < MAX_VARINT_BYTES; ++i) {
+                        if (m_pos == m_end) return false;
+                        const uint8_t byte = static_cast<uint8_t>(*m_pos++);
+                        value |= static_cast<uint64_t>(byte & 0x7F) << (7 * i);
+                        if ((byte & 0x80) == 0) return true;
+                    }
+                    return false;
+                }
+
+                bool varint32(uint32_t& value) noexcept {
+                    uint64_t wide = 0;
+                    if (!varint(wide) || wide > std::numeric_limits<uint32_t>::max()) return false;
+                    value = static_cast<uint32_t>(wide);
+                    return true;
+                }
+
+                bool labels(std::vector<LabelInfo>& out, const bool ids_only) {
+                    uint64_t count = 0;
+                    if (!varint(count)) return false;
+
+                    // every label takes at least a byte, a bad count cannot make us allocate much
+                    if (count > MAX_LABELS_LIMIT || count > remaining()) return false;
+                    out.clear();
+                    out.resize(static_cast<size_t>(count));
+
+                    // ids must come out strictly increasing, diff and apply rely on it
+                    uint64_t prev = 0;
+                    for (size_t i = 0; i < out.size(); ++i) {
+                        LabelInfo& info = out[i];
+                        uint32_t gap = 0;
+                        if (!varint32(gap)) return false;
+                        if (gap == 0 && i != 0) return false;
+                        prev += gap;
+                        if (prev > static_cast<uint64_t>(std::numeric_limits<Label>::max())) return false;
+                        info.label = static_cast<Label>(prev);
+                        if (ids_only) continue;
+                        if (!varint32(info.size) || !varint32(info.flags)) return false;
+                    }
+                    return true;
+                }
+        };
+    }
+
+    std::vector<std::byte> encode_full(const BroadcastMessage& msg) {
+        std::vector<std::byte> out;
+        out.reserve(4 * MAX_VARINT_BYTES +
+                    (msg.send_labels.labels.size() + msg.recv_labels.labels.size()) * MAX_LABEL_BYTES);
+        put_varint(out, msg.send_labels.gen);
+        put_labels(out, msg.send_labels.labels, false);
+        put_varint(out, msg.recv_labels.gen);
+        put_labels(out, msg.recv_labels.labels, false);
+        return out;
+    }
+
+    std::vector<std::byte> encode_delta(const BroadcastDelta& delta) {
+        std::vector<std::byte> out;
+        out.reserve(4 * MAX_VARINT_BYTES + (delta.added.size() + delta.removed.size()) * MAX_LABEL_BYTES);
+        put_varint(out, delta.base_gen);
+        put_varint(out, delta.gen);
+        put_labels(out, delta.added, false);
+        put_labels(out, delta.removed, true);
+        return out;
+    }
+
+    std::vector<std::byte> encode_resync(const BroadcastResync& resync) {
+        std::vector<std::byte> out;
+        put_varint(out, static_cast<uint32_t>(resync.target));
+        return out;
+    }
+
+    bool decode_full(const std::byte* body, size_t size, BroadcastMessage& out) {
+        Reader rd(body, size);
+        return rd.varint(out.send_labels.gen) && rd.labels(out.send_labels.labels, false) &&
+               rd.varint(out.recv_labels.gen) && rd.labels(out.recv_labels.labels, false) &&
+               rd.done();
+    }
+
+    bool decode_delta(const std::byte* body, size_t size, BroadcastDelta& out) {
+        Reader rd(body, size);
+        if (!rd.varint(out.base_gen) || !rd.varint(out.gen) ||
+            !rd.labels(out.added, false) || !rd.labels(out.removed, true) || !rd.done()) {
+            return false;
+        }
+
+        // diff_labels never puts a label in both lists, apply and the subscriber update would disagree on it
+        auto a = out.added.begin();
+        for (const LabelInfo& r : out.removed) {
+            while (a != out.added.end() && a->label < r.label) ++a;
+            if (a != out.added.end() && a->label == r.label) return false;
+        }
+        return true;
+    }
+
+    bool decode_resync(const std::byte* body, size_t size, BroadcastResync& out) {
+        Reader rd(body, size);
+        uint32_t target = 0;
+        if (!rd.varint32(target) || !rd.done()) return false;
+        out.target = static_cast<int32_t>(target);
+        return true;
+    }
+
+    void diff_labels(const std::vector<LabelInfo>& before,
+                     const std::vector<LabelInfo>& after,
+                     std::vector<LabelInfo>& changed,
+                     std::vector<LabelInfo>& removed) {
+        changed.clear();
+        removed.clear();
+        auto b = before.begin();
+        auto a = after.begin();
+        while (a != after.end() || b != before.end()) {
+            if (b == before.end() || (a != after.end() && a->label < b->label)) {
+                changed.push_back(*a++);
+            } else if (a == after.end() || b->label < a->label) {
+                removed.push_back(*b++);
+            } else {
+                if (a->size != b->size || a->flags != b->flags) changed.push_back(*a);
+                ++a;
+                ++b;
+            }
+        }
+    }
+
+    void apply_labels(std::vector<LabelInfo>& labels,
+                      const std::vector<LabelInfo>& changed,
+                      const std::vector<LabelInfo>& removed) {
+        std::vector<LabelInfo> out;
+        out.reserve(labels.size() + changed.size());
+        auto l = labels.begin();
+        auto c = changed.begin();
+        auto r = removed.begin();
+        while (l != labels.end() || c != changed.end()) {
+            if (l == labels.end() || (c != changed.end() && c->label <= l->label)) {
+                if (l != labels.end() && c->label == l->label) ++l; // changed replaces it
+                out.push_back(*c++);
+                continue;
+            }
+            while (r != removed.end() && r->label < l->label) ++r;
+            if (r == removed.end() || r->label != l->label) out.push_back(*l);
+            ++l;
+        }
+        labels = std::move(out);
+    }
+
+    size_t max_broadcast_fragments() {
+        constexpr size_t payload = BROADCAST_DATAGRAM_SIZE - sizeof(BroadcastHeader);
+        constexpr size_t body = 6 * MAX_VARINT_BYTES + 2 * static_cast<size_t>(MAX_LABELS_LIMIT) * MAX_LABEL_BYTES;
+        static_assert((body + payload - 1) / payload <= std::numeric_limits<uint16_t>::max());
+        return (body + payload - 1) / payload;
+    }
+
+    bool BroadcastReassembly::add(const BroadcastHeader& hdr, const std::byte* payload, size_t size, std::vector<std::byte>& body) {
+        if (hdr.frag_count == 0 || hdr.frag >= hdr.frag_count || hdr.frag_count > max_broadcast_fragments()) {
+            return false;
+        }
+
+        // nearly every message fits one datagram, it never touches the pending state
+        if (hdr.frag_count == 1) {
+            body.assign(payload, payload + size);
+            return true;
+        }
+
+        Pending& pending = m_pending[hdr.id];
+        if (pending.count == 0 || pending.seq != hdr.seq || pending.kind != hdr.kind || pending.count != hdr.frag_count) {
+            pending.seq = hdr.seq;
+            pending.kind = hdr.kind;
+            pending.count = hdr.frag_count;
+            pending.have = 0;
+            pending.parts.clear();
+            pending.parts.resize(hdr.frag_count);
+        }
+
+        std::vector<std::byte>& part = pending.parts[hdr.frag];
+        if (!part.empty() || size == 0) return false; // repeated
+        part.assign(payload, payload + size);
+        pending.have = static_cast<uint16_t>(pending.have + 1);
+        if (pending.have != pending.count) return false;
+
+        size_t total = 0;
+        for (const auto& p : pending.parts) total += p.size();
+        body.clear();
+        body.reserve(total);
+        for (const auto& p : pending.parts) body.insert(body.end(), p.begin(), p.end());
+        m_pending.erase(hdr.id);
+        return true;
+    }
+}
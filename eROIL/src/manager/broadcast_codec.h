@@ -0,0 +1,61 @@
+#pragma once
+#include <vector>
+#include <unordered_map>
+
+#include "types/const_types.h"
+#include "types/label_io_types.h"
+
+namespace eroil::io {
+    /*
+        discovery wire format, every integer is an unsigned LEB128 varint:
+            full:   send_gen, send_count, send labels, recv_gen, recv_count, recv labels
+            delta:  base_gen, gen, added_count, added labels, removed_count, removed label ids
+            resync: target
+        labels are sorted and each id is sent as the distance from the previous one (the first
+        from 0) followed by size and flags, so a dense label range costs a few bytes per label.
+        the body is then cut into BROADCAST_DATAGRAM_SIZE datagrams each led by a BroadcastHeader
+    */
+
+    std::vector<std::byte> encode_full(const BroadcastMessage& msg);
+    std::vector<std::byte> encode_delta(const BroadcastDelta& delta);
+    std::vector<std::byte> encode_resync(const BroadcastResync& resync);
+
+    // false when the body is truncated, has trailing bytes, holds more than MAX_LABELS_LIMIT labels
+    // or a label list that is not strictly increasing. a delta also fails if a label is both added and removed
+    bool decode_full(const std::byte* body, size_t size, BroadcastMessage& out);
+    bool decode_delta(const std::byte* body, size_t size, BroadcastDelta& out);
+    bool decode_resync(const std::byte* body, size_t size, BroadcastResync& out);
+
+    // sorted merge of two sorted label lists: changed gets labels new in after or whose size/flags
+    // differ, removed gets labels only in before. a delta from before to after
+    void diff_labels(const std::vector<LabelInfo>& before,
+                     const std::vector<LabelInfo>& after,
+                     std::vector<LabelInfo>& changed,
+                     std::vector<LabelInfo>& removed);
+
+    // applies a delta (sorted changed and removed lists) to a sorted label list in place
+    void apply_labels(std::vector<LabelInfo>& labels,
+                      const std::vector<LabelInfo>& changed,
+                      const std::vector<LabelInfo>& removed);
+
+    // collects the fragments of the message each node is sending. a node only has one message
+    // in flight at a time, a fragment with a new seq drops whatever was left of the previous one
+    class BroadcastReassembly {
+        private:
+            struct Pending {
+                uint32_t seq = 0;
+                BroadcastKind kind = BroadcastKind::Full;
+                uint16_t count = 0;
+                uint16_t have = 0;
+                std::vector<std::vector<std::byte>> parts{};
+            };
+            std::unordered_map<NodeId, Pending> m_pending;
+
+        public:
+            // true once hdr completed a message, body then holds all of it
+            bool add(const BroadcastHeader& hdr, const std::byte* payload, size_t size, std::vector<std::byte>& body);
+    };
+
+    // most fragments a legal message can need, anything above is dropped on arrival
+    size_t max_broadcast_fragments();
+}
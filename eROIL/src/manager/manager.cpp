@@ -1,5 +1,6 @@
 #include "manager.h"
 #include <array>
+#include <cstddef>
 #include <cstring>
 #include <thread>
 #include <chrono>
@@ -10,6 +11,9 @@
 #include "platform/platform.h"
 #include "types/label_io_types.h"
 #include "time/timing.h"
+#include "memory/copy.h"
+#include "broadcast_codec.h"
+#include "config/route_manifest.h"
 
 namespace eroil {
     static uint64_t unique_id() {
@@ -22,9 +26,10 @@ namespace eroil {
         m_cfg(cfg),
         m_router{}, 
         m_sock_context{},
-        m_comms{cfg.id, m_router},
+        m_comms{m_cfg, m_router},
         m_broadcast{},
-        m_valid(false) {
+        m_valid(false),
+        m_bcast_signal(std::make_shared<BroadcastSignal>()) {
                 
         // confirm we know who we are
         addr::NodeAddress addr = addr::get_address(m_id);
@@ -47,6 +52,12 @@ namespace eroil {
         return;
     }
 
+    Manager::~Manager() {
+        // waits out a broadcast being handled, the threads find alive cleared after that
+        std::lock_guard lock(m_bcast_signal->alive_mtx);
+        m_bcast_signal->alive = false;
+    }
+
     bool Manager::init() {
         if (!m_valid) {
             return false;
@@ -59,6 +70,15 @@ namespace eroil {
             LOG("tsc frequency estimated: ", tsc_hz, " Hz");
         }).join();
 
+        // known routes are subscribed as each shm block/socket comes up, discovery confirms them later
+        if (m_cfg.route_manifest) {
+            load_route_manifest();
+        }
+        m_comms.set_transport_up_callback([this, signal = m_bcast_signal](NodeId id) {
+            std::lock_guard alive_lock(signal->alive_mtx);
+            if (signal->alive) transport_up(id);
+        });
+
         if (!m_comms.start()) {
             evtlog::crit(elog_kind::NoComms, elog_cat::Manager);
             return false;
@@ -91,10 +111,18 @@ namespace eroil {
             return nullptr;
         }
         
+        if (!m_router.has_send_route(data.label) && m_router.send_label_count() >= m_cfg.max_labels) {
+            ERR_PRINT("node already sends max_labels=", m_cfg.max_labels, " labels");
+            ERR_PRINT("open send request for label=", data.label, " ignored");
+            return nullptr;
+        }
+        
         auto handle = std::make_shared<hndl::SendHandle>(unique_id(), data);
         handle_uid uid = handle->uid;
         m_router.register_send_publisher(std::move(handle));
 
+        // nodes that already told us they receive this label are subscribed right away
+        add_known_subscribers(data.label);
         return m_router.get_send_handle(uid);
     }
 
@@ -133,6 +161,7 @@ namespace eroil {
 
         // create send buffer
         io::SendBuf sbuf(data_buf, data_size);
+        sbuf.src_payload = data_buf + send_offset;
 
         // attach header for send
         io::LabelHeader hdr;
@@ -143,12 +172,19 @@ namespace eroil {
         hdr.label = handle->data.label;
         hdr.label_size = static_cast<uint32_t>(data_size);
         hdr.recv_offset = static_cast<uint32_t>(recv_offset);
+        hdr.checksum = 0;
+
+        // copy data into buffer after header, checksummed on the way through when enabled
+        std::byte* payload = sbuf.data.get() + sizeof(hdr);
+        if (m_cfg.tcp_checksum) {
+            hdr.flags = static_cast<uint16_t>(hdr.flags | static_cast<uint16_t>(io::LabelFlag::Checksum));
+            hdr.checksum = mem::copy_out_crc32c(payload, data_buf + send_offset, data_size, io::label_header_checksum(hdr));
+        } else {
+            mem::copy_out(payload, data_buf + send_offset, data_size);
+        }
 
         // copy header
         std::memcpy(sbuf.data.get(), &hdr, sizeof(hdr));
-
-        // copy data into buffer after header
-        std::memcpy(sbuf.data.get() + sizeof(hdr), data_buf + send_offset, data_size);
         
         // hand off to sender
         m_comms.enqueue_send(handle->uid, handle->data.label, std::move(sbuf));
@@ -170,7 +206,9 @@ namespace eroil {
             return nullptr;
         }
 
-        if (data.buf == nullptr) {
+        // a null buf asks for slots in our shm arena
+        const bool use_arena = data.buf == nullptr && m_cfg.shm_arena_size != 0;
+        if (data.buf == nullptr && !use_arena) {
             ERR_PRINT("got invalid data buf for label=", data.label);
             ERR_PRINT("open recv request for label=", data.label, " ignored");
             return nullptr;
@@ -188,9 +226,53 @@ namespace eroil {
             return nullptr;
         }
 
+        if (!m_router.has_recv_route(data.label) && m_router.recv_label_count() >= m_cfg.max_labels) {
+            ERR_PRINT("node already receives max_labels=", m_cfg.max_labels, " labels");
+            ERR_PRINT("open recv request for label=", data.label, " ignored");
+            return nullptr;
+        }
+
+        std::shared_ptr<shm::ShmArena> arena = nullptr;
+        uint32_t arena_entry = 0;
+        uint64_t arena_next = 0;
+        if (use_arena) {
+            arena = m_router.open_arena(m_id, m_cfg.shm_arena_size);
+            if (arena == nullptr) {
+                ERR_PRINT("shm arena unavailable for label=", data.label);
+                ERR_PRINT("open recv request for label=", data.label, " ignored");
+                return nullptr;
+            }
+
+            // modes that may overwrite never hold publishers back, the others wait for recv_dismiss
+            const bool overwrite = data.signal_mode == iosb::SignalMode::OVERWRITE ||
+                                   data.signal_mode == iosb::SignalMode::SIGNAL_ALL_WRITE_ALL;
+            std::byte* slots = nullptr;
+            if (!arena->acquire(data.label, data.buf_size, data.buf_slots, overwrite, arena_entry, slots, arena_next)) {
+                ERR_PRINT("open recv request for label=", data.label, " ignored");
+                return nullptr;
+            }
+
+            // slots move under the publishers, there is nothing to redirect to
+            data.buf = slots;
+            data.aux_buf = nullptr;
+        }
+
         auto handle = std::make_shared<hndl::RecvHandle>(unique_id(), data);
         handle_uid uid = handle->uid;
+        handle->arena = std::move(arena);
+        handle->arena_entry = arena_entry;
+        handle->arena_next = arena_next;
+
+        // latest value subscribers read the label mailbox, they stay on the ring if it cannot be opened
+        if (m_cfg.shm_mailbox && handle->arena == nullptr && data.signal_mode == iosb::SignalMode::OVERWRITE) {
+            handle->mailbox = m_router.open_mailbox(data.label, data.buf_size);
+            if (handle->mailbox != nullptr) {
+                handle->mailbox_seq = handle->mailbox->current_seq();
+            }
+        }
+
         m_router.register_recv_subscriber(std::move(handle));
+        notify_broadcast(false);
 
         return m_router.get_recv_handle(uid);
     }
@@ -202,6 +284,17 @@ namespace eroil {
         }
 
         m_router.unregister_recv_subscriber(handle);
+        notify_broadcast(false);
+    }
+
+    void Manager::pull_mailbox(hndl::RecvHandle* handle) {
+        if (handle == nullptr || handle->mailbox == nullptr) return;
+        rt::Router::pull_mailbox(*handle);
+    }
+
+    void Manager::return_arena_slots(hndl::RecvHandle* handle, uint32_t count) {
+        if (handle == nullptr || handle->arena == nullptr) return;
+        rt::Router::return_arena_slots(*handle, count);
     }
 
     bool Manager::start_broadcast() {
@@ -219,136 +312,422 @@ namespace eroil {
         }
         LOG("udp multicast group joined");
 
-        std::thread([this]() { send_broadcast(); }).detach();
+        std::thread([this, signal = m_bcast_signal]() { send_broadcast(signal); }).detach();
         LOG("udp multicast send thread started");
 
-        std::thread([this]() {
+        std::thread([this, signal = m_bcast_signal]() {
             //plat::affinitize_current_thread(2);
-            recv_broadcast();
+            recv_broadcast(signal);
         }).detach();
         
         LOG("udp multicast recv thread started");
         return true;
     }
 
-    void Manager::send_broadcast() {
+    void Manager::notify_broadcast(const bool full) {
+        {
+            std::lock_guard lock(m_bcast_signal->mtx);
+            m_bcast_signal->dirty = true;
+            m_bcast_signal->full = m_bcast_signal->full || full;
+        }
+        m_bcast_signal->cv.notify_one();
+    }
+
+    void Manager::send_broadcast(std::shared_ptr<BroadcastSignal> signal) {
+        // peers learn of changes from deltas right away, the full snapshot only repairs anything missed
+        constexpr auto FULL_INTERVAL = std::chrono::seconds(10);
+        constexpr auto RETRY_INTERVAL = std::chrono::seconds(1);
+
         io::BroadcastMessage msg{};
-        msg.id = m_id;
+        io::BroadcastDelta delta{};
 
-        // dont start broadcasting for a few seconds to give us a chance
-        // to open all shared memory blocks before we start registering 
-        // subcribers with the router and sending out broadcasts about them
-        std::this_thread::sleep_for(std::chrono::milliseconds(5 * 1000));
+        // recv labels as of the last broadcast that went out, deltas are taken against it
+        std::vector<io::LabelInfo> sent{};
+        uint64_t sent_gen = 0;
+        bool sent_any = false;
 
+        // shm blocks are open before this thread starts, the first subscriber change or a peers first
+        // snapshot wakes us. a node with nothing to announce still goes out with the periodic full
+        auto next_full = std::chrono::steady_clock::now() + FULL_INTERVAL;
         while (true) {
+            bool full = false;
             {
-                EvtMark mark(elog_cat::Broadcast);
-                msg.send_labels = m_router.get_send_labels_snapshot();
-                msg.recv_labels = m_router.get_recv_labels_snapshot();
-
-                // send broadcast
-                sock::SockResult err = m_broadcast.send_broadcast(&msg, sizeof(msg));
-                if (err.code != sock::SockErr::None) {
-                    evtlog::warn(elog_kind::SendFailed, elog_cat::Broadcast);
-                    ERR_PRINT("broadcast send failed!");
-                    print_socket_result(err);
-                }
+                std::unique_lock lock(signal->mtx);
+                signal->cv.wait_until(lock, next_full, [&signal] { return signal->dirty || signal->full; });
+                full = signal->full || !sent_any || std::chrono::steady_clock::now() >= next_full;
+                signal->dirty = false;
+                signal->full = false;
             }
 
-            std::this_thread::sleep_for(std::chrono::milliseconds(3 * 1000));
-        }
-    }
-
-    void Manager::recv_broadcast() {
-        io::BroadcastMessage msg{};
+            std::lock_guard alive_lock(signal->alive_mtx);
+            if (!signal->alive) return;
 
-        while (true) {
-            m_broadcast.recv_broadcast(&msg, sizeof(msg));
             EvtMark mark(elog_cat::Broadcast);
+            io::LabelsSnapshot recv = m_router.get_recv_labels_snapshot();
+            if (!full && recv.gen == sent_gen) continue; // nothing a subscriber decision depends on
+
+            // remote publishers may send any of our labels on the multicast data plane
+            if (m_comms.mcast_data()) {
+                for (io::LabelInfo& info : recv.labels) {
+                    info.flags |= static_cast<uint32_t>(io::LabelInfoFlag::Multicast);
+                }
+            }
 
-            std::unordered_map<Label, uint32_t> recv{};
-            recv.reserve(MAX_LABELS);
-            for (const io::LabelInfo& recv_label : msg.recv_labels.labels) {
-                if (recv_label.label > INVALID_LABEL) {
-                    auto [it, inserted] = recv.emplace(recv_label.label, recv_label.size);
-                    if (!inserted) {
-                        (void)it; // dont care about iterator
-                        ERR_PRINT("we got a duplicate in recv'd broadcast message recv_label list");
-                        evtlog::warn(elog_kind::DuplicateLabel, elog_cat::Broadcast);
+            // both lists are sorted, walk them together: added or changed (size/flags) and removed
+            if (!full) {
+                delta.added.clear();
+                delta.removed.clear();
+                auto now_it = recv.labels.begin();
+                auto sent_it = sent.begin();
+                while (now_it != recv.labels.end() || sent_it != sent.end()) {
+                    if (sent_it == sent.end() || (now_it != recv.labels.end() && now_it->label < sent_it->label)) {
+                        delta.added.push_back(*now_it++);
+                    } else if (now_it == recv.labels.end() || sent_it->label < now_it->label) {
+                        delta.removed.push_back(*sent_it++);
+                    } else {
+                        if (now_it->size != sent_it->size || now_it->flags != sent_it->flags) delta.added.push_back(*now_it);
+                        ++now_it;
+                        ++sent_it;
                     }
                 }
+
+                // more changed than is left, a snapshot says it just as well
+                if (delta.added.size() + delta.removed.size() > recv.labels.size()) full = true;
+            }
+
+            bool ok = false;
+            if (full) {
+                msg.send_labels = m_router.get_send_labels_snapshot();
+                msg.recv_labels = recv;
+                ok = send_broadcast_body(io::BroadcastKind::Full, io::encode_full(msg));
+            } else {
+                delta.base_gen = sent_gen;
+                delta.gen = recv.gen;
+                ok = send_broadcast_body(io::BroadcastKind::Delta, io::encode_delta(delta));
+            }
+
+            if (!ok) {
+                // peers may now be behind, catch them up with a full snapshot soon
+                sent_any = false;
+                next_full = std::min(next_full, std::chrono::steady_clock::now() + RETRY_INTERVAL);
+                continue;
+            }
+
+            sent = std::move(recv.labels);
+            sent_gen = recv.gen;
+            sent_any = true;
+            if (full) next_full = std::chrono::steady_clock::now() + FULL_INTERVAL;
+        }
+    }
+
+    bool Manager::send_broadcast_body(const io::BroadcastKind kind, const std::vector<std::byte>& body) {
+        constexpr size_t PAYLOAD = BROADCAST_DATAGRAM_SIZE - sizeof(io::BroadcastHeader);
+        const size_t frag_count = std::max<size_t>(1, (body.size() + PAYLOAD - 1) / PAYLOAD);
+        if (frag_count > io::max_broadcast_fragments()) {
+            ERR_PRINT("broadcast message of size=", body.size(), " needs too many datagrams");
+            return false;
+        }
+
+        io::BroadcastHeader hdr{};
+        hdr.kind = kind;
+        hdr.id = m_id;
+        hdr.seq = ++m_bcast_seq;
+        hdr.frag_count = static_cast<uint16_t>(frag_count);
+
+        std::byte datagram[BROADCAST_DATAGRAM_SIZE];
+        for (size_t frag = 0; frag < frag_count; ++frag) {
+            const size_t offset = frag * PAYLOAD;
+            const size_t bytes = std::min(PAYLOAD, body.size() - offset);
+            hdr.frag = static_cast<uint16_t>(frag);
+            std::memcpy(datagram, &hdr, sizeof(hdr));
+            if (bytes != 0) std::memcpy(datagram + sizeof(hdr), body.data() + offset, bytes);
+
+            sock::SockResult err = m_broadcast.send_broadcast(datagram, sizeof(hdr) + bytes);
+            if (err.code != sock::SockErr::None) {
+                evtlog::warn(elog_kind::SendFailed, elog_cat::Broadcast);
+                ERR_PRINT("broadcast send failed!");
+                print_socket_result(err);
+                return false;
             }
-            add_subscriber(msg.id, recv);
-            remove_subscriber(msg.id, recv);
         }
+        return true;
     }
 
-    void Manager::add_subscriber(const NodeId source_id, const std::unordered_map<Label, uint32_t>& recv_labels) {
-        for (const auto& [label, size] : recv_labels) {
-            if (label <= INVALID_LABEL) continue;
+    void Manager::recv_broadcast(std::shared_ptr<BroadcastSignal> signal) {
+        // bigger than any datagram we send so an oversized one is seen as such instead of truncated
+        std::vector<std::byte> buf(2 * BROADCAST_DATAGRAM_SIZE);
+        std::vector<std::byte> body{};
+        io::BroadcastReassembly reassembly{};
+        io::BroadcastMessage msg{};
+        io::BroadcastDelta delta{};
+        io::BroadcastResync resync{};
 
-            // if we do not send this label, ignore it
-            if (!m_router.has_send_route(label)) continue;
+        while (true) {
+            sock::SockResult result = m_broadcast.recv_broadcast(buf.data(), buf.size());
+            if (result.code != sock::SockErr::None || result.bytes < static_cast<int>(sizeof(io::BroadcastHeader))) {
+                continue;
+            }
+            const size_t bytes = static_cast<size_t>(result.bytes);
 
-            // check if they're already on subscriber list
-            if (m_router.is_send_subscriber(label, source_id)) continue;
+            std::lock_guard alive_lock(signal->alive_mtx);
+            if (!signal->alive) return;
+            EvtMark mark(elog_cat::Broadcast);
 
-            // add them as a subscriber of this label
-            const addr::NodeAddress addr = addr::get_address(source_id);
-            switch (addr.kind) {
-                case addr::RouteKind::Self: // fallthrough
-                case addr::RouteKind::Shm: {
-                    //PRINT("adding local send subscriber, nodeid=", source_id, " label=", label);
-                    m_router.add_local_send_subscriber(label, size, source_id);
-                    evtlog::info(elog_kind::AddLocalSendSubscriber, elog_cat::Router, source_id, label);
+            io::BroadcastHeader hdr{};
+            std::memcpy(&hdr, buf.data(), sizeof(hdr));
+            if (hdr.magic != MAGIC_NUM || hdr.version != VERSION || bytes > BROADCAST_DATAGRAM_SIZE ||
+                hdr.id <= INVALID_NODE || hdr.id >= MAX_NODES) {
+                evtlog::warn(elog_kind::InvalidHeader, elog_cat::Broadcast);
+                continue;
+            }
+
+            const std::byte* payload = buf.data() + sizeof(hdr);
+            if (!reassembly.add(hdr, payload, bytes - sizeof(hdr), body)) continue;
+
+            bool valid = false;
+            switch (hdr.kind) {
+                case io::BroadcastKind::Full: {
+                    valid = io::decode_full(body.data(), body.size(), msg);
+                    if (valid) {
+                        msg.hdr = hdr;
+                        handle_full(msg);
+                    }
+                    break;
+                }
+                case io::BroadcastKind::Delta: {
+                    valid = io::decode_delta(body.data(), body.size(), delta);
+                    if (valid) {
+                        delta.hdr = hdr;
+                        handle_delta(delta);
+                    }
                     break;
                 }
-                case addr::RouteKind::Socket: {
-                    //PRINT("adding remote send subscriber, nodeid=", source_id, " label=", label);
-                    m_router.add_remote_send_subscriber(label, size, source_id);
-                    evtlog::info(elog_kind::AddRemoteSendSubscriber, elog_cat::Router, source_id, label);
+                case io::BroadcastKind::Resync: {
+                    valid = io::decode_resync(body.data(), body.size(), resync);
+                    if (valid && resync.target == m_id) notify_broadcast(true);
                     break;
                 }
                 default: {
-                    ERR_PRINT("tried to add send subscriber but did not know routekind, ", static_cast<int>(addr.kind));
                     break;
                 }
             }
+
+            if (!valid) {
+                ERR_PRINT("got malformed broadcast from nodeid=", hdr.id);
+                evtlog::warn(elog_kind::MalformedRecv, elog_cat::Broadcast);
+            }
         }
     }
 
-    void Manager::remove_subscriber(const NodeId source_id, const std::unordered_map<Label, uint32_t>& recv_labels) {
-        auto send_labels = m_router.get_send_labels();
-        for (const auto& [label, _] : send_labels) {
-            if (label <= INVALID_LABEL) continue;
-
-            // if theyre not a recver of this label, continue
-            if (!m_router.is_send_subscriber(label, source_id)) continue;
-
-            // they still want this label, continue
-            if (recv_labels.find(label) != recv_labels.end()) continue;
-
-            // they no longer subscribe to this label, remove them
-            const addr::NodeAddress addr = addr::get_address(source_id);
-            switch (addr.kind) {
-                case addr::RouteKind::Self: // fallthrough
-                case addr::RouteKind::Shm: {
-                    PRINT("removing local send subscriber, nodeid=", source_id, " label=", label);
-                    m_router.remove_local_send_subscriber(label, source_id);
-                    evtlog::info(elog_kind::RemoveLocalSendSubscriber, elog_cat::Router, source_id, label);
-                    break;
-                }
-                case addr::RouteKind::Socket: {
-                    PRINT("removing remote send subscriber, nodeid=", source_id, " label=", label);
-                    m_router.remove_remote_send_subscriber(label, source_id);
-                    evtlog::info(elog_kind::RemoveRemoteSendSubscriber, elog_cat::Router, source_id, label);
-                    break;
-                }
-                default: {
-                    ERR_PRINT("tried to remove send subscriber but did not know routekind, ", static_cast<int>(addr.kind));
-                    break;
+    void Manager::handle_full(const io::BroadcastMessage& msg) {
+        const NodeId source_id = msg.hdr.id;
+        std::lock_guard lock(m_peers_mtx);
+        auto [it, inserted] = m_peers.try_emplace(source_id);
+        PeerLabels& peer = it->second;
+        const bool first_contact = inserted || peer.manifest;
+
+        // a node we have not heard from just started, it needs our labels too
+        if (first_contact && source_id != m_id) notify_broadcast(true);
+
+        // the periodic snapshot of routes we already follow, nothing to reconcile
+        if (!first_contact && !peer.retry && peer.gen == msg.recv_labels.gen) return;
+
+        std::vector<io::LabelInfo> labels = msg.recv_labels.labels;
+        auto last = std::unique(labels.begin(), labels.end(), [](const io::LabelInfo& a, const io::LabelInfo& b) {
+            return a.label == b.label;
+        });
+        if (last != labels.end()) {
+            ERR_PRINT("we got a duplicate in recv'd broadcast message recv_label list");
+            evtlog::warn(elog_kind::DuplicateLabel, elog_cat::Broadcast);
+            labels.erase(last, labels.end());
+        }
+
+        if (peer.manifest) {
+            check_manifest(source_id, peer, labels);
+            peer.manifest = false;
+        }
+
+        std::vector<io::LabelInfo> added{};
+        std::vector<io::LabelInfo> removed{};
+        io::diff_labels(peer.recv, labels, added, removed);
+        peer.recv = std::move(labels);
+        peer.gen = msg.recv_labels.gen;
+        update_subscribers(source_id, peer, added, removed);
+    }
+
+    void Manager::handle_delta(const io::BroadcastDelta& delta) {
+        const NodeId source_id = delta.hdr.id;
+        std::lock_guard lock(m_peers_mtx);
+        auto [it, inserted] = m_peers.try_emplace(source_id);
+        PeerLabels& peer = it->second;
+
+        if (inserted || peer.gen != delta.base_gen) {
+            if (!inserted && delta.gen <= peer.gen) return; // old or repeated
+            evtlog::warn(elog_kind::DeltaGap, elog_cat::Broadcast, source_id);
+            request_resync(source_id, peer);
+            return;
+        }
+
+        io::apply_labels(peer.recv, delta.added, delta.removed);
+        peer.gen = delta.gen;
+        update_subscribers(source_id, peer, delta.added, delta.removed);
+    }
+
+    void Manager::request_resync(const NodeId target, PeerLabels& peer) {
+        // one ask per node in flight, its full snapshot or the periodic one answers it
+        constexpr auto RESYNC_INTERVAL = std::chrono::milliseconds(250);
+        const auto now = std::chrono::steady_clock::now();
+        if (now < peer.resync_at) return;
+        peer.resync_at = now + RESYNC_INTERVAL;
+
+        io::BroadcastResync resync{};
+        resync.target = target;
+        if (!send_broadcast_body(io::BroadcastKind::Resync, io::encode_resync(resync))) {
+            ERR_PRINT("broadcast resync request failed!");
+        }
+    }
+
+    void Manager::add_known_subscribers(const Label label) {
+        std::lock_guard lock(m_peers_mtx);
+        for (auto& [source_id, peer] : m_peers) {
+            auto it = std::lower_bound(peer.recv.begin(), peer.recv.end(), label,
+                [](const io::LabelInfo& info, const Label l) { return info.label < l; });
+            if (it == peer.recv.end() || it->label != label) continue;
+            // a node waiting on its transport gets everything once that is up, see transport_up
+            if (apply_subscribers(source_id, { *it }, {}) != 0) peer.retry = true;
+        }
+    }
+
+    void Manager::load_route_manifest() {
+        const std::vector<cfg::ManifestRoute> routes = cfg::load_route_manifest(std::string(ROUTE_MANIFEST_FILE_PATH));
+
+        std::lock_guard lock(m_peers_mtx);
+        for (const cfg::ManifestRoute& route : routes) {
+            // only the labels we publish need subscribers
+            const bool publisher = route.publishers.empty() ||
+                std::find(route.publishers.begin(), route.publishers.end(), m_id) != route.publishers.end();
+            if (!publisher) continue;
+            m_manifest_labels.push_back(route.label);
+
+            io::LabelInfo info{};
+            info.label = route.label;
+            info.size = route.size;
+            for (const NodeId id : route.subscribers) {
+                if (addr::get_address(id).kind == addr::RouteKind::None) {
+                    ERR_PRINT("route manifest subscriber nodeid=", id, " of label=", route.label, " is not in the address book");
+                    continue;
                 }
+                PeerLabels& peer = m_peers[id];
+                peer.recv.push_back(info);
+                peer.manifest = true;
+                peer.retry = true; // nothing is up yet, every add waits on its transport
             }
         }
+
+        std::sort(m_manifest_labels.begin(), m_manifest_labels.end());
+        m_manifest_labels.erase(std::unique(m_manifest_labels.begin(), m_manifest_labels.end()), m_manifest_labels.end());
+        for (auto& [id, peer] : m_peers) {
+            std::sort(peer.recv.begin(), peer.recv.end());
+            auto last = std::unique(peer.recv.begin(), peer.recv.end(), [](const io::LabelInfo& a, const io::LabelInfo& b) {
+                return a.label == b.label;
+            });
+            peer.recv.erase(last, peer.recv.end());
+        }
+        LOG("route manifest has us publish ", m_manifest_labels.size(), " labels to ", m_peers.size(), " nodes");
+    }
+
+    void Manager::transport_up(const NodeId id) {
+        std::lock_guard lock(m_peers_mtx);
+        if (!addr::host_gateways()) {
+            auto it = m_peers.find(id);
+            if (it == m_peers.end() || !it->second.retry) return;
+            update_subscribers(id, it->second, {}, {}); // retry redoes every add the node is known for
+            return;
+        }
+
+        // a gateway coming up makes every node we reach through it reachable
+        for (auto& [peer_id, peer] : m_peers) {
+            if (peer.retry && transport_of(peer_id) == id) update_subscribers(peer_id, peer, {}, {});
+        }
+    }
+
+    void Manager::check_manifest(const NodeId source_id, const PeerLabels& peer, const std::vector<io::LabelInfo>& labels) {
+        // peer.recv holds what the manifest says the node takes from us, labels what it actually announced
+        std::vector<io::LabelInfo> announced{};
+        for (const io::LabelInfo& info : labels) {
+            if (std::binary_search(m_manifest_labels.begin(), m_manifest_labels.end(), info.label)) {
+                announced.push_back(info);
+            }
+        }
+
+        std::vector<io::LabelInfo> unlisted{};
+        std::vector<io::LabelInfo> missing{};
+        io::diff_labels(peer.recv, announced, unlisted, missing);
+        for (const io::LabelInfo& info : unlisted) {
+            // flags are picked at runtime, only a size disagreement matters for a listed label
+            auto listed = std::lower_bound(peer.recv.begin(), peer.recv.end(), info);
+            if (listed != peer.recv.end() && listed->label == info.label && listed->size == info.size) continue;
+            ERR_PRINT("route manifest disagrees with nodeid=", source_id, " on label=", info.label, " size=", info.size);
+            evtlog::warn(elog_kind::ManifestMismatch, elog_cat::Broadcast, source_id, info.label);
+        }
+        for (const io::LabelInfo& info : missing) {
+            ERR_PRINT("route manifest lists nodeid=", source_id, " as subscriber of label=", info.label, " but it does not receive it");
+            evtlog::warn(elog_kind::ManifestMismatch, elog_cat::Broadcast, source_id, info.label);
+        }
+    }
+
+    void Manager::update_subscribers(const NodeId source_id,
+                                     PeerLabels& peer,
+                                     const std::vector<io::LabelInfo>& added,
+                                     const std::vector<io::LabelInfo>& removed) {
+        // adds refused last time are redone in full, the router skips the ones already in place
+        const uint32_t failed = apply_subscribers(source_id, peer.retry ? peer.recv : added, removed);
+        if (failed != 0) {
+            LOG("cannot add ", failed, " send subscriptions for nodeid=", source_id, " yet, its transport is not up");
+        }
+        peer.retry = failed != 0;
+    }
+
+    NodeId Manager::transport_of(const NodeId id) const {
+        // nodes on other hosts are reached through a host gateway, ours or theirs
+        if (addr::host_gateways() && addr::get_address(id).kind == addr::RouteKind::Socket) {
+            return addr::relay_hop(m_id, id);
+        }
+        return id;
+    }
+
+    uint32_t Manager::apply_subscribers(const NodeId source_id,
+                                        const std::vector<io::LabelInfo>& added,
+                                        const std::vector<io::LabelInfo>& removed) {
+        const addr::NodeAddress addr = addr::get_address(source_id);
+        bool local = false;
+        switch (addr.kind) {
+            case addr::RouteKind::Self: // fallthrough
+            case addr::RouteKind::Shm: {
+                local = true;
+                break;
+            }
+            case addr::RouteKind::Socket: {
+                local = false;
+                break;
+            }
+            default: {
+                ERR_PRINT("tried to update send subscribers but did not know routekind, ", static_cast<int>(addr.kind));
+                return 0;
+            }
+        }
+
+        rt::SubscriberChanges changes = m_router.update_send_subscribers(source_id, transport_of(source_id), local, added, removed);
+
+        const elog_kind add_kind = local ? elog_kind::AddLocalSendSubscriber : elog_kind::AddRemoteSendSubscriber;
+        const elog_kind remove_kind = local ? elog_kind::RemoveLocalSendSubscriber : elog_kind::RemoveRemoteSendSubscriber;
+        for (const Label label : changes.added) {
+            evtlog::info(add_kind, elog_cat::Router, source_id, label);
+        }
+        for (const Label label : changes.removed) {
+            PRINT("removing ", local ? "local" : "remote", " send subscriber, nodeid=", source_id, " label=", label);
+            evtlog::info(remove_kind, elog_cat::Router, source_id, label);
+        }
+        return changes.failed;
     }
 }
\ No newline at end of file
@@ -2,6 +2,10 @@
 #include <vector>
 #include <string>
 #include <unordered_map>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
 
 #include "types/const_types.h"
 #include "config/config.h"
@@ -38,9 +42,36 @@ namespace eroil {
             sock::UDPMulticastSocket m_broadcast;
             bool m_valid;
 
+            // discovery: the send thread sleeps until our routes change or someone asks for a full snapshot.
+            // shared with the detached broadcast threads, they only touch the manager while holding
+            // alive_mtx with alive set so a delta arriving during teardown is dropped instead
+            struct BroadcastSignal {
+                std::mutex mtx;
+                std::condition_variable cv;
+                bool dirty = false;
+                bool full = false;
+                std::mutex alive_mtx;
+                bool alive = true;
+            };
+            std::shared_ptr<BroadcastSignal> m_bcast_signal;
+            uint32_t m_bcast_seq = 0;   // numbers our discovery messages, only touched under alive_mtx
+
+            // recv labels each node last told us about, deltas apply on top of gen. a snapshot of a
+            // gen we already have changes nothing and is skipped unless some of its adds were refused
+            struct PeerLabels {
+                uint64_t gen = 0;
+                std::vector<io::LabelInfo> recv{};  // sorted by label
+                bool retry = false;                 // shm block/socket to the node was not up, redo every add
+                bool manifest = false;              // seeded from etc/routes.cfg, not heard from yet
+                std::chrono::steady_clock::time_point resync_at{};
+            };
+            std::mutex m_peers_mtx;
+            std::unordered_map<NodeId, PeerLabels> m_peers;
+            std::vector<Label> m_manifest_labels;   // sorted, labels the route manifest has us publish
+
         public:
             Manager(cfg::ManagerConfig cfg);
-            ~Manager() = default;
+            ~Manager();
 
             EROIL_NO_COPY(Manager)
             EROIL_NO_MOVE(Manager)
@@ -51,14 +82,31 @@ namespace eroil {
             void close_send(hndl::SendHandle* handle);
             hndl::RecvHandle* open_recv(hndl::OpenReceiveData data);
             void close_recv(hndl::RecvHandle* handle);
+            void pull_mailbox(hndl::RecvHandle* handle);
+            void return_arena_slots(hndl::RecvHandle* handle, uint32_t count);
             void write_event_log() noexcept { evtlog::write_evtlog(); }
             void write_event_log(const std::string& directory) noexcept { evtlog::write_evtlog(directory); }
 
         private:
             bool start_broadcast();
-            void send_broadcast();
-            void recv_broadcast();
-            void add_subscriber(const NodeId source_id, const std::unordered_map<Label, uint32_t>& recv_labels);
-            void remove_subscriber(const NodeId source_id, const std::unordered_map<Label, uint32_t>& recv_labels);
+            void send_broadcast(std::shared_ptr<BroadcastSignal> signal);
+            void recv_broadcast(std::shared_ptr<BroadcastSignal> signal);
+            void notify_broadcast(const bool full);
+            bool send_broadcast_body(const io::BroadcastKind kind, const std::vector<std::byte>& body);
+            void handle_full(const io::BroadcastMessage& msg);
+            void handle_delta(const io::BroadcastDelta& delta);
+            void request_resync(const NodeId target, PeerLabels& peer);
+            void add_known_subscribers(const Label label);
+            void load_route_manifest();
+            void transport_up(const NodeId id);
+            void check_manifest(const NodeId source_id, const PeerLabels& peer, const std::vector<io::LabelInfo>& labels);
+            void update_subscribers(const NodeId source_id,
+                                    PeerLabels& peer,
+                                    const std::vector<io::LabelInfo>& added,
+                                    const std::vector<io::LabelInfo>& removed);
+            NodeId transport_of(const NodeId id) const;
+            uint32_t apply_subscribers(const NodeId source_id,
+                                       const std::vector<io::LabelInfo>& added,
+                                       const std::vector<io::LabelInfo>& removed);
     };
 }
\ No newline at end of file
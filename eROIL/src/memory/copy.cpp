@@ -0,0 +1,141 @@
+#include "copy.h"
+#include <cstdint>
+#include <cstring>
+#include "cpu_features.h"
+
+namespace eroil::mem {
+    namespace {
+        using CopyFn = void (*)(std::byte*, const std::byte*, size_t) noexcept;
+
+        struct CopyKernel {
+            CopyFn fn;
+            const char* name;
+        };
+
+        constexpr size_t PREFETCH_DIST = 512;      // bytes ahead of the copy cursor
+
+        inline void prefetch_read(const std::byte* p) noexcept {
+#if defined(_MSC_VER) && defined(EROIL_X86)
+            _mm_prefetch(reinterpret_cast<const char*>(p), _MM_HINT_T0);
+#elif defined(__GNUC__)
+            __builtin_prefetch(p, 0, 3);
+#else
+            (void)p;
+#endif
+        }
+
+#if !defined(EROIL_X86)
+        void copy_plain(std::byte* dst, const std::byte* src, size_t size) noexcept {
+            std::memcpy(dst, src, size);
+        }
+#else
+        // bytes needed to bring dst up to an align boundary
+        inline size_t align_head(const std::byte* dst, size_t align, size_t size) noexcept {
+            const size_t mis = reinterpret_cast<uintptr_t>(dst) & (align - 1);
+            const size_t head = mis == 0 ? 0 : align - mis;
+            return head < size ? head : size;
+        }
+
+        EROIL_TARGET("sse2")
+        void stream_sse2(std::byte* dst, const std::byte* src, size_t size) noexcept {
+            const size_t head = align_head(dst, 16, size);
+            std::memcpy(dst, src, head);
+            dst += head; src += head; size -= head;
+
+            while (size >= 64) {
+                prefetch_read(src + PREFETCH_DIST);
+                const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+                const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 16));
+                const __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 32));
+                const __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 48));
+                _mm_stream_si128(reinterpret_cast<__m128i*>(dst), a);
+                _mm_stream_si128(reinterpret_cast<__m128i*>(dst + 16), b);
+                _mm_stream_si128(reinterpret_cast<__m128i*>(dst + 32), c);
+                _mm_stream_si128(reinterpret_cast<__m128i*>(dst + 48), d);
+                dst += 64; src += 64; size -= 64;
+            }
+
+            // streaming stores are weakly ordered, fence before anyone publishes the data
+            _mm_sfence();
+            std::memcpy(dst, src, size);
+        }
+
+        EROIL_TARGET("avx2")
+        void stream_avx2(std::byte* dst, const std::byte* src, size_t size) noexcept {
+            const size_t head = align_head(dst, 32, size);
+            std::memcpy(dst, src, head);
+            dst += head; src += head; size -= head;
+
+            while (size >= 128) {
+                prefetch_read(src + PREFETCH_DIST);
+                prefetch_read(src + PREFETCH_DIST + 64);
+                const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src));
+                const __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + 32));
+                const __m256i c = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + 64));
+                const __m256i d = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + 96));
+                _mm256_stream_si256(reinterpret_cast<__m256i*>(dst), a);
+                _mm256_stream_si256(reinterpret_cast<__m256i*>(dst + 32), b);
+                _mm256_stream_si256(reinterpret_cast<__m256i*>(dst + 64), c);
+                _mm256_stream_si256(reinterpret_cast<__m256i*>(dst + 96), d);
+                dst += 128; src += 128; size -= 128;
+            }
+
+            _mm_sfence();
+            std::memcpy(dst, src, size);
+        }
+
+        EROIL_TARGET("avx512f")
+        void stream_avx512(std::byte* dst, const std::byte* src, size_t size) noexcept {
+            const size_t head = align_head(dst, 64, size);
+            std::memcpy(dst, src, head);
+            dst += head; src += head; size -= head;
+
+            while (size >= 256) {
+                prefetch_read(src + PREFETCH_DIST);
+                prefetch_read(src + PREFETCH_DIST + 64);
+                prefetch_read(src + PREFETCH_DIST + 128);
+                prefetch_read(src + PREFETCH_DIST + 192);
+                const __m512i a = _mm512_loadu_si512(src);
+                const __m512i b = _mm512_loadu_si512(src + 64);
+                const __m512i c = _mm512_loadu_si512(src + 128);
+                const __m512i d = _mm512_loadu_si512(src + 192);
+                _mm512_stream_si512(reinterpret_cast<__m512i*>(dst), a);
+                _mm512_stream_si512(reinterpret_cast<__m512i*>(dst + 64), b);
+                _mm512_stream_si512(reinterpret_cast<__m512i*>(dst + 128), c);
+                _mm512_stream_si512(reinterpret_cast<__m512i*>(dst + 192), d);
+                dst += 256; src += 256; size -= 256;
+            }
+
+            _mm_sfence();
+            std::memcpy(dst, src, size);
+        }
+#endif
+
+        CopyKernel select_stream_kernel() noexcept {
+#if defined(EROIL_X86)
+            if (cpu_has_avx512f()) return { stream_avx512, "avx512" };
+            if (cpu_has_avx2()) return { stream_avx2, "avx2" };
+            return { stream_sse2, "sse2" };
+#else
+            return { copy_plain, "memcpy" };
+#endif
+        }
+
+        const CopyKernel& stream_kernel() noexcept {
+            static const CopyKernel kernel = select_stream_kernel();
+            return kernel;
+        }
+    }
+
+    void copy_out(void* dst, const void* src, size_t size) noexcept {
+        if (size < STREAM_THRESHOLD) {
+            std::memcpy(dst, src, size);
+            return;
+        }
+        stream_kernel().fn(static_cast<std::byte*>(dst), static_cast<const std::byte*>(src), size);
+    }
+
+    const char* copy_kernel_name() noexcept {
+        return stream_kernel().name;
+    }
+}
@@ -0,0 +1,18 @@
+#pragma once
+#include <cstddef>
+
+namespace eroil::mem {
+    // payload copy engine for data another core/process reads next (shm blocks, subscriber
+    // slots, send buffers). above STREAM_THRESHOLD the copy uses non-temporal stores with the
+    // source prefetched ahead, so it does not evict the writer's cache or pull every destination
+    // line in for ownership first. the widest of AVX-512/AVX2/SSE2 the cpu supports is picked
+    // once at runtime, small copies and non x86 targets use std::memcpy
+    //
+    // data the copying thread reads right back should keep using std::memcpy
+    constexpr size_t STREAM_THRESHOLD = 128 * 1024;
+
+    void copy_out(void* dst, const void* src, size_t size) noexcept;
+
+    // name of the streaming kernel picked for this cpu
+    const char* copy_kernel_name() noexcept;
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+// x86 feature detection shared by the copy and checksum kernels
+// kernels are compiled per instruction set with EROIL_TARGET and picked once at runtime
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+    #define EROIL_X86 1
+    #include <immintrin.h>
+    #if defined(_MSC_VER)
+        #include <intrin.h>
+        #define EROIL_TARGET(isa)
+    #else
+        #define EROIL_TARGET(isa) __attribute__((target(isa)))
+    #endif
+#endif
+
+namespace eroil::mem {
+#if defined(EROIL_X86)
+    #if defined(_MSC_VER)
+    inline bool cpu_has_sse42() noexcept {
+        int info[4] = {};
+        __cpuid(info, 1);
+        return (info[2] & (1 << 20)) != 0;
+    }
+
+    inline bool cpu_has_avx2() noexcept {
+        int info[4] = {};
+        __cpuid(info, 1);
+        const bool osxsave = (info[2] & (1 << 27)) != 0;
+        const bool avx = (info[2] & (1 << 28)) != 0;
+        if (!osxsave || !avx || (_xgetbv(0) & 0x6) != 0x6) return false;
+        __cpuidex(info, 7, 0);
+        return (info[1] & (1 << 5)) != 0;
+    }
+
+    inline bool cpu_has_avx512f() noexcept {
+        if (!cpu_has_avx2()) return false;
+        int info[4] = {};
+        __cpuidex(info, 7, 0);
+        // os must save the opmask and upper zmm state
+        return (info[1] & (1 << 16)) != 0 && (_xgetbv(0) & 0xe6) == 0xe6;
+    }
+    #else
+    inline bool cpu_has_sse42() noexcept {
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("sse4.2");
+    }
+
+    inline bool cpu_has_avx2() noexcept {
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2");
+    }
+
+    inline bool cpu_has_avx512f() noexcept {
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx512f");
+    }
+    #endif
+#endif
+}
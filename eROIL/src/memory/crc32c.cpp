@@ -0,0 +1,368 @@
+#include "crc32c.h"
+#include <cstring>
+#include "copy.h"
+#include "cpu_features.h"
+
+#if defined(EROIL_X86) && (defined(__x86_64__) || defined(_M_X64))
+    #define EROIL_CRC_HW 1     // crc32 has a 64 bit form on x86-64 only
+#endif
+
+namespace eroil::mem {
+    namespace {
+        constexpr uint32_t POLY = 0x82f63b78u;  // reflected castagnoli polynomial
+
+        // hw path works on three independent streams of LONG (then SHORT) bytes so the
+        // crc32 instruction latency is hidden, the partial crcs are then shifted into place
+        constexpr size_t LONG = 8192;
+        constexpr size_t SHORT = 256;
+
+        struct Tables {
+            uint32_t sw[8][256];          // slicing-by-8
+            uint32_t long_shift[4][256];  // apply LONG zero bytes to a crc
+            uint32_t short_shift[4][256]; // apply SHORT zero bytes to a crc
+        };
+
+        uint32_t gf2_matrix_times(const uint32_t* mat, uint32_t vec) noexcept {
+            uint32_t sum = 0;
+            while (vec != 0) {
+                if ((vec & 1) != 0) sum ^= *mat;
+                vec >>= 1;
+                mat++;
+            }
+            return sum;
+        }
+
+        void gf2_matrix_square(uint32_t* square, const uint32_t* mat) noexcept {
+            for (size_t n = 0; n < 32; ++n) {
+                square[n] = gf2_matrix_times(mat, mat[n]);
+            }
+        }
+
+        // operator that appends len zero bytes to a crc, len must be a power of two
+        void zeros_op(uint32_t* even, size_t len) noexcept {
+            uint32_t odd[32];
+            odd[0] = POLY;
+            uint32_t row = 1;
+            for (size_t n = 1; n < 32; ++n) {
+                odd[n] = row;
+                row <<= 1;
+            }
+
+            gf2_matrix_square(even, odd);   // 2 zero bits
+            gf2_matrix_square(odd, even);   // 4 zero bits
+            while (true) {
+                gf2_matrix_square(even, odd);
+                len >>= 1;
+                if (len == 0) return;
+                gf2_matrix_square(odd, even);
+                len >>= 1;
+                if (len == 0) break;
+            }
+            std::memcpy(even, odd, sizeof(odd));
+        }
+
+        void build_shift(uint32_t zeros[4][256], size_t len) noexcept {
+            uint32_t op[32];
+            zeros_op(op, len);
+            for (uint32_t n = 0; n < 256; ++n) {
+                zeros[0][n] = gf2_matrix_times(op, n);
+                zeros[1][n] = gf2_matrix_times(op, n << 8);
+                zeros[2][n] = gf2_matrix_times(op, n << 16);
+                zeros[3][n] = gf2_matrix_times(op, n << 24);
+            }
+        }
+
+        Tables build_tables() noexcept {
+            Tables t{};
+            for (uint32_t n = 0; n < 256; ++n) {
+                uint32_t crc = n;
+                for (int32_t k = 0; k < 8; ++k) {
+                    crc = (crc & 1) != 0 ? (crc >> 1) ^ POLY : crc >> 1;
+                }
+                t.sw[0][n] = crc;
+            }
+            for (uint32_t n = 0; n < 256; ++n) {
+                uint32_t crc = t.sw[0][n];
+                for (size_t k = 1; k < 8; ++k) {
+                    crc = t.sw[0][crc & 0xff] ^ (crc >> 8);
+                    t.sw[k][n] = crc;
+                }
+            }
+            build_shift(t.long_shift, LONG);
+            build_shift(t.short_shift, SHORT);
+            return t;
+        }
+
+        const Tables& tables() noexcept {
+            static const Tables t = build_tables();
+            return t;
+        }
+
+        inline uint64_t load64(const std::byte* p) noexcept {
+            uint64_t v;
+            std::memcpy(&v, p, sizeof(v));
+            return v;
+        }
+
+        uint32_t crc_sw(uint32_t crc, const std::byte* next, size_t len) noexcept {
+            const Tables& t = tables();
+            while (len > 0 && (reinterpret_cast<uintptr_t>(next) & 7) != 0) {
+                crc = t.sw[0][(crc ^ static_cast<uint32_t>(*next)) & 0xff] ^ (crc >> 8);
+                next++;
+                len--;
+            }
+
+            // little endian hosts only, same as the rest of the wire format
+            while (len >= 8) {
+                const uint64_t v = load64(next) ^ crc;
+                crc = t.sw[7][v & 0xff] ^
+                      t.sw[6][(v >> 8) & 0xff] ^
+                      t.sw[5][(v >> 16) & 0xff] ^
+                      t.sw[4][(v >> 24) & 0xff] ^
+                      t.sw[3][(v >> 32) & 0xff] ^
+                      t.sw[2][(v >> 40) & 0xff] ^
+                      t.sw[1][(v >> 48) & 0xff] ^
+                      t.sw[0][v >> 56];
+                next += 8;
+                len -= 8;
+            }
+
+            while (len > 0) {
+                crc = t.sw[0][(crc ^ static_cast<uint32_t>(*next)) & 0xff] ^ (crc >> 8);
+                next++;
+                len--;
+            }
+            return crc;
+        }
+
+        using CopyCrcFn = uint32_t (*)(uint32_t, std::byte*, const std::byte*, size_t) noexcept;
+
+#if defined(EROIL_CRC_HW)
+        inline uint32_t shift(const uint32_t zeros[4][256], uint32_t crc) noexcept {
+            return zeros[0][crc & 0xff] ^ zeros[1][(crc >> 8) & 0xff] ^
+                   zeros[2][(crc >> 16) & 0xff] ^ zeros[3][crc >> 24];
+        }
+
+        EROIL_TARGET("sse4.2")
+        uint32_t crc_hw(uint32_t crc, const std::byte* next, size_t len) noexcept {
+            const Tables& t = tables();
+            uint64_t crc0 = crc;
+
+            while (len > 0 && (reinterpret_cast<uintptr_t>(next) & 7) != 0) {
+                crc0 = _mm_crc32_u8(static_cast<uint32_t>(crc0), static_cast<uint8_t>(*next));
+                next++;
+                len--;
+            }
+
+            while (len >= LONG * 3) {
+                uint64_t crc1 = 0;
+                uint64_t crc2 = 0;
+                const std::byte* end = next + LONG;
+                do {
+                    crc0 = _mm_crc32_u64(crc0, load64(next));
+                    crc1 = _mm_crc32_u64(crc1, load64(next + LONG));
+                    crc2 = _mm_crc32_u64(crc2, load64(next + LONG + LONG));
+                    next += 8;
+                } while (next < end);
+                crc0 = shift(t.long_shift, static_cast<uint32_t>(crc0)) ^ crc1;
+                crc0 = shift(t.long_shift, static_cast<uint32_t>(crc0)) ^ crc2;
+                next += LONG * 2;
+                len -= LONG * 3;
+            }
+
+            while (len >= SHORT * 3) {
+                uint64_t crc1 = 0;
+                uint64_t crc2 = 0;
+                const std::byte* end = next + SHORT;
+                do {
+                    crc0 = _mm_crc32_u64(crc0, load64(next));
+                    crc1 = _mm_crc32_u64(crc1, load64(next + SHORT));
+                    crc2 = _mm_crc32_u64(crc2, load64(next + SHORT + SHORT));
+                    next += 8;
+                } while (next < end);
+                crc0 = shift(t.short_shift, static_cast<uint32_t>(crc0)) ^ crc1;
+                crc0 = shift(t.short_shift, static_cast<uint32_t>(crc0)) ^ crc2;
+                next += SHORT * 2;
+                len -= SHORT * 3;
+            }
+
+            while (len >= 8) {
+                crc0 = _mm_crc32_u64(crc0, load64(next));
+                next += 8;
+                len -= 8;
+            }
+
+            while (len > 0) {
+                crc0 = _mm_crc32_u8(static_cast<uint32_t>(crc0), static_cast<uint8_t>(*next));
+                next++;
+                len--;
+            }
+            return static_cast<uint32_t>(crc0);
+        }
+
+        // fused copy + crc, the same three stream layout as crc_hw. each cache line is loaded once,
+        // stored and crc'd from L1. for the streaming variants full line stores matter, an 8 byte
+        // movnti version of this loop was slower than crc then copy
+        //
+        // head and tail are shared, only the line store differs per kernel
+        EROIL_TARGET("sse4.2")
+        uint32_t copy_crc_bytes(uint32_t crc, std::byte* dst, const std::byte* src, size_t len) noexcept {
+            while (len > 0) {
+                *dst = *src;
+                crc = _mm_crc32_u8(crc, static_cast<uint8_t>(*src));
+                dst++;
+                src++;
+                len--;
+            }
+            return crc;
+        }
+
+        EROIL_TARGET("sse4.2")
+        uint32_t copy_crc_tail(uint32_t crc, std::byte* dst, const std::byte* src, size_t len) noexcept {
+            // streaming stores are weakly ordered, fence before anyone publishes the data
+            _mm_sfence();
+            std::memcpy(dst, src, len);
+            return crc_hw(crc, src, len);
+        }
+
+    #define EROIL_COPY_CRC_KERNEL(NAME, ISA, ALIGN, STORE_LINE)                                 \
+        EROIL_TARGET(ISA)                                                                       \
+        uint32_t NAME(uint32_t crc, std::byte* dst, const std::byte* src, size_t len) noexcept {\
+            const Tables& t = tables();                                                         \
+            const size_t mis = reinterpret_cast<uintptr_t>(dst) & (ALIGN - 1);                  \
+            const size_t head = mis == 0 ? 0 : (ALIGN - mis < len ? ALIGN - mis : len);         \
+            uint64_t crc0 = copy_crc_bytes(crc, dst, src, head);                                \
+            dst += head; src += head; len -= head;                                              \
+                                                                                                \
+            while (len >= LONG * 3) {                                                           \
+                uint64_t crc1 = 0;                                                              \
+                uint64_t crc2 = 0;                                                              \
+                const std::byte* end = src + LONG;                                              \
+                do {                                                                            \
+                    STORE_LINE(dst, src);                                                       \
+                    STORE_LINE(dst + LONG, src + LONG);                                         \
+                    STORE_LINE(dst + LONG + LONG, src + LONG + LONG);                           \
+                    for (size_t i = 0; i < 64; i += 8) {                                        \
+                        crc0 = _mm_crc32_u64(crc0, load64(src + i));                            \
+                        crc1 = _mm_crc32_u64(crc1, load64(src + LONG + i));                     \
+                        crc2 = _mm_crc32_u64(crc2, load64(src + LONG + LONG + i));              \
+                    }                                                                           \
+                    src += 64;                                                                  \
+                    dst += 64;                                                                  \
+                } while (src < end);                                                            \
+                crc0 = shift(t.long_shift, static_cast<uint32_t>(crc0)) ^ crc1;                 \
+                crc0 = shift(t.long_shift, static_cast<uint32_t>(crc0)) ^ crc2;                 \
+                src += LONG * 2;                                                                \
+                dst += LONG * 2;                                                                \
+                len -= LONG * 3;                                                                \
+            }                                                                                   \
+                                                                                                \
+            while (len >= SHORT * 3) {                                                          \
+                uint64_t crc1 = 0;                                                              \
+                uint64_t crc2 = 0;                                                              \
+                const std::byte* end = src + SHORT;                                             \
+                do {                                                                            \
+                    STORE_LINE(dst, src);                                                       \
+                    STORE_LINE(dst + SHORT, src + SHORT);                                       \
+                    STORE_LINE(dst + SHORT + SHORT, src + SHORT + SHORT);                       \
+                    for (size_t i = 0; i < 64; i += 8) {                                        \
+                        crc0 = _mm_crc32_u64(crc0, load64(src + i));                            \
+                        crc1 = _mm_crc32_u64(crc1, load64(src + SHORT + i));                    \
+                        crc2 = _mm_crc32_u64(crc2, load64(src + SHORT + SHORT + i));            \
+                    }                                                                           \
+                    src += 64;                                                                  \
+                    dst += 64;                                                                  \
+                } while (src < end);                                                            \
+                crc0 = shift(t.short_shift, static_cast<uint32_t>(crc0)) ^ crc1;                \
+                crc0 = shift(t.short_shift, static_cast<uint32_t>(crc0)) ^ crc2;                \
+                src += SHORT * 2;                                                               \
+                dst += SHORT * 2;                                                               \
+                len -= SHORT * 3;                                                               \
+            }                                                                                   \
+            return copy_crc_tail(static_cast<uint32_t>(crc0), dst, src, len);                   \
+        }
+
+    #define EROIL_STORE_LINE_CACHED(d, s)                                                                           \
+        for (size_t j = 0; j < 64; j += 16) {                                                                       \
+            _mm_storeu_si128(reinterpret_cast<__m128i*>((d) + j), _mm_loadu_si128(reinterpret_cast<const __m128i*>((s) + j))); \
+        }
+    #define EROIL_STORE_LINE_SSE2(d, s)                                                                             \
+        for (size_t j = 0; j < 64; j += 16) {                                                                       \
+            _mm_stream_si128(reinterpret_cast<__m128i*>((d) + j), _mm_loadu_si128(reinterpret_cast<const __m128i*>((s) + j))); \
+        }
+    #define EROIL_STORE_LINE_AVX2(d, s)                                                                             \
+        _mm256_stream_si256(reinterpret_cast<__m256i*>(d), _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s)));   \
+        _mm256_stream_si256(reinterpret_cast<__m256i*>((d) + 32), _mm256_loadu_si256(reinterpret_cast<const __m256i*>((s) + 32)))
+    #define EROIL_STORE_LINE_AVX512(d, s)                                                                           \
+        _mm512_stream_si512(reinterpret_cast<__m512i*>(d), _mm512_loadu_si512(s))
+
+        EROIL_COPY_CRC_KERNEL(copy_crc_cached, "sse4.2", 16, EROIL_STORE_LINE_CACHED)
+        EROIL_COPY_CRC_KERNEL(copy_crc_sse42, "sse4.2", 16, EROIL_STORE_LINE_SSE2)
+        EROIL_COPY_CRC_KERNEL(copy_crc_avx2, "sse4.2,avx2", 32, EROIL_STORE_LINE_AVX2)
+        EROIL_COPY_CRC_KERNEL(copy_crc_avx512, "sse4.2,avx512f", 64, EROIL_STORE_LINE_AVX512)
+
+    #undef EROIL_STORE_LINE_AVX512
+    #undef EROIL_STORE_LINE_AVX2
+    #undef EROIL_STORE_LINE_SSE2
+    #undef EROIL_STORE_LINE_CACHED
+    #undef EROIL_COPY_CRC_KERNEL
+#endif
+
+        uint32_t copy_crc_plain(uint32_t crc, std::byte* dst, const std::byte* src, size_t len) noexcept {
+            std::memcpy(dst, src, len);
+            return crc_sw(crc, src, len);
+        }
+
+        uint32_t copy_out_crc_plain(uint32_t crc, std::byte* dst, const std::byte* src, size_t len) noexcept {
+            copy_out(dst, src, len);
+            return crc_sw(crc, src, len);
+        }
+
+        struct CrcKernels {
+            bool hw = false;
+            CopyCrcFn copy = copy_crc_plain;
+            CopyCrcFn copy_out = copy_out_crc_plain;
+        };
+
+        CrcKernels select_kernels() noexcept {
+            CrcKernels k{};
+#if defined(EROIL_CRC_HW)
+            if (!cpu_has_sse42()) return k;
+            k.hw = true;
+            k.copy = copy_crc_cached;
+            if (cpu_has_avx512f()) k.copy_out = copy_crc_avx512;
+            else if (cpu_has_avx2()) k.copy_out = copy_crc_avx2;
+            else k.copy_out = copy_crc_sse42;
+#endif
+            return k;
+        }
+
+        const CrcKernels& kernels() noexcept {
+            static const CrcKernels k = select_kernels();
+            return k;
+        }
+    }
+
+    uint32_t crc32c(const void* data, size_t size, uint32_t crc) noexcept {
+        const auto* p = static_cast<const std::byte*>(data);
+        crc = ~crc;
+#if defined(EROIL_CRC_HW)
+        if (kernels().hw) return ~crc_hw(crc, p, size);
+#endif
+        return ~crc_sw(crc, p, size);
+    }
+
+    uint32_t copy_crc32c(void* dst, const void* src, size_t size, uint32_t crc) noexcept {
+        return ~kernels().copy(~crc, static_cast<std::byte*>(dst), static_cast<const std::byte*>(src), size);
+    }
+
+    uint32_t copy_out_crc32c(void* dst, const void* src, size_t size, uint32_t crc) noexcept {
+        // small payloads are cache resident, no streaming stores
+        if (size < STREAM_THRESHOLD) return copy_crc32c(dst, src, size, crc);
+        return ~kernels().copy_out(~crc, static_cast<std::byte*>(dst), static_cast<const std::byte*>(src), size);
+    }
+
+    bool crc32c_hw() noexcept {
+        return kernels().hw;
+    }
+}
@@ -0,0 +1,23 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+namespace eroil::mem {
+    // crc32c (castagnoli), used for optional shm record and socket frame checksums
+    // x86-64 with SSE4.2 -> crc32 instruction over three interleaved streams
+    // everything else -> software slicing-by-8
+    //
+    // crc is the value of a previous call to continue a running checksum, 0 to start one
+    uint32_t crc32c(const void* data, size_t size, uint32_t crc = 0) noexcept;
+
+    // std::memcpy that returns crc32c(src) continued from crc, each word is checksummed as it is copied
+    uint32_t copy_crc32c(void* dst, const void* src, size_t size, uint32_t crc = 0) noexcept;
+
+    // mem::copy_out that returns crc32c(src) continued from crc. above STREAM_THRESHOLD the
+    // checksum is taken on the words as they pass through registers on their way to streaming
+    // stores, so the source is read from memory once
+    uint32_t copy_out_crc32c(void* dst, const void* src, size_t size, uint32_t crc = 0) noexcept;
+
+    // true when the crc32 instruction is being used
+    bool crc32c_hw() noexcept;
+}
@@ -3,6 +3,9 @@
 #include <semaphore.h>
 #include <pthread.h>
 #include <sched.h>
+#include <signal.h>
+#include <unistd.h>
+#include <cerrno>
 #include <chrono>
 #include <sstream>
 #include <iomanip>
@@ -60,5 +63,14 @@ namespace eroil::plat {
         oss << std::put_time(&tm, "%Y%m%d_%H%M%S");
         return oss.str();
     }
+
+    uint32_t process_id() {
+        return static_cast<uint32_t>(::getpid());
+    }
+
+    bool process_alive(uint32_t pid) {
+        if (::kill(static_cast<pid_t>(pid), 0) == 0) return true;
+        return errno == EPERM;
+    }
 }
 #endif
\ No newline at end of file
@@ -11,4 +11,8 @@ namespace eroil::plat {
     void affinitize_current_thread(uint32_t cpu);
     void affinitize_current_thread_to_current_cpu();
     std::string timestamp_str();
+
+    uint32_t process_id();
+    // false only once the process is gone, one we are not allowed to query counts as alive
+    bool process_alive(uint32_t pid);
 }
\ No newline at end of file
@@ -64,5 +64,18 @@ namespace eroil::plat {
         oss << std::put_time(&tm, "%Y%m%d_%H%M%S");
         return oss.str();
     }
+
+    uint32_t process_id() {
+        return static_cast<uint32_t>(::GetCurrentProcessId());
+    }
+
+    bool process_alive(uint32_t pid) {
+        HANDLE process = ::OpenProcess(SYNCHRONIZE, FALSE, static_cast<DWORD>(pid));
+        if (process == nullptr) return ::GetLastError() == ERROR_ACCESS_DENIED;
+
+        const bool alive = ::WaitForSingleObject(process, 0) == WAIT_TIMEOUT;
+        ::CloseHandle(process);
+        return alive;
+    }
 }
 #endif
\ No newline at end of file
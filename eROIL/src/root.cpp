@@ -38,6 +38,21 @@ namespace eroil {
             }
         }
 
+        // hosts come from the ips in peer_ips.cfg, the test modes ignore those
+        if (config.host_gateway) {
+            if (config.mode != cfg::ManagerMode::Normal) {
+                LOG("host gateways are only used in Normal mode, every remote node gets its own socket");
+                config.host_gateway = false;
+            } else {
+                // the data plane asks for lost frames on the sockets gateways take away
+                if (config.mcast_data.enabled) {
+                    LOG("multicast data plane is not used with host gateways");
+                    config.mcast_data.enabled = false;
+                }
+                addr::use_host_gateways(id);
+            }
+        }
+
         // initialize manager
         manager = std::make_unique<Manager>(config);
         initialized = manager->init();
@@ -127,7 +142,6 @@ namespace eroil {
         data.num_iosb = static_cast<uint32_t>(num_iosb);
         data.iosb_index = 0;
         data.signal_mode = signal_mode;
-        data.recv_count = 0;
         
         return manager->open_recv(data);
     }
@@ -140,37 +154,53 @@ namespace eroil {
 
     uint32_t recv_count(hndl::RecvHandle* handle) {
         if (handle == nullptr) return 0;
-        std::lock_guard lock(handle->mtx);
-        return handle->data.recv_count;
+
+        // mailbox subscribers take the latest value on the calling thread
+        if (handle->mailbox != nullptr && is_ready()) {
+            manager->pull_mailbox(handle);
+        }
+        return handle->recv_count.load(std::memory_order_acquire);
     }
 
     void recv_dismiss(hndl::RecvHandle* handle, uint32_t count) {
         if (handle == nullptr) return;
 
-        std::lock_guard lock(handle->mtx);
-        if (count > handle->data.recv_count) {
-            handle->data.recv_count = 0;
-        } else {
-            handle->data.recv_count -= count;
+        // producers only ever add, saturate at 0 without taking the write lock
+        uint32_t current = handle->recv_count.load(std::memory_order_relaxed);
+        while (true) {
+            const uint32_t reduced = count > current ? 0 : current - count;
+            if (handle->recv_count.compare_exchange_weak(current, reduced,
+                                                         std::memory_order_acq_rel,
+                                                         std::memory_order_relaxed)) {
+                // arena slots dismissed here may be written by publishers again
+                if (handle->arena != nullptr && is_ready()) {
+                    manager->return_arena_slots(handle, current - reduced);
+                }
+                return;
+            }
         }
     }
 
     void recv_idle(hndl::RecvHandle* handle) {
         if (handle == nullptr) return;
-        std::lock_guard lock(handle->mtx);
-        handle->is_idle = true;
+        handle->is_idle.store(true, std::memory_order_release);
     }
 
     void recv_resume(hndl::RecvHandle* handle) {
         if (handle == nullptr) return;
-        std::lock_guard lock(handle->mtx);
-        handle->is_idle = false;
+        handle->is_idle.store(false, std::memory_order_release);
     }
 
     void recv_reset(hndl::RecvHandle* handle) {
         if (handle == nullptr) return;
-        std::lock_guard lock(handle->mtx);
-        handle->data.recv_count = 0;
+        // moves the producer's slot index, wait out any delivery in progress
+        std::lock_guard lock(handle->write_mtx);
+        const uint32_t dropped = handle->recv_count.exchange(0, std::memory_order_acq_rel);
+        if (handle->arena != nullptr && is_ready()) {
+            // arena slots are handed out in ticket order, the next one is wherever publishers are
+            manager->return_arena_slots(handle, dropped);
+            return;
+        }
         handle->data.buf_index = 0;
     }
 
@@ -179,12 +209,19 @@ namespace eroil {
         if (handle->data.buf == nullptr) return;
         if (handle->data.aux_buf == nullptr) return;
 
-        std::lock_guard lock(handle->mtx);
+        std::lock_guard lock(handle->write_mtx);
         std::byte* buf = handle->data.buf;
         handle->data.buf = handle->data.aux_buf;
         handle->data.aux_buf = buf;
         handle->data.buf_index = 0;
-        handle->data.recv_count = 0; // i think we reset this
+        handle->recv_count.store(0, std::memory_order_release); // i think we reset this
+    }
+
+    std::byte* recv_buffer(hndl::RecvHandle* handle) {
+        if (handle == nullptr) return nullptr;
+        // arena slots never move, buf only changes on redirect which arena handles cannot do
+        std::lock_guard lock(handle->write_mtx);
+        return handle->data.buf;
     }
 
     int32_t get_msg_label(iosb::Iosb* iosb) {
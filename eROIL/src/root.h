@@ -57,6 +57,7 @@ namespace eroil {
     void recv_resume(hndl::RecvHandle* handle);
     void recv_reset(hndl::RecvHandle* handle);
     void recv_redirect(hndl::RecvHandle* handle);
+    std::byte* recv_buffer(hndl::RecvHandle* handle);
 
     //
     // queries
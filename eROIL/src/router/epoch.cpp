@@ -0,0 +1,91 @@
+#include "epoch.h"
+#include <atomic>
+#include <limits>
+#include "safe_print.h"
+
+namespace eroil::rt::epoch {
+    namespace {
+        constexpr uint64_t IDLE = std::numeric_limits<uint64_t>::max();
+        constexpr int32_t NO_SLOT = -1;
+        constexpr int32_t SHARED_SLOT = -2;
+
+        // own cache line each so readers on different threads never write the same line
+        struct alignas(64) ReaderSlot {
+            std::atomic<uint64_t> epoch{IDLE};
+            std::atomic<bool> owned{false};
+        };
+
+        ReaderSlot g_slots[MAX_READER_SLOTS];
+        std::atomic<uint64_t> g_epoch{1};
+        alignas(64) std::atomic<uint32_t> g_shared_readers{0};
+
+        int32_t claim_slot() noexcept {
+            for (size_t i = 0; i < MAX_READER_SLOTS; ++i) {
+                bool expected = false;
+                if (g_slots[i].owned.compare_exchange_strong(expected, true, std::memory_order_acq_rel)) {
+                    return static_cast<int32_t>(i);
+                }
+            }
+
+            static std::atomic<bool> warned{false};
+            if (!warned.exchange(true, std::memory_order_relaxed)) {
+                ERR_PRINT("more than ", MAX_READER_SLOTS, " router reader threads, the rest share one slot");
+            }
+            return SHARED_SLOT;
+        }
+
+        // gives the slot back when the thread exits
+        struct ThreadReader {
+            int32_t slot = NO_SLOT;
+            uint32_t depth = 0;
+
+            ~ThreadReader() {
+                if (slot < 0) return;
+                g_slots[slot].epoch.store(IDLE, std::memory_order_release);
+                g_slots[slot].owned.store(false, std::memory_order_release);
+            }
+        };
+
+        thread_local ThreadReader t_reader;
+    }
+
+    // the slot store and the callers pointer load are both seq_cst: a writer that swapped the
+    // pointer and then saw this slot idle knows this reader will load the new pointer
+    void pin() noexcept {
+        ThreadReader& reader = t_reader;
+        if (reader.depth++ != 0) return;
+        if (reader.slot == NO_SLOT) reader.slot = claim_slot();
+
+        if (reader.slot == SHARED_SLOT) {
+            g_shared_readers.fetch_add(1, std::memory_order_seq_cst);
+            return;
+        }
+        g_slots[reader.slot].epoch.store(g_epoch.load(std::memory_order_seq_cst), std::memory_order_seq_cst);
+    }
+
+    void unpin() noexcept {
+        ThreadReader& reader = t_reader;
+        if (reader.depth == 0 || --reader.depth != 0) return;
+
+        if (reader.slot == SHARED_SLOT) {
+            g_shared_readers.fetch_sub(1, std::memory_order_release);
+            return;
+        }
+        g_slots[reader.slot].epoch.store(IDLE, std::memory_order_release);
+    }
+
+    uint64_t advance() noexcept {
+        return g_epoch.fetch_add(1, std::memory_order_seq_cst);
+    }
+
+    uint64_t oldest_pinned() noexcept {
+        if (g_shared_readers.load(std::memory_order_seq_cst) != 0) return 0;
+
+        uint64_t oldest = IDLE;
+        for (const ReaderSlot& slot : g_slots) {
+            const uint64_t pinned = slot.epoch.load(std::memory_order_seq_cst);
+            if (pinned < oldest) oldest = pinned;
+        }
+        return oldest;
+    }
+}
@@ -0,0 +1,35 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include "macros.h"
+
+namespace eroil::rt::epoch {
+    /*
+        epoch based reclamation for pointers the router publishes with an atomic store.
+        a reader pins the current epoch in its threads slot before loading the pointer and unpins
+        when done, it never waits on anyone. a writer that unpublished a pointer calls advance()
+        and frees it once oldest_pinned() is past the epoch advance() returned
+    */
+
+    // threads past this many readers share a counter that holds back all reclaiming while non zero
+    constexpr size_t MAX_READER_SLOTS = 256;
+
+    void pin() noexcept;
+    void unpin() noexcept;
+
+    // moves to the next epoch, returns the one anything unpublished before the call retires in
+    uint64_t advance() noexcept;
+
+    // lowest epoch a reader is pinned in, or UINT64_MAX when no reader is pinned
+    uint64_t oldest_pinned() noexcept;
+
+    // pins for a scope, nested guards on one thread share the outer pin
+    class Guard {
+        public:
+            Guard() noexcept { pin(); }
+            ~Guard() { unpin(); }
+
+            EROIL_NO_COPY(Guard)
+            EROIL_NO_MOVE(Guard)
+    };
+}
@@ -0,0 +1,68 @@
+#pragma once
+#include <cstdint>
+#include "types/const_types.h"
+
+namespace eroil::rt {
+    // set of node ids as one bit per node, ids outside 0..MAX_NODES-1 are never members
+    class NodeSet {
+        private:
+            static_assert(MAX_NODES <= 64, "node set is a single 64 bit word");
+            uint64_t m_bits = 0;
+
+            static uint64_t bit(NodeId id) noexcept {
+                return uint64_t{1} << static_cast<uint32_t>(id);
+            }
+
+        public:
+            static bool in_range(NodeId id) noexcept {
+                return id >= 0 && id < MAX_NODES;
+            }
+
+            // false when id is out of range or already a member
+            bool add(NodeId id) noexcept {
+                if (!in_range(id) || contains(id)) return false;
+                m_bits |= bit(id);
+                return true;
+            }
+
+            // false when id was not a member
+            bool remove(NodeId id) noexcept {
+                if (!contains(id)) return false;
+                m_bits &= ~bit(id);
+                return true;
+            }
+
+            bool contains(NodeId id) const noexcept {
+                return in_range(id) && (m_bits & bit(id)) != 0;
+            }
+
+            bool empty() const noexcept { return m_bits == 0; }
+
+            // the set as it goes over the wire, bit n is node n
+            uint64_t bits() const noexcept { return m_bits; }
+            static NodeSet from_bits(uint64_t bits) noexcept {
+                constexpr uint64_t all = ~uint64_t{0} >> (64 - MAX_NODES);
+                NodeSet set{};
+                set.m_bits = bits & all;
+                return set;
+            }
+
+            uint32_t size() const noexcept {
+                uint32_t count = 0;
+                for (uint64_t bits = m_bits; bits != 0; bits &= bits - 1) ++count;
+                return count;
+            }
+
+            // members in id order
+            template <typename Fn>
+            void for_each(Fn&& fn) const {
+                for (NodeId id = 0; id < MAX_NODES; ++id) {
+                    if ((m_bits >> static_cast<uint32_t>(id)) == 0) return;
+                    if ((m_bits & bit(id)) != 0) fn(id);
+                }
+            }
+
+            bool operator==(const NodeSet& other) const noexcept { return m_bits == other.m_bits; }
+            bool operator!=(const NodeSet& other) const noexcept { return m_bits != other.m_bits; }
+    };
+}
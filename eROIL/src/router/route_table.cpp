@@ -1,90 +1,73 @@
 #include "route_table.h"
 #include <algorithm>
+#include <chrono>
 #include "safe_print.h"
 #include "types/label_io_types.h"
 
 namespace eroil::rt {
+    uint64_t RouteTable::first_gen() noexcept {
+        const auto now = std::chrono::system_clock::now().time_since_epoch();
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(now).count());
+    }
+
     io::LabelsSnapshot RouteTable::get_send_labels_snapshot() const {
         io::LabelsSnapshot snapshot{};
-        snapshot.gen = m_send_gen.load(std::memory_order_relaxed);
+        snapshot.gen = m_send_gen;
         snapshot.labels = get_send_labels_sorted();
         return snapshot;
     }
 
     io::LabelsSnapshot RouteTable::get_recv_labels_snapshot() const {
         io::LabelsSnapshot snapshot{};
-        snapshot.gen = m_recv_gen.load(std::memory_order_relaxed);
+        snapshot.gen = m_recv_gen;
         snapshot.labels = get_recv_labels_sorted();
         return snapshot;
     }
 
-    std::array<io::LabelInfo, MAX_LABELS> RouteTable::get_send_labels() const {
-        std::array<io::LabelInfo, MAX_LABELS> labels{};
-
-        size_t index = 0;
-        for (const auto& [label, route] : m_send_routes) {
-            if (index >= MAX_LABELS) {
-                ERR_PRINT("too many send labels for broadcast message to send");
-                break;
-            }
-            labels[index].label = label;
-            labels[index].size = static_cast<uint32_t>(route.label_size);
-            index += 1;
-        }
+    std::vector<io::LabelInfo> RouteTable::get_send_labels() const {
+        std::vector<io::LabelInfo> labels{};
+        labels.reserve(m_send_routes.size());
+        m_send_routes.for_each([&labels](Label label, const SendRoute& route) {
+            io::LabelInfo& info = labels.emplace_back();
+            info.label = label;
+            info.size = static_cast<uint32_t>(route.label_size);
+        });
 
         return labels;
     }
 
-    std::array<io::LabelInfo, MAX_LABELS> RouteTable::get_recv_labels() const {
-        std::array<io::LabelInfo, MAX_LABELS> labels{};
-
-        size_t index = 0;
-        for (const auto& [label, route] : m_recv_routes) {
-            if (index >= MAX_LABELS) {
-                ERR_PRINT("too many recv labels for broadcast message to send");
-                break;
-            }
-            labels[index].label = label;
-            labels[index].size = static_cast<uint32_t>(route.label_size);
-            index += 1;
-        }
+    std::vector<io::LabelInfo> RouteTable::get_recv_labels() const {
+        std::vector<io::LabelInfo> labels{};
+        labels.reserve(m_recv_routes.size());
+        m_recv_routes.for_each([&labels](Label label, const RecvRoute& route) {
+            io::LabelInfo& info = labels.emplace_back();
+            info.label = label;
+            info.size = static_cast<uint32_t>(route.label_size);
+            info.flags = route.flags();
+        });
 
         return labels;
     }
 
-    std::array<io::LabelInfo, MAX_LABELS> RouteTable::get_send_labels_sorted() const {
-        std::array<io::LabelInfo, MAX_LABELS> labels = get_send_labels();
-        std::sort(
-            labels.begin(), 
-            labels.end(),
-            [](const io::LabelInfo& a, const io::LabelInfo& b) {
-                return a.label < b.label;
-            }
-        );
-
+    std::vector<io::LabelInfo> RouteTable::get_send_labels_sorted() const {
+        std::vector<io::LabelInfo> labels = get_send_labels();
+        std::sort(labels.begin(), labels.end());
         return labels;
     }
 
-    std::array<io::LabelInfo, MAX_LABELS> RouteTable::get_recv_labels_sorted() const {
-        std::array<io::LabelInfo, MAX_LABELS> labels = get_recv_labels();
-        std::sort(
-            labels.begin(), 
-            labels.end(),
-            [](const io::LabelInfo& a, const io::LabelInfo& b) {
-                return a.label < b.label;
-            }
-        );
-
+    std::vector<io::LabelInfo> RouteTable::get_recv_labels_sorted() const {
+        std::vector<io::LabelInfo> labels = get_recv_labels();
+        std::sort(labels.begin(), labels.end());
         return labels;
     }
 
     // send route
     void RouteTable::create_send_route(Label label, hndl::SendHandle* handle) {
-        auto [it, inserted] = m_send_routes.emplace(
+        auto [route, inserted] = m_send_routes.try_emplace(
             label,
-            SendRoute{ label, handle->data.buf_size, {}, {}, {} }
+            SendRoute{ label, handle->data.buf_size, {}, {}, {}, {}, {}, {} }
         );
-        (void)it;
+        (void)route;
 
         if (!inserted) {
             ERR_PRINT("failed to insert new send route");
@@ -157,7 +140,7 @@ namespace eroil::rt {
         return true;
     }
 
-    bool RouteTable::add_local_send_subscriber(Label label, size_t size, NodeId dst_id) {
+    bool RouteTable::add_local_send_subscriber(Label label, size_t size, NodeId dst_id, uint32_t flags) {
         SendRoute* route = get_send_route(label);
         if (route == nullptr) {
             ERR_PRINT("send route not found, label=", label);
@@ -174,7 +157,13 @@ namespace eroil::rt {
             return false;
         }
 
-        route->local_subscribers.push_back(dst_id);
+        NodeSet& set = (flags & static_cast<uint32_t>(io::LabelInfoFlag::Mailbox)) != 0 ? route->mailbox_subscribers
+                     : (flags & static_cast<uint32_t>(io::LabelInfoFlag::Arena)) != 0   ? route->arena_subscribers
+                                                                                         : route->local_subscribers;
+        if (!set.add(dst_id)) {
+            ERR_PRINT("nodeid out of range, label=", label, ", to_id=", dst_id);
+            return false;
+        }
         return true;
     }
 
@@ -185,22 +174,16 @@ namespace eroil::rt {
             return false;
         }
 
-        auto it = std::find(
-            route->local_subscribers.begin(),
-            route->local_subscribers.end(),
-            dst_id
-        );
-
-        if (it == route->local_subscribers.end()) {
-            ERR_PRINT("event not found, label=", label, ", to_id=", dst_id);
-            return false;
-        }
+        // a node is on exactly one of the local paths
+        if (route->mailbox_subscribers.remove(dst_id)) return true;
+        if (route->arena_subscribers.remove(dst_id)) return true;
+        if (route->local_subscribers.remove(dst_id)) return true;
 
-        route->local_subscribers.erase(it);
-        return true;
+        ERR_PRINT("event not found, label=", label, ", to_id=", dst_id);
+        return false;
     }
 
-    bool RouteTable::add_remote_send_subscriber(Label label, size_t size, NodeId dst_id) {
+    bool RouteTable::add_remote_send_subscriber(Label label, size_t size, NodeId dst_id, uint32_t flags) {
         SendRoute* route = get_send_route(label);
         if (route == nullptr) {
             ERR_PRINT("send route not found, label=", label);
@@ -217,7 +200,13 @@ namespace eroil::rt {
             return false;
         }
 
-        route->remote_subscribers.push_back(dst_id);
+        if (!route->remote_subscribers.add(dst_id)) {
+            ERR_PRINT("nodeid out of range, label=", label, ", to_id=", dst_id);
+            return false;
+        }
+        if ((flags & static_cast<uint32_t>(io::LabelInfoFlag::Multicast)) != 0) {
+            route->mcast_subscribers.add(dst_id);
+        }
         return true;
     }
 
@@ -228,35 +217,24 @@ namespace eroil::rt {
             return false;
         }
 
-        auto it = std::find(
-            route->remote_subscribers.begin(),
-            route->remote_subscribers.end(),
-            dst_id
-        );
-
-        if (it == route->remote_subscribers.end()) {
+        if (!route->remote_subscribers.remove(dst_id)) {
             ERR_PRINT("not a remote send subscriber, label=", label, ", to_id=", dst_id);
             return false;
         }
-        route->remote_subscribers.erase(it);
+        route->mcast_subscribers.remove(dst_id);
         return true;
     }
 
     const SendRoute* RouteTable::get_send_route(Label label) const noexcept {
-        auto it = m_send_routes.find(label);
-        if (it == m_send_routes.end()) return nullptr;
-        return &it->second;
+        return m_send_routes.find(label);
     }
 
-    SendRoute* RouteTable::get_send_route(Label label) noexcept {
-        auto it = m_send_routes.find(label);
-        if (it == m_send_routes.end()) return nullptr;
-        return &it->second;
+    SendRoute* RouteTable::get_send_route(Label label) {
+        return m_send_routes.find_mut(label);
     }
     
     bool RouteTable::has_send_route(Label label) const noexcept {
-        auto it = m_send_routes.find(label);
-        return it != m_send_routes.end();
+        return m_send_routes.contains(label);
     }
 
     bool RouteTable::is_send_publisher(Label label, handle_uid uid) const noexcept {
@@ -274,36 +252,39 @@ namespace eroil::rt {
     bool RouteTable::is_local_send_subscriber(Label label, NodeId dst_id) const noexcept {
         const SendRoute* route = get_send_route(label);
         if (route == nullptr) return false;
-        if (route->local_subscribers.empty()) return false;
+        return route->local_subscribers.contains(dst_id) ||
+               route->mailbox_subscribers.contains(dst_id) ||
+               route->arena_subscribers.contains(dst_id);
+    }
 
-        auto it = std::find(
-            route->local_subscribers.begin(),
-            route->local_subscribers.end(),
-            dst_id
-        );
-        return it != route->local_subscribers.end();
+    uint32_t RouteTable::local_send_flags(Label label, NodeId dst_id) const noexcept {
+        const SendRoute* route = get_send_route(label);
+        if (route == nullptr) return 0;
+        if (route->mailbox_subscribers.contains(dst_id)) return static_cast<uint32_t>(io::LabelInfoFlag::Mailbox);
+        if (route->arena_subscribers.contains(dst_id)) return static_cast<uint32_t>(io::LabelInfoFlag::Arena);
+        return 0;
     }
 
     bool RouteTable::is_remote_send_subscriber(Label label, NodeId dst_id) const noexcept {
         const SendRoute* route = get_send_route(label);
         if (route == nullptr) return false;
-        if (route->remote_subscribers.empty()) return false;
+        return route->remote_subscribers.contains(dst_id);
+    }
 
-        auto it = std::find(
-            route->remote_subscribers.begin(),
-            route->remote_subscribers.end(),
-            dst_id
-        );
-        return it != route->remote_subscribers.end();
+    uint32_t RouteTable::remote_send_flags(Label label, NodeId dst_id) const noexcept {
+        const SendRoute* route = get_send_route(label);
+        if (route == nullptr) return 0;
+        if (route->mcast_subscribers.contains(dst_id)) return static_cast<uint32_t>(io::LabelInfoFlag::Multicast);
+        return 0;
     }
 
     // recv route
     void RouteTable::create_recv_route(Label label, hndl::RecvHandle* handle) {
-        auto [it, inserted] = m_recv_routes.emplace(
+        auto [route, inserted] = m_recv_routes.try_emplace(
             label,
-            RecvRoute{ label, handle->data.buf_size, {} }
+            RecvRoute{ label, handle->data.buf_size, {}, {}, {} }
         );
-        (void)it;
+        (void)route;
 
         if (!inserted) {
             ERR_PRINT("failed to insert new recv route");
@@ -344,7 +325,16 @@ namespace eroil::rt {
             return false;
         }
 
+        // a subscriber that needs the ring takes the label back off the mailbox/arena, tell publishers
+        const uint32_t was_flags = route->flags();
         route->subscribers.push_back(handle->uid);
+        if (handle->mailbox != nullptr) {
+            route->mailbox_subscribers.push_back(handle->uid);
+        }
+        if (handle->arena != nullptr) {
+            route->arena_subscribers.push_back(handle->uid);
+        }
+        if (was_flags != route->flags()) ++m_recv_gen;
         return true;
     }
     
@@ -366,31 +356,37 @@ namespace eroil::rt {
             return false;
         }
 
+        const uint32_t was_flags = route->flags();
         route->subscribers.erase(it);
+        route->mailbox_subscribers.erase(
+            std::remove(route->mailbox_subscribers.begin(), route->mailbox_subscribers.end(), uid),
+            route->mailbox_subscribers.end()
+        );
+        route->arena_subscribers.erase(
+            std::remove(route->arena_subscribers.begin(), route->arena_subscribers.end(), uid),
+            route->arena_subscribers.end()
+        );
 
         if (route->subscribers.empty()) {
             m_recv_routes.erase(label);
             ++m_recv_gen;
+        } else if (was_flags != route->flags()) {
+            ++m_recv_gen;
         }
 
         return true;
     }
 
     const RecvRoute* RouteTable::get_recv_route(Label label) const noexcept {
-        auto it = m_recv_routes.find(label);
-        if (it == m_recv_routes.end()) return nullptr;
-        return &it->second;
+        return m_recv_routes.find(label);
     }
 
-    RecvRoute* RouteTable::get_recv_route(Label label) noexcept {
-        auto it = m_recv_routes.find(label);
-        if (it == m_recv_routes.end()) return nullptr;
-        return &it->second;
+    RecvRoute* RouteTable::get_recv_route(Label label) {
+        return m_recv_routes.find_mut(label);
     }
     
     bool RouteTable::has_recv_route(Label label) const noexcept {
-        auto it = m_recv_routes.find(label);
-        return it != m_recv_routes.end();
+        return m_recv_routes.contains(label);
     }
 
     bool RouteTable::is_recv_subscriber(Label label, handle_uid uid) const noexcept {
@@ -407,21 +403,21 @@ namespace eroil::rt {
 
     std::vector<handle_uid>
     RouteTable::snapshot_send_publishers(Label label) const {
-        auto it = m_send_routes.find(label);
-        if (it == m_send_routes.end()) {
+        const SendRoute* route = get_send_route(label);
+        if (route == nullptr) {
             ERR_PRINT("send route not found, label=", label);
             return {};
         }
-        return it->second.publishers;
+        return route->publishers;
     }
 
     std::vector<handle_uid>
     RouteTable::snapshot_recv_subscribers(Label label) const {
-        auto it = m_recv_routes.find(label);
-        if (it == m_recv_routes.end()) {
+        const RecvRoute* route = get_recv_route(label);
+        if (route == nullptr) {
             ERR_PRINT("recv route not found, label=", label);
             return {};
         }
-        return it->second.subscribers;
+        return route->subscribers;
     }
 }
@@ -4,11 +4,12 @@
 #include <optional>
 #include <cstddef>
 #include <variant>
-#include <atomic>
 
 #include "types/const_types.h"
 #include "types/handles.h"
 #include "types/label_io_types.h"
+#include "sharded_map.h"
+#include "node_set.h"
 #include "macros.h"
 
 namespace eroil::rt {
@@ -16,23 +17,47 @@ namespace eroil::rt {
         Label label;
         size_t label_size;
         std::vector<handle_uid> publishers;
-        std::vector<NodeId> remote_subscribers;
-        std::vector<NodeId> local_subscribers;
+        NodeSet remote_subscribers;
+        NodeSet mcast_subscribers;      // subset of remote_subscribers listening on the labels multicast group
+        NodeSet local_subscribers;
+        NodeSet mailbox_subscribers;    // local nodes reading the label's shm mailbox instead of their ring
+        NodeSet arena_subscribers;      // local nodes whose subscribers take the label in their shm arena
     };
 
     struct RecvRoute {
         Label label;
         size_t label_size;
         std::vector<handle_uid> subscribers;
+        std::vector<handle_uid> mailbox_subscribers;    // subscribers that pull the shm mailbox
+        std::vector<handle_uid> arena_subscribers;      // subscribers whose slots live in our shm arena
+
+        // publishers on this host may skip our ring only if nobody here needs every message
+        bool mailbox_only() const noexcept {
+            return !subscribers.empty() && mailbox_subscribers.size() == subscribers.size();
+        }
+
+        // or if every subscriber here takes the label straight into its arena slots
+        bool arena_only() const noexcept {
+            return !subscribers.empty() && arena_subscribers.size() == subscribers.size();
+        }
+
+        // io::LabelInfoFlag bits advertised for this label
+        uint32_t flags() const noexcept {
+            if (mailbox_only()) return static_cast<uint32_t>(io::LabelInfoFlag::Mailbox);
+            if (arena_only()) return static_cast<uint32_t>(io::LabelInfoFlag::Arena);
+            return 0;
+        }
     };
 
     class RouteTable {
         private:
-            std::unordered_map<Label, SendRoute> m_send_routes;
-            std::unordered_map<Label, RecvRoute> m_recv_routes;
+            ShardedMap<Label, SendRoute> m_send_routes;
+            ShardedMap<Label, RecvRoute> m_recv_routes;
 
-            std::atomic<uint64_t> m_send_gen{1};
-            std::atomic<uint64_t> m_recv_gen{1};
+            // seeded from the wall clock so a restarted node never reuses a gen its peers remember
+            static uint64_t first_gen() noexcept;
+            uint64_t m_send_gen{first_gen()};
+            uint64_t m_recv_gen{first_gen()};
 
             void create_send_route(Label label, hndl::SendHandle* handle);
             void create_recv_route(Label label, hndl::RecvHandle* handle);
@@ -41,40 +66,50 @@ namespace eroil::rt {
             RouteTable() = default;
             ~RouteTable() = default;
 
-            EROIL_NO_COPY(RouteTable)
+            // the router copies the table for every version it publishes, copies share unchanged routes
+            EROIL_DEFAULT_COPY(RouteTable)
             EROIL_NO_MOVE(RouteTable)
 
             io::LabelsSnapshot get_send_labels_snapshot() const;
             io::LabelsSnapshot get_recv_labels_snapshot() const;
-            std::array<io::LabelInfo, MAX_LABELS> get_send_labels() const;
-            std::array<io::LabelInfo, MAX_LABELS> get_recv_labels() const;
-            std::array<io::LabelInfo, MAX_LABELS> get_send_labels_sorted() const;
-            std::array<io::LabelInfo, MAX_LABELS> get_recv_labels_sorted() const;
+            std::vector<io::LabelInfo> get_send_labels() const;
+            std::vector<io::LabelInfo> get_recv_labels() const;
+            std::vector<io::LabelInfo> get_send_labels_sorted() const;
+            std::vector<io::LabelInfo> get_recv_labels_sorted() const;
+            size_t send_label_count() const noexcept { return m_send_routes.size(); }
+            size_t recv_label_count() const noexcept { return m_recv_routes.size(); }
+            uint64_t recv_gen() const noexcept { return m_recv_gen; }
 
             // send route ops
             bool add_send_publisher(Label label, hndl::SendHandle* handle);
             bool remove_send_publisher(Label label, handle_uid uid);
 
-            bool add_local_send_subscriber(Label label, size_t size, NodeId dst_id);
-            bool add_remote_send_subscriber(Label label, size_t size, NodeId dst_id);
+            // flags picks the path: io::LabelInfoFlag::Mailbox, ::Arena or 0 for the nodes ring
+            bool add_local_send_subscriber(Label label, size_t size, NodeId dst_id, uint32_t flags);
+            // flags io::LabelInfoFlag::Multicast when the node also listens on the labels multicast group
+            bool add_remote_send_subscriber(Label label, size_t size, NodeId dst_id, uint32_t flags);
             
             bool remove_local_send_subscriber(Label label, NodeId dst_id);
             bool remove_remote_send_subscriber(Label label, NodeId dst_id);
 
             const SendRoute* get_send_route(Label label) const noexcept;
-            SendRoute* get_send_route(Label label) noexcept;
+            // non const getters unshare the route from other copies of the table
+            SendRoute* get_send_route(Label label);
 
             bool has_send_route(Label label) const noexcept;
             bool is_send_publisher(Label label, handle_uid uid) const noexcept;
             bool is_local_send_subscriber(Label label, NodeId dst_id) const noexcept;
+            // path a local subscriber was added with, see add_local_send_subscriber
+            uint32_t local_send_flags(Label label, NodeId dst_id) const noexcept;
             bool is_remote_send_subscriber(Label label, NodeId dst_id) const noexcept;
+            uint32_t remote_send_flags(Label label, NodeId dst_id) const noexcept;
 
             // recv route ops
             bool add_recv_subscriber(Label label, hndl::RecvHandle* handle);
             bool remove_recv_subscriber(Label label, handle_uid uid);
 
             const RecvRoute* get_recv_route(Label label) const noexcept;
-            RecvRoute* get_recv_route(Label label) noexcept;
+            RecvRoute* get_recv_route(Label label);
 
             bool has_recv_route(Label label) const noexcept;
             bool is_recv_subscriber(Label label, handle_uid id) const noexcept;
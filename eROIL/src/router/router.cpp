@@ -6,41 +6,85 @@
 #include "safe_print.h"
 #include <algorithm>
 #include "comm/write_iosb.h"
+#include "workers/mcast_data.h"
+#include "address/address.h"
+#include "memory/copy.h"
 #include "assertion.h"
+#include "epoch.h"
 
 namespace eroil::rt {
+    Router::Router() : m_state{new RouterState{}} {}
+
+    Router::~Router() {
+        // nothing reads the router once it is being destroyed
+        delete m_state.load(std::memory_order_acquire);
+        for (auto& [retired_epoch, old] : m_retired) {
+            (void)retired_epoch;
+            delete old;
+        }
+    }
+
+    // versions
+    const RouterState& Router::state() const noexcept {
+        // seq_cst pairs with the epoch pin, see epoch::pin
+        return *m_state.load(std::memory_order_seq_cst);
+    }
+
+    std::unique_ptr<RouterState> Router::draft() const {
+        return std::make_unique<RouterState>(*m_state.load(std::memory_order_relaxed));
+    }
+
+    void Router::publish(std::unique_ptr<RouterState> next) {
+        const RouterState* old = m_state.exchange(next.release(), std::memory_order_seq_cst);
+        m_retired.emplace_back(epoch::advance(), old);
+        reclaim();
+    }
+
+    void Router::reclaim() {
+        const uint64_t oldest = epoch::oldest_pinned();
+        auto keep = std::remove_if(m_retired.begin(), m_retired.end(), [oldest](const auto& retired) {
+            if (retired.first >= oldest) return false;
+            delete retired.second;
+            return true;
+        });
+        m_retired.erase(keep, m_retired.end());
+    }
+
     // open/close send/recv
     void Router::register_send_publisher(std::shared_ptr<hndl::SendHandle> handle) {
         if (!handle) return;
 
-        std::unique_lock lock(m_router_mtx);
+        std::lock_guard lock(m_write_mtx);
+        std::unique_ptr<RouterState> next = draft();
 
         const handle_uid uid = handle->uid;
         const Label label = handle->data.label;
 
         // store handle
-        auto [_, inserted] = m_send_handles.try_emplace(uid, std::move(handle));
+        auto [stored, inserted] = next->send_handles.try_emplace(uid, std::move(handle));
         if (!inserted) {
             ERR_PRINT("duplicate send handle uid=", uid);
             return;
         }
 
         // add handle to route
-        hndl::SendHandle* ptr = m_send_handles[uid].get();
-        if (!m_routes.add_send_publisher(label, ptr)) {
+        if (!next->routes.add_send_publisher(label, stored->get())) {
             ERR_PRINT("failed to add handle to send route=", label);
-            m_send_handles.erase(uid);
+            return;
         }
+
+        publish(std::move(next));
     }
 
     void Router::unregister_send_publisher(const hndl::SendHandle* handle) {
         if (!handle) return;
 
-        std::unique_lock lock(m_router_mtx);
+        std::lock_guard lock(m_write_mtx);
+        std::unique_ptr<RouterState> next = draft();
 
         // validate pointer still matches uid
-        auto it = m_send_handles.find(handle->uid);
-        if (it == m_send_handles.end() || it->second.get() != handle) {
+        const auto* stored = next->send_handles.find(handle->uid);
+        if (stored == nullptr || stored->get() != handle) {
             ERR_PRINT("invalid SendHandle*");
             return;
         }
@@ -49,13 +93,15 @@ namespace eroil::rt {
         const handle_uid uid = handle->uid;
 
         // erase handle first
-        m_send_handles.erase(it);
+        next->send_handles.erase(uid);
 
         // remove from route table (removes uid from publishers; may delete route if unused)
-        if (!m_routes.remove_send_publisher(label, uid)) {
+        if (!next->routes.remove_send_publisher(label, uid)) {
             ERR_PRINT("route table did not contain publisher uid=", uid, " label=", label);
             // continue anyway
         }
+
+        publish(std::move(next));
     }
 
     void Router::register_recv_subscriber(std::shared_ptr<hndl::RecvHandle> handle) {
@@ -64,32 +110,39 @@ namespace eroil::rt {
             return;
         }
 
-        std::unique_lock lock(m_router_mtx);
+        std::lock_guard lock(m_write_mtx);
+        std::unique_ptr<RouterState> next = draft();
 
         const handle_uid uid = handle->uid;
         const Label label = handle->data.label;
 
-        auto [_, h_inserted] = m_recv_handles.try_emplace(uid, std::move(handle));
+        auto [stored, h_inserted] = next->recv_handles.try_emplace(uid, std::move(handle));
         if (!h_inserted) {
             ERR_PRINT("duplicate recv handle uid=", uid);
             return;
         }
 
         // update routes
-        hndl::RecvHandle* ptr = m_recv_handles[uid].get();
-        if (!m_routes.add_recv_subscriber(label, ptr)) {
+        if (!next->routes.add_recv_subscriber(label, stored->get())) {
             ERR_PRINT("failed to add handle to recv route=", label);
-            m_recv_handles.erase(uid);
+            return;
         }
+
+        if ((*stored)->arena != nullptr) {
+            next->arena_handles.push_back(*stored);
+        }
+
+        publish(std::move(next));
     }
 
     void Router::unregister_recv_subscriber(const hndl::RecvHandle* handle) {
         if (!handle) return;
 
-        std::unique_lock lock(m_router_mtx);
+        std::lock_guard lock(m_write_mtx);
+        std::unique_ptr<RouterState> next = draft();
 
-        auto it = m_recv_handles.find(handle->uid);
-        if (it == m_recv_handles.end() || it->second.get() != handle) {
+        const auto* stored = next->recv_handles.find(handle->uid);
+        if (stored == nullptr || stored->get() != handle) {
             ERR_PRINT("invalid RecvHandle*");
             return;
         }
@@ -97,136 +150,267 @@ namespace eroil::rt {
         const handle_uid uid = handle->uid;
         const Label label = handle->data.label;
 
-        m_recv_handles.erase(uid);
+        // publishers stop writing the entry once it is released, its slots go back to the arena
+        if (handle->arena != nullptr) {
+            handle->arena->release(handle->arena_entry);
+            next->arena_handles.erase(
+                std::remove(next->arena_handles.begin(), next->arena_handles.end(), *stored),
+                next->arena_handles.end()
+            );
+        }
+
+        next->recv_handles.erase(uid);
 
-        if (!m_routes.remove_recv_subscriber(label, uid)) {
+        if (!next->routes.remove_recv_subscriber(label, uid)) {
             ERR_PRINT("route table did not contain subscriber uid=", uid, " label=", label);
         }
+
+        publish(std::move(next));
     }
 
     hndl::SendHandle* Router::get_send_handle(handle_uid uid) {
-        std::shared_lock lock(m_router_mtx);
-        auto it = m_send_handles.find(uid);
-        if (it == m_send_handles.end()) {
+        epoch::Guard guard;
+        const auto* stored = state().send_handles.find(uid);
+        if (stored == nullptr) {
             return nullptr;
         }
-        return it->second.get();
+        return stored->get();
     }
 
     hndl::RecvHandle* Router::get_recv_handle(handle_uid uid) {
-        std::shared_lock lock(m_router_mtx);
-        auto it = m_recv_handles.find(uid);
-        if (it == m_recv_handles.end()) {
+        epoch::Guard guard;
+        const auto* stored = state().recv_handles.find(uid);
+        if (stored == nullptr) {
             return nullptr;
         }
-        return it->second.get();
+        return stored->get();
     }
 
     // route interface
-    void Router::add_local_send_subscriber(Label label, size_t size, NodeId dst_id) {
-        std::unique_lock lock(m_router_mtx);
-
-        if (!m_transports.has_send_shm(dst_id)) {
-            LOG("cannot not add local subscriber, shm send to nodeid=", dst_id, " has not yet been established");
-            return;
+    SubscriberChanges Router::update_send_subscribers(const NodeId dst_id,
+                                                      const NodeId via_id,
+                                                      const bool local,
+                                                      const std::vector<io::LabelInfo>& add,
+                                                      const std::vector<io::LabelInfo>& remove) {
+        SubscriberChanges changes{};
+        std::lock_guard lock(m_write_mtx);
+        std::unique_ptr<RouterState> next = draft();
+        RouteTable& routes = next->routes;
+
+        for (const io::LabelInfo& info : remove) {
+            if (local) {
+                if (!routes.is_local_send_subscriber(info.label, dst_id)) continue;
+                routes.remove_local_send_subscriber(info.label, dst_id);
+            } else {
+                if (!routes.is_remote_send_subscriber(info.label, dst_id)) continue;
+                routes.remove_remote_send_subscriber(info.label, dst_id);
+            }
+            changes.removed.push_back(info.label);
         }
 
-        if (!m_routes.add_local_send_subscriber(label, size, dst_id)) {
-            ERR_PRINT("failed to add local send subscriber for label=", label, " to_id=", dst_id);
-            return;
-        }
-    }
+        const uint32_t path_flags = local ? static_cast<uint32_t>(io::LabelInfoFlag::Mailbox) |
+                                            static_cast<uint32_t>(io::LabelInfoFlag::Arena)
+                                          : static_cast<uint32_t>(io::LabelInfoFlag::Multicast);
+
+        // a remote node behind a host gateway is reached through its gateways socket, or
+        // off our own gateway through the shm block to that
+        const bool reachable = local ? next->transports.has_send_shm(via_id)
+                                     : next->transports.has_socket(via_id) || next->transports.has_send_shm(via_id);
+        for (const io::LabelInfo& info : add) {
+            // if we do not send this label, ignore it
+            if (!routes.has_send_route(info.label)) continue;
+
+            // local subscribers move between their ring, the mailbox and their arena as their handles change,
+            // remote ones on and off the multicast group
+            const uint32_t flags = info.flags & path_flags;
+            if (local && routes.is_local_send_subscriber(info.label, dst_id)) {
+                if (routes.local_send_flags(info.label, dst_id) == flags) continue;
+                routes.remove_local_send_subscriber(info.label, dst_id);
+            }
+            if (!local && routes.is_remote_send_subscriber(info.label, dst_id)) {
+                if (routes.remote_send_flags(info.label, dst_id) == flags) continue;
+                routes.remove_remote_send_subscriber(info.label, dst_id);
+            }
 
-    void Router::add_remote_send_subscriber(Label label, size_t label_size, NodeId to_id) {
-        std::unique_lock lock(m_router_mtx);
+            if (!reachable) {
+                changes.failed += 1;
+                continue;
+            }
 
-        if (!m_transports.has_socket(to_id)) {
-            LOG("cannot add remote subscriber, socket to nodeid=", to_id, " is disconnected or not yet established");
-            return;
+            const bool added = local ? add_local_send_subscriber(*next, info.label, info.size, dst_id, flags)
+                                     : routes.add_remote_send_subscriber(info.label, info.size, dst_id, flags);
+            if (!added) {
+                ERR_PRINT("failed to add send subscriber for label=", info.label, " to_id=", dst_id);
+                continue;
+            }
+            changes.added.push_back(info.label);
         }
 
-        if (!m_routes.add_remote_send_subscriber(label, label_size, to_id)) {
-            ERR_PRINT("failed to add remote send subscriber for label=", label, " to_id=", to_id);
-            return;
+        if (!changes.added.empty() || !changes.removed.empty()) {
+            publish(std::move(next));
         }
+        return changes;
     }
 
-    void Router::remove_local_send_subscriber(Label label, NodeId dst_id) {
-        std::unique_lock lock(m_router_mtx);
-        m_routes.remove_local_send_subscriber(label, dst_id);
-    }
+    // caller holds m_write_mtx, state is the unpublished draft
+    bool Router::add_local_send_subscriber(RouterState& state, Label label, size_t size, NodeId dst_id, uint32_t flags) {
+        // subscriber asked for the mailbox or its arena, keep using its ring if we cannot open it
+        const uint32_t mailbox = static_cast<uint32_t>(io::LabelInfoFlag::Mailbox);
+        const uint32_t arena = static_cast<uint32_t>(io::LabelInfoFlag::Arena);
+        if ((flags & mailbox) != 0 && state.transports.open_mailbox(label, size) == nullptr) {
+            LOG("mailbox for label=", label, " unavailable, local subscriber nodeid=", dst_id, " stays on the ring");
+            flags &= ~mailbox;
+        }
+        if ((flags & arena) != 0 && state.transports.open_peer_arena(dst_id) == nullptr) {
+            LOG("arena of nodeid=", dst_id, " unavailable, local subscriber for label=", label, " stays on the ring");
+            flags &= ~arena;
+        }
 
-    void Router::remove_remote_send_subscriber(Label label, NodeId dst_id) {
-        std::unique_lock lock(m_router_mtx);
-        m_routes.remove_remote_send_subscriber(label, dst_id);
+        return state.routes.add_local_send_subscriber(label, size, dst_id, flags);
     }
 
     io::LabelsSnapshot Router::get_send_labels_snapshot() const {
-        std::shared_lock lock(m_router_mtx);
-        return m_routes.get_send_labels_snapshot();
+        epoch::Guard guard;
+        return state().routes.get_send_labels_snapshot();
     }
 
     io::LabelsSnapshot Router::get_recv_labels_snapshot() const {
-        std::shared_lock lock(m_router_mtx);
-        return m_routes.get_recv_labels_snapshot();
+        epoch::Guard guard;
+        return state().routes.get_recv_labels_snapshot();
+    }
+
+    std::vector<io::LabelInfo> Router::get_send_labels() const {
+        epoch::Guard guard;
+        return state().routes.get_send_labels();
+    }
+
+    size_t Router::send_label_count() const noexcept {
+        epoch::Guard guard;
+        return state().routes.send_label_count();
     }
 
-    std::array<io::LabelInfo, MAX_LABELS> Router::get_send_labels() const {
-        std::shared_lock lock(m_router_mtx);
-        return m_routes.get_send_labels();
+    size_t Router::recv_label_count() const noexcept {
+        epoch::Guard guard;
+        return state().routes.recv_label_count();
+    }
+
+    uint64_t Router::recv_gen() const noexcept {
+        epoch::Guard guard;
+        return state().routes.recv_gen();
     }
 
     bool Router::has_send_route(Label label) const noexcept {
-        std::shared_lock lock(m_router_mtx);
-        return m_routes.has_send_route(label);
+        epoch::Guard guard;
+        return state().routes.has_send_route(label);
     }
 
     bool Router::has_recv_route(Label label) const noexcept {
-        std::shared_lock lock(m_router_mtx);
-        return m_routes.has_recv_route(label);
+        epoch::Guard guard;
+        return state().routes.has_recv_route(label);
     }
 
-    bool Router::is_send_subscriber(Label label, NodeId to_id) const noexcept {
-        std::shared_lock lock(m_router_mtx);
-        if (m_routes.is_remote_send_subscriber(label, to_id)) {
-            return true;
-        }
-        return m_routes.is_local_send_subscriber(label, to_id);
+    bool Router::upsert_socket(NodeId id, std::shared_ptr<sock::TCPClient> sock) {
+        std::lock_guard lock(m_write_mtx);
+        std::unique_ptr<RouterState> next = draft();
+        if (!next->transports.upsert_socket(id, std::move(sock))) return false;
+        publish(std::move(next));
+        return true;
     }
 
-    bool Router::upsert_socket(NodeId id, std::shared_ptr<sock::TCPClient> sock) {
-        std::unique_lock lock(m_router_mtx);
-        return m_transports.upsert_socket(id, std::move(sock));
+    bool Router::upsert_sockets(NodeId id, std::vector<std::shared_ptr<sock::TCPClient>> socks) {
+        std::lock_guard lock(m_write_mtx);
+        std::unique_ptr<RouterState> next = draft();
+        if (!next->transports.upsert_sockets(id, std::move(socks))) return false;
+        publish(std::move(next));
+        return true;
     }
 
     std::shared_ptr<sock::TCPClient> Router::get_socket(NodeId id) const noexcept {
-        std::shared_lock lock(m_router_mtx);
-        return m_transports.get_socket(id);
+        epoch::Guard guard;
+        return state().transports.get_socket(id);
+    }
+
+    std::shared_ptr<sock::TCPClient> Router::get_socket(NodeId id, uint32_t stripe) const noexcept {
+        epoch::Guard guard;
+        return state().transports.get_socket(id, stripe);
+    }
+
+    std::vector<std::shared_ptr<sock::TCPClient>> Router::get_sockets(NodeId id) const {
+        epoch::Guard guard;
+        return state().transports.get_sockets(id);
+    }
+
+    void Router::set_tcp_stripes(uint32_t stripes) noexcept {
+        m_tcp_stripes.store(std::clamp<uint32_t>(stripes, 1, MAX_TCP_STRIPES), std::memory_order_relaxed);
+    }
+
+    uint32_t Router::tcp_stripe(Label label, size_t label_size) const noexcept {
+        const uint32_t stripes = m_tcp_stripes.load(std::memory_order_relaxed);
+        if (stripes < 2 || label_size < TCP_STRIPE_BULK_SIZE) return 0;
+
+        // fibonacci hash so neighbouring label ids land on different stripes
+        const uint32_t hash = static_cast<uint32_t>(label) * 2654435761u;
+        return 1 + (hash >> 16) % (stripes - 1);
     }
 
     bool Router::has_socket(NodeId id) const noexcept {
-        std::shared_lock lock(m_router_mtx);
-        return m_transports.has_socket(id);
+        epoch::Guard guard;
+        return state().transports.has_socket(id);
     }
 
-    bool Router::open_send_shm(NodeId dst_id) {
-        std::unique_lock lock(m_router_mtx);
-        return m_transports.open_send_shm(dst_id);
+    bool Router::open_send_shm(NodeId src_id, NodeId dst_id, bool checksum) {
+        std::lock_guard lock(m_write_mtx);
+        if (m_state.load(std::memory_order_relaxed)->transports.has_send_shm(dst_id)) return true;
+
+        std::unique_ptr<RouterState> next = draft();
+        if (!next->transports.open_send_shm(src_id, dst_id, checksum)) return false;
+        publish(std::move(next));
+        return true;
     }
 
     std::shared_ptr<shm::ShmSend> Router::get_send_shm(NodeId dst_id) const noexcept {
-        std::shared_lock lock(m_router_mtx);
-        return m_transports.get_send_shm(dst_id);
+        epoch::Guard guard;
+        return state().transports.get_send_shm(dst_id);
     }
 
-    bool Router::open_recv_shm(NodeId my_id) {
-        std::unique_lock lock(m_router_mtx);
-        return m_transports.open_recv_shm(my_id);
+    bool Router::open_recv_shm(NodeId my_id, size_t ring_size, uint32_t lane_count) {
+        std::lock_guard lock(m_write_mtx);
+        if (m_state.load(std::memory_order_relaxed)->transports.get_recv_shm() != nullptr) return true;
+
+        std::unique_ptr<RouterState> next = draft();
+        if (!next->transports.open_recv_shm(my_id, ring_size, lane_count)) return false;
+        publish(std::move(next));
+        return true;
     }
 
     std::shared_ptr<shm::ShmRecv> Router::get_recv_shm() const noexcept {
-        std::shared_lock lock(m_router_mtx);
-        return m_transports.get_recv_shm();
+        epoch::Guard guard;
+        return state().transports.get_recv_shm();
+    }
+
+    std::shared_ptr<shm::ShmMailbox> Router::open_mailbox(Label label, size_t label_size) {
+        std::lock_guard lock(m_write_mtx);
+        std::unique_ptr<RouterState> next = draft();
+        const bool existed = next->transports.get_mailbox(label) != nullptr;
+        std::shared_ptr<shm::ShmMailbox> mailbox = next->transports.open_mailbox(label, label_size);
+        if (mailbox != nullptr && !existed) publish(std::move(next));
+        return mailbox;
+    }
+
+    std::shared_ptr<shm::ShmArena> Router::open_arena(NodeId my_id, size_t size) {
+        std::lock_guard lock(m_write_mtx);
+        std::unique_ptr<RouterState> next = draft();
+        const bool existed = next->transports.get_arena() != nullptr;
+        std::shared_ptr<shm::ShmArena> arena = next->transports.open_arena(my_id, size);
+        if (arena != nullptr && !existed) publish(std::move(next));
+        return arena;
+    }
+
+    void Router::set_mcast(std::shared_ptr<wrk::McastData> mcast) {
+        std::lock_guard lock(m_write_mtx);
+        std::unique_ptr<RouterState> next = draft();
+        next->transports.set_mcast(std::move(mcast));
+        publish(std::move(next));
     }
 
     std::pair<io::SendJobErr, std::shared_ptr<io::SendJob>> 
@@ -237,11 +421,15 @@ namespace eroil::rt {
         job->label = label;
         job->seq = seq.fetch_add(1, std::memory_order_relaxed);
 
+        NodeSet relay_dests{};
+        std::vector<std::shared_ptr<sock::TCPClient>> relay_socks{};
+        std::vector<std::shared_ptr<shm::ShmSend>> relay_shm{};
         {
-            std::shared_lock lock(m_router_mtx);
+            epoch::Guard guard;
+            const RouterState& current = state();
             DB_ASSERT(job->send_buffer.total_size <= MAX_LABEL_SIZE, "label too large to send");
 
-            const SendRoute* route = m_routes.get_send_route(label);
+            const SendRoute* route = current.routes.get_send_route(label);
             if (route == nullptr) {
                 ERR_PRINT("no route for label=", label);
                 return { io::SendJobErr::RouteNotFound, job };
@@ -253,13 +441,13 @@ namespace eroil::rt {
                 return { io::SendJobErr::SizeMismatch, job };
             }
 
-            auto handle_it = m_send_handles.find(uid);
-            if (handle_it == m_send_handles.end()) {
+            const auto* publisher = current.send_handles.find(uid);
+            if (publisher == nullptr) {
                 ERR_PRINT("got handle uid that does not match any known send handles, uid=", uid);
                 return { io::SendJobErr::UnknownHandle, job };
             }
 
-            std::vector<handle_uid> uids = m_routes.snapshot_send_publishers(label);
+            const std::vector<handle_uid>& uids = route->publishers;
             if (uids.empty()) {
                 ERR_PRINT("no send publishers for label=", label);
                 return { io::SendJobErr::NoPublishers, job };
@@ -277,33 +465,115 @@ namespace eroil::rt {
             }
 
             // store publisher
-            job->publisher = handle_it->second;
+            job->publisher = *publisher;
+            job->stripe = tcp_stripe(label, route->label_size);
 
             // snapshot local subs
             if (!route->local_subscribers.empty()) {
                 job->local_recvrs.reserve(route->local_subscribers.size());
-                for (const NodeId local : route->local_subscribers) {
+                route->local_subscribers.for_each([&](const NodeId local) {
                     job->local_recvrs.push_back(
-                        m_transports.get_send_shm(local)
+                        current.transports.get_send_shm(local)
                     );
-                }
+                });
             }
             
+            // every local mailbox reader shares one block, written once by the caller
+            if (!route->mailbox_subscribers.empty()) {
+                job->mailbox = current.transports.get_mailbox(label);
+            }
+
+            // arena subscribers get the payload written straight into their slots by the caller
+            if (!route->arena_subscribers.empty()) {
+                job->arenas.reserve(route->arena_subscribers.size());
+                route->arena_subscribers.for_each([&](const NodeId local) {
+                    job->arenas.push_back(
+                        current.transports.get_peer_arena(local)
+                    );
+                });
+            }
+
+            // every remote subscriber sits behind a host gateway, one wrapped frame goes to the gateways
+            if (!route->remote_subscribers.empty() && addr::host_gateways()) {
+                relay_dests = route->remote_subscribers;
+                if (addr::gateway_of(my_id) == my_id) {
+                    NodeSet hops{};
+                    relay_dests.for_each([&](const NodeId remote) { hops.add(addr::gateway_of(remote)); });
+                    hops.for_each([&](const NodeId gateway) {
+                        relay_socks.push_back(current.transports.get_socket(gateway, job->stripe));
+                    });
+                } else {
+                    relay_shm.push_back(current.transports.get_send_shm(addr::gateway_of(my_id)));
+                }
+            }
+
+            // enough remote subscribers listen on the labels group, one multicast send stands in for their sockets.
+            // the gateways already carry it to every remote subscriber, multicast would deliver it twice
+            bool mcast = false;
+            if (!route->mcast_subscribers.empty() && relay_dests.empty()) {
+                std::shared_ptr<wrk::McastData> plane = current.transports.get_mcast();
+                if (plane != nullptr && route->mcast_subscribers.size() >= plane->min_subscribers()) {
+                    job->mcast_recvrs.push_back(std::move(plane));
+                    mcast = true;
+                }
+            }
+
             // snapshot remote subs
-            if (!route->remote_subscribers.empty()) {
+            if (!route->remote_subscribers.empty() && relay_dests.empty()) {
                 job->remote_recvrs.reserve(route->remote_subscribers.size());
-                for (const NodeId remote : route->remote_subscribers) {
+                route->remote_subscribers.for_each([&](const NodeId remote) {
+                    if (mcast && route->mcast_subscribers.contains(remote)) return;
                     job->remote_recvrs.push_back(
-                        m_transports.get_socket(remote)
+                        current.transports.get_socket(remote, job->stripe)
                     );
-                }
+                });
             }
         }
 
-        job->pending_sends.store(job->local_recvrs.size() + job->remote_recvrs.size(), std::memory_order_relaxed);
+        if (!relay_shm.empty() || !relay_socks.empty()) {
+            job->relay = make_relay_job(*job, relay_dests, std::move(relay_shm), std::move(relay_socks));
+            job->relay->parent = job;
+        }
+
+        job->pending_sends.store(job->local_recvrs.size() + job->remote_recvrs.size() + job->mcast_recvrs.size() +
+                                 (job->relay != nullptr ? 1 : 0),
+                                 std::memory_order_relaxed);
         return { io::SendJobErr::None, job };
     }
 
+    std::shared_ptr<io::SendJob> Router::make_relay_job(const io::SendJob& job,
+                                                       const NodeSet dests,
+                                                       std::vector<std::shared_ptr<shm::ShmSend>> own_gateway,
+                                                       std::vector<std::shared_ptr<sock::TCPClient>> gateways) {
+        constexpr size_t WRAP_SIZE = sizeof(io::LabelHeader) + sizeof(io::RelayHeader);
+        io::SendBuf buf(WRAP_SIZE + job.send_buffer.total_size);
+
+        io::LabelHeader hdr{};
+        hdr.magic = MAGIC_NUM;
+        hdr.version = VERSION;
+        hdr.source_id = job.source_id;
+        hdr.flags = static_cast<uint16_t>(io::LabelFlag::Relay);
+        hdr.label = job.label;
+        hdr.label_size = static_cast<uint32_t>(buf.data_size);
+
+        io::RelayHeader relay{};
+        relay.dests = dests.bits();
+
+        std::memcpy(buf.data.get(), &hdr, sizeof(hdr));
+        std::memcpy(buf.data.get() + sizeof(hdr), &relay, sizeof(relay));
+        std::memcpy(buf.data.get() + WRAP_SIZE, job.send_buffer.data.get(), job.send_buffer.total_size);
+
+        auto wrapped = std::make_shared<io::SendJob>(std::move(buf));
+        wrapped->source_id = job.source_id;
+        wrapped->label = job.label;
+        wrapped->seq = job.seq;
+        wrapped->stripe = job.stripe;
+        wrapped->local_recvrs = std::move(own_gateway);
+        wrapped->remote_recvrs = std::move(gateways);
+        wrapped->pending_sends.store(wrapped->local_recvrs.size() + wrapped->remote_recvrs.size(), std::memory_order_relaxed);
+        return wrapped;
+    }
+
     void Router::distribute_recvd_label(const NodeId source_id, 
                                         const Label label, 
                                         const std::byte* buf, 
@@ -311,152 +581,309 @@ namespace eroil::rt {
                                         const size_t recv_offset) const {
         if (buf == nullptr || size == 0) return;
         
-        // get subscribers snapshot
-        std::vector<std::shared_ptr<hndl::RecvHandle>> subscribers;
-        {
-            std::shared_lock lock(m_router_mtx);
-            
-            const RecvRoute* route = m_routes.get_recv_route(label);
-            if (route == nullptr) {
-                ERR_PRINT("unknown label=", label);
-                return;
-            }
+        // the version stays alive while we are pinned, deliver straight from it
+        epoch::Guard guard;
+        const RouterState& current = state();
 
-            if (route->label_size != size) {
-                ERR_PRINT("size mismatch label=", label,
-                          " expected=", route->label_size, " got=", size);
-                return;
-            }
+        const RecvRoute* route = current.routes.get_recv_route(label);
+        if (route == nullptr) {
+            ERR_PRINT("unknown label=", label);
+            return;
+        }
 
-            std::vector<handle_uid> uids = m_routes.snapshot_recv_subscribers(label);
-            if (uids.empty()) {
-                ERR_PRINT("no recv subscribers for label=", label);
-                return;
-            }
+        if (route->label_size != size) {
+            ERR_PRINT("size mismatch label=", label,
+                      " expected=", route->label_size, " got=", size);
+            return;
+        }
 
-            subscribers.reserve(uids.size());
-            for (handle_uid uid : uids) {
-                auto it = m_recv_handles.find(uid);
-                if (it != m_recv_handles.end() && it->second) {
-                    subscribers.push_back(it->second);
-                }
-            }
+        if (route->subscribers.empty()) {
+            ERR_PRINT("no recv subscribers for label=", label);
+            return;
         }
 
         // write to subscribers buffers
-        for (const std::shared_ptr<hndl::RecvHandle>& sub : subscribers) {
-            if (sub == nullptr) {
+        for (handle_uid uid : route->subscribers) {
+            const auto* sub = current.recv_handles.find(uid);
+            if (sub == nullptr || *sub == nullptr) {
                 ERR_PRINT("got null subscriber for label=", label);
                 continue;
             }
+            deliver(**sub, source_id, label, buf, size, recv_offset);
+        }
+    }
 
-            if (sub->data.buf == nullptr) { 
-                ERR_PRINT("subscriber has no buffer for label=", label);
-                continue;
+    bool Router::pull_mailbox(hndl::RecvHandle& sub) {
+        if (sub.mailbox == nullptr) return false;
+        if (sub.is_idle.load(std::memory_order_acquire)) return false;
+
+        // the slot index is shared with deliveries from other hosts and with redirect/reset. never wait
+        // on them from a recv_count poll, whoever holds the lock is adding a value already and the
+        // mailbox keeps ours for the next poll
+        std::unique_lock lock(sub.write_mtx, std::try_to_lock);
+        if (!lock.owns_lock()) return false;
+
+        const hndl::OpenReceiveData& data = sub.data;
+        if (data.buf == nullptr || data.buf_slots == 0 || data.buf_size == 0) return false;
+
+        // same slot an OVERWRITE delivery would replace, the value is read straight into it
+        const size_t slot = data.buf_index;
+        std::byte* dst = data.buf + (slot * data.buf_size);
+
+        NodeId source_id = INVALID_NODE;
+        uint32_t recv_offset = 0;
+        uint32_t size = 0;
+        switch (sub.mailbox->read(sub.mailbox_seq, source_id, recv_offset, size, dst, data.buf_size)) {
+            case shm::MailboxRead::NewData: break;
+            case shm::MailboxRead::Invalid: {
+                ERR_PRINT("mailbox value does not fit subscriber buffer for label=", data.label);
+                return false;
             }
+            default: return false;
+        }
 
-            if (sub->data.buf_slots == 0) {
-                ERR_PRINT("subscriber has no buffer slots for label=", label);
-                continue;
-            }
+        sub.data.buf_index = (slot + 1) % data.buf_slots;
+        comm::write_recv_iosb(&sub, source_id, data.label, size, recv_offset, slot, dst);
+        sub.recv_count.fetch_add(1, std::memory_order_release);
+        return true;
+    }
 
-            if (sub->data.buf_size == 0) { 
-                ERR_PRINT("subscriber buffer size is 0 for label=", label);
-                continue;
-            }
+    uint32_t Router::drain_arena(const uint32_t stuck_writer_ms) const {
+        epoch::Guard guard;
+        const RouterState& current = state();
+        if (current.arena_handles.empty()) return 0;
 
-            if (recv_offset > sub->data.buf_size) {
-                ERR_PRINT("recv offset > buf size for label=", label);
-                continue;
-            }
+        const uint64_t stuck_ns = static_cast<uint64_t>(stuck_writer_ms) * 1000ull * 1000ull;
+        uint32_t skipped = 0;
+        for (const std::shared_ptr<hndl::RecvHandle>& sub : current.arena_handles) {
+            skipped += drain_arena_handle(*sub, stuck_ns);
+        }
+        return skipped;
+    }
 
-            // if subscriber temporarily disabled recv
-            if (sub->is_idle) {
-                continue;
-            }
+    uint32_t Router::drain_arena_handle(hndl::RecvHandle& sub, const uint64_t stuck_ns) {
+        shm::ShmArena& arena = *sub.arena;
+        const uint32_t entry = sub.arena_entry;
+        const bool idle = sub.is_idle.load(std::memory_order_acquire);
 
-            // TODO: right now we always replace the oldeest buffer slot which makes sense
-            // to me, but i'm unclear if that is the way it works in the real system
-
-            std::lock_guard lock(sub->mtx);
-            switch (sub->data.signal_mode) {
-                // signal on error only, allowed to overwrite
-                case iosb::SignalMode::OVERWRITE: {
-                    const size_t slot = sub->data.buf_index;
-                    std::byte* dst = sub->data.buf + (slot * sub->data.buf_size);
-                    std::memcpy(dst + recv_offset, buf, size);
-                    
-                    sub->data.recv_count += 1;
-                    sub->data.buf_index = (sub->data.buf_index + 1) % sub->data.buf_slots;
-
-                    // TODO: do we write the IOSB every message but never signal or do we never
-                    // write the IOSB also?
-                    comm::write_recv_iosb(sub.get(), source_id, label, size, recv_offset, slot, dst);
+        std::lock_guard lock(sub.write_mtx);
+
+        // publishers found every slot taken, same signal deliver gives a full buffer
+        if (arena.take_full(entry) != 0 && !idle) {
+            switch (sub.data.signal_mode) {
+                case iosb::SignalMode::BUFFER_FULL:
+                case iosb::SignalMode::EVERY_MESSAGE:
+                    plat::try_signal_sem(sub.data.sem);
                     break;
-                }
+                default:
+                    break;
+            }
+        }
 
-                // signal on error or buffer full, not allowed to overwrite
-                case iosb::SignalMode::BUFFER_FULL: {
-                    // full and not allowed to overwrite, signal again
-                    if (sub->data.recv_count == sub->data.buf_slots) {
-                        // TODO: actually this is an error, do we write an IOSB for the error?
-                        // comm::write_recv_iosb(sub.get(), source_id, label, size, recv_offset, dst);
-                        plat::try_signal_sem(sub->data.sem);
-                    } else {
-                        // not full yet, copy data into next buffer slot
-                        const size_t slot = sub->data.buf_index;
-                        std::byte* dst = sub->data.buf + (slot * sub->data.buf_size);
-                        std::memcpy(dst + recv_offset, buf, size);
-                        
-                        sub->data.recv_count += 1;
-                        sub->data.buf_index = (sub->data.buf_index + 1) % sub->data.buf_slots;
-
-                        // TODO: do we only write IOSB when full or do we write IOSB every message
-                        // but only signal on full?
-
-                        // if we are now full, signal
-                        if (sub->data.recv_count == sub->data.buf_slots) {
-                            comm::write_recv_iosb(sub.get(), source_id, label, size, recv_offset, slot, dst);
-                            plat::try_signal_sem(sub->data.sem);
-                        }
+        uint32_t skipped = 0;
+        shm::ArenaDelivery delivery;
+        while (true) {
+            switch (arena.take(entry, sub.arena_next, delivery)) {
+                case shm::ArenaTake::Delivered: {
+                    sub.arena_stalled_ns = 0;
+                    if (idle) {
+                        // idle subscribers drop what arrives, the slot is free again
+                        arena.return_credits(entry, 1);
+                        continue;
                     }
-                    break;
+                    deliver_arena(sub, delivery);
+                    continue;
                 }
-                
-                // signal every message, not allowed to overwrite
-                case iosb::SignalMode::EVERY_MESSAGE: {
-                    const size_t slot = sub->data.buf_index;
-                    std::byte* dst = sub->data.buf + (slot * sub->data.buf_size);
-                    if (sub->data.recv_count < sub->data.buf_slots) {
-                        std::memcpy(dst + recv_offset, buf, size);
-                    
-                        sub->data.recv_count += 1;
-                        sub->data.buf_index = (sub->data.buf_index + 1) % sub->data.buf_slots;
+
+                // writer is still copying and posts once it commits. one that never does
+                // (died) is skipped once it held the ticket past the deadline
+                case shm::ArenaTake::Pending: {
+                    const uint64_t now = shm::shm_clock_ns();
+                    if (sub.arena_stalled_ns == 0) {
+                        sub.arena_stalled_ns = now;
+                        return skipped;
                     }
+                    if (now - sub.arena_stalled_ns <= stuck_ns) return skipped;
 
-                    comm::write_recv_iosb(sub.get(), source_id, label, size, recv_offset, slot, dst);
-                    plat::try_signal_sem(sub->data.sem);
-                    break;
+                    arena.skip(entry, sub.arena_next);
+                    sub.arena_stalled_ns = 0;
+                    skipped += 1;
+                    continue;
                 }
 
-                // always write always signal - this is just for testing, actual system does not use this
-                case iosb::SignalMode::SIGNAL_ALL_WRITE_ALL: {
-                    const size_t slot = sub->data.buf_index;
-                    std::byte* dst = sub->data.buf + (slot * sub->data.buf_size);
-                    std::memcpy(dst + recv_offset, buf, size);
-                
-                    sub->data.recv_count += 1;
-                    sub->data.buf_index = (sub->data.buf_index + 1) % sub->data.buf_slots;
-
-                    comm::write_recv_iosb(sub.get(), source_id, label, size, recv_offset, slot, dst);
-                    plat::try_signal_sem(sub->data.sem);
-                    break;
+                case shm::ArenaTake::Empty:
+                default: {
+                    sub.arena_stalled_ns = 0;
+                    return skipped;
                 }
+            }
+        }
+    }
 
-                default: {
-                    ERR_PRINT("got unknown signal mode=", static_cast<int32_t>(sub->data.signal_mode));
-                    break;
+    void Router::deliver_arena(hndl::RecvHandle& sub, const shm::ArenaDelivery& delivery) {
+        // payload is already in the slot, only the bookkeeping deliver would do is left
+        const size_t slot = delivery.slot;
+        std::byte* dst = sub.data.buf + (slot * sub.data.buf_size);
+        const Label label = sub.data.label;
+        sub.data.buf_index = (slot + 1) % sub.data.buf_slots;
+
+        switch (sub.data.signal_mode) {
+            case iosb::SignalMode::OVERWRITE: {
+                comm::write_recv_iosb(&sub, delivery.source_id, label, delivery.size, delivery.recv_offset, slot, dst);
+                sub.recv_count.fetch_add(1, std::memory_order_release);
+                break;
+            }
+
+            // publishers only write a slot they took a credit for, there is always room here
+            case iosb::SignalMode::BUFFER_FULL: {
+                const uint32_t count = sub.recv_count.fetch_add(1, std::memory_order_acq_rel) + 1;
+                if (count >= sub.data.buf_slots) {
+                    comm::write_recv_iosb(&sub, delivery.source_id, label, delivery.size, delivery.recv_offset, slot, dst);
+                    plat::try_signal_sem(sub.data.sem);
                 }
+                break;
+            }
+
+            case iosb::SignalMode::EVERY_MESSAGE:
+            case iosb::SignalMode::SIGNAL_ALL_WRITE_ALL: {
+                comm::write_recv_iosb(&sub, delivery.source_id, label, delivery.size, delivery.recv_offset, slot, dst);
+                sub.recv_count.fetch_add(1, std::memory_order_release);
+                plat::try_signal_sem(sub.data.sem);
+                break;
+            }
+
+            default: {
+                ERR_PRINT("got unknown signal mode=", static_cast<int32_t>(sub.data.signal_mode));
+                break;
+            }
+        }
+    }
+
+    void Router::return_arena_slots(hndl::RecvHandle& sub, const uint32_t count) {
+        if (sub.arena == nullptr || count == 0) return;
+        sub.arena->return_credits(sub.arena_entry, count);
+    }
+
+    void Router::deliver(hndl::RecvHandle& sub,
+                         const NodeId source_id,
+                         const Label label,
+                         const std::byte* buf,
+                         const size_t size,
+                         const size_t recv_offset) {
+        // arena subscribers take everything through their slots, the recv worker hands it over
+        if (sub.arena != nullptr) {
+            if (sub.is_idle.load(std::memory_order_acquire)) return;
+            if (!sub.arena->publish_entry(sub.arena_entry, source_id, static_cast<uint32_t>(recv_offset), buf, size)) {
+                ERR_PRINT("arena slot write failed for label=", label);
+                return;
+            }
+            sub.arena->wake();
+            return;
+        }
+
+        if (sub.data.buf == nullptr) { 
+            ERR_PRINT("subscriber has no buffer for label=", label);
+            return;
+        }
+
+        if (sub.data.buf_slots == 0) {
+            ERR_PRINT("subscriber has no buffer slots for label=", label);
+            return;
+        }
+
+        if (sub.data.buf_size == 0) { 
+            ERR_PRINT("subscriber buffer size is 0 for label=", label);
+            return;
+        }
+
+        if (recv_offset > sub.data.buf_size) {
+            ERR_PRINT("recv offset > buf size for label=", label);
+            return;
+        }
+
+        // if subscriber temporarily disabled recv
+        if (sub.is_idle.load(std::memory_order_acquire)) {
+            return;
+        }
+
+        // TODO: right now we always replace the oldeest buffer slot which makes sense
+        // to me, but i'm unclear if that is the way it works in the real system
+
+        std::lock_guard lock(sub.write_mtx);
+        switch (sub.data.signal_mode) {
+            // signal on error only, allowed to overwrite
+            case iosb::SignalMode::OVERWRITE: {
+                const size_t slot = sub.data.buf_index;
+                std::byte* dst = sub.data.buf + (slot * sub.data.buf_size);
+                mem::copy_out(dst + recv_offset, buf, size);
+                sub.data.buf_index = (sub.data.buf_index + 1) % sub.data.buf_slots;
+
+                // TODO: do we write the IOSB every message but never signal or do we never
+                // write the IOSB also?
+                comm::write_recv_iosb(&sub, source_id, label, size, recv_offset, slot, dst);
+                sub.recv_count.fetch_add(1, std::memory_order_release);
+                break;
+            }
+
+            // signal on error or buffer full, not allowed to overwrite
+            case iosb::SignalMode::BUFFER_FULL: {
+                // full and not allowed to overwrite, signal again
+                if (sub.recv_count.load(std::memory_order_acquire) >= sub.data.buf_slots) {
+                    // TODO: actually this is an error, do we write an IOSB for the error?
+                    // comm::write_recv_iosb(&sub, source_id, label, size, recv_offset, dst);
+                    plat::try_signal_sem(sub.data.sem);
+                } else {
+                    // not full yet, copy data into next buffer slot
+                    const size_t slot = sub.data.buf_index;
+                    std::byte* dst = sub.data.buf + (slot * sub.data.buf_size);
+                    mem::copy_out(dst + recv_offset, buf, size);
+                    sub.data.buf_index = (sub.data.buf_index + 1) % sub.data.buf_slots;
+                    const uint32_t count = sub.recv_count.fetch_add(1, std::memory_order_acq_rel) + 1;
+
+                    // TODO: do we only write IOSB when full or do we write IOSB every message
+                    // but only signal on full?
+
+                    // if we are now full, signal
+                    if (count >= sub.data.buf_slots) {
+                        comm::write_recv_iosb(&sub, source_id, label, size, recv_offset, slot, dst);
+                        plat::try_signal_sem(sub.data.sem);
+                    }
+                }
+                break;
+            }
+            
+            // signal every message, not allowed to overwrite
+            case iosb::SignalMode::EVERY_MESSAGE: {
+                const size_t slot = sub.data.buf_index;
+                std::byte* dst = sub.data.buf + (slot * sub.data.buf_size);
+                const bool has_room = sub.recv_count.load(std::memory_order_acquire) < sub.data.buf_slots;
+                if (has_room) {
+                    mem::copy_out(dst + recv_offset, buf, size);
+                    sub.data.buf_index = (sub.data.buf_index + 1) % sub.data.buf_slots;
+                }
+
+                comm::write_recv_iosb(&sub, source_id, label, size, recv_offset, slot, dst);
+                if (has_room) sub.recv_count.fetch_add(1, std::memory_order_release);
+                plat::try_signal_sem(sub.data.sem);
+                break;
+            }
+
+            // always write always signal - this is just for testing, actual system does not use this
+            case iosb::SignalMode::SIGNAL_ALL_WRITE_ALL: {
+                const size_t slot = sub.data.buf_index;
+                std::byte* dst = sub.data.buf + (slot * sub.data.buf_size);
+                mem::copy_out(dst + recv_offset, buf, size);
+                sub.data.buf_index = (sub.data.buf_index + 1) % sub.data.buf_slots;
+
+                comm::write_recv_iosb(&sub, source_id, label, size, recv_offset, slot, dst);
+                sub.recv_count.fetch_add(1, std::memory_order_release);
+                plat::try_signal_sem(sub.data.sem);
+                break;
+            }
+
+            default: {
+                ERR_PRINT("got unknown signal mode=", static_cast<int32_t>(sub.data.signal_mode));
+                break;
             }
         }
     }
@@ -2,7 +2,8 @@
 #include <memory>
 #include <unordered_map>
 #include <vector>
-#include <shared_mutex>
+#include <mutex>
+#include <atomic>
 #include <utility>
 
 #include "types/const_types.h"
@@ -10,23 +11,39 @@
 #include "types/send_io_types.h"
 #include "route_table.h"
 #include "transport_registry.h"
+#include "sharded_map.h"
 #include "macros.h"
 
 namespace eroil::rt {
+    // what a batched subscriber update did, see update_send_subscribers
+    struct SubscriberChanges {
+        std::vector<Label> added{};
+        std::vector<Label> removed{};
+        uint32_t failed = 0;    // adds that found no shm block/socket to the node yet, worth trying again later
+    };
 
-    class Router {
-        private:
-            mutable std::shared_mutex m_router_mtx;
+    // everything the router knows, one immutable version of it is published at a time
+    struct RouterState {
+        RouteTable routes;
+        TransportRegistry transports;
 
-            RouteTable m_routes;
-            TransportRegistry m_transports;
+        ShardedMap<handle_uid, std::shared_ptr<hndl::SendHandle>> send_handles;
+        ShardedMap<handle_uid, std::shared_ptr<hndl::RecvHandle>> recv_handles;
+        std::vector<std::shared_ptr<hndl::RecvHandle>> arena_handles;   // subset with slots in our arena
+    };
 
-            std::unordered_map<handle_uid, std::shared_ptr<hndl::SendHandle>> m_send_handles;
-            std::unordered_map<handle_uid, std::shared_ptr<hndl::RecvHandle>> m_recv_handles;
+    class Router {
+        private:
+            // readers pin an epoch and read m_state without a lock. writers take m_write_mtx, change
+            // a copy of the state and swap it in, the old version is freed once no reader can see it
+            std::atomic<const RouterState*> m_state;
+            std::mutex m_write_mtx;
+            std::vector<std::pair<uint64_t, const RouterState*>> m_retired;     // epoch retired in, state
+            std::atomic<uint32_t> m_tcp_stripes{1};
 
         public:
-            Router() = default;
-            ~Router() = default;
+            Router();
+            ~Router();
 
             EROIL_NO_COPY(Router)
             EROIL_NO_MOVE(Router)
@@ -39,28 +56,44 @@ namespace eroil::rt {
             hndl::SendHandle* get_send_handle(handle_uid uid); 
             hndl::RecvHandle* get_recv_handle(handle_uid uid);
 
-            // add/remove subscribers for labels we send
-            void add_local_send_subscriber(Label label, size_t size, NodeId dst_id);
-            void add_remote_send_subscriber(Label label, size_t size, NodeId dst_id);
-            void remove_local_send_subscriber(Label label, NodeId to_id);
-            void remove_remote_send_subscriber(Label label, NodeId to_id);
+            // add/remove dst_id as a subscriber of the labels we send, published as one version. add holds labels
+            // it newly receives or changed (size/flags), labels we do not send or it already has are skipped.
+            // via_id is the node whose shm block/socket the sends take, dst_id itself unless a host gateway relays
+            SubscriberChanges update_send_subscribers(const NodeId dst_id,
+                                                      const NodeId via_id,
+                                                      const bool local,
+                                                      const std::vector<io::LabelInfo>& add,
+                                                      const std::vector<io::LabelInfo>& remove);
 
             io::LabelsSnapshot get_send_labels_snapshot() const;
             io::LabelsSnapshot get_recv_labels_snapshot() const;
-            std::array<io::LabelInfo, MAX_LABELS> get_send_labels() const;
+            std::vector<io::LabelInfo> get_send_labels() const;
+            size_t send_label_count() const noexcept;
+            size_t recv_label_count() const noexcept;
+            uint64_t recv_gen() const noexcept;     // changes whenever get_recv_labels_snapshot() would
 
             bool has_send_route(Label label) const noexcept;
             bool has_recv_route(Label label) const noexcept;
-            bool is_send_subscriber(Label label, NodeId to_id) const noexcept;
 
             bool upsert_socket(NodeId id, std::shared_ptr<sock::TCPClient> sock);
+            bool upsert_sockets(NodeId id, std::vector<std::shared_ptr<sock::TCPClient>> socks);
             std::shared_ptr<sock::TCPClient> get_socket(NodeId id) const noexcept;
+            std::shared_ptr<sock::TCPClient> get_socket(NodeId id, uint32_t stripe) const noexcept;
+            std::vector<std::shared_ptr<sock::TCPClient>> get_sockets(NodeId id) const;
             bool has_socket(NodeId id) const noexcept;
+
+            // tcp connections we dial per remote peer, set before any socket comes up. a label always takes
+            // the same stripe so its frames stay in order, bulk labels hash over every stripe but the first
+            void set_tcp_stripes(uint32_t stripes) noexcept;
+            uint32_t tcp_stripe(Label label, size_t label_size) const noexcept;
             
-            bool open_send_shm(NodeId dst_id);
+            bool open_send_shm(NodeId src_id, NodeId dst_id, bool checksum);
             std::shared_ptr<shm::ShmSend> get_send_shm(NodeId dst_id) const noexcept;
-            bool open_recv_shm(NodeId my_id);
+            bool open_recv_shm(NodeId my_id, size_t ring_size, uint32_t lane_count);
             std::shared_ptr<shm::ShmRecv> get_recv_shm() const noexcept;
+            std::shared_ptr<shm::ShmMailbox> open_mailbox(Label label, size_t label_size);
+            std::shared_ptr<shm::ShmArena> open_arena(NodeId my_id, size_t size);
+            void set_mcast(std::shared_ptr<wrk::McastData> mcast);
 
             std::pair<io::SendJobErr, std::shared_ptr<io::SendJob>> 
             build_send_job(const NodeId my_id, const Label label, const handle_uid uid, io::SendBuf send_buf);
@@ -69,5 +102,40 @@ namespace eroil::rt {
                                         const std::byte* buf, 
                                         const size_t size, 
                                         const size_t recv_offset) const;
+
+            // OVERWRITE subscribers with a mailbox take the latest value into their next slot
+            // from the application thread, true when a new value was delivered. skipped while another
+            // writer holds the subscriber
+            static bool pull_mailbox(hndl::RecvHandle& sub);
+
+            // hands committed arena tickets of every arena subscriber to the app, called by the
+            // shm recv worker after each ring drain. returns tickets skipped for a stuck writer
+            uint32_t drain_arena(const uint32_t stuck_writer_ms) const;
+
+            // app dismissed or reset count arena slots, publishers may fill them again
+            static void return_arena_slots(hndl::RecvHandle& sub, const uint32_t count);
+
+        private:
+            // caller holds an epoch::Guard
+            const RouterState& state() const noexcept;
+
+            // caller holds m_write_mtx
+            std::unique_ptr<RouterState> draft() const;
+            void publish(std::unique_ptr<RouterState> next);
+            void reclaim();
+
+            static std::shared_ptr<io::SendJob> make_relay_job(const io::SendJob& job,
+                                                               const NodeSet dests,
+                                                               std::vector<std::shared_ptr<shm::ShmSend>> own_gateway,
+                                                               std::vector<std::shared_ptr<sock::TCPClient>> gateways);
+            static bool add_local_send_subscriber(RouterState& state, Label label, size_t size, NodeId dst_id, uint32_t flags);
+            static uint32_t drain_arena_handle(hndl::RecvHandle& sub, const uint64_t stuck_ns);
+            static void deliver_arena(hndl::RecvHandle& sub, const shm::ArenaDelivery& delivery);
+            static void deliver(hndl::RecvHandle& sub,
+                                const NodeId source_id,
+                                const Label label,
+                                const std::byte* buf,
+                                const size_t size,
+                                const size_t recv_offset);
     };
 }
@@ -0,0 +1,94 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <memory>
+#include <utility>
+#include <vector>
+#include <cstddef>
+
+namespace eroil::rt {
+    // map split in shards that copies of the map share, each shard a flat array sorted by key.
+    // copying costs SHARDS pointers, the first change to a shared shard copies that shard only.
+    // copies must only be changed and copied by one thread at a time (the router writer), any
+    // number may read them meanwhile. pointers from find stay valid until the next insert/erase
+    template <typename Key, typename Value>
+    class ShardedMap {
+        private:
+            static constexpr size_t SHARDS = 64;
+            using Entry = std::pair<Key, Value>;
+            using Shard = std::vector<Entry>;
+
+            std::array<std::shared_ptr<Shard>, SHARDS> m_shards;
+            size_t m_size = 0;
+
+            static size_t shard_of(const Key& key) noexcept {
+                return std::hash<Key>{}(key) % SHARDS;
+            }
+
+            template <typename S>
+            static auto lower_bound(S& shard, const Key& key) noexcept {
+                return std::lower_bound(shard.begin(), shard.end(), key,
+                    [](const Entry& entry, const Key& k) { return entry.first < k; });
+            }
+
+            Shard& own_shard(const Key& key) {
+                std::shared_ptr<Shard>& ptr = m_shards[shard_of(key)];
+                if (ptr == nullptr) {
+                    ptr = std::make_shared<Shard>();
+                } else if (ptr.use_count() != 1) {
+                    ptr = std::make_shared<Shard>(*ptr);
+                }
+                return *ptr;
+            }
+
+        public:
+            size_t size() const noexcept { return m_size; }
+            bool empty() const noexcept { return m_size == 0; }
+
+            const Value* find(const Key& key) const noexcept {
+                const Shard* shard = m_shards[shard_of(key)].get();
+                if (shard == nullptr) return nullptr;
+                auto it = lower_bound(*shard, key);
+                if (it == shard->end() || it->first != key) return nullptr;
+                return &it->second;
+            }
+
+            // unshares the keys shard, only call on a copy nobody else reads yet
+            Value* find_mut(const Key& key) {
+                if (find(key) == nullptr) return nullptr;
+                Shard& shard = own_shard(key);
+                return &lower_bound(shard, key)->second;
+            }
+
+            bool contains(const Key& key) const noexcept {
+                return find(key) != nullptr;
+            }
+
+            std::pair<Value*, bool> try_emplace(const Key& key, Value value) {
+                Shard& shard = own_shard(key);
+                auto it = lower_bound(shard, key);
+                if (it != shard.end() && it->first == key) return { &it->second, false };
+
+                it = shard.emplace(it, key, std::move(value));
+                m_size += 1;
+                return { &it->second, true };
+            }
+
+            bool erase(const Key& key) {
+                if (!contains(key)) return false;
+                Shard& shard = own_shard(key);
+                shard.erase(lower_bound(shard, key));
+                m_size -= 1;
+                return true;
+            }
+
+            // shards one after the other, each in key order
+            template <typename Fn>
+            void for_each(Fn&& fn) const {
+                for (const auto& shard : m_shards) {
+                    if (shard == nullptr) continue;
+                    for (const auto& [key, value] : *shard) fn(key, value);
+                }
+            }
+    };
+}
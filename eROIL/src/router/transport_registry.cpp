@@ -8,12 +8,26 @@ namespace eroil::rt {
     bool TransportRegistry::upsert_socket(NodeId id, std::shared_ptr<sock::TCPClient> sock) {
         if (sock == nullptr) return false;
 
+        std::vector<std::shared_ptr<sock::TCPClient>> socks{};
+        socks.push_back(std::move(sock));
+        return upsert_sockets(id, std::move(socks));
+    }
+
+    bool TransportRegistry::upsert_sockets(NodeId id, std::vector<std::shared_ptr<sock::TCPClient>> socks) {
+        if (socks.empty() || socks.size() > MAX_TCP_STRIPES) return false;
+        for (const auto& sock : socks) {
+            if (sock == nullptr) return false;
+        }
+
+        // the whole set is replaced, a stripe of the old set must not outlive it
         auto it = m_sockets.find(id);
         if (it != m_sockets.end()) {
-            it->second->disconnect();
+            for (const auto& old : it->second) {
+                old->disconnect();
+            }
         }
 
-        m_sockets.insert_or_assign(id, std::move(sock));
+        m_sockets.insert_or_assign(id, std::move(socks));
         return true;
     }
 
@@ -21,27 +35,39 @@ namespace eroil::rt {
         auto it = m_sockets.find(id);
         if (it == m_sockets.end()) return false;
 
-        it->second->disconnect();
+        for (const auto& sock : it->second) {
+            sock->disconnect();
+        }
         m_sockets.erase(it);
         return true;
     }
 
     std::shared_ptr<sock::TCPClient> TransportRegistry::get_socket(NodeId id) const noexcept {
+        return get_socket(id, 0);
+    }
+
+    std::shared_ptr<sock::TCPClient> TransportRegistry::get_socket(NodeId id, uint32_t stripe) const noexcept {
+        auto it = m_sockets.find(id);
+        if (it == m_sockets.end() || it->second.empty()) return nullptr;
+        return stripe < it->second.size() ? it->second[stripe] : it->second.front();
+    }
+
+    std::vector<std::shared_ptr<sock::TCPClient>> TransportRegistry::get_sockets(NodeId id) const {
         auto it = m_sockets.find(id);
-        if (it == m_sockets.end()) return nullptr;
+        if (it == m_sockets.end()) return {};
         return it->second;
     }
 
     bool TransportRegistry::has_socket(NodeId id) const noexcept {
         auto it = m_sockets.find(id);
-        return (it != m_sockets.end()) && (it->second != nullptr);
+        return (it != m_sockets.end()) && !it->second.empty();
     }
 
     // send shm
-    bool TransportRegistry::open_send_shm(NodeId dst_id) {
+    bool TransportRegistry::open_send_shm(NodeId src_id, NodeId dst_id, bool checksum) {
         if (has_send_shm(dst_id)) return true;
 
-        auto shm = std::make_shared<shm::ShmSend>(dst_id);
+        auto shm = std::make_shared<shm::ShmSend>(src_id, dst_id, checksum);
         if (!shm->open()) {
             shm->close();
             return false;
@@ -63,10 +89,10 @@ namespace eroil::rt {
     }
 
     // recv shm
-    bool TransportRegistry::open_recv_shm(NodeId my_id) {
+    bool TransportRegistry::open_recv_shm(NodeId my_id, size_t ring_size, uint32_t lane_count) {
         if (m_recv_shm != nullptr) return true;
 
-        m_recv_shm = std::make_shared<shm::ShmRecv>(my_id);
+        m_recv_shm = std::make_shared<shm::ShmRecv>(my_id, ring_size, lane_count);
         if (!m_recv_shm->create_or_open()) {
             ERR_PRINT("create_or_open failed for recv shm");
             m_recv_shm->close();
@@ -80,4 +106,73 @@ namespace eroil::rt {
     std::shared_ptr<shm::ShmRecv> TransportRegistry::get_recv_shm() const noexcept {
         return m_recv_shm;
     }
+
+    // mailbox
+    std::shared_ptr<shm::ShmMailbox> TransportRegistry::open_mailbox(Label label, size_t label_size) {
+        auto it = m_mailboxes.find(label);
+        if (it != m_mailboxes.end()) {
+            if (it->second->label_size() != label_size) {
+                ERR_PRINT("mailbox size mismatch label=", label, " expected=", it->second->label_size(), " got=", label_size);
+                return nullptr;
+            }
+            return it->second;
+        }
+
+        auto mailbox = std::make_shared<shm::ShmMailbox>(label, label_size);
+        if (!mailbox->create_or_open()) {
+            ERR_PRINT("create_or_open failed for mailbox label=", label);
+            return nullptr;
+        }
+
+        m_mailboxes.emplace(label, mailbox);
+        return mailbox;
+    }
+
+    std::shared_ptr<shm::ShmMailbox> TransportRegistry::get_mailbox(Label label) const noexcept {
+        auto it = m_mailboxes.find(label);
+        if (it == m_mailboxes.end()) return nullptr;
+        return it->second;
+    }
+
+    // arena
+    std::shared_ptr<shm::ShmArena> TransportRegistry::open_arena(NodeId my_id, size_t size) {
+        if (m_arena != nullptr) return m_arena;
+
+        auto arena = std::make_shared<shm::ShmArena>(my_id, size);
+        if (!arena->create_or_reinit()) {
+            ERR_PRINT("create_or_reinit failed for shm arena");
+            return nullptr;
+        }
+
+        m_arena = arena;
+        return m_arena;
+    }
+
+    std::shared_ptr<shm::ShmArena> TransportRegistry::get_arena() const noexcept {
+        return m_arena;
+    }
+
+    std::shared_ptr<shm::ShmArena> TransportRegistry::open_peer_arena(NodeId dst_id) {
+        if (m_arena != nullptr && m_arena->node_id() == dst_id) return m_arena;
+
+        auto it = m_peer_arenas.find(dst_id);
+        if (it != m_peer_arenas.end()) return it->second;
+
+        auto arena = std::make_shared<shm::ShmArena>(dst_id, 0);
+        if (!arena->open()) {
+            ERR_PRINT("open failed for shm arena of node=", dst_id);
+            return nullptr;
+        }
+
+        m_peer_arenas.emplace(dst_id, arena);
+        return arena;
+    }
+
+    std::shared_ptr<shm::ShmArena> TransportRegistry::get_peer_arena(NodeId dst_id) const noexcept {
+        if (m_arena != nullptr && m_arena->node_id() == dst_id) return m_arena;
+
+        auto it = m_peer_arenas.find(dst_id);
+        if (it == m_peer_arenas.end()) return nullptr;
+        return it->second;
+    }
 }
\ No newline at end of file
@@ -8,35 +8,64 @@
 #include "socket/tcp_socket.h"
 #include "shm/shm_recv.h"
 #include "shm/shm_send.h"
+#include "shm/shm_mailbox.h"
+#include "shm/shm_arena.h"
 #include "macros.h"
 
+namespace eroil::wrk { class McastData; }
+
 namespace eroil::rt {
     class TransportRegistry {
         private:
             std::shared_ptr<shm::ShmRecv> m_recv_shm;
             std::unordered_map<NodeId, std::shared_ptr<shm::ShmSend>> m_send_shm;
-            std::unordered_map<NodeId, std::shared_ptr<sock::TCPClient>> m_sockets;
+            std::unordered_map<NodeId, std::vector<std::shared_ptr<sock::TCPClient>>> m_sockets;     // one per stripe
+            std::unordered_map<Label, std::shared_ptr<shm::ShmMailbox>> m_mailboxes;
+            std::shared_ptr<shm::ShmArena> m_arena;
+            std::unordered_map<NodeId, std::shared_ptr<shm::ShmArena>> m_peer_arenas;
+            std::shared_ptr<wrk::McastData> m_mcast;
 
         public:
             TransportRegistry() = default;
             ~TransportRegistry() = default;
 
-            EROIL_NO_COPY(TransportRegistry)
+            // copies share the transports, the router copies the registry for every new version it publishes
+            EROIL_DEFAULT_COPY(TransportRegistry)
             EROIL_NO_MOVE(TransportRegistry)
 
-            // socket
+            // socket, a peer has one per stripe. stripe 0 carries the control frames, get_socket(id) is stripe 0
+            // and a stripe the peer does not have falls back to it
             bool upsert_socket(NodeId id, std::shared_ptr<sock::TCPClient> sock);
+            bool upsert_sockets(NodeId id, std::vector<std::shared_ptr<sock::TCPClient>> socks);
             bool delete_socket(NodeId id);
             std::shared_ptr<sock::TCPClient> get_socket(NodeId id) const noexcept;
+            std::shared_ptr<sock::TCPClient> get_socket(NodeId id, uint32_t stripe) const noexcept;
+            std::vector<std::shared_ptr<sock::TCPClient>> get_sockets(NodeId id) const;
             bool has_socket(NodeId id) const noexcept;
 
             // send shm
-            bool open_send_shm(NodeId dst_id);
+            bool open_send_shm(NodeId src_id, NodeId dst_id, bool checksum);
             std::shared_ptr<shm::ShmSend> get_send_shm(NodeId dst_id) const noexcept;
             bool has_send_shm(NodeId dst_id) const noexcept;
 
             // recv shm
-            bool open_recv_shm(NodeId my_id);
+            bool open_recv_shm(NodeId my_id, size_t ring_size, uint32_t lane_count);
             std::shared_ptr<shm::ShmRecv> get_recv_shm() const noexcept;
+
+            // label mailbox, shared by our publishers and subscribers of the label
+            std::shared_ptr<shm::ShmMailbox> open_mailbox(Label label, size_t label_size);
+            std::shared_ptr<shm::ShmMailbox> get_mailbox(Label label) const noexcept;
+
+            // our arena, slots of our arena subscribers
+            std::shared_ptr<shm::ShmArena> open_arena(NodeId my_id, size_t size);
+            std::shared_ptr<shm::ShmArena> get_arena() const noexcept;
+
+            // arena of a local subscriber node, ours when dst_id is us
+            std::shared_ptr<shm::ShmArena> open_peer_arena(NodeId dst_id);
+            std::shared_ptr<shm::ShmArena> get_peer_arena(NodeId dst_id) const noexcept;
+
+            // multicast data plane, null unless enabled and started
+            void set_mcast(std::shared_ptr<wrk::McastData> mcast) noexcept { m_mcast = std::move(mcast); }
+            std::shared_ptr<wrk::McastData> get_mcast() const noexcept { return m_mcast; }
     };
 }
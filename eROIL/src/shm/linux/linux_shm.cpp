@@ -19,17 +19,23 @@ namespace eroil::shm {
     //     return static_cast<shm_handle>(fd);
     // }
 
-    Shm::Shm(const int32_t id, const size_t total_size) : 
-        m_id(id), m_total_size(total_size), m_handle(-1), m_view(nullptr) {}
+    Shm::Shm(const int32_t id, const size_t total_size, const ShmKind kind) : 
+        m_id(id), m_kind(kind), m_total_size(total_size), m_handle(-1), m_view(nullptr) {}
 
     Shm::Shm(Shm&& other) noexcept
         : m_id(other.m_id),
+          m_kind(other.m_kind),
           m_total_size(other.m_total_size),
           m_handle(other.m_handle),
-          m_view(other.m_view) {
+          m_view(other.m_view),
+          m_mirror_view(other.m_mirror_view),
+          m_mirror_size(other.m_mirror_size),
+          m_mirror_region(other.m_mirror_region) {
 
         other.m_handle = -1;
         other.m_view   = nullptr;
+        other.m_mirror_view = nullptr;
+        other.m_mirror_size = 0;
         other.m_id  = -1;
         other.m_total_size = 0;
     }
@@ -39,12 +45,18 @@ namespace eroil::shm {
             close();
 
             m_id = other.m_id;
+            m_kind = other.m_kind;
             m_total_size = other.m_total_size;
             m_handle = other.m_handle;
             m_view = other.m_view;
+            m_mirror_view = other.m_mirror_view;
+            m_mirror_size = other.m_mirror_size;
+            m_mirror_region = other.m_mirror_region;
 
             other.m_handle = -1;
             other.m_view = nullptr;
+            other.m_mirror_view = nullptr;
+            other.m_mirror_size = 0;
             other.m_id = -1;
             other.m_total_size = 0;
         }
@@ -56,6 +68,8 @@ namespace eroil::shm {
     }
 
     std::string Shm::name() const noexcept {
+        if (m_kind == ShmKind::Mailbox) return "/eroil.mbox." + std::to_string(m_id);
+        if (m_kind == ShmKind::Arena) return "/eroil.arena." + std::to_string(m_id);
         return "/eroil.node." + std::to_string(m_id);
     }
 
@@ -108,25 +122,120 @@ namespace eroil::shm {
         struct stat st;
         if (fstat(m_handle, &st) != 0) {
             ::close(m_handle);
+            m_handle = -1;
             return { ShmErr::UnknownError, ShmOp::Open };
         }
 
-        if ( static_cast<size_t>(st.st_size) != total_size()) {
+        // creator has not sized it yet
+        if (st.st_size <= 0) {
+            ::close(m_handle);
+            m_handle = -1;
+            return { ShmErr::NotInitialized, ShmOp::Open };
+        }
+
+        const size_t actual = static_cast<size_t>(st.st_size);
+        if (m_total_size != 0 && actual != m_total_size) {
             ::close(m_handle);
+            m_handle = -1;
             return { ShmErr::SizeMismatch, ShmOp::Open };
         }
 
-        const size_t total = total_size();
-        m_view = ::mmap(nullptr, total, PROT_READ | PROT_WRITE, MAP_SHARED, m_handle, 0);
+        m_view = ::mmap(nullptr, actual, PROT_READ | PROT_WRITE, MAP_SHARED, m_handle, 0);
         if (m_view == MAP_FAILED) {
+            m_view = nullptr;
             ::close(m_handle);
+            m_handle = -1;
             return { ShmErr::FileMapFailed, ShmOp::Open };
         }
 
+        m_total_size = actual;
+        return { ShmErr::None, ShmOp::Open };
+    }
+
+    ShmResult Shm::resize(const size_t new_total_size) {
+        if (!is_valid()) return { ShmErr::NotOpen, ShmOp::Resize };
+        if (new_total_size < m_total_size) return { ShmErr::SizeMismatch, ShmOp::Resize }; // never shrink under a sender
+        if (new_total_size == m_total_size) return { ShmErr::None, ShmOp::Resize };
+
+        if (::ftruncate(m_handle, static_cast<off_t>(new_total_size)) != 0) {
+            return { ShmErr::UnknownError, ShmOp::Resize };
+        }
+
+        void* view = ::mremap(m_view, m_total_size, new_total_size, MREMAP_MAYMOVE);
+        if (view == MAP_FAILED) {
+            return { ShmErr::FileMapFailed, ShmOp::Resize };
+        }
+
+        m_view = view;
+        m_total_size = new_total_size;
+        return { ShmErr::None, ShmOp::Resize };
+    }
+
+    ShmResult Shm::remap() {
+        if (!is_valid()) return { ShmErr::NotOpen, ShmOp::Resize };
+
+        struct stat st;
+        if (fstat(m_handle, &st) != 0) return { ShmErr::UnknownError, ShmOp::Resize };
+
+        const size_t actual = static_cast<size_t>(st.st_size);
+        if (actual == m_total_size) return { ShmErr::None, ShmOp::Resize };
+
+        // the old mapping stays valid until the new one is in place
+        void* view = ::mremap(m_view, m_total_size, actual, MREMAP_MAYMOVE);
+        if (view == MAP_FAILED) {
+            return { ShmErr::FileMapFailed, ShmOp::Resize };
+        }
+
+        m_view = view;
+        m_total_size = actual;
+        return { ShmErr::None, ShmOp::Resize };
+    }
+
+    ShmResult Shm::map_mirrored(const size_t offset, const size_t region_size, const uint32_t regions) {
+        if (!is_valid()) return { ShmErr::NotOpen, ShmOp::Open };
+        unmap_mirrored();
+
+        const size_t page = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+        if (regions == 0 || offset % page != 0 || region_size % page != 0 ||
+            offset + region_size * regions > m_total_size) {
+            return { ShmErr::InvalidOffset, ShmOp::Open };
+        }
+
+        // reserve the whole span first so nothing else lands between the two aliases
+        const size_t span = region_size * 2 * regions;
+        void* base = ::mmap(nullptr, span, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+        if (base == MAP_FAILED) return { ShmErr::FileMapFailed, ShmOp::Open };
+
+        for (uint32_t r = 0; r < regions; ++r) {
+            const off_t file_offset = static_cast<off_t>(offset + r * region_size);
+            std::byte* at = static_cast<std::byte*>(base) + r * 2 * region_size;
+
+            for (std::byte* alias : { at, at + region_size }) {
+                void* view = ::mmap(alias, region_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, m_handle, file_offset);
+                if (view == MAP_FAILED) {
+                    ::munmap(base, span);
+                    return { ShmErr::FileMapFailed, ShmOp::Open };
+                }
+            }
+        }
+
+        m_mirror_view = base;
+        m_mirror_size = span;
+        m_mirror_region = region_size;
         return { ShmErr::None, ShmOp::Open };
     }
 
+    void Shm::unmap_mirrored() noexcept {
+        if (m_mirror_view != nullptr) {
+            ::munmap(m_mirror_view, m_mirror_size);
+            m_mirror_view = nullptr;
+        }
+        m_mirror_size = 0;
+        m_mirror_region = 0;
+    }
+
     void Shm::close() noexcept {
+        unmap_mirrored();
         const size_t total = total_size();
 
         if (m_view != nullptr) {
@@ -3,6 +3,8 @@
 #include <chrono>
 #include "safe_print.h"
 #include <cstring>
+#include "memory/copy.h"
+#include "memory/crc32c.h"
 
 namespace eroil::shm {
     void Shm::memset(size_t offset, int32_t val, size_t bytes) {
@@ -18,6 +20,14 @@ namespace eroil::shm {
         return m_total_size; 
     }
 
+    std::byte* Shm::mirrored(const uint32_t region) const noexcept {
+        if (m_mirror_view == nullptr) return nullptr;
+
+        const size_t offset = static_cast<size_t>(region) * 2 * m_mirror_region;
+        if (offset >= m_mirror_size) return nullptr;
+        return static_cast<std::byte*>(m_mirror_view) + offset;
+    }
+
     ShmResult Shm::read(void* buf, const size_t size, const size_t offset) const noexcept {
         if (!is_valid()) return { ShmErr::NotOpen, ShmOp::Read };
         if (size > m_total_size) return { ShmErr::TooLarge, ShmOp::Read };
@@ -27,12 +37,30 @@ namespace eroil::shm {
         return { ShmErr::None, ShmOp::Read };
     }
 
+    ShmResult Shm::read(void* buf, const size_t size, const size_t offset, uint32_t& crc) const noexcept {
+        if (!is_valid()) return { ShmErr::NotOpen, ShmOp::Read };
+        if (size > m_total_size) return { ShmErr::TooLarge, ShmOp::Read };
+        if (offset + size > m_total_size) return { ShmErr::InvalidOffset, ShmOp::Read };
+
+        crc = mem::copy_crc32c(buf, static_cast<std::byte*>(m_view) + offset, size, crc);
+        return { ShmErr::None, ShmOp::Read };
+    }
+
     ShmResult Shm::write(const void* buf, const size_t size, const size_t offset) noexcept {
         if (!is_valid()) return { ShmErr::NotOpen, ShmOp::Write };
         if (size > m_total_size) return{ ShmErr::TooLarge, ShmOp::Write };
         if (offset + size > m_total_size) return { ShmErr::InvalidOffset, ShmOp::Write };
 
-        std::memcpy(static_cast<std::byte*>(m_view) + offset, buf, size);
+        mem::copy_out(static_cast<std::byte*>(m_view) + offset, buf, size);
+        return { ShmErr::None, ShmOp::Write };
+    }
+
+    ShmResult Shm::write(const void* buf, const size_t size, const size_t offset, uint32_t& crc) noexcept {
+        if (!is_valid()) return { ShmErr::NotOpen, ShmOp::Write };
+        if (size > m_total_size) return{ ShmErr::TooLarge, ShmOp::Write };
+        if (offset + size > m_total_size) return { ShmErr::InvalidOffset, ShmOp::Write };
+
+        crc = mem::copy_out_crc32c(static_cast<std::byte*>(m_view) + offset, buf, size, crc);
         return { ShmErr::None, ShmOp::Write };
     }
 }
\ No newline at end of file
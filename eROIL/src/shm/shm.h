@@ -26,6 +26,7 @@ namespace eroil::shm {
         RecvFailed,
         WouldBlock,
         InvalidOffset,
+        NotSupported,
     };
 
     enum class ShmOp {
@@ -33,6 +34,7 @@ namespace eroil::shm {
         Open,
         Read,
         Write,
+        Resize,
     };
 
     struct ShmResult {
@@ -63,6 +65,7 @@ namespace eroil::shm {
                 case ShmErr::RecvFailed: return "RecvFailed";
                 case ShmErr::WouldBlock: return "WouldBlock";
                 case ShmErr::InvalidOffset: return "InvalidOffset";
+                case ShmErr::NotSupported: return "NotSupported";
                 default: return "Unknown - error is undefined";
             }
         }
@@ -73,20 +76,35 @@ namespace eroil::shm {
                 case ShmOp::Open: return "Open";
                 case ShmOp::Read: return "Read";
                 case ShmOp::Write: return "Write";
+                case ShmOp::Resize: return "Resize";
                 default: return "Unknown - op is undefined";
             }
         }
     };
 
+    // what a block holds, picks its name
+    enum class ShmKind {
+        Node,       // per node recv ring, eroil.node.<id>
+        Mailbox,    // per label latest value mailbox, eroil.mbox.<label>
+        Arena,      // per node subscriber slots, eroil.arena.<id>
+    };
+
     class Shm {
         private:
             int32_t m_id;
+            ShmKind m_kind;
             size_t m_total_size;
             shm_handle m_handle;
             shm_view m_view;
 
+            // second view where each region is followed by a copy of itself (linux only)
+            shm_view m_mirror_view = nullptr;
+            size_t m_mirror_size = 0;
+            size_t m_mirror_region = 0;
+
         public:
-            Shm(const int32_t id, const size_t total_size);
+            // total_size 0 opens an existing block at whatever size its creator picked
+            Shm(const int32_t id, const size_t total_size, const ShmKind kind = ShmKind::Node);
             virtual ~Shm() { close(); }
 
             EROIL_NO_COPY(Shm)
@@ -98,12 +116,27 @@ namespace eroil::shm {
             NO_DISCARD ShmResult create();
             NO_DISCARD ShmResult open();
             void close() noexcept;
+            // creator only, grows the block in place and maps the new size (linux only)
+            NO_DISCARD ShmResult resize(const size_t new_total_size);
+            // opener side of resize, maps the block again at its current size
+            NO_DISCARD ShmResult remap();
+            // maps regions [offset, offset + region_size * regions) a second time with every region followed
+            // by an alias of itself, so a record running off the end of a region continues at its start
+            // offset and region_size must be page multiples. replaces any previous mirrored view (linux only)
+            NO_DISCARD ShmResult map_mirrored(const size_t offset, const size_t region_size, const uint32_t regions);
+            void unmap_mirrored() noexcept;
 
             // shared implementation
             void memset(size_t offset, int32_t val, size_t bytes);
             size_t total_size() const noexcept;
+            // start of a region in the mirrored view, nullptr when not mirrored
+            std::byte* mirrored(const uint32_t region) const noexcept;
             NO_DISCARD ShmResult read(void* buf, const size_t size, const size_t offset) const noexcept;
+            // read that also continues crc (crc32c) over the bytes read
+            NO_DISCARD ShmResult read(void* buf, const size_t size, const size_t offset, uint32_t& crc) const noexcept;
             NO_DISCARD ShmResult write(const void* buf, const size_t size, const size_t offset) noexcept;
+            // write that also continues crc (crc32c) over buf on the way through
+            NO_DISCARD ShmResult write(const void* buf, const size_t size, const size_t offset, uint32_t& crc) noexcept;
             template <typename T>
             T* map_to_type(size_t offset) const { 
                 if (offset > m_total_size) return nullptr;
@@ -0,0 +1,324 @@
+#include "shm_arena.h"
+#include <algorithm>
+#include <cstring>
+#include <thread>
+#include "safe_print.h"
+#include "memory/copy.h"
+
+namespace eroil::shm {
+    ShmArena::ShmArena(NodeId id, size_t size) :
+        m_id(id), m_size(size), m_shm(id, size, ShmKind::Arena), m_event(id), m_owner(size != 0),
+        m_cache_gen(0) {}
+
+    bool ShmArena::create_or_reinit() {
+        if (!m_owner) return false;
+        if (m_size < SHM_MIN_ARENA_SIZE || m_size > SHM_MAX_ARENA_SIZE) {
+            ERR_PRINT("shm arena size outside the supported range, size=", m_size);
+            return false;
+        }
+
+        shm::ShmResult create_result = m_shm.create();
+        switch (create_result.code) {
+            case ShmErr::None: { return init_as_new(); }
+            case ShmErr::AlreadyExists: { break; } // left by an earlier run, we own it so start it over
+            default: {
+                ERR_PRINT("shm arena create err=", create_result.code_to_string());
+                return false;
+            }
+        }
+
+        m_shm = Shm(m_id, 0, ShmKind::Arena);
+        shm::ShmResult open_result = m_shm.open();
+        if (!open_result.ok()) {
+            ERR_PRINT("shm arena open err=", open_result.code_to_string());
+            return false;
+        }
+
+        if (m_shm.total_size() < m_size) {
+            shm::ShmResult resize_result = m_shm.resize(m_size);
+            if (!resize_result.ok()) {
+                LOG("shm arena keeping existing block size=", m_shm.total_size(), " requested=", m_size,
+                    " err=", resize_result.code_to_string());
+            }
+        }
+        if (m_shm.total_size() <= ArenaLayout::DATA_OFFSET) {
+            ERR_PRINT("existing shm arena too small, size=", m_shm.total_size());
+            return false;
+        }
+        return init_as_new();
+    }
+
+    bool ShmArena::init_as_new() {
+        auto* hdr = m_shm.map_to_type<ShmHeader>(ArenaLayout::HDR_OFFSET);
+        if (hdr == nullptr) {
+            ERR_PRINT("shm arena header offset invalid, total=", m_shm.total_size());
+            return false;
+        }
+
+        hdr->state.store(SHM_INITING, std::memory_order_relaxed);
+        hdr->magic = MAGIC_NUM;
+        hdr->version = VERSION;
+        hdr->total_size = m_shm.total_size();
+
+        // entries and meta only, slots are cleared as they are handed out
+        m_shm.memset(ArenaLayout::META_OFFSET, 0, ArenaLayout::DATA_OFFSET - ArenaLayout::META_OFFSET);
+
+        ArenaMeta* m = meta();
+        if (m == nullptr) return false;
+        m->node_id = m_id;
+        m->entry_count = SHM_ARENA_MAX_ENTRIES;
+        m->data_offset = ArenaLayout::DATA_OFFSET;
+        m->used.store(0, std::memory_order_relaxed);
+        // publishers keep their label cache across our restarts, never hand them a generation they saw
+        m->generation.store(shm_clock_ns(), std::memory_order_relaxed);
+
+        hdr->state.store(SHM_READY, std::memory_order_release);
+        return true;
+    }
+
+    bool ShmArena::open() {
+        if (m_owner) return false;
+
+        bool opened = false;
+        for (int i = 0; i < 50; ++i) {
+            if (m_shm.open().ok()) {
+                opened = true;
+                break;
+            }
+            std::this_thread::yield();
+        }
+        if (!opened) return false;
+
+        auto* hdr = m_shm.map_to_type<ShmHeader>(ArenaLayout::HDR_OFFSET);
+        if (hdr == nullptr || hdr->state.load(std::memory_order_acquire) != SHM_READY ||
+            hdr->magic != MAGIC_NUM || hdr->version != VERSION || meta() == nullptr) {
+            m_shm.close();
+            return false;
+        }
+        return true;
+    }
+
+    ArenaMeta* ShmArena::meta() const noexcept {
+        return m_shm.map_to_type<ArenaMeta>(ArenaLayout::META_OFFSET);
+    }
+
+    ArenaEntry* ShmArena::entry_at(uint32_t entry) const noexcept {
+        if (entry >= SHM_ARENA_MAX_ENTRIES) return nullptr;
+        return m_shm.map_to_type<ArenaEntry>(ArenaLayout::entry_offset(entry));
+    }
+
+    SlotMeta* ShmArena::slot_meta(const ArenaEntry& e, uint32_t slot) const noexcept {
+        if (slot >= e.slots) return nullptr;
+        return m_shm.map_to_type<SlotMeta>(e.data_offset + static_cast<size_t>(slot) * sizeof(SlotMeta));
+    }
+
+    std::byte* ShmArena::slot_data(const ArenaEntry& e, uint32_t slot) const noexcept {
+        if (slot >= e.slots) return nullptr;
+        const size_t metas = (static_cast<size_t>(e.slots) * sizeof(SlotMeta) + 63) & ~static_cast<size_t>(63);
+        const size_t offset = e.data_offset + metas + static_cast<size_t>(slot) * e.buf_size;
+        if (offset + e.buf_size > m_shm.total_size()) return nullptr;
+        return m_shm.map_to_type<std::byte>(offset);
+    }
+
+    bool ShmArena::acquire(Label label, size_t buf_size, uint32_t slots, bool overwrite,
+                           uint32_t& entry, std::byte*& slots_base, uint64_t& next_ticket) {
+        if (!m_owner || buf_size == 0 || buf_size > MAX_LABEL_SIZE || slots == 0) return false;
+
+        std::lock_guard lock(m_mtx);
+        ArenaMeta* m = meta();
+        if (m == nullptr) return false;
+
+        // reuse a released entry that is big enough, otherwise carve a new one off the end
+        const size_t need = ArenaLayout::entry_bytes(buf_size, slots);
+        ArenaEntry* e = nullptr;
+        uint32_t index = SHM_ARENA_MAX_ENTRIES;
+        for (uint32_t i = 0; i < SHM_ARENA_MAX_ENTRIES; ++i) {
+            ArenaEntry* candidate = entry_at(i);
+            if (candidate == nullptr || candidate->state.load(std::memory_order_acquire) != ENTRY_FREE) continue;
+            if (candidate->capacity >= need) { e = candidate; index = i; break; }
+            if (candidate->capacity == 0 && index == SHM_ARENA_MAX_ENTRIES) index = i;
+        }
+
+        if (e == nullptr) {
+            if (index == SHM_ARENA_MAX_ENTRIES) {
+                ERR_PRINT("shm arena has no free entries, label=", label, " max=", SHM_ARENA_MAX_ENTRIES);
+                return false;
+            }
+
+            const uint64_t used = m->used.load(std::memory_order_relaxed);
+            const uint64_t offset = m->data_offset + used;
+            if (offset + need > m_shm.total_size()) {
+                ERR_PRINT("shm arena out of space for label=", label, " need=", need,
+                          " free=", m_shm.total_size() - std::min<size_t>(offset, m_shm.total_size()));
+                return false;
+            }
+
+            e = entry_at(index);
+            if (e == nullptr) return false;
+            e->data_offset = offset;
+            e->capacity = need;
+            m->used.store(used + need, std::memory_order_relaxed);
+        }
+
+        e->label = label;
+        e->buf_size = static_cast<uint32_t>(buf_size);
+        e->slots = slots;
+        e->overwrite = overwrite ? 1u : 0u;
+        e->credits.store(overwrite ? 0u : slots, std::memory_order_relaxed);
+        e->full.store(0, std::memory_order_relaxed);
+        e->dropped.store(0, std::memory_order_relaxed);
+        m_shm.memset(e->data_offset, 0, need);
+
+        entry = index;
+        slots_base = slot_data(*e, 0);
+        next_ticket = e->claimed.load(std::memory_order_acquire);
+        e->state.store(ENTRY_ACTIVE, std::memory_order_release);
+        m->generation.fetch_add(1, std::memory_order_acq_rel);
+        return slots_base != nullptr;
+    }
+
+    void ShmArena::release(uint32_t entry) {
+        if (!m_owner) return;
+
+        std::lock_guard lock(m_mtx);
+        ArenaEntry* e = entry_at(entry);
+        ArenaMeta* m = meta();
+        if (e == nullptr || m == nullptr) return;
+
+        e->state.store(ENTRY_FREE, std::memory_order_release);
+        m->generation.fetch_add(1, std::memory_order_acq_rel);
+    }
+
+    ArenaTake ShmArena::take(uint32_t entry, uint64_t& next, ArenaDelivery& out) const noexcept {
+        ArenaEntry* e = entry_at(entry);
+        if (e == nullptr || e->slots == 0) return ArenaTake::Empty;
+
+        while (true) {
+            const uint64_t claimed = e->claimed.load(std::memory_order_acquire);
+            if (next >= claimed) return ArenaTake::Empty;
+
+            // overwriting publishers lapped us, only the newest slots worth still exist
+            if (e->overwrite != 0 && claimed - next > e->slots) next = claimed - e->slots;
+
+            const uint32_t slot = static_cast<uint32_t>(next % e->slots);
+            SlotMeta* m = slot_meta(*e, slot);
+            if (m == nullptr) return ArenaTake::Empty;
+
+            const uint64_t committed = m->committed.load(std::memory_order_acquire);
+            if (committed == next + 1) {
+                out.slot = slot;
+                out.source_id = m->source_id;
+                out.size = m->size;
+                out.recv_offset = m->recv_offset;
+                next += 1;
+                return ArenaTake::Delivered;
+            }
+
+            // a later lap already landed in this slot
+            if (committed > next + 1) {
+                next += 1;
+                continue;
+            }
+            return ArenaTake::Pending;
+        }
+    }
+
+    void ShmArena::skip(uint32_t entry, uint64_t& next) noexcept {
+        next += 1;
+        return_credits(entry, 1);
+    }
+
+    uint32_t ShmArena::take_full(uint32_t entry) noexcept {
+        ArenaEntry* e = entry_at(entry);
+        if (e == nullptr) return 0;
+        return e->full.exchange(0, std::memory_order_acq_rel);
+    }
+
+    void ShmArena::return_credits(uint32_t entry, uint32_t count) noexcept {
+        ArenaEntry* e = entry_at(entry);
+        if (e == nullptr || e->overwrite != 0 || count == 0) return;
+
+        uint32_t current = e->credits.load(std::memory_order_relaxed);
+        while (true) {
+            const uint32_t raised = std::min(e->slots, current + count);
+            if (e->credits.compare_exchange_weak(current, raised, std::memory_order_acq_rel, std::memory_order_relaxed)) {
+                return;
+            }
+        }
+    }
+
+    bool ShmArena::publish(Label label, NodeId source_id, uint32_t recv_offset,
+                           const std::byte* buf, size_t size) {
+        ArenaMeta* m = meta();
+        if (m == nullptr) return false;
+
+        // entries only change when a subscriber opens or closes, rescan the table then
+        std::vector<uint32_t> entries;
+        {
+            std::lock_guard lock(m_mtx);
+            const uint64_t gen = m->generation.load(std::memory_order_acquire);
+            if (gen != m_cache_gen) {
+                m_cache.clear();
+                for (uint32_t i = 0; i < SHM_ARENA_MAX_ENTRIES; ++i) {
+                    const ArenaEntry* e = entry_at(i);
+                    if (e == nullptr || e->state.load(std::memory_order_acquire) != ENTRY_ACTIVE) continue;
+                    m_cache[e->label].push_back(i);
+                }
+                m_cache_gen = gen;
+            }
+
+            auto it = m_cache.find(label);
+            if (it != m_cache.end()) entries = it->second;
+        }
+
+        bool ok = true;
+        for (const uint32_t entry : entries) {
+            const ArenaEntry* e = entry_at(entry);
+            if (e == nullptr || e->label != label) continue; // released and reused since we cached it
+            ok = publish_entry(entry, source_id, recv_offset, buf, size) && ok;
+        }
+        if (!entries.empty()) wake();
+        return ok;
+    }
+
+    bool ShmArena::publish_entry(uint32_t entry, NodeId source_id, uint32_t recv_offset,
+                                 const std::byte* buf, size_t size) noexcept {
+        ArenaEntry* e = entry_at(entry);
+        if (e == nullptr || buf == nullptr) return false;
+        if (e->state.load(std::memory_order_acquire) != ENTRY_ACTIVE) return false;
+        if (size == 0 || static_cast<size_t>(recv_offset) + size > e->buf_size) return false;
+
+        // subscriber has not dismissed anything since it filled up, it is told on its next wake
+        if (e->overwrite == 0) {
+            uint32_t credits = e->credits.load(std::memory_order_acquire);
+            while (true) {
+                if (credits == 0) {
+                    e->full.fetch_add(1, std::memory_order_acq_rel);
+                    e->dropped.fetch_add(1, std::memory_order_relaxed);
+                    return true;
+                }
+                if (e->credits.compare_exchange_weak(credits, credits - 1, std::memory_order_acq_rel, std::memory_order_acquire)) {
+                    break;
+                }
+            }
+        }
+
+        const uint64_t ticket = e->claimed.fetch_add(1, std::memory_order_acq_rel);
+        const uint32_t slot = static_cast<uint32_t>(ticket % e->slots);
+        SlotMeta* m = slot_meta(*e, slot);
+        std::byte* dst = slot_data(*e, slot);
+        if (m == nullptr || dst == nullptr) return false;
+
+        mem::copy_out(dst + recv_offset, buf, size);
+        m->source_id = source_id;
+        m->size = static_cast<uint32_t>(size);
+        m->recv_offset = recv_offset;
+        m->committed.store(ticket + 1, std::memory_order_release);
+        return true;
+    }
+
+    void ShmArena::wake() const noexcept {
+        evt::NamedSemResult result = m_event.post();
+        (void)result; // a full semaphore already wakes the worker
+    }
+}
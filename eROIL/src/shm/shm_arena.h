@@ -0,0 +1,139 @@
+#pragma once
+#include <atomic>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include "shm.h"
+#include "shm_header.h"
+#include "events/named_semaphore.h"
+#include "types/const_types.h"
+#include "macros.h"
+
+namespace eroil::shm {
+    enum ArenaEntryState : uint32_t {
+        ENTRY_FREE = 0,
+        ENTRY_ACTIVE = 1,
+    };
+
+    struct ArenaMeta {
+        NodeId node_id = INVALID_NODE;
+        uint32_t entry_count = 0;
+        uint64_t data_offset = 0;
+        std::atomic<uint64_t> used{0};          // bump allocator over the data block, owner only
+        std::atomic<uint64_t> generation{0};    // bumped whenever an entry is taken or released
+    };
+    static_assert(sizeof(ArenaMeta) <= 64);
+
+    // one subscriber's slots. publishers claim a ticket, write slot ticket % slots and
+    // commit it, the owners recv worker hands committed tickets to the app in order
+    struct ArenaEntry {
+        alignas(64) std::atomic<uint32_t> state{ENTRY_FREE};
+        Label label = INVALID_LABEL;
+        uint32_t buf_size = 0;
+        uint32_t slots = 0;
+        uint32_t overwrite = 0;                 // publishers never wait for a free slot
+        uint32_t _pad = 0;
+        uint64_t data_offset = 0;               // SlotMeta[slots] followed by the slots
+        uint64_t capacity = 0;                  // bytes reserved, kept when the entry is reused
+        alignas(64) std::atomic<uint64_t> claimed{0};   // next ticket, never reset so late writers stay behind
+        std::atomic<uint32_t> credits{0};       // free slots, returned by the app on dismiss
+        std::atomic<uint32_t> full{0};          // sends dropped since the worker last looked
+        std::atomic<uint64_t> dropped{0};
+    };
+    static_assert(sizeof(ArenaEntry) == 128);
+
+    struct SlotMeta {
+        std::atomic<uint64_t> committed{0};     // ticket + 1 once the slot holds that ticket
+        NodeId source_id = INVALID_NODE;
+        uint32_t size = 0;
+        uint32_t recv_offset = 0;
+        uint32_t _pad = 0;
+        uint64_t _pad2 = 0;
+    };
+    static_assert(sizeof(SlotMeta) == 32);
+
+    struct ArenaLayout {
+        static constexpr size_t HDR_OFFSET = 0;
+        static constexpr size_t META_OFFSET = 64;
+        static constexpr size_t ENTRY_TABLE_OFFSET = 128;
+        static constexpr size_t DATA_OFFSET =
+            (ENTRY_TABLE_OFFSET + SHM_ARENA_MAX_ENTRIES * sizeof(ArenaEntry) + 4095) & ~static_cast<size_t>(4095);
+
+        static constexpr size_t entry_offset(const uint32_t entry) noexcept {
+            return ENTRY_TABLE_OFFSET + static_cast<size_t>(entry) * sizeof(ArenaEntry);
+        }
+
+        static constexpr size_t entry_bytes(const size_t buf_size, const uint32_t slots) noexcept {
+            const size_t metas = (static_cast<size_t>(slots) * sizeof(SlotMeta) + 63) & ~static_cast<size_t>(63);
+            return metas + ((buf_size * slots + 63) & ~static_cast<size_t>(63));
+        }
+    };
+    static_assert(sizeof(ShmHeader) <= ArenaLayout::META_OFFSET);
+
+    enum class ArenaTake {
+        Delivered,  // next ticket was committed and handed out
+        Empty,      // nothing claimed past next
+        Pending,    // next ticket claimed but its writer has not committed yet
+    };
+
+    struct ArenaDelivery {
+        uint32_t slot = 0;
+        NodeId source_id = INVALID_NODE;
+        uint32_t size = 0;
+        uint32_t recv_offset = 0;
+    };
+
+    // per node block (eroil.arena.<id>) holding the slots of that nodes arena subscribers.
+    // the owner creates it and hands slots out to open_recv_label, same host publishers open
+    // it and write labels straight into the slots then ring the owners recv semaphore
+    class ShmArena {
+        private:
+            NodeId m_id;
+            size_t m_size;
+            Shm m_shm;
+            evt::NamedSemaphore m_event;
+            bool m_owner;
+
+            // owner: entry allocation. publisher: label -> entries cache for m_cache_gen
+            std::mutex m_mtx;
+            uint64_t m_cache_gen;
+            std::unordered_map<Label, std::vector<uint32_t>> m_cache;
+
+        public:
+            // size 0 opens another nodes arena at whatever size it was created with
+            ShmArena(NodeId id, size_t size);
+            ~ShmArena() = default;
+
+            EROIL_NO_COPY(ShmArena)
+            EROIL_NO_MOVE(ShmArena)
+
+            NodeId node_id() const noexcept { return m_id; }
+
+            // owner
+            bool create_or_reinit();
+            NO_DISCARD bool acquire(Label label, size_t buf_size, uint32_t slots, bool overwrite,
+                                    uint32_t& entry, std::byte*& slots_base, uint64_t& next_ticket);
+            void release(uint32_t entry);
+            NO_DISCARD ArenaTake take(uint32_t entry, uint64_t& next, ArenaDelivery& out) const noexcept;
+            void skip(uint32_t entry, uint64_t& next) noexcept;
+            uint32_t take_full(uint32_t entry) noexcept;
+            void return_credits(uint32_t entry, uint32_t count) noexcept;
+
+            // publisher
+            bool open();
+            // writes every active entry for label, returns false if any of them could not take it
+            NO_DISCARD bool publish(Label label, NodeId source_id, uint32_t recv_offset,
+                                    const std::byte* buf, size_t size);
+            // single entry, used by the owner when a label for an arena subscriber arrives another way
+            NO_DISCARD bool publish_entry(uint32_t entry, NodeId source_id, uint32_t recv_offset,
+                                          const std::byte* buf, size_t size) noexcept;
+            void wake() const noexcept;
+
+        private:
+            bool init_as_new();
+            ArenaMeta* meta() const noexcept;
+            ArenaEntry* entry_at(uint32_t entry) const noexcept;
+            SlotMeta* slot_meta(const ArenaEntry& e, uint32_t slot) const noexcept;
+            std::byte* slot_data(const ArenaEntry& e, uint32_t slot) const noexcept;
+    };
+}
@@ -1,7 +1,9 @@
 #pragma once
 #include <atomic>
+#include <chrono>
 #include <cstddef>
 #include "types/const_types.h"
+#include "memory/crc32c.h"
 
 namespace eroil::shm {
     enum ShmState : uint32_t {
@@ -19,20 +21,45 @@ namespace eroil::shm {
     static_assert(sizeof(ShmHeader) == 24);
     static_assert(std::atomic<std::uint32_t>::is_always_lock_free);
 
+    enum RingFlag : uint32_t { RING_MIRRORED = 1u << 0 };
+
     struct ShmMetaData {
         NodeId node_id = INVALID_NODE;
-        uint32_t _pad= 0;
-        size_t data_block_size;
+        uint32_t lane_count = 0;          // lanes in use, the lane table always has SHM_MAX_LANES slots
+        size_t data_block_size;           // all lanes together
+        uint32_t ring_flags = 0;          // RING_MIRRORED: records may run across a lane end, no wrap records
+        uint32_t _pad = 0;
         alignas(64) std::atomic<uint64_t> generation{0};
-        alignas(64) std::atomic<uint64_t> head_bytes{0};
-        alignas(64) std::atomic<uint64_t> tail_bytes{0};
-        alignas(64) std::atomic<uint64_t> published_count{0}; // for debugging
+        std::atomic<uint64_t> full_count{0};    // sends dropped for lack of space, tells the owner to grow
     };
     static_assert(sizeof(ShmMetaData) % 64 == 0);
     static_assert(alignof(ShmMetaData) == 64);
     static_assert(std::atomic<uint64_t>::is_always_lock_free);
 
-    enum RecordFlag : uint32_t { DROPPED = 1u << 0 };
+    // lane owner is the producers node id and process id in one word, a lane whose process died
+    // can then be taken over with a single cas without racing a restart of the same node
+    static constexpr uint64_t lane_owner(NodeId id, uint32_t pid) noexcept {
+        return (static_cast<uint64_t>(pid) << 32) | static_cast<uint32_t>(id);
+    }
+    static constexpr NodeId lane_owner_node(uint64_t owner) noexcept {
+        return static_cast<NodeId>(static_cast<uint32_t>(owner));
+    }
+    static constexpr uint32_t lane_owner_pid(uint64_t owner) noexcept {
+        return static_cast<uint32_t>(owner >> 32);
+    }
+    static constexpr uint64_t LANE_FREE = lane_owner(INVALID_NODE, 0);
+
+    // one per source node. the producer only writes its own cache line and the consumer only
+    // writes the tail line, so producers never contend with each other or the consumer
+    struct LaneMeta {
+        alignas(64) std::atomic<uint64_t> head_bytes{0};    // producer
+        std::atomic<uint64_t> owner{LANE_FREE};             // claimed once by the producer, cleared by init
+        std::atomic<uint64_t> published_count{0};           // producer side, for debugging
+        alignas(64) std::atomic<uint64_t> tail_bytes{0};    // consumer
+    };
+    static_assert(sizeof(LaneMeta) == 128);
+
+    enum RecordFlag : uint32_t { DROPPED = 1u << 0, CHECKSUM = 1u << 1 };
     enum RecordState : uint32_t { WRITING = 0, COMMITTED = 1, WRAP = 2 };
 
     struct alignas(8) RecordHeader {
@@ -45,39 +72,95 @@ namespace eroil::shm {
         uint64_t epoch = 0;
         Label label = INVALID_LABEL;
         NodeId source_id = INVALID_NODE;
+        uint32_t checksum = 0;      // crc32c of header fields + payload, only valid with CHECKSUM flag
+        uint32_t _pad = 0;
     };
     static_assert(sizeof(RecordHeader) % 8 == 0);
-    static_assert(sizeof(RecordHeader) == 48);
+    static_assert(sizeof(RecordHeader) == 56);
+
+    // monotonic and system wide (CLOCK_MONOTONIC / QPC) so writer and reader timestamps compare
+    static inline uint64_t shm_clock_ns() noexcept {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+    // crc32c over everything a reader trusts in a record, state is excluded since it changes after the write
+    // header fields go first so a writer can continue the crc while it copies the payload in
+    static inline uint32_t record_header_checksum(const RecordHeader& rec) noexcept {
+        const uint64_t fields[6] = {
+            static_cast<uint64_t>(rec.magic) | (static_cast<uint64_t>(rec.flags) << 32),
+            static_cast<uint64_t>(rec.user_seq),
+            static_cast<uint64_t>(rec.total_size),
+            static_cast<uint64_t>(rec.payload_size),
+            rec.epoch,
+            static_cast<uint64_t>(static_cast<uint32_t>(rec.label)) | (static_cast<uint64_t>(static_cast<uint32_t>(rec.source_id)) << 32)
+        };
+        return mem::crc32c(fields, sizeof(fields));
+    }
+
+    static inline uint32_t record_checksum(const RecordHeader& rec, const std::byte* payload) noexcept {
+        return mem::crc32c(payload, rec.payload_size, record_header_checksum(rec));
+    }
 
     static constexpr size_t align_up(size_t curr_size, size_t align) noexcept {
         return (curr_size + (align - 1)) & ~(align - 1);
     }
 
     struct ShmLayout {
+        // lanes start and end on a page (64KB covers windows allocation granularity too) so each
+        // lane can be mapped on its own
+        static constexpr size_t LANE_ALIGN = 64 * KILOBYTE;
         static constexpr size_t HDR_OFFSET = 0;
         static constexpr size_t META_DATA_OFFSET = align_up(sizeof(shm::ShmHeader), 64);
-        static constexpr size_t DATA_BLOCK_OFFSET = align_up(META_DATA_OFFSET + sizeof(ShmMetaData), 64);
-        static constexpr size_t DATA_BLOCK_SIZE = SHM_BLOCK_SIZE - DATA_BLOCK_OFFSET;
-        // largest allowed position where a payload write ends (leaves enough room for wrap record header in all cases)
-        static constexpr size_t DATA_USABLE_LIMIT = DATA_BLOCK_SIZE - sizeof(RecordHeader);
+        static constexpr size_t LANE_TABLE_OFFSET = align_up(META_DATA_OFFSET + sizeof(ShmMetaData), 64);
+        static constexpr size_t DATA_BLOCK_OFFSET = align_up(LANE_TABLE_OFFSET + SHM_MAX_LANES * sizeof(LaneMeta), LANE_ALIGN);
+
+        // sized per block, both sides derive these from the total size in ShmHeader and lane count in ShmMetaData
+        size_t total_size = 0;
+        size_t data_block_size = 0;
+        uint32_t lane_count = 0;
+        size_t lane_size = 0;
+        bool mirrored = false;
+        // largest allowed position in a lane where a payload write ends. a mirrored lane can use all of it,
+        // otherwise leave enough room for wrap record header in all cases
+        size_t lane_usable_limit = 0;
+
+        ShmLayout() = default;
+        explicit ShmLayout(size_t total, uint32_t lanes, bool mirror = false) noexcept :
+            total_size(total),
+            data_block_size(total - DATA_BLOCK_OFFSET),
+            lane_count(lanes),
+            lane_size(((total - DATA_BLOCK_OFFSET) / lanes) & ~(LANE_ALIGN - 1)),
+            mirrored(mirror),
+            lane_usable_limit(mirror ? lane_size : lane_size - sizeof(RecordHeader)) {}
+
+        static constexpr size_t lane_meta_offset(uint32_t lane) noexcept {
+            return LANE_TABLE_OFFSET + lane * sizeof(LaneMeta);
+        }
+
+        size_t header_offset(uint32_t lane, uint64_t pos_bytes) const noexcept {
+            return DATA_BLOCK_OFFSET + lane * lane_size + (pos_bytes % lane_size);
+        }
+
+        size_t data_offset(uint32_t lane, uint64_t pos_bytes) const noexcept {
+            return header_offset(lane, pos_bytes) + sizeof(RecordHeader);
+        }
     };
     static_assert(ShmLayout::META_DATA_OFFSET >= sizeof(shm::ShmHeader), "meta overlaps header");
-    static_assert(ShmLayout::DATA_BLOCK_OFFSET >= ShmLayout::META_DATA_OFFSET + sizeof(ShmMetaData), "data overlaps meta");
-    static_assert(ShmLayout::DATA_BLOCK_OFFSET <= SHM_BLOCK_SIZE, "data offset exceeds block size");
-    static_assert(ShmLayout::DATA_BLOCK_SIZE > 0, "no space for data");
-    static_assert(ShmLayout::DATA_USABLE_LIMIT <= ShmLayout::DATA_BLOCK_SIZE, "usable limit invalid");
-
-    static inline size_t get_header_offset(uint64_t pos_bytes) noexcept {
-        return ShmLayout::DATA_BLOCK_OFFSET + (pos_bytes % ShmLayout::DATA_BLOCK_SIZE);
-    }
+    static_assert(ShmLayout::LANE_TABLE_OFFSET >= ShmLayout::META_DATA_OFFSET + sizeof(ShmMetaData), "lanes overlap meta");
+    static_assert(ShmLayout::DATA_BLOCK_OFFSET >= ShmLayout::LANE_TABLE_OFFSET + SHM_MAX_LANES * sizeof(LaneMeta), "data overlaps lanes");
+    static_assert((((SHM_MIN_BLOCK_SIZE - ShmLayout::DATA_BLOCK_OFFSET) / SHM_MAX_LANES) & ~(ShmLayout::LANE_ALIGN - 1)) >= SHM_MIN_LANE_SIZE,
+                  "min block cannot fit every lane");
 
-    static inline size_t get_data_offset(uint64_t pos_bytes) noexcept {
-        return get_header_offset(pos_bytes) + sizeof(RecordHeader);
+    static inline bool validate_layout(size_t block_size) noexcept {
+        // sizes come from config or another process, anything outside the supported range
+        // (or not a whole number of pages) did not come from us
+        return block_size >= SHM_MIN_BLOCK_SIZE &&
+               block_size <= SHM_MAX_BLOCK_SIZE &&
+               block_size % (64 * KILOBYTE) == 0;
     }
 
-    static inline bool validate_layout(size_t block_size) noexcept {
-        // this should ALWAYS return true due to static_asserts above
-        // but a sanity at runtime check incase someone changes something 
-        return block_size == SHM_BLOCK_SIZE;
+    static inline bool validate_lanes(uint32_t lane_count) noexcept {
+        return lane_count >= 1 && lane_count <= SHM_MAX_LANES;
     }
 }
\ No newline at end of file
@@ -0,0 +1,192 @@
+#include "shm_mailbox.h"
+#include <chrono>
+#include <cstring>
+#include <thread>
+#include "safe_print.h"
+#include "memory/copy.h"
+
+namespace eroil::shm {
+    ShmMailbox::ShmMailbox(Label label, size_t label_size) :
+        m_label(label), m_label_size(label_size),
+        m_shm(label, MailboxLayout::total_size(label_size), ShmKind::Mailbox),
+        m_meta(nullptr), m_data(nullptr) {}
+
+    bool ShmMailbox::create_or_open() {
+        if (is_open()) return true;
+
+        if (m_label_size == 0 || m_label_size > MAX_LABEL_SIZE) {
+            ERR_PRINT("shm mailbox label size outside the supported range, label=", m_label, " size=", m_label_size);
+            return false;
+        }
+
+        shm::ShmResult create_result = m_shm.create();
+        switch (create_result.code) {
+            case ShmErr::None: { return init_as_new(); }
+            case ShmErr::AlreadyExists: { break; } // someone else on the host got here first
+            default: {
+                ERR_PRINT("shm mailbox create err=", create_result.code_to_string(), " label=", m_label);
+                return false;
+            }
+        }
+
+        // the creator may still be sizing or initializing it, give it a moment
+        m_shm = Shm(m_label, 0, ShmKind::Mailbox);
+        for (int i = 0; i < 100; ++i) {
+            shm::ShmResult open_result = m_shm.open();
+            if (open_result.ok()) {
+                if (adopt_existing()) return true;
+                m_shm.close();
+                m_shm = Shm(m_label, 0, ShmKind::Mailbox);
+            } else if (open_result.code != ShmErr::NotInitialized) {
+                ERR_PRINT("shm mailbox open err=", open_result.code_to_string(), " label=", m_label);
+                return false;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+
+        ERR_PRINT("shm mailbox for label=", m_label, " never became ready or does not match, size=", m_label_size);
+        return false;
+    }
+
+    bool ShmMailbox::init_as_new() {
+        auto* hdr = m_shm.map_to_type<ShmHeader>(MailboxLayout::HDR_OFFSET);
+        auto* meta = m_shm.map_to_type<MailboxMeta>(MailboxLayout::META_OFFSET);
+        if (hdr == nullptr || meta == nullptr) {
+            ERR_PRINT("shm mailbox offsets invalid, label=", m_label, " total=", m_shm.total_size());
+            return false;
+        }
+
+        hdr->state.store(SHM_INITING, std::memory_order_relaxed);
+        hdr->magic = MAGIC_NUM;
+        hdr->version = VERSION;
+        hdr->total_size = m_shm.total_size();
+
+        meta->seq.store(0, std::memory_order_relaxed);
+        meta->label = m_label;
+        meta->label_size = static_cast<uint32_t>(m_label_size);
+        meta->source_id = INVALID_NODE;
+        meta->recv_offset = 0;
+        meta->payload_size = 0;
+
+        m_meta = meta;
+        m_data = m_shm.map_to_type<std::byte>(MailboxLayout::DATA_OFFSET);
+        hdr->state.store(SHM_READY, std::memory_order_release);
+        return m_data != nullptr;
+    }
+
+    bool ShmMailbox::adopt_existing() {
+        auto* hdr = m_shm.map_to_type<ShmHeader>(MailboxLayout::HDR_OFFSET);
+        auto* meta = m_shm.map_to_type<MailboxMeta>(MailboxLayout::META_OFFSET);
+        if (hdr == nullptr || meta == nullptr) return false;
+        if (hdr->state.load(std::memory_order_acquire) != SHM_READY) return false;
+
+        // other processes may be using it, a block left by another build or label size is never reset
+        if (hdr->magic != MAGIC_NUM || hdr->version != VERSION ||
+            hdr->total_size != m_shm.total_size() ||
+            meta->label != m_label || meta->label_size != m_label_size) {
+            ERR_PRINT("existing shm mailbox does not match, label=", m_label, " size=", m_label_size,
+                      " found label=", meta->label, " size=", meta->label_size, " version=", hdr->version);
+            return false;
+        }
+
+        m_data = m_shm.map_to_type<std::byte>(MailboxLayout::DATA_OFFSET);
+        if (m_data == nullptr) return false;
+        m_meta = meta;
+        return true;
+    }
+
+    uint64_t ShmMailbox::current_seq() const noexcept {
+        if (m_meta == nullptr) return 0;
+        return m_meta->seq.load(std::memory_order_acquire) & ~1ull;
+    }
+
+    uint64_t ShmMailbox::lock_for_write() noexcept {
+        uint64_t seq = m_meta->seq.load(std::memory_order_relaxed);
+
+        // same holder we already waited out, most likely dead. dont spin another LOCK_WAIT_NS
+        const uint64_t wedged = m_wedged_seq.load(std::memory_order_relaxed);
+        if (wedged != 0) {
+            if (seq == wedged) return 0;
+            m_wedged_seq.store(0, std::memory_order_relaxed);
+        }
+
+        uint64_t wait_start = 0;
+        while (true) {
+            if ((seq & 1) == 0) {
+                if (m_meta->seq.compare_exchange_weak(seq, seq + 1, std::memory_order_acquire, std::memory_order_relaxed)) {
+                    return seq + 1;
+                }
+                continue;
+            }
+
+            // another publisher is mid write, wait it out. a holder that died leaves seq odd,
+            // readers then see Busy and writes fail rather than tear a value still being copied
+            const uint64_t now = shm_clock_ns();
+            if (wait_start == 0) wait_start = now;
+            if (now - wait_start > LOCK_WAIT_NS) {
+                m_wedged_seq.store(seq, std::memory_order_relaxed);
+                return 0;
+            }
+
+            std::this_thread::yield();
+            seq = m_meta->seq.load(std::memory_order_relaxed);
+        }
+    }
+
+    bool ShmMailbox::write(const NodeId source_id,
+                           const uint32_t recv_offset,
+                           const std::byte* buf,
+                           const size_t size) noexcept {
+        if (m_meta == nullptr || buf == nullptr) return false;
+        if (size == 0 || size > m_label_size) return false;
+
+        const uint64_t locked = lock_for_write();
+        if (locked == 0) return false;
+        std::atomic_thread_fence(std::memory_order_release);
+
+        m_meta->source_id = source_id;
+        m_meta->recv_offset = recv_offset;
+        m_meta->payload_size = static_cast<uint32_t>(size);
+        mem::copy_out(m_data, buf, size);
+
+        m_meta->seq.store(locked + 1, std::memory_order_release);
+        return true;
+    }
+
+    MailboxRead ShmMailbox::read(uint64_t& seen,
+                                 NodeId& source_id,
+                                 uint32_t& recv_offset,
+                                 uint32_t& size,
+                                 std::byte* dst,
+                                 const size_t dst_size) const noexcept {
+        if (m_meta == nullptr || dst == nullptr) return MailboxRead::Invalid;
+
+        for (uint32_t attempt = 0; attempt < MAX_READ_TRIES; ++attempt) {
+            const uint64_t before = m_meta->seq.load(std::memory_order_acquire);
+            if (before == seen) return MailboxRead::NoChange;
+            if ((before & 1) != 0) {
+                std::this_thread::yield();
+                continue;
+            }
+
+            const NodeId src = m_meta->source_id;
+            const uint32_t offset = m_meta->recv_offset;
+            const uint32_t payload = m_meta->payload_size;
+
+            // fields may be torn, only trust them once seq is confirmed unchanged
+            const bool fits = payload <= m_label_size && static_cast<size_t>(offset) + payload <= dst_size;
+            if (fits) std::memcpy(dst + offset, m_data, payload);
+
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (m_meta->seq.load(std::memory_order_relaxed) != before) continue;
+
+            seen = before;
+            if (!fits || payload == 0) return MailboxRead::Invalid;
+            source_id = src;
+            recv_offset = offset;
+            size = payload;
+            return MailboxRead::NewData;
+        }
+        return MailboxRead::Busy;
+    }
+}
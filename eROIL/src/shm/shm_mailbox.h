@@ -0,0 +1,97 @@
+#pragma once
+#include <atomic>
+#include "shm.h"
+#include "shm_header.h"
+#include "types/const_types.h"
+#include "macros.h"
+
+namespace eroil::shm {
+    // latest value of one label, guarded by a seqlock. seq is odd while a writer is
+    // copying in, readers copy out and retry if seq moved underneath them
+    struct MailboxMeta {
+        alignas(64) std::atomic<uint64_t> seq{0};
+        uint64_t _reserved = 0;
+        Label label = INVALID_LABEL;
+        uint32_t label_size = 0;                // payload capacity
+        NodeId source_id = INVALID_NODE;        // fields below are written under the seqlock
+        uint32_t recv_offset = 0;
+        uint32_t payload_size = 0;
+        uint32_t _pad = 0;
+    };
+    static_assert(sizeof(MailboxMeta) == 64);
+    static_assert(alignof(MailboxMeta) == 64);
+
+    struct MailboxLayout {
+        static constexpr size_t HDR_OFFSET = 0;
+        static constexpr size_t META_OFFSET = 64;
+        static constexpr size_t DATA_OFFSET = META_OFFSET + sizeof(MailboxMeta);
+
+        static constexpr size_t total_size(const size_t label_size) noexcept {
+            return DATA_OFFSET + ((label_size + 63) & ~static_cast<size_t>(63));
+        }
+    };
+    static_assert(sizeof(ShmHeader) <= MailboxLayout::META_OFFSET);
+
+    enum class MailboxRead {
+        NewData,    // a value newer than seen was copied out
+        NoChange,   // nothing published since seen
+        Busy,       // writer kept seq odd or kept moving it, try again later
+        Invalid,    // block not ready or published value does not fit the destination
+    };
+
+    // one block per label (eroil.mbox.<label>) shared by every publisher and subscriber on
+    // the host. publishers write it once per send instead of a record per subscriber ring,
+    // subscribers read it from the app thread so no recv worker sits in the path
+    class ShmMailbox {
+        private:
+            // a publisher gives up after waiting this long for seq. the holder is never
+            // taken over, a stalled writer that wakes would still copy over the next value.
+            // once a holder outlasted it, writes fail right away until seq moves again
+            static constexpr uint64_t LOCK_WAIT_NS = 1000ull * 1000ull * 1000ull;
+            static constexpr uint32_t MAX_READ_TRIES = 64;
+
+            Label m_label;
+            size_t m_label_size;
+            Shm m_shm;
+            MailboxMeta* m_meta;
+            std::byte* m_data;
+            std::atomic<uint64_t> m_wedged_seq{0};  // odd seq a holder kept past LOCK_WAIT_NS, 0 = none
+
+        public:
+            ShmMailbox(Label label, size_t label_size);
+            ~ShmMailbox() = default;
+
+            EROIL_NO_COPY(ShmMailbox)
+            EROIL_NO_MOVE(ShmMailbox)
+
+            // first user on the host creates the block, everyone else opens it
+            bool create_or_open();
+            bool is_open() const noexcept { return m_meta != nullptr; }
+            Label label() const noexcept { return m_label; }
+            size_t label_size() const noexcept { return m_label_size; }
+
+            // seq of the value currently held, readers start from here so a value left by
+            // an earlier run is not handed out as new
+            uint64_t current_seq() const noexcept;
+
+            NO_DISCARD bool write(const NodeId source_id,
+                                  const uint32_t recv_offset,
+                                  const std::byte* buf,
+                                  const size_t size) noexcept;
+
+            // copies the latest value to dst + its recv offset when its seq differs from seen
+            // the copy goes straight to dst, on Busy it may hold part of a value
+            NO_DISCARD MailboxRead read(uint64_t& seen,
+                                        NodeId& source_id,
+                                        uint32_t& recv_offset,
+                                        uint32_t& size,
+                                        std::byte* dst,
+                                        const size_t dst_size) const noexcept;
+
+        private:
+            bool init_as_new();
+            bool adopt_existing();
+            // odd seq now held by this writer, 0 if another writer never let go
+            uint64_t lock_for_write() noexcept;
+    };
+}
@@ -1,16 +1,25 @@
 #include "shm_recv.h"
+#include <algorithm>
 #include <cstring>
 #include <memory>
 #include "safe_print.h"
+#include "memory/crc32c.h"
 
 namespace eroil::shm {
-    ShmRecv::ShmRecv(NodeId id) : m_id(id), m_shm(id, SHM_BLOCK_SIZE), m_event(id) {}
+    ShmRecv::ShmRecv(NodeId id, size_t ring_size, uint32_t lane_count) :
+        m_id(id), m_ring_size(ring_size), m_lane_count(lane_count), m_shm(id, ring_size),
+        m_layout(ring_size, lane_count), m_event(id) {}
     ShmRecv::~ShmRecv() = default;
 
     bool ShmRecv::create_or_open() {
-        if (!validate_layout(m_shm.total_size())) {
-            ERR_PRINT("shm recv block size does not match expected size");
-            ERR_PRINT("    expected=", SHM_BLOCK_SIZE, ", actual=", m_shm.total_size());
+        if (!validate_layout(m_ring_size)) {
+            ERR_PRINT("shm recv block size is outside the supported range");
+            ERR_PRINT("    min=", SHM_MIN_BLOCK_SIZE, ", max=", SHM_MAX_BLOCK_SIZE, ", actual=", m_ring_size);
+            return false;
+        }
+
+        if (!validate_lanes(m_lane_count)) {
+            ERR_PRINT("shm recv lane count is outside the supported range, lanes=", m_lane_count, " max=", SHM_MAX_LANES);
             return false;
         }
 
@@ -21,7 +30,10 @@ namespace eroil::shm {
         //      block exists but valid -> reset it
         shm::ShmResult create_result = m_shm.create();
         switch (create_result.code) {
-            case ShmErr::None: { return init_as_new(); }
+            case ShmErr::None: {
+                map_lanes();
+                return init_as_new();
+            }
             case ShmErr::AlreadyExists: { break; } // try to open it below
             case ShmErr::DoubleOpen:    // fallthrough
             case ShmErr::InvalidName:   // fallthrough
@@ -36,10 +48,12 @@ namespace eroil::shm {
             }
         }
 
-        // block existed, opening it instead
+        // block existed, opening it instead. a previous run may have used another size so
+        // adopt whatever exists and grow it if it is smaller than what we were asked for
+        m_shm = Shm(m_id, 0);
         shm::ShmResult open_result = m_shm.open();
         switch (open_result.code) {
-            case ShmErr::None: { return reinit(); }
+            case ShmErr::None: { return adopt_existing(); }
             case ShmErr::DoubleOpen:    // fallthrough
             case ShmErr::InvalidName:   // fallthrough
             case ShmErr::DoesNotExist:  // fallthrough
@@ -59,6 +73,25 @@ namespace eroil::shm {
         return false;
     }
 
+    bool ShmRecv::adopt_existing() {
+        if (m_shm.total_size() < m_ring_size) {
+            shm::ShmResult resize_result = m_shm.resize(m_ring_size);
+            if (!resize_result.ok()) {
+                LOG("shm recv keeping existing block size=", m_shm.total_size(), " requested=", m_ring_size,
+                    " err=", resize_result.code_to_string());
+            }
+        }
+
+        if (!validate_layout(m_shm.total_size())) {
+            ERR_PRINT("existing shm recv block size is outside the supported range, size=", m_shm.total_size());
+            return false;
+        }
+
+        m_layout = ShmLayout(m_shm.total_size(), m_lane_count);
+        map_lanes();
+        return reinit();
+    }
+
     void ShmRecv::close() {
         m_shm.close();
         m_event.close();
@@ -89,11 +122,12 @@ namespace eroil::shm {
         }
 
         meta->node_id = m_id;
-        meta->data_block_size = ShmLayout::DATA_BLOCK_SIZE;
+        meta->lane_count = m_layout.lane_count;
+        meta->ring_flags = m_layout.mirrored ? static_cast<uint32_t>(RING_MIRRORED) : 0u;
+        meta->data_block_size = m_layout.data_block_size;
         meta->generation.store(1, std::memory_order_relaxed);
-        meta->head_bytes.store(0, std::memory_order_relaxed);
-        meta->tail_bytes.store(0, std::memory_order_relaxed);
-        meta->published_count.store(0, std::memory_order_relaxed);
+        meta->full_count.store(0, std::memory_order_relaxed);
+        reset_lanes(true);
         
         // announce this is ready for use
         hdr->state.store(SHM_READY, std::memory_order_release);
@@ -119,9 +153,11 @@ namespace eroil::shm {
  
         // if header is mangled, assume block needs to be treated as new
         hdr->state.store(SHM_INITING, std::memory_order_release);
+        auto* old_meta = m_shm.map_to_type<ShmMetaData>(ShmLayout::META_DATA_OFFSET);
         if (hdr->magic != MAGIC_NUM ||
             hdr->version != VERSION ||
-            hdr->total_size != m_shm.total_size()) {
+            hdr->total_size != m_shm.total_size() ||
+            old_meta == nullptr || old_meta->lane_count != m_layout.lane_count) {
             return init_as_new();
         }
 
@@ -133,12 +169,13 @@ namespace eroil::shm {
             return false;
         }
 
+        // lane owners are kept, senders that survived us carry on in the lane they had
         meta->node_id = m_id;
-        meta->data_block_size = ShmLayout::DATA_BLOCK_SIZE;
+        meta->data_block_size = m_layout.data_block_size;
+        meta->ring_flags = m_layout.mirrored ? static_cast<uint32_t>(RING_MIRRORED) : 0u;
         meta->generation.fetch_add(1, std::memory_order_relaxed);
-        meta->head_bytes.store(0, std::memory_order_relaxed);
-        meta->tail_bytes.store(0, std::memory_order_relaxed);
-        meta->published_count.store(0, std::memory_order_relaxed);
+        meta->full_count.store(0, std::memory_order_relaxed);
+        reset_lanes(false);
         
         // announce this is ready for use
         hdr->state.store(SHM_READY, std::memory_order_release);
@@ -168,9 +205,41 @@ namespace eroil::shm {
             return ShmRecvData{ShmRecvErr::BlockCorrupted};
         }
 
-        uint64_t gen = meta->generation.load(std::memory_order_acquire);
-        uint64_t tail = meta->tail_bytes.load(std::memory_order_acquire);
-        uint64_t head = meta->head_bytes.load(std::memory_order_acquire);
+        const uint64_t gen = meta->generation.load(std::memory_order_acquire);
+
+        // one record per call, start after the lane we served last so every source gets a turn
+        // a lane whose writer has not finished is skipped rather than blocking the others
+        m_stalled_lanes = 0;
+        for (uint32_t i = 0; i < m_layout.lane_count; ++i) {
+            const uint32_t lane = (m_next_lane + i) % m_layout.lane_count;
+            ShmRecvData data = recv_lane(lane, gen, recv_buf, max_size);
+
+            switch (data.result.code) {
+                case ShmRecvErr::NoRecords: { continue; }
+                case ShmRecvErr::NotYetPublished: {
+                    m_stalled_lanes |= (1u << lane);
+                    continue;
+                }
+                default: {
+                    m_next_lane = (lane + 1) % m_layout.lane_count;
+                    return data;
+                }
+            }
+        }
+
+        if (m_stalled_lanes != 0) return ShmRecvData{ShmRecvErr::NotYetPublished};
+        return ShmRecvData{ShmRecvErr::NoRecords};
+    }
+
+    ShmRecvData ShmRecv::recv_lane(uint32_t lane, uint64_t gen, std::byte* recv_buf, size_t max_size) {
+        LaneMeta* lm = lane_meta(lane);
+        if (lm == nullptr) {
+            ERR_PRINT("shm recv lane pointer offset invalid, lane=", lane);
+            return ShmRecvData{ShmRecvErr::BlockCorrupted};
+        }
+
+        uint64_t tail = lm->tail_bytes.load(std::memory_order_relaxed);
+        uint64_t head = lm->head_bytes.load(std::memory_order_acquire);
 
         if (head == tail) return ShmRecvData{ShmRecvErr::NoRecords};
         if (head < tail) {
@@ -181,7 +250,8 @@ namespace eroil::shm {
         // find next COMMITTED record, moving passed WRAP records we find
         bool found = false;
         while (head > tail && !found) {
-            auto* rec_hdr = m_shm.map_to_type<RecordHeader>(get_header_offset(tail));
+            auto* rec_hdr = record_at(lane, tail);
+            if (rec_hdr == nullptr) return ShmRecvData{ShmRecvErr::BlockCorrupted};
             const uint32_t state = rec_hdr->state.load(std::memory_order_acquire);
             
             if (state == WRITING) {
@@ -192,10 +262,10 @@ namespace eroil::shm {
                 return ShmRecvData{ShmRecvErr::BlockCorrupted};
             }
 
-            // we cannot trust messages, flush the backlog and continue
+            // we cannot trust messages, flush this lane and continue
             if (rec_hdr->epoch != gen) {
-                ERR_PRINT("flushing backlog due to invalid record generation");
-                flush_backlog();
+                ERR_PRINT("flushing lane backlog due to invalid record generation, lane=", lane);
+                flush_lane(lane);
                 return ShmRecvData{ShmRecvErr::NoRecords};
             }
 
@@ -210,15 +280,13 @@ namespace eroil::shm {
                     const size_t total_size = rec_hdr->total_size;
                     if (total_size < sizeof(RecordHeader) ||
                        ((total_size & 7u) != 0) ||
-                       (total_size > ShmLayout::DATA_BLOCK_SIZE) ||
+                       (total_size > m_layout.lane_size) ||
                        (rec_hdr->payload_size != 0)) return ShmRecvData{ShmRecvErr::BlockCorrupted};
 
                     // move tail_bytes passed the wrap record for next iteration
-                    // update head incase someone allocated while we did this
                     const uint64_t new_tail = tail + static_cast<uint64_t>(total_size);
-                    meta->tail_bytes.store(new_tail, std::memory_order_release);
+                    lm->tail_bytes.store(new_tail, std::memory_order_release);
                     tail = new_tail;
-                    head = meta->head_bytes.load(std::memory_order_acquire);
                     continue;
                 }
 
@@ -233,9 +301,9 @@ namespace eroil::shm {
         if (!found) return ShmRecvData{ShmRecvErr::NoRecords};
         
         // read header and data
-        auto* rec_hdr = m_shm.map_to_type<RecordHeader>(get_header_offset(tail));
+        auto* rec_hdr = record_at(lane, tail);
         if (rec_hdr == nullptr) {
-            ERR_PRINT("rec_hdr was null, tail offset invalid, offset=", get_header_offset(tail));
+            ERR_PRINT("rec_hdr was null, tail offset invalid, offset=", m_layout.header_offset(lane, tail));
             return ShmRecvData{ShmRecvErr::BlockCorrupted};
         }
 
@@ -243,8 +311,9 @@ namespace eroil::shm {
         const size_t total_size = rec_hdr->total_size;
         if (total_size < sizeof(RecordHeader) ||
            ((total_size & 7u) != 0) ||
-           (total_size > ShmLayout::DATA_BLOCK_SIZE) ||
-           (rec_hdr->payload_size == 0))  { return ShmRecvData{ShmRecvErr::BlockCorrupted}; }
+           (total_size > m_layout.lane_size) ||
+           (rec_hdr->payload_size == 0) ||
+           (rec_hdr->payload_size > total_size - sizeof(RecordHeader)))  { return ShmRecvData{ShmRecvErr::BlockCorrupted}; }
 
         // if label is too large to fit in the provided buffer, return error
         if (rec_hdr->payload_size > max_size) {
@@ -259,18 +328,40 @@ namespace eroil::shm {
         out.user_seq = rec_hdr->user_seq;
         out.buf_size = rec_hdr->payload_size;
         out.recv_buf = recv_buf;
-        shm::ShmResult read_result = m_shm.read(out.recv_buf, out.buf_size, get_data_offset(tail));
+
+        // a record that fails its checksum is consumed like any other, total_size passed the checks above
+        // so the next record is still reachable. if total_size itself was the corrupted field the next
+        // header fails its magic check and we fall back to a re-init
+        bool corrupted = false;
+        shm::ShmResult read_result{ ShmErr::None, ShmOp::Read };
+        if (m_layout.mirrored) {
+            // record may run across the lane end, the alias after the lane makes it one contiguous read
+            const std::byte* payload = reinterpret_cast<const std::byte*>(rec_hdr) + sizeof(RecordHeader);
+            if ((rec_hdr->flags & CHECKSUM) != 0) {
+                const uint32_t crc = mem::copy_crc32c(out.recv_buf, payload, out.buf_size, record_header_checksum(*rec_hdr));
+                corrupted = crc != rec_hdr->checksum;
+            } else {
+                std::memcpy(out.recv_buf, payload, out.buf_size);
+            }
+        } else if ((rec_hdr->flags & CHECKSUM) != 0) {
+            uint32_t crc = record_header_checksum(*rec_hdr);
+            read_result = m_shm.read(out.recv_buf, out.buf_size, m_layout.data_offset(lane, tail), crc);
+            corrupted = crc != rec_hdr->checksum;
+        } else {
+            read_result = m_shm.read(out.recv_buf, out.buf_size, m_layout.data_offset(lane, tail));
+        }
         if (!read_result.ok()) {
             ERR_PRINT("shm read error=", read_result.code_to_string());
         }
 
         // move tail_bytes passed the record we've just read
         const uint64_t new_tail = tail + static_cast<uint64_t>(total_size);
-        meta->tail_bytes.store(new_tail, std::memory_order_release);
-
-        // use publish count to keep an eye on the number of items published vs yet to consume (debugging only)
-        meta->published_count.fetch_sub(1, std::memory_order_relaxed);
+        lm->tail_bytes.store(new_tail, std::memory_order_release);
 
+        if (corrupted) {
+            ERR_PRINT("shm record failed checksum, skipped label=", out.label, " sourceid=", out.source_id);
+            return ShmRecvData{ShmRecvErr::ChecksumMismatch};
+        }
         return out;
     }
 
@@ -279,23 +370,124 @@ namespace eroil::shm {
         // we're in a situation where we do not know if we can trust that record to allow us to continue
         // 
         // since we dont know what to trust, trust non of it. flush ALL old messages by advancing the 
-        // tail to head, and continuing normally
+        // tail to head, and continuing normally. only the lanes that stalled are flushed, other
+        // sources carry on untouched
         //
         // this should be an EXTREMELY rare case:
         //      - writer died mid-write before publishing "COMMITTED" message
         //      - writer was allowed to write even though generation changed after re-init
         //
+        for (uint32_t lane = 0; lane < m_layout.lane_count; ++lane) {
+            if (m_stalled_lanes == 0 || (m_stalled_lanes & (1u << lane)) != 0) {
+                flush_lane(lane);
+            }
+        }
+        m_stalled_lanes = 0;
+        LOG("flushed shm recv backlog");
+    }
 
-        auto* meta = m_shm.map_to_type<ShmMetaData>(ShmLayout::META_DATA_OFFSET);
-        if (meta == nullptr) {
-            ERR_PRINT("shm recv meta pointer offset invalid");
-            ERR_PRINT("    offset=", ShmLayout::META_DATA_OFFSET);
+    void ShmRecv::flush_lane(uint32_t lane) {
+        LaneMeta* lm = lane_meta(lane);
+        if (lm == nullptr) {
+            ERR_PRINT("shm recv lane pointer offset invalid, lane=", lane);
             return;
         }
         
-        const uint64_t head = meta->head_bytes.load(std::memory_order_acquire);
-        meta->tail_bytes.store(head, std::memory_order_release);
-        meta->published_count.store(0, std::memory_order_relaxed);
-        LOG("flushed shm recv backlog");
+        const uint64_t head = lm->head_bytes.load(std::memory_order_acquire);
+        lm->tail_bytes.store(head, std::memory_order_release);
+    }
+
+    void ShmRecv::map_lanes() {
+        // every lane is mapped twice back to back so records never have to wrap
+        shm::ShmResult result = m_shm.map_mirrored(ShmLayout::DATA_BLOCK_OFFSET, m_layout.lane_size, m_layout.lane_count);
+        if (!result.ok() && result.code != ShmErr::NotSupported) {
+            LOG("shm recv could not mirror lanes, using wrap records, err=", result.code_to_string());
+        }
+        m_layout = ShmLayout(m_layout.total_size, m_layout.lane_count, result.ok());
+    }
+
+    RecordHeader* ShmRecv::record_at(uint32_t lane, uint64_t pos) const noexcept {
+        if (m_layout.mirrored) {
+            std::byte* base = m_shm.mirrored(lane);
+            if (base == nullptr) return nullptr;
+            return reinterpret_cast<RecordHeader*>(base + (pos % m_layout.lane_size));
+        }
+        return m_shm.map_to_type<RecordHeader>(m_layout.header_offset(lane, pos));
+    }
+
+    LaneMeta* ShmRecv::lane_meta(uint32_t lane) const noexcept {
+        return m_shm.map_to_type<LaneMeta>(ShmLayout::lane_meta_offset(lane));
+    }
+
+    void ShmRecv::reset_lanes(bool clear_owners) noexcept {
+        for (uint32_t lane = 0; lane < SHM_MAX_LANES; ++lane) {
+            LaneMeta* lm = lane_meta(lane);
+            if (lm == nullptr) continue;
+            if (clear_owners) lm->owner.store(LANE_FREE, std::memory_order_relaxed);
+            lm->head_bytes.store(0, std::memory_order_relaxed);
+            lm->tail_bytes.store(0, std::memory_order_relaxed);
+            lm->published_count.store(0, std::memory_order_relaxed);
+        }
+        m_next_lane = 0;
+        m_stalled_lanes = 0;
+    }
+
+    uint64_t ShmRecv::backlog_bytes() const noexcept {
+        uint64_t fullest = 0;
+        for (uint32_t lane = 0; lane < m_layout.lane_count; ++lane) {
+            const LaneMeta* lm = lane_meta(lane);
+            if (lm == nullptr) continue;
+
+            const uint64_t tail = lm->tail_bytes.load(std::memory_order_acquire);
+            const uint64_t head = lm->head_bytes.load(std::memory_order_acquire);
+            if (head > tail) fullest = std::max(fullest, head - tail);
+        }
+        return fullest;
+    }
+
+    uint64_t ShmRecv::full_count() const noexcept {
+        const auto* meta = m_shm.map_to_type<ShmMetaData>(ShmLayout::META_DATA_OFFSET);
+        if (meta == nullptr) return 0;
+        return meta->full_count.load(std::memory_order_relaxed);
+    }
+
+    bool ShmRecv::grow(size_t new_total_size) {
+        if (new_total_size <= m_shm.total_size() || !validate_layout(new_total_size)) return false;
+
+        auto* hdr = m_shm.map_to_type<ShmHeader>(ShmLayout::HDR_OFFSET);
+        auto* meta = m_shm.map_to_type<ShmMetaData>(ShmLayout::META_DATA_OFFSET);
+        if (hdr == nullptr || meta == nullptr) return false;
+
+        // same protocol as reinit: writers that see INITING drop the send, writers that reserved
+        // under the old generation are flushed by the epoch check once we are READY again
+        hdr->state.store(SHM_INITING, std::memory_order_release);
+        if (backlog_bytes() != 0) {
+            hdr->state.store(SHM_READY, std::memory_order_release);
+            return false;
+        }
+
+        shm::ShmResult resize_result = m_shm.resize(new_total_size);
+        if (!resize_result.ok()) {
+            // mapping may have moved even on failure, re-read everything through m_shm
+            ERR_PRINT("shm recv could not grow ring, size=", new_total_size, " err=", resize_result.code_to_string());
+            hdr = m_shm.map_to_type<ShmHeader>(ShmLayout::HDR_OFFSET);
+            if (hdr != nullptr) hdr->state.store(SHM_READY, std::memory_order_release);
+            return false;
+        }
+
+        m_layout = ShmLayout(m_shm.total_size(), m_layout.lane_count);
+        map_lanes();
+        hdr = m_shm.map_to_type<ShmHeader>(ShmLayout::HDR_OFFSET);
+        meta = m_shm.map_to_type<ShmMetaData>(ShmLayout::META_DATA_OFFSET);
+        if (hdr == nullptr || meta == nullptr) return false;
+        hdr->total_size = m_shm.total_size();
+        meta->data_block_size = m_layout.data_block_size;
+        meta->ring_flags = m_layout.mirrored ? static_cast<uint32_t>(RING_MIRRORED) : 0u;
+        meta->generation.fetch_add(1, std::memory_order_relaxed);
+        meta->full_count.store(0, std::memory_order_relaxed);
+        reset_lanes(false);
+
+        hdr->state.store(SHM_READY, std::memory_order_release);
+        return true;
     }
 }
\ No newline at end of file
@@ -16,6 +16,7 @@ namespace eroil::shm {
         TailCorruption,     // re-init
         BlockCorrupted,     // re-init
         LabelTooLarge,      // label recvd larger than 
+        ChecksumMismatch,   // record skipped, keep reading
         UnknownError        // re-init
     };
 
@@ -39,6 +40,8 @@ namespace eroil::shm {
                 case ShmRecvErr::NotYetPublished: return "NotYetPublished";
                 case ShmRecvErr::TailCorruption: return "TailCorruption";
                 case ShmRecvErr::BlockCorrupted: return "BlockCorrupted";
+                case ShmRecvErr::LabelTooLarge: return "LabelTooLarge";
+                case ShmRecvErr::ChecksumMismatch: return "ChecksumMismatch";
                 case ShmRecvErr::UnknownError: return "UnknownError";
                 default: return "Unknown - error is undefined";
             }
@@ -74,13 +77,18 @@ namespace eroil::shm {
     class ShmRecv {
         private:
             NodeId m_id;
+            size_t m_ring_size;     // requested block size, an existing larger block is kept as is
+            uint32_t m_lane_count;  // one lane per local source node
             Shm m_shm;
+            ShmLayout m_layout;
+            uint32_t m_next_lane = 0;       // round robin start for the next recv
+            uint32_t m_stalled_lanes = 0;   // bit per lane whose next record was not yet published
             evt::NamedSemaphore m_event;
             ShmHeader* m_shm_hdr = nullptr;
             ShmMetaData* m_shm_meta = nullptr;
 
         public:
-            ShmRecv(NodeId id);
+            ShmRecv(NodeId id, size_t ring_size, uint32_t lane_count);
             ~ShmRecv();
 
             EROIL_NO_COPY(ShmRecv)
@@ -90,8 +98,30 @@ namespace eroil::shm {
             void close();
             bool init_as_new();
             bool reinit();
+            bool adopt_existing();
             NO_DISCARD evt::NamedSemResult wait();
+            // next record from any lane, lanes are served round robin so one busy source cannot starve the rest
             NO_DISCARD ShmRecvData recv(std::byte* recv_buf, size_t max_size);
+            // flushes the lanes whose writer stalled, or every lane when none did
             void flush_backlog();
+
+            // ring occupancy, used by the recv worker to decide when to grow
+            // per lane, the fullest lane is what drops sends
+            size_t capacity() const noexcept { return m_layout.lane_size; }
+            size_t total_size() const noexcept { return m_layout.total_size; }
+            uint64_t backlog_bytes() const noexcept;
+            uint64_t full_count() const noexcept;
+
+            // only valid while the ring is empty, senders remap on their next send
+            // returns false when the platform cannot resize (windows) or the resize failed
+            bool grow(size_t new_total_size);
+
+        private:
+            void map_lanes();
+            RecordHeader* record_at(uint32_t lane, uint64_t pos) const noexcept;
+            LaneMeta* lane_meta(uint32_t lane) const noexcept;
+            void reset_lanes(bool clear_owners) noexcept;
+            ShmRecvData recv_lane(uint32_t lane, uint64_t gen, std::byte* recv_buf, size_t max_size);
+            void flush_lane(uint32_t lane);
     };
 }
\ No newline at end of file
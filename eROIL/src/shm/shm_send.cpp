@@ -3,29 +3,57 @@
 #include <cstring>
 #include <memory>
 #include "safe_print.h"
+#include "platform/platform.h"
+#include "memory/copy.h"
+#include "memory/crc32c.h"
 
 namespace eroil::shm {
-    ShmSend::ShmSend(NodeId dst_id) : m_dst_id(dst_id), m_shm(dst_id, SHM_BLOCK_SIZE), m_event(dst_id) {}
+    // ring size and lane count are picked by the destination, open adopts whatever it created
+    ShmSend::ShmSend(NodeId src_id, NodeId dst_id, bool checksum) :
+        m_src_id(src_id), m_dst_id(dst_id), m_shm(dst_id, 0), m_layout{}, m_lane(SHM_MAX_LANES),
+        m_event(dst_id), m_checksum(checksum), m_pid(plat::process_id()) {}
     ShmSend::~ShmSend() = default;
 
     bool ShmSend::open() {
-        if (!validate_layout(m_shm.total_size())) {
-            ERR_PRINT("shm send block size does not match expected size");
-            ERR_PRINT("    expected=", SHM_BLOCK_SIZE, ", actual=", m_shm.total_size());
-            return false;
-        }
-
         // senders only ever open a destination nodes shared memory block
         // never create it. try a few times before giving up
+        bool opened = false;
         for (int i = 0; i < 50; ++i) {
             shm::ShmResult open_result = m_shm.open();
             if (open_result.ok()) {
-                return true;
+                opened = true;
+                break;
             }
             std::this_thread::yield();
         }
+        if (!opened) return false;
 
-        return false;
+        if (!validate_layout(m_shm.total_size())) {
+            ERR_PRINT("shm send block size is outside the supported range, nodeid=", m_dst_id);
+            ERR_PRINT("    min=", SHM_MIN_BLOCK_SIZE, ", max=", SHM_MAX_BLOCK_SIZE, ", actual=", m_shm.total_size());
+            m_shm.close();
+            return false;
+        }
+
+        // claim our lane up front so a full block is reported here rather than on every send
+        auto* hdr = m_shm.map_to_type<ShmHeader>(ShmLayout::HDR_OFFSET);
+        auto* meta = m_shm.map_to_type<ShmMetaData>(ShmLayout::META_DATA_OFFSET);
+        if (hdr == nullptr || meta == nullptr || hdr->state.load(std::memory_order_acquire) != SHM_READY) {
+            m_shm.close();
+            return false;
+        }
+
+        if (!refresh_layout(*hdr)) {
+            m_shm.close();
+            return false;
+        }
+
+        if (claim_lane() == nullptr) {
+            ERR_PRINT("shm send found no free lane in block for nodeid=", m_dst_id, " lanes=", m_layout.lane_count);
+            m_shm.close();
+            return false;
+        }
+        return true;
     }
 
     void ShmSend::close() {
@@ -60,105 +88,91 @@ namespace eroil::shm {
             return { ShmSendErr::InvalidOffset, ShmSendOp::Send };
         }
 
+        // consumer grew its ring or re-created it with another lane count, map the new layout before touching any record
+        const bool block_mirrored = (meta->ring_flags & RING_MIRRORED) != 0;
+        if (hdr->total_size != m_layout.total_size || meta->lane_count != m_layout.lane_count ||
+            block_mirrored != m_layout.mirrored) {
+            if (!refresh_layout(*hdr)) return { ShmSendErr::BlockNotInitialized, ShmSendOp::Send };
+            hdr = m_shm.map_to_type<ShmHeader>(ShmLayout::HDR_OFFSET);
+            meta = m_shm.map_to_type<ShmMetaData>(ShmLayout::META_DATA_OFFSET);
+        }
+
+        // lane ownership is cleared when the consumer creates the block fresh, claim again if we lost it
+        LaneMeta* lane = claim_lane();
+        if (lane == nullptr) {
+            ERR_PRINT("shm send found no free lane for label=", label, " to nodeid=", m_dst_id);
+            return { ShmSendErr::NoFreeLane, ShmSendOp::Send };
+        }
+
         uint64_t gen = meta->generation.load(std::memory_order_acquire);
 
         // how much space will we need for this data send
         const size_t reserved = align_up(buf_size + sizeof(RecordHeader), 8);
         
         // this is a hard error condition that should never occur
-        if (reserved > ShmLayout::DATA_BLOCK_SIZE) {
+        if (reserved > m_layout.lane_usable_limit) {
             ERR_PRINT("tried to reserve more than allowed, reserved=", reserved, 
-                      " allowed=", ShmLayout::DATA_BLOCK_SIZE, ", to nodeid=", m_dst_id);
+                      " allowed=", m_layout.lane_usable_limit, ", to nodeid=", m_dst_id);
             return { ShmSendErr::SizeTooLarge, ShmSendOp::Send };
         }
 
-        bool reserved_success = false;
-        uint64_t head = meta->head_bytes.load(std::memory_order_acquire);
-        
-        for (int tries = 0; tries < 100; ++tries) {
-            const uint64_t tail = meta->tail_bytes.load(std::memory_order_acquire);
-            if (head < tail) {
-                // assumption: consumer moved tail after we loaded head
-                // if the head/tail are actually corrupted, consumer should fix it
-                head = meta->head_bytes.load(std::memory_order_acquire);
-                continue;
-            }
-            
-            // consumer has not freed enough space for this message
-            const uint64_t used = head - tail;
-            if (used + reserved > ShmLayout::DATA_BLOCK_SIZE) {
-                ERR_PRINT("not enough space available size=", reserved,
-                          " to nodeid=", m_dst_id, " CONSUMER IS TOO SLOW!");
-                return { ShmSendErr::NotEnoughSpace, ShmSendOp::Send };
-            }
+        // we are the only writer of this lanes head, no reservation race to lose
+        uint64_t head = lane->head_bytes.load(std::memory_order_relaxed);
+        const uint64_t tail = lane->tail_bytes.load(std::memory_order_acquire);
+        if (head < tail) {
+            // consumer reset the lane under us (re-init), it fixes head/tail on its side
+            ERR_PRINT("shm lane tail passed head for nodeid=", m_dst_id);
+            return { ShmSendErr::AllocatorCorrupted, ShmSendOp::Send };
+        }
 
-            // logic error: some writer wrote a data record instead of wrap record and broke things
-            const size_t head_offset = head % ShmLayout::DATA_BLOCK_SIZE;
-            if (head_offset > ShmLayout::DATA_USABLE_LIMIT) {
-                ERR_PRINT("head pushed out of usable zone, allocator corrupted");
-                return { ShmSendErr::AllocatorCorrupted, ShmSendOp::Send };
-            }
+        // logic error: a data record was written instead of wrap record and broke things
+        const size_t head_offset = head % m_layout.lane_size;
+        if (head_offset > m_layout.lane_usable_limit) {
+            ERR_PRINT("head pushed out of usable zone, allocator corrupted");
+            return { ShmSendErr::AllocatorCorrupted, ShmSendOp::Send };
+        }
 
-            // current position + allocation would prevent a wrap header from being written, wrap now
-            if (head_offset + reserved > ShmLayout::DATA_USABLE_LIMIT) {
-                const size_t space_til_wrap = ShmLayout::DATA_BLOCK_SIZE - head_offset;
-                const uint64_t new_head = head + static_cast<uint64_t>(space_til_wrap);
-
-                // compare exchange success means we allocated for wrap record
-                // failure means someone else handled it
-                if (meta->head_bytes.compare_exchange_weak(head, new_head,
-                                                           std::memory_order_acq_rel,
-                                                           std::memory_order_relaxed)) {
-                    auto* rec_hdr = m_shm.map_to_type<RecordHeader>(get_header_offset(head));
-                    if (rec_hdr == nullptr) { // if this happens someone changed something and broke everything
-                        ERR_PRINT("rec_hdr ptr null and could not allocate memory, head offset was invalid");
-                        ERR_PRINT("    offset=", get_header_offset(head));
-                        continue;
-                    }
-
-                    rec_hdr->state.store(WRITING, std::memory_order_relaxed);
-                    rec_hdr->magic = MAGIC_NUM;
-                    rec_hdr->total_size = space_til_wrap;
-                    rec_hdr->payload_size = 0;
-                    rec_hdr->flags = 0;
-                    rec_hdr->user_seq = 0;
-                    rec_hdr->epoch = gen;
-                    rec_hdr->label = 0;
-                    rec_hdr->source_id = 0;
-                    rec_hdr->state.store(WRAP, std::memory_order_release);
-                    head = new_head;
-                }
-                continue;
-            }
+        // current position + allocation would prevent a wrap header from being written, wrap first
+        // a mirrored lane just carries on through its alias past the end
+        const size_t space_til_wrap = (!m_layout.mirrored && head_offset + reserved > m_layout.lane_usable_limit) ? 
+            m_layout.lane_size - head_offset : 0;
 
-            // compare exchange success means we allocated for data record
-            // failure means someone else allocated before us and head contains the updated head
-            const uint64_t new_head = head + static_cast<uint64_t>(reserved);
-            if (meta->head_bytes.compare_exchange_weak(head, new_head,
-                                                       std::memory_order_acq_rel,
-                                                       std::memory_order_relaxed)) {
-                reserved_success = true;
-                break;
-            }
+        // consumer has not freed enough space for this message
+        const uint64_t used = head - tail;
+        if (used + space_til_wrap + reserved > m_layout.lane_size) {
+            ERR_PRINT("not enough space available size=", reserved,
+                      " to nodeid=", m_dst_id, " CONSUMER IS TOO SLOW!");
+            meta->full_count.fetch_add(1, std::memory_order_relaxed); // consumer may grow the ring
+            return { ShmSendErr::NotEnoughSpace, ShmSendOp::Send };
         }
 
-        // was never able to allocate space
-        if (!reserved_success) {
-            ERR_PRINT(" could not allocate space for label=", label, " to nodeid=", m_dst_id);
-            return { ShmSendErr::CouldNotAllocate, ShmSendOp::Send };
-        }
-        
-        // if a re-init happened while we were allocating, abandon
-        if (hdr->state.load(std::memory_order_acquire) != SHM_READY ||
-            meta->generation.load(std::memory_order_acquire) != gen) {
-            return { ShmSendErr::BlockReinitialized, ShmSendOp::Send };
+        if (space_til_wrap != 0) {
+            auto* wrap_hdr = record_at(head);
+            if (wrap_hdr == nullptr) { // if this happens someone changed something and broke everything
+                ERR_PRINT("wrap_hdr ptr null, head offset was invalid");
+                ERR_PRINT("    offset=", m_layout.header_offset(m_lane, head));
+                return { ShmSendErr::InvalidOffset, ShmSendOp::Send };
+            }
+
+            wrap_hdr->state.store(WRITING, std::memory_order_relaxed);
+            wrap_hdr->magic = MAGIC_NUM;
+            wrap_hdr->total_size = space_til_wrap;
+            wrap_hdr->payload_size = 0;
+            wrap_hdr->flags = 0;
+            wrap_hdr->user_seq = 0;
+            wrap_hdr->epoch = gen;
+            wrap_hdr->label = 0;
+            wrap_hdr->source_id = 0;
+            wrap_hdr->checksum = 0;
+            wrap_hdr->state.store(WRAP, std::memory_order_relaxed);
+            head += static_cast<uint64_t>(space_til_wrap);
         }
         
         // set writing and fill in header
-        auto* rec_hdr = m_shm.map_to_type<RecordHeader>(get_header_offset(head));
+        auto* rec_hdr = record_at(head);
         if (rec_hdr == nullptr) { // if this happens someone changed something and broke everything
             ERR_PRINT("rec_hdr ptr null, head offset was invalid");
-            ERR_PRINT("    offset=", get_header_offset(head));
+            ERR_PRINT("    offset=", m_layout.header_offset(m_lane, head));
             return { ShmSendErr::InvalidOffset, ShmSendOp::Send };
         }
 
@@ -166,23 +180,47 @@ namespace eroil::shm {
         rec_hdr->magic = MAGIC_NUM;
         rec_hdr->total_size = reserved;
         rec_hdr->payload_size = buf_size;
-        rec_hdr->flags = 0;
+        rec_hdr->flags = m_checksum ? static_cast<uint32_t>(CHECKSUM) : 0u;
         rec_hdr->user_seq = seq;
         rec_hdr->epoch = gen;
         rec_hdr->label = label;
         rec_hdr->source_id = id;
+        rec_hdr->checksum = 0;
 
-        // copy data immediately after record header
-        shm::ShmResult write_result = m_shm.write(buf, buf_size, get_data_offset(head));
+        // copy data immediately after record header, checksummed on the way in when enabled
+        shm::ShmResult write_result{ ShmErr::None, ShmOp::Write };
+        if (m_layout.mirrored) {
+            // bounds are the lane alias, reserved already fit in the lane
+            std::byte* payload = reinterpret_cast<std::byte*>(rec_hdr) + sizeof(RecordHeader);
+            if (m_checksum) {
+                rec_hdr->checksum = mem::copy_out_crc32c(payload, buf, buf_size, record_header_checksum(*rec_hdr));
+            } else {
+                mem::copy_out(payload, buf, buf_size);
+            }
+        } else if (m_checksum) {
+            uint32_t crc = record_header_checksum(*rec_hdr);
+            write_result = m_shm.write(buf, buf_size, m_layout.data_offset(m_lane, head), crc);
+            rec_hdr->checksum = crc;
+        } else {
+            write_result = m_shm.write(buf, buf_size, m_layout.data_offset(m_lane, head));
+        }
         if (!write_result.ok()) {
             ERR_PRINT("shm write failed, err=", write_result.code_to_string());
         }
+        rec_hdr->state.store(COMMITTED, std::memory_order_relaxed);
+
+        // if a re-init happened while we were writing, abandon. the consumer reset this lane
+        // and moving head now would point it at records it never saw
+        if (hdr->state.load(std::memory_order_acquire) != SHM_READY ||
+            meta->generation.load(std::memory_order_acquire) != gen) {
+            return { ShmSendErr::BlockReinitialized, ShmSendOp::Send };
+        }
 
-        // publish this record is ready
-        rec_hdr->state.store(COMMITTED, std::memory_order_release);
+        // publish the wrap record and this record in one go, the consumer never reads passed head
+        lane->head_bytes.store(head + static_cast<uint64_t>(reserved), std::memory_order_release);
 
-        // increment publish count (debugging only)
-        meta->published_count.fetch_add(1, std::memory_order_relaxed);
+        // increment publish count (debugging only), lives on our own cache line
+        lane->published_count.fetch_add(1, std::memory_order_relaxed);
 
         // notify
         evt::NamedSemResult post_result = m_event.post();
@@ -192,4 +230,99 @@ namespace eroil::shm {
 
         return { ShmSendErr::None, ShmSendOp::Send };
     }
+
+    bool ShmSend::refresh_layout(const ShmHeader& hdr) {
+        const size_t advertised = hdr.total_size;
+        if (advertised != m_shm.total_size()) {
+            shm::ShmResult result = m_shm.remap();
+            if (!result.ok() || m_shm.total_size() != advertised) {
+                ERR_PRINT("shm send could not follow ring resize, nodeid=", m_dst_id, " advertised=", advertised,
+                          " mapped=", m_shm.total_size(), " err=", result.code_to_string());
+                return false;
+            }
+            LOG("shm send remapped ring for nodeid=", m_dst_id, " size=", advertised);
+        }
+
+        const auto* meta = m_shm.map_to_type<ShmMetaData>(ShmLayout::META_DATA_OFFSET);
+        if (meta == nullptr || !validate_layout(advertised) || !validate_lanes(meta->lane_count)) {
+            ERR_PRINT("shm send got an invalid block layout, nodeid=", m_dst_id, " size=", advertised);
+            return false;
+        }
+
+        // a mirrored block has records that cross lane ends, we can only write to it through our own mirror
+        const bool mirrored = (meta->ring_flags & RING_MIRRORED) != 0;
+        ShmLayout layout(advertised, meta->lane_count, mirrored);
+        if (mirrored) {
+            shm::ShmResult result = m_shm.map_mirrored(ShmLayout::DATA_BLOCK_OFFSET, layout.lane_size, layout.lane_count);
+            if (!result.ok()) {
+                ERR_PRINT("shm send could not mirror lanes of nodeid=", m_dst_id, " err=", result.code_to_string());
+                return false;
+            }
+        } else {
+            m_shm.unmap_mirrored();
+        }
+
+        m_layout = layout;
+        return true;
+    }
+
+    RecordHeader* ShmSend::record_at(uint64_t pos) const noexcept {
+        if (m_layout.mirrored) {
+            std::byte* lane = m_shm.mirrored(m_lane);
+            if (lane == nullptr) return nullptr;
+            return reinterpret_cast<RecordHeader*>(lane + (pos % m_layout.lane_size));
+        }
+        return m_shm.map_to_type<RecordHeader>(m_layout.header_offset(m_lane, pos));
+    }
+
+    LaneMeta* ShmSend::claim_lane() {
+        auto lane_at = [this](uint32_t i) {
+            return m_shm.map_to_type<LaneMeta>(ShmLayout::lane_meta_offset(i));
+        };
+        const uint64_t me = lane_owner(m_src_id, m_pid);
+
+        // fast path, still own the lane we claimed last time
+        if (m_lane < m_layout.lane_count) {
+            LaneMeta* lane = lane_at(m_lane);
+            if (lane->owner.load(std::memory_order_acquire) == me) return lane;
+        }
+
+        // a lane left behind by a previous run of this node is ours again
+        for (uint32_t i = 0; i < m_layout.lane_count; ++i) {
+            LaneMeta* lane = lane_at(i);
+            uint64_t owner = lane->owner.load(std::memory_order_acquire);
+            if (lane_owner_node(owner) == m_src_id &&
+                lane->owner.compare_exchange_strong(owner, me, std::memory_order_acq_rel)) {
+                m_lane = i;
+                return lane;
+            }
+        }
+
+        for (uint32_t i = 0; i < m_layout.lane_count; ++i) {
+            LaneMeta* lane = lane_at(i);
+            uint64_t expected = LANE_FREE;
+            if (lane->owner.compare_exchange_strong(expected, me, std::memory_order_acq_rel)) {
+                m_lane = i;
+                return lane;
+            }
+        }
+
+        // every lane is owned, take one whose producer died. it only ever moved head after a
+        // commit so whatever it left is complete and the consumer still reads it before ours
+        for (uint32_t i = 0; i < m_layout.lane_count; ++i) {
+            LaneMeta* lane = lane_at(i);
+            uint64_t owner = lane->owner.load(std::memory_order_acquire);
+            const uint32_t pid = lane_owner_pid(owner);
+            if (pid == 0 || pid == m_pid || plat::process_alive(pid)) continue;
+
+            if (lane->owner.compare_exchange_strong(owner, me, std::memory_order_acq_rel)) {
+                LOG("shm send took over lane=", i, " of nodeid=", m_dst_id, " from dead nodeid=", lane_owner_node(owner));
+                m_lane = i;
+                return lane;
+            }
+        }
+
+        m_lane = SHM_MAX_LANES;
+        return nullptr;
+    }
 }
\ No newline at end of file
@@ -14,7 +14,8 @@ namespace eroil::shm {
         NotEnoughSpace,     // try again or drop
         SizeTooLarge,       // hard error
         CouldNotAllocate,   // hard error
-        AllocatorCorrupted  // fatal, maybe retry a few times
+        AllocatorCorrupted, // fatal, maybe retry a few times
+        NoFreeLane          // every lane in the destination block is owned by another source
     };
 
     enum class ShmSendOp {
@@ -39,6 +40,7 @@ namespace eroil::shm {
                 case ShmSendErr::SizeTooLarge: return "SizeTooLarge";
                 case ShmSendErr::CouldNotAllocate: return "CouldNotAllocate";
                 case ShmSendErr::AllocatorCorrupted: return "AllocatorCorrupted";
+                case ShmSendErr::NoFreeLane: return "NoFreeLane";
                 default: return "Unknown - error is undefined";
             }
         }
@@ -52,14 +54,20 @@ namespace eroil::shm {
     };
  
     // shared memory we write labels to
+    // each source owns one lane of the destination block, only the send worker thread writes to it
     class ShmSend {
         private:
+            NodeId m_src_id;
             NodeId m_dst_id;
             Shm m_shm;
+            ShmLayout m_layout;
+            uint32_t m_lane;    // lane we own in the destination block, SHM_MAX_LANES until claimed
             evt::NamedSemaphore m_event;
+            bool m_checksum;    // stamp records with a crc32c the reader verifies
+            uint32_t m_pid;     // written into the lane owner so other senders can tell when we died
 
         public:
-            ShmSend(NodeId dst_id);
+            ShmSend(NodeId src_id, NodeId dst_id, bool checksum = false);
             ~ShmSend();
 
             EROIL_NO_COPY(ShmSend)
@@ -72,5 +80,10 @@ namespace eroil::shm {
                                           const uint32_t seq, 
                                           const size_t buf_size, 
                                           const std::byte* buf);
+
+        private:
+            bool refresh_layout(const ShmHeader& hdr);
+            LaneMeta* claim_lane();
+            RecordHeader* record_at(uint64_t pos) const noexcept;
     };
 }
\ No newline at end of file
@@ -26,11 +26,12 @@ namespace eroil::shm {
         return out;
     }
 
-    Shm::Shm(const int32_t id, const size_t total_size) : 
-        m_id(id), m_total_size(total_size), m_handle(nullptr), m_view(nullptr) {}
+    Shm::Shm(const int32_t id, const size_t total_size, const ShmKind kind) : 
+        m_id(id), m_kind(kind), m_total_size(total_size), m_handle(nullptr), m_view(nullptr) {}
 
     Shm::Shm(Shm&& other) noexcept : 
         m_id(other.m_id),
+        m_kind(other.m_kind),
         m_total_size(other.m_total_size),
         m_handle(other.m_handle),
         m_view(other.m_view) {
@@ -46,6 +47,7 @@ namespace eroil::shm {
             close();
 
             m_id = other.m_id;
+            m_kind = other.m_kind;
             m_total_size = other.m_total_size;
             m_handle = other.m_handle;
             m_view = other.m_view;
@@ -67,6 +69,8 @@ namespace eroil::shm {
         //return "Global\\eroil.node." + std::to_string(m_id);
 
         // local session only
+        if (m_kind == ShmKind::Mailbox) return "Local\\eroil.mbox." + std::to_string(m_id);
+        if (m_kind == ShmKind::Arena) return "Local\\eroil.arena." + std::to_string(m_id);
         return "Local\\eroil.node." + std::to_string(m_id);
     }
 
@@ -132,10 +136,44 @@ namespace eroil::shm {
             m_handle = nullptr;
             return { ShmErr::FileMapFailed, ShmOp::Open };
         }
-   
+
+        // the view covers the whole section, its region size is the size the creator picked
+        MEMORY_BASIC_INFORMATION info{};
+        if (::VirtualQuery(m_view, &info, sizeof(info)) == 0) {
+            close();
+            return { ShmErr::UnknownError, ShmOp::Open };
+        }
+
+        const size_t actual = static_cast<size_t>(info.RegionSize);
+        if (m_total_size != 0 && actual != m_total_size) {
+            close();
+            return { ShmErr::SizeMismatch, ShmOp::Open };
+        }
+
+        m_total_size = actual;
         return { ShmErr::None, ShmOp::Open };
     }
 
+    ShmResult Shm::resize(const size_t new_total_size) {
+        // pagefile backed sections cannot grow, the size picked at create is final
+        (void)new_total_size;
+        return { ShmErr::NotSupported, ShmOp::Resize };
+    }
+
+    ShmResult Shm::remap() {
+        // sections never change size, nothing to remap
+        if (!is_valid()) return { ShmErr::NotOpen, ShmOp::Resize };
+        return { ShmErr::None, ShmOp::Resize };
+    }
+
+    ShmResult Shm::map_mirrored(const size_t offset, const size_t region_size, const uint32_t regions) {
+        // would need placeholder views (MapViewOfFile3), rings keep using wrap records here
+        (void)offset; (void)region_size; (void)regions;
+        return { ShmErr::NotSupported, ShmOp::Open };
+    }
+
+    void Shm::unmap_mirrored() noexcept {}
+
     void Shm::close() noexcept {
         if (m_view != nullptr) {
             ::UnmapViewOfFile(m_view);
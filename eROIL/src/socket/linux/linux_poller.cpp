@@ -0,0 +1,161 @@
+#if defined(EROIL_LINUX)
+#include "socket/poller.h"
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <errno.h>
+#include <algorithm>
+#include <array>
+
+#include "safe_print.h"
+
+namespace eroil::sock {
+    // key reserved for the wake eventfd, never handed out to callers
+    static constexpr uint64_t WAKE_KEY = UINT64_MAX;
+    static constexpr size_t MAX_NATIVE_EVENTS = 64;
+
+    Poller::Poller() : m_poll_handle(INVALID_SOCKET), m_wake_handle(INVALID_SOCKET), m_handles{}, m_keys{}, m_want_write{} {}
+
+    Poller::~Poller() {
+        close();
+    }
+
+    SockResult Poller::open() {
+        if (m_poll_handle != INVALID_SOCKET) {
+            return SockResult{ SockErr::DoubleOpen, SockOp::Open, 0, 0 };
+        }
+
+        m_poll_handle = ::epoll_create1(EPOLL_CLOEXEC);
+        if (m_poll_handle < 0) {
+            const int err = errno;
+            m_poll_handle = INVALID_SOCKET;
+            return SockResult{ map_err(err), SockOp::Open, err, 0 };
+        }
+
+        m_wake_handle = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (m_wake_handle < 0) {
+            const int err = errno;
+            m_wake_handle = INVALID_SOCKET;
+            close();
+            return SockResult{ map_err(err), SockOp::Open, err, 0 };
+        }
+
+        epoll_event ev{};
+        ev.events = EPOLLIN;
+        ev.data.u64 = WAKE_KEY;
+        if (::epoll_ctl(m_poll_handle, EPOLL_CTL_ADD, m_wake_handle, &ev) != 0) {
+            const int err = errno;
+            close();
+            return SockResult{ map_err(err), SockOp::Configure, err, 0 };
+        }
+
+        return SockResult{ SockErr::None, SockOp::Open, 0, 0 };
+    }
+
+    void Poller::close() noexcept {
+        if (m_wake_handle != INVALID_SOCKET) {
+            ::close(m_wake_handle);
+            m_wake_handle = INVALID_SOCKET;
+        }
+
+        if (m_poll_handle != INVALID_SOCKET) {
+            ::close(m_poll_handle);
+            m_poll_handle = INVALID_SOCKET;
+        }
+
+        m_handles.clear();
+        m_keys.clear();
+        m_want_write.clear();
+    }
+
+    SockResult Poller::add(socket_handle handle, uint64_t key, bool want_write) {
+        if (m_poll_handle == INVALID_SOCKET) {
+            return SockResult{ SockErr::NotOpen, SockOp::Configure, 0, 0 };
+        }
+
+        if (handle == INVALID_SOCKET || key == WAKE_KEY) {
+            return SockResult{ SockErr::InvalidArgument, SockOp::Configure, 0, 0 };
+        }
+
+        // level triggered, the reactor drains until WouldBlock anyway and level
+        // triggering means a missed drain is retried on the next wait instead of lost
+        epoll_event ev{};
+        ev.events = EPOLLIN | EPOLLRDHUP;
+        if (want_write) ev.events |= EPOLLOUT;
+        ev.data.u64 = key;
+        if (::epoll_ctl(m_poll_handle, EPOLL_CTL_ADD, handle, &ev) != 0) {
+            const int err = errno;
+            return SockResult{ map_err(err), SockOp::Configure, err, 0 };
+        }
+
+        m_handles.push_back(handle);
+        m_keys.push_back(key);
+        m_want_write.push_back(want_write ? 1 : 0);
+        return SockResult{ SockErr::None, SockOp::Configure, 0, 0 };
+    }
+
+    void Poller::remove(socket_handle handle) noexcept {
+        auto it = std::find(m_handles.begin(), m_handles.end(), handle);
+        if (it == m_handles.end()) return;
+
+        const auto index = static_cast<size_t>(std::distance(m_handles.begin(), it));
+        m_handles.erase(it);
+        m_keys.erase(m_keys.begin() + static_cast<std::ptrdiff_t>(index));
+        m_want_write.erase(m_want_write.begin() + static_cast<std::ptrdiff_t>(index));
+
+        // a closed fd is removed from the epoll set by the kernel, ENOENT/EBADF here is expected
+        if (m_poll_handle != INVALID_SOCKET && handle != INVALID_SOCKET) {
+            (void)::epoll_ctl(m_poll_handle, EPOLL_CTL_DEL, handle, nullptr);
+        }
+    }
+
+    SockResult Poller::wait(PollEvent* events, size_t max_events, int32_t timeout_ms, size_t& count) {
+        count = 0;
+        if (m_poll_handle == INVALID_SOCKET) {
+            return SockResult{ SockErr::NotOpen, SockOp::Poll, 0, 0 };
+        }
+
+        if (events == nullptr || max_events == 0) {
+            return SockResult{ SockErr::InvalidArgument, SockOp::Poll, 0, 0 };
+        }
+
+        std::array<epoll_event, MAX_NATIVE_EVENTS> native{};
+        const int max_native = static_cast<int>(std::min(max_events, MAX_NATIVE_EVENTS));
+
+        int ready = 0;
+        do {
+            ready = ::epoll_wait(m_poll_handle, native.data(), max_native, timeout_ms);
+        } while (ready < 0 && errno == EINTR);
+
+        if (ready < 0) {
+            const int err = errno;
+            return SockResult{ map_err(err), SockOp::Poll, err, 0 };
+        }
+
+        for (int i = 0; i < ready; ++i) {
+            const epoll_event& ev = native[static_cast<size_t>(i)];
+            if (ev.data.u64 == WAKE_KEY) {
+                uint64_t drained = 0;
+                (void)::read(m_wake_handle, &drained, sizeof(drained));
+                continue;
+            }
+
+            PollEvent& out = events[count++];
+            out.key = ev.data.u64;
+            out.readable = (ev.events & EPOLLIN) != 0;
+            out.writable = (ev.events & EPOLLOUT) != 0;
+            out.hangup = (ev.events & (EPOLLHUP | EPOLLRDHUP)) != 0;
+            out.error = (ev.events & EPOLLERR) != 0;
+        }
+
+        return SockResult{ SockErr::None, SockOp::Poll, 0, 0 };
+    }
+
+    void Poller::wake() noexcept {
+        if (m_wake_handle == INVALID_SOCKET) return;
+        const uint64_t one = 1;
+        (void)::write(m_wake_handle, &one, sizeof(one));
+    }
+}
+#endif
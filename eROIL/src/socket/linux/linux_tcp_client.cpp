@@ -7,11 +7,14 @@
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include <errno.h>
+#include <fcntl.h>
+#include <linux/errqueue.h>
+#include <cstring>
 
 #include "safe_print.h"
 
 namespace eroil::sock {
-    TCPClient::TCPClient() : TCPSocket(), m_dest_id(INVALID_NODE) {}
+    TCPClient::TCPClient() : TCPSocket(), m_dest_id(INVALID_NODE), m_zerocopy(false), m_zc_next_seq(0) {}
 
     SockResult TCPClient::connect(const char* ip, uint16_t port) {
         if (!handle_valid()) return SockResult{ SockErr::InvalidHandle, SockOp::Connect, 0, 0 };
@@ -38,6 +41,64 @@ namespace eroil::sock {
         return SockResult{ SockErr::None, SockOp::Connect, 0, 0 };
     }
 
+    SockResult TCPClient::begin_connect(const char* ip, uint16_t port) {
+        if (!handle_valid()) return SockResult{ SockErr::InvalidHandle, SockOp::Connect, 0, 0 };
+        if (is_connected())  return SockResult{ SockErr::AlreadyConnected, SockOp::Connect, 0, 0 };
+
+        if (!ip || *ip == '\0') {
+            return SockResult{ SockErr::InvalidIp, SockOp::Connect, 0, 0 };
+        }
+
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port   = htons(port);
+
+        if (::inet_pton(AF_INET, ip, &addr.sin_addr) != 1) {
+            return SockResult{ SockErr::InvalidIp, SockOp::Connect, 0, 0 };
+        }
+
+        // non-blocking for the handshake only, finish_connect() puts the socket back
+        const int flags = ::fcntl(m_handle, F_GETFL, 0);
+        if (flags < 0 || ::fcntl(m_handle, F_SETFL, flags | O_NONBLOCK) != 0) {
+            const int err = errno;
+            return SockResult{ map_err(err), SockOp::Configure, err, 0 };
+        }
+
+        // loopback can complete right away
+        if (::connect(m_handle, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0) {
+            return finish_connect();
+        }
+
+        const int err = errno;
+        if (err == EINPROGRESS || err == EINTR) {
+            return SockResult{ SockErr::WouldBlock, SockOp::Connect, err, 0 };
+        }
+        return SockResult{ map_err(err), SockOp::Connect, err, 0 };
+    }
+
+    SockResult TCPClient::finish_connect() {
+        if (!handle_valid()) return SockResult{ SockErr::InvalidHandle, SockOp::Connect, 0, 0 };
+        if (is_connected())  return SockResult{ SockErr::AlreadyConnected, SockOp::Connect, 0, 0 };
+
+        int err = 0;
+        socklen_t len = sizeof(err);
+        if (::getsockopt(m_handle, SOL_SOCKET, SO_ERROR, &err, &len) != 0) {
+            err = errno;
+        }
+        if (err != 0) {
+            return SockResult{ map_err(err), SockOp::Connect, err, 0 };
+        }
+
+        const int flags = ::fcntl(m_handle, F_GETFL, 0);
+        if (flags < 0 || ::fcntl(m_handle, F_SETFL, flags & ~O_NONBLOCK) != 0) {
+            const int ferr = errno;
+            return SockResult{ map_err(ferr), SockOp::Configure, ferr, 0 };
+        }
+
+        m_connected = true;
+        return SockResult{ SockErr::None, SockOp::Connect, 0, 0 };
+    }
+
     SockResult TCPClient::send(const void* data, const size_t size) {
         if (!is_connected()) {
             return SockResult{ SockErr::NotConnected, SockOp::Send, 0, 0 };
@@ -135,6 +196,62 @@ namespace eroil::sock {
         return SockResult{ SockErr::None, SockOp::Send, 0, static_cast<int>(total) };
     }
 
+    SockResult TCPClient::try_send_all(const void* data, const size_t size) {
+        if (!is_connected()) {
+            return SockResult{ SockErr::NotConnected, SockOp::Send, 0, 0 };
+        }
+
+        if (size == 0) {
+            return SockResult{ SockErr::SizeZero, SockOp::Send, 0, 0 };
+        }
+
+        if (size > static_cast<size_t>(INT32_MAX)) {
+            return SockResult{ SockErr::SizeTooLarge, SockOp::Send, 0, 0 };
+        }
+
+        std::unique_lock lock(m_send_mtx, std::try_to_lock);
+        if (!lock.owns_lock()) {
+            return SockResult{ SockErr::WouldBlock, SockOp::Send, 0, 0 };
+        }
+
+        size_t total = 0;
+        const auto* ptr = static_cast<const std::byte*>(data);
+
+        // only the first send may give up, once part of the frame is out the rest has to follow
+        int flags = MSG_NOSIGNAL | MSG_DONTWAIT;
+        while (total < size) {
+            const ssize_t sent = ::send(m_handle, ptr + total, size - total, flags);
+
+            if (sent > 0) {
+                total += static_cast<size_t>(sent);
+                flags = MSG_NOSIGNAL;
+                continue;
+            }
+
+            if (sent == 0) {
+                m_connected = false;
+                return SockResult{ SockErr::Closed, SockOp::Send, 0, static_cast<int>(total) };
+            }
+
+            const int err = errno;
+            if (err == EINTR) {
+                continue; // retry
+            }
+
+            if (err == EWOULDBLOCK && total == 0) {
+                return SockResult{ SockErr::WouldBlock, SockOp::Send, err, 0 };
+            }
+
+            if (is_fatal_send_err(err)) {
+                m_connected = false;
+            }
+
+            return SockResult{ map_err(err), SockOp::Send, err, static_cast<int>(total) };
+        }
+
+        return SockResult{ SockErr::None, SockOp::Send, 0, static_cast<int>(total) };
+    }
+
     SockResult TCPClient::recv(void* data, const size_t size) {
         if (!is_connected()) {
             return SockResult{ SockErr::NotConnected, SockOp::Recv, 0, 0 };
@@ -228,5 +345,161 @@ namespace eroil::sock {
             static_cast<int>(total)
         };
     }
+
+    SockResult TCPClient::try_recv(void* data, const size_t size) {
+        if (!is_connected()) {
+            return SockResult{ SockErr::NotConnected, SockOp::Recv, 0, 0 };
+        }
+
+        if (size == 0) {
+            return SockResult{ SockErr::SizeZero, SockOp::Recv, 0, 0 };
+        }
+
+        if (size > static_cast<size_t>(INT32_MAX)) {
+            return SockResult{ SockErr::SizeTooLarge, SockOp::Recv, 0, 0 };
+        }
+
+        while (true) {
+            const ssize_t recv_bytes = ::recv(
+                m_handle,
+                data,
+                size,
+                MSG_DONTWAIT
+            );
+
+            if (recv_bytes > 0) {
+                return SockResult{ SockErr::None, SockOp::Recv, 0, static_cast<int>(recv_bytes) };
+            }
+
+            if (recv_bytes == 0) {
+                // peer performed orderly shutdown
+                m_connected = false;
+                return SockResult{ SockErr::Closed, SockOp::Recv, 0, 0 };
+            }
+
+            const int err = errno;
+            if (err == EINTR) {
+                continue; // retry, we were interrupted
+            }
+
+            if (err == EWOULDBLOCK) { // aka EAGAIN
+                return SockResult{ SockErr::WouldBlock, SockOp::Recv, err, 0 };
+            }
+
+            return SockResult{ map_err(err), SockOp::Recv, err, 0 };
+        }
+    }
+    SockResult TCPClient::enable_zerocopy() {
+        if (!handle_valid()) return SockResult{ SockErr::InvalidHandle, SockOp::Configure, 0, 0 };
+
+        const int one = 1;
+        if (::setsockopt(m_handle, SOL_SOCKET, SO_ZEROCOPY, &one, sizeof(one)) != 0) {
+            const int err = errno;
+            return SockResult{ map_err(err), SockOp::Configure, err, 0 };
+        }
+
+        m_zerocopy = true;
+        return SockResult{ SockErr::None, SockOp::Configure, 0, 0 };
+    }
+
+    SockResult TCPClient::send_all_zerocopy(const void* data, const size_t size, uint32_t& zc_first, uint32_t& zc_count) {
+        zc_first = 0;
+        zc_count = 0;
+
+        if (!is_connected()) {
+            return SockResult{ SockErr::NotConnected, SockOp::Send, 0, 0 };
+        }
+
+        if (size == 0) {
+            return SockResult{ SockErr::SizeZero, SockOp::Send, 0, 0 };
+        }
+
+        if (size > static_cast<size_t>(INT32_MAX)) {
+            return SockResult{ SockErr::SizeTooLarge, SockOp::Send, 0, 0 };
+        }
+
+        size_t total = 0;
+        const auto* ptr = static_cast<const std::byte*>(data);
+        int flags = m_zerocopy ? (MSG_NOSIGNAL | MSG_ZEROCOPY) : MSG_NOSIGNAL;
+
+        std::lock_guard lock(m_send_mtx);
+        zc_first = m_zc_next_seq;
+        while (total < size) {
+            const ssize_t sent = ::send(
+                m_handle,
+                ptr + total,
+                size - total,
+                flags
+            );
+
+            if (sent > 0) {
+                total += static_cast<size_t>(sent);
+                if ((flags & MSG_ZEROCOPY) != 0) {
+                    m_zc_next_seq += 1;
+                    zc_count += 1;
+                }
+                continue;
+            }
+
+            if (sent == 0) {
+                m_connected = false;
+                return SockResult{ SockErr::Closed, SockOp::Send, 0, static_cast<int>(total) };
+            }
+
+            const int err = errno;
+            if (err == EINTR) {
+                continue; // retry
+            }
+
+            // out of optmem for pinned pages, finish this frame with a regular copy
+            if (err == ENOBUFS && (flags & MSG_ZEROCOPY) != 0) {
+                flags = MSG_NOSIGNAL;
+                continue;
+            }
+
+            if (is_fatal_send_err(err)) {
+                m_connected = false;
+            }
+
+            return SockResult{ map_err(err), SockOp::Send, err, static_cast<int>(total) };
+        }
+
+        return SockResult{ SockErr::None, SockOp::Send, 0, static_cast<int>(total) };
+    }
+
+    size_t TCPClient::reap_zerocopy(ZeroCopyRange* out, const size_t max) {
+        if (out == nullptr || !handle_valid()) return 0;
+
+        size_t count = 0;
+        while (count < max) {
+            alignas(cmsghdr) char control[128];
+            msghdr msg{};
+            msg.msg_control = control;
+            msg.msg_controllen = sizeof(control);
+
+            const ssize_t ret = ::recvmsg(m_handle, &msg, MSG_ERRQUEUE | MSG_DONTWAIT);
+            if (ret < 0) {
+                if (errno == EINTR) continue;
+                break; // EAGAIN, error queue drained
+            }
+
+            for (cmsghdr* cm = CMSG_FIRSTHDR(&msg); cm != nullptr && count < max; cm = CMSG_NXTHDR(&msg, cm)) {
+                const bool is_recverr =
+                    (cm->cmsg_level == SOL_IP && cm->cmsg_type == IP_RECVERR) ||
+                    (cm->cmsg_level == SOL_IPV6 && cm->cmsg_type == IPV6_RECVERR);
+                if (!is_recverr) continue;
+
+                sock_extended_err serr{};
+                std::memcpy(&serr, CMSG_DATA(cm), sizeof(serr));
+                if (serr.ee_errno != 0 || serr.ee_origin != SO_EE_ORIGIN_ZEROCOPY) continue;
+
+                out[count].lo = serr.ee_info;
+                out[count].hi = serr.ee_data;
+                out[count].copied = (serr.ee_code & SO_EE_CODE_ZEROCOPY_COPIED) != 0;
+                count += 1;
+            }
+        }
+        return count;
+    }
 }
 #endif
@@ -0,0 +1,338 @@
+#if defined(EROIL_LINUX)
+#include "socket/uring.h"
+
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#include <sys/mman.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <errno.h>
+#include <cstring>
+#include <vector>
+
+#include "safe_print.h"
+
+namespace eroil::sock {
+    static constexpr uint64_t WAKE_KEY = UINT64_MAX;
+    static constexpr uint64_t CANCEL_KEY = UINT64_MAX - 1;
+
+    static constexpr uint32_t REQUIRED_FEATURES =
+        IORING_FEAT_SINGLE_MMAP | IORING_FEAT_NODROP | IORING_FEAT_EXT_ARG;
+
+    static int sys_uring_setup(uint32_t entries, io_uring_params* params) noexcept {
+        return static_cast<int>(::syscall(__NR_io_uring_setup, entries, params));
+    }
+
+    static int sys_uring_enter(int fd, uint32_t to_submit, uint32_t min_complete, uint32_t flags, const void* arg, size_t arg_size) noexcept {
+        return static_cast<int>(::syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, arg, arg_size));
+    }
+
+    static int sys_uring_register(int fd, uint32_t opcode, void* arg, uint32_t nr_args) noexcept {
+        return static_cast<int>(::syscall(__NR_io_uring_register, fd, opcode, arg, nr_args));
+    }
+
+    template <class T>
+    static T* at_offset(void* base, uint32_t offset) noexcept {
+        return static_cast<T*>(static_cast<void*>(static_cast<char*>(base) + offset));
+    }
+
+    Uring::Uring() :
+        m_ring_fd(INVALID_SOCKET),
+        m_wake_fd(INVALID_SOCKET),
+        m_wake_buf(0),
+        m_wake_armed(false),
+        m_sq_map(nullptr),
+        m_sq_map_size(0),
+        m_cq_map(nullptr),
+        m_cq_map_size(0),
+        m_sqes(nullptr),
+        m_sqes_size(0),
+        m_sq_head(nullptr),
+        m_sq_tail(nullptr),
+        m_sq_array(nullptr),
+        m_sq_mask(0),
+        m_sq_entries(0),
+        m_cq_head(nullptr),
+        m_cq_tail(nullptr),
+        m_cqes(nullptr),
+        m_cq_mask(0),
+        m_sqe_tail(0) {}
+
+    Uring::~Uring() {
+        close();
+    }
+
+    bool Uring::supported() noexcept {
+        Uring ring;
+        if (!ring.open(8).ok()) return false;
+
+        // ask the kernel which opcodes it knows, send/recv need 5.6+ and ext arg waits 5.11+
+        std::vector<std::byte> buf(sizeof(io_uring_probe) + 256 * sizeof(io_uring_probe_op));
+        io_uring_probe* probe = static_cast<io_uring_probe*>(static_cast<void*>(buf.data()));
+        if (sys_uring_register(ring.m_ring_fd, IORING_REGISTER_PROBE, probe, 256) < 0) {
+            return false;
+        }
+
+        const uint8_t needed[] = {
+            IORING_OP_SEND,
+            IORING_OP_RECV,
+            IORING_OP_READ,
+            IORING_OP_ASYNC_CANCEL
+        };
+
+        for (uint8_t op : needed) {
+            if (op > probe->last_op) return false;
+            if ((probe->ops[op].flags & IO_URING_OP_SUPPORTED) == 0) return false;
+        }
+        return true;
+    }
+
+    SockResult Uring::open(uint32_t entries) {
+        if (is_open()) {
+            return SockResult{ SockErr::DoubleOpen, SockOp::Open, 0, 0 };
+        }
+
+        io_uring_params params{};
+        params.flags = IORING_SETUP_CLAMP;
+        const int fd = sys_uring_setup(entries, &params);
+        if (fd < 0) {
+            // ENOSYS on old kernels, EPERM when io_uring is disabled by sysctl/seccomp
+            const int err = errno;
+            return SockResult{ map_err(err), SockOp::Open, err, 0 };
+        }
+        m_ring_fd = fd;
+
+        if ((params.features & REQUIRED_FEATURES) != REQUIRED_FEATURES) {
+            close();
+            return SockResult{ SockErr::NotInitialized, SockOp::Open, 0, 0 };
+        }
+
+        // single mmap covers both the sq and cq rings
+        const size_t sq_size = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+        const size_t cq_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        m_sq_map_size = sq_size > cq_size ? sq_size : cq_size;
+        m_sq_map = ::mmap(nullptr, m_sq_map_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_ring_fd, IORING_OFF_SQ_RING);
+        if (m_sq_map == MAP_FAILED) {
+            const int err = errno;
+            m_sq_map = nullptr;
+            close();
+            return SockResult{ map_err(err), SockOp::Open, err, 0 };
+        }
+        m_cq_map = m_sq_map;
+        m_cq_map_size = 0; // shared with the sq mapping, not unmapped separately
+
+        m_sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+        m_sqes = ::mmap(nullptr, m_sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_ring_fd, IORING_OFF_SQES);
+        if (m_sqes == MAP_FAILED) {
+            const int err = errno;
+            m_sqes = nullptr;
+            close();
+            return SockResult{ map_err(err), SockOp::Open, err, 0 };
+        }
+
+        m_sq_head = at_offset<uint32_t>(m_sq_map, params.sq_off.head);
+        m_sq_tail = at_offset<uint32_t>(m_sq_map, params.sq_off.tail);
+        m_sq_array = at_offset<uint32_t>(m_sq_map, params.sq_off.array);
+        m_sq_mask = *at_offset<uint32_t>(m_sq_map, params.sq_off.ring_mask);
+        m_sq_entries = *at_offset<uint32_t>(m_sq_map, params.sq_off.ring_entries);
+        m_sqe_tail = *m_sq_tail;
+
+        m_cq_head = at_offset<uint32_t>(m_cq_map, params.cq_off.head);
+        m_cq_tail = at_offset<uint32_t>(m_cq_map, params.cq_off.tail);
+        m_cqes = at_offset<void>(m_cq_map, params.cq_off.cqes);
+        m_cq_mask = *at_offset<uint32_t>(m_cq_map, params.cq_off.ring_mask);
+
+        m_wake_fd = ::eventfd(0, EFD_CLOEXEC);
+        if (m_wake_fd < 0) {
+            const int err = errno;
+            m_wake_fd = INVALID_SOCKET;
+            close();
+            return SockResult{ map_err(err), SockOp::Open, err, 0 };
+        }
+        arm_wake();
+
+        return SockResult{ SockErr::None, SockOp::Open, 0, 0 };
+    }
+
+    void Uring::close() noexcept {
+        if (m_sqes != nullptr) {
+            ::munmap(m_sqes, m_sqes_size);
+            m_sqes = nullptr;
+        }
+
+        if (m_sq_map != nullptr) {
+            ::munmap(m_sq_map, m_sq_map_size);
+            m_sq_map = nullptr;
+        }
+
+        if (m_cq_map != nullptr && m_cq_map_size != 0) {
+            ::munmap(m_cq_map, m_cq_map_size);
+        }
+        m_cq_map = nullptr;
+
+        // closing the ring cancels anything still in flight
+        if (m_ring_fd != INVALID_SOCKET) {
+            ::close(m_ring_fd);
+            m_ring_fd = INVALID_SOCKET;
+        }
+
+        if (m_wake_fd != INVALID_SOCKET) {
+            ::close(m_wake_fd);
+            m_wake_fd = INVALID_SOCKET;
+        }
+
+        m_wake_armed = false;
+        m_sq_head = nullptr;
+        m_sq_tail = nullptr;
+        m_sq_array = nullptr;
+        m_cq_head = nullptr;
+        m_cq_tail = nullptr;
+        m_cqes = nullptr;
+    }
+
+    void* Uring::next_sqe() noexcept {
+        if (!is_open()) return nullptr;
+
+        const uint32_t head = __atomic_load_n(m_sq_head, __ATOMIC_ACQUIRE);
+        if (m_sqe_tail - head >= m_sq_entries) return nullptr;
+
+        const uint32_t index = m_sqe_tail & m_sq_mask;
+        io_uring_sqe* sqe = static_cast<io_uring_sqe*>(m_sqes) + index;
+        std::memset(sqe, 0, sizeof(io_uring_sqe));
+        m_sq_array[index] = index;
+        m_sqe_tail += 1;
+        return sqe;
+    }
+
+    bool Uring::prep_send(socket_handle handle, const void* data, size_t size, uint64_t user_data) noexcept {
+        io_uring_sqe* sqe = static_cast<io_uring_sqe*>(next_sqe());
+        if (sqe == nullptr) return false;
+
+        sqe->opcode = IORING_OP_SEND;
+        sqe->fd = handle;
+        sqe->addr = reinterpret_cast<uintptr_t>(data);
+        sqe->len = static_cast<uint32_t>(size);
+        sqe->msg_flags = MSG_NOSIGNAL;
+        sqe->user_data = user_data;
+        return true;
+    }
+
+    bool Uring::prep_recv(socket_handle handle, void* data, size_t size, uint64_t user_data) noexcept {
+        io_uring_sqe* sqe = static_cast<io_uring_sqe*>(next_sqe());
+        if (sqe == nullptr) return false;
+
+        sqe->opcode = IORING_OP_RECV;
+        sqe->fd = handle;
+        sqe->addr = reinterpret_cast<uintptr_t>(data);
+        sqe->len = static_cast<uint32_t>(size);
+        sqe->user_data = user_data;
+        return true;
+    }
+
+    bool Uring::prep_cancel(uint64_t target_user_data) noexcept {
+        io_uring_sqe* sqe = static_cast<io_uring_sqe*>(next_sqe());
+        if (sqe == nullptr) return false;
+
+        sqe->opcode = IORING_OP_ASYNC_CANCEL;
+        sqe->fd = -1;
+        sqe->addr = target_user_data;
+        sqe->user_data = CANCEL_KEY;
+        return true;
+    }
+
+    void Uring::arm_wake() noexcept {
+        if (m_wake_armed || m_wake_fd == INVALID_SOCKET) return;
+
+        io_uring_sqe* sqe = static_cast<io_uring_sqe*>(next_sqe());
+        if (sqe == nullptr) return; // retried on the next submit
+
+        sqe->opcode = IORING_OP_READ;
+        sqe->fd = m_wake_fd;
+        sqe->addr = reinterpret_cast<uintptr_t>(&m_wake_buf);
+        sqe->len = sizeof(m_wake_buf);
+        sqe->off = 0;
+        sqe->user_data = WAKE_KEY;
+        m_wake_armed = true;
+    }
+
+    SockResult Uring::submit_and_wait(int32_t timeout_ms) {
+        if (!is_open()) {
+            return SockResult{ SockErr::NotOpen, SockOp::Poll, 0, 0 };
+        }
+
+        arm_wake();
+
+        // publish everything prepared so far
+        __atomic_store_n(m_sq_tail, m_sqe_tail, __ATOMIC_RELEASE);
+        const uint32_t to_submit = m_sqe_tail - __atomic_load_n(m_sq_head, __ATOMIC_ACQUIRE);
+
+        __kernel_timespec ts{};
+        ts.tv_sec = timeout_ms / 1000;
+        ts.tv_nsec = static_cast<long long>(timeout_ms % 1000) * 1000 * 1000;
+
+        io_uring_getevents_arg arg{};
+        arg.ts = reinterpret_cast<uintptr_t>(&ts);
+
+        const uint32_t min_complete = timeout_ms > 0 ? 1 : 0;
+        const int ret = sys_uring_enter(
+            m_ring_fd,
+            to_submit,
+            min_complete,
+            IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG,
+            &arg,
+            sizeof(arg)
+        );
+
+        if (ret < 0) {
+            const int err = errno;
+            switch (err) {
+                case ETIME:     // timed out with nothing completed
+                case EINTR:     // signal, caller loops
+                case EAGAIN:    // kernel short on resources, retry next loop
+                case EBUSY:     // completion queue backed up, reap then retry
+                    return SockResult{ SockErr::None, SockOp::Poll, 0, 0 };
+                default:
+                    return SockResult{ map_err(err), SockOp::Poll, err, 0 };
+            }
+        }
+
+        return SockResult{ SockErr::None, SockOp::Poll, 0, ret };
+    }
+
+    size_t Uring::reap(UringCompletion* out, size_t max) noexcept {
+        if (!is_open() || out == nullptr) return 0;
+
+        size_t count = 0;
+        uint32_t head = *m_cq_head;
+        const uint32_t tail = __atomic_load_n(m_cq_tail, __ATOMIC_ACQUIRE);
+        const io_uring_cqe* cqes = static_cast<const io_uring_cqe*>(m_cqes);
+
+        while (head != tail && count < max) {
+            const io_uring_cqe& cqe = cqes[head & m_cq_mask];
+            head += 1;
+
+            if (cqe.user_data == WAKE_KEY) {
+                m_wake_armed = false;
+                continue;
+            }
+
+            if (cqe.user_data == CANCEL_KEY) continue;
+
+            out[count].user_data = cqe.user_data;
+            out[count].res = cqe.res;
+            count += 1;
+        }
+
+        __atomic_store_n(m_cq_head, head, __ATOMIC_RELEASE);
+        arm_wake();
+        return count;
+    }
+
+    void Uring::wake() noexcept {
+        if (m_wake_fd == INVALID_SOCKET) return;
+        const uint64_t one = 1;
+        (void)::write(m_wake_fd, &one, sizeof(one));
+    }
+}
+#endif
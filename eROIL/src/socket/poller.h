@@ -0,0 +1,52 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "types/const_types.h"
+#include "socket_result.h"
+#include "macros.h"
+
+namespace eroil::sock {
+    struct PollEvent {
+        uint64_t key = 0;       // caller supplied tag given to add()
+        bool readable = false;
+        bool writable = false;  // only reported for handles added with want_write, a connect in flight completed
+        bool hangup = false;    // peer closed, drain then drop
+        bool error = false;     // pending socket error, or zero copy notifications on the error queue
+    };
+
+    // readiness multiplexer for a set of sockets
+    // linux -> epoll + eventfd for wake ups
+    // windows -> WSAPoll + loopback udp socket for wake ups
+    //
+    // a poller is owned by a single thread, only wake() is safe to call from other threads
+    class Poller {
+        private:
+            socket_handle m_poll_handle;    // epoll fd (linux only)
+            socket_handle m_wake_handle;    // eventfd (linux) or bound udp socket (windows)
+            std::vector<socket_handle> m_handles;
+            std::vector<uint64_t> m_keys;
+            std::vector<uint8_t> m_want_write;
+
+        public:
+            Poller();
+            ~Poller();
+
+            EROIL_NO_COPY(Poller)
+            EROIL_NO_MOVE(Poller)
+
+            NO_DISCARD SockResult open();
+            void close() noexcept;
+
+            // want_write also reports writable, for non-blocking connects waiting on their handshake
+            NO_DISCARD SockResult add(socket_handle handle, uint64_t key, bool want_write = false);
+            void remove(socket_handle handle) noexcept;
+
+            // waits up to timeout_ms for readiness, fills events and sets count
+            // a wake() or an expired timeout returns with count = 0
+            NO_DISCARD SockResult wait(PollEvent* events, size_t max_events, int32_t timeout_ms, size_t& count);
+            void wake() noexcept;
+
+            // shared implementation
+            size_t size() const noexcept { return m_handles.size(); }
+    };
+}
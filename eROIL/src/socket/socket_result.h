@@ -31,6 +31,7 @@ namespace eroil::sock {
         InvalidIp,
         SizeZero,
         SizeTooLarge,
+        Unsupported,         // feature not available on this platform/kernel
         Unknown,
     };
 
@@ -45,7 +46,8 @@ namespace eroil::sock {
         Send,
         Recv, 
         Shutdown, 
-        Close 
+        Close,
+        Poll
     };
 
     struct SockResult {
@@ -81,6 +83,7 @@ namespace eroil::sock {
                 case SockErr::InvalidIp: return "InvalidIp";
                 case SockErr::SizeZero: return "SizeZero";
                 case SockErr::SizeTooLarge: return "SizeTooLarge";
+                case SockErr::Unsupported: return "Unsupported";
                 case SockErr::Unknown: return "Unknown";
                 default: return "Unknown - error is undefined";
             }
@@ -99,6 +102,7 @@ namespace eroil::sock {
                 case SockOp::Recv: return "Recv"; 
                 case SockOp::Shutdown: return "Shutdown"; 
                 case SockOp::Close: return "Close";
+                case SockOp::Poll: return "Poll";
                 default: return "Unknown - op is undefined";
             }
         }
@@ -7,6 +7,14 @@
 #include "macros.h"
 
 namespace eroil::sock {
+    // one zero-copy completion from the socket error queue, covers zero-copy
+    // send calls lo..hi (inclusive). copied means the kernel fell back to copying
+    struct ZeroCopyRange {
+        uint32_t lo = 0;
+        uint32_t hi = 0;
+        bool copied = false;
+    };
+
     class TCPSocket {
         protected:
             socket_handle m_handle;
@@ -39,6 +47,9 @@ namespace eroil::sock {
                 close();
             }
 
+            socket_handle native_handle() const noexcept {
+                return m_handle;
+            }
 
         protected:
             bool handle_valid() const noexcept;
@@ -47,6 +58,8 @@ namespace eroil::sock {
     class TCPClient final : public TCPSocket {
         private:
             NodeId m_dest_id;
+            bool m_zerocopy;
+            uint32_t m_zc_next_seq;     // kernel numbers each successful MSG_ZEROCOPY send call from 0
 
             // to prevent any chance of a send being interrupted and data arriving at
             // destination out of order, we lock on sends. We do not need to lock
@@ -64,11 +77,44 @@ namespace eroil::sock {
             NodeId get_destination_id() { return m_dest_id; }
 
             SockResult connect(const char* ip, uint16_t port);
+
+            // non-blocking connect, None when it completed at once and WouldBlock while the handshake
+            // is in flight. once the handle polls writable (or errors) finish_connect() reports the outcome
+            // and puts the socket back in blocking mode. on failure the socket is done, close it
+            SockResult begin_connect(const char* ip, uint16_t port);
+            SockResult finish_connect();
             SockResult send(const void* data, const size_t size);
             SockResult send_all(const void* data, const size_t size);
+
+            // small control frames (heartbeats). never waits on the send lock or, on linux, a full socket
+            // buffer, WouldBlock means nothing was written. once part of the frame is out the rest follows
+            SockResult try_send_all(const void* data, const size_t size);
             SockResult recv(void* data, const size_t size);
             SockResult recv_all(void* data, const size_t size);
 
+            // never blocks, returns WouldBlock when nothing is waiting in the socket buffer
+            SockResult try_recv(void* data, const size_t size);
+
+            // for senders that complete asynchronously (io_uring). the send lock is held for
+            // as long as a frame is in flight so pings cannot land in the middle of it.
+            // lock and unlock must come from the same thread
+            bool try_lock_send() noexcept { return m_send_mtx.try_lock(); }
+            void unlock_send() noexcept { m_send_mtx.unlock(); }
+
+            // same fatal error handling send() applies, for sends completed somewhere else
+            void mark_send_error(int32_t sys_error) noexcept {
+                if (is_fatal_send_err(sys_error)) m_connected = false;
+            }
+
+            // linux MSG_ZEROCOPY, the kernel transmits straight from the caller's pages so the
+            // buffer must stay untouched until reap_zerocopy() reports the send calls covering it.
+            // zc_first/zc_count are the zero-copy send calls this frame used, zc_count is 0 when
+            // the kernel refused zero-copy and the frame was copied instead
+            SockResult enable_zerocopy();
+            bool zerocopy_enabled() const noexcept { return m_zerocopy; }
+            SockResult send_all_zerocopy(const void* data, const size_t size, uint32_t& zc_first, uint32_t& zc_count);
+            size_t reap_zerocopy(ZeroCopyRange* out, const size_t max);
+
             // shared implementation
             SockResult open_and_connect(const char* ip, uint16_t port) {
                 const sock::SockResult open_err = open();
@@ -77,6 +123,14 @@ namespace eroil::sock {
                 }
                 return connect(ip, port);
             }
+
+            SockResult open_and_begin_connect(const char* ip, uint16_t port) {
+                const sock::SockResult open_err = open();
+                if (open_err.code != SockErr::None) {
+                    return open_err;
+                }
+                return begin_connect(ip, port);
+            }
     };
 
     class TCPServer final : public TCPSocket {
@@ -1,5 +1,6 @@
 #pragma once
 #include <cstdint>
+#include <string>
 #include <utility>
 
 #include "types/const_types.h"
@@ -22,8 +23,15 @@ namespace eroil::sock {
             EROIL_NO_COPY(UDPMulticastSocket)
             EROIL_DECL_MOVE(UDPMulticastSocket)
 
+            // binds cfg.port without joining a group, join_group() picks the groups to receive
+            SockResult open(const cfg::UdpMcastConfig& cfg);
             SockResult open_and_join(const cfg::UdpMcastConfig& cfg);
+            SockResult join_group(const std::string& group_ip) noexcept;
+            SockResult leave_group(const std::string& group_ip) noexcept;
+            SockResult set_recv_timeout(uint32_t timeout_ms) noexcept;  // recv_broadcast then fails with WouldBlock
+            SockResult set_recv_buffer(size_t size) noexcept;           // the os may cap it
             SockResult send_broadcast(const void* data, size_t size) noexcept;
+            SockResult send_to(const std::string& group_ip, const void* data, size_t size) noexcept;   // any group, our port
             SockResult recv_broadcast(void* data, size_t size) noexcept;
             void close() noexcept;
 
@@ -38,5 +46,6 @@ namespace eroil::sock {
 
         private:
             bool handle_valid() const noexcept;
+            SockResult change_group(const std::string& group_ip, bool join) noexcept;
     };
 }
@@ -0,0 +1,78 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include "types/const_types.h"
+#include "socket_result.h"
+#include "macros.h"
+
+namespace eroil::sock {
+    struct UringCompletion {
+        uint64_t user_data = 0;
+        int32_t res = 0;        // bytes transferred, or -errno
+    };
+
+    // thin io_uring wrapper driven by raw syscalls, no liburing dependency
+    // linux only, on windows (or kernels without io_uring) open() fails and
+    // callers fall back to the regular blocking/polled socket path
+    //
+    // a ring is owned by a single thread, only wake() is safe to call from other threads
+    // user_data values at the very top of the uint64 range are reserved for internal use
+    class Uring {
+        private:
+            socket_handle m_ring_fd;
+            socket_handle m_wake_fd;     // eventfd, a read is kept armed on it so wake() completes a wait
+            uint64_t m_wake_buf;
+            bool m_wake_armed;
+
+            void* m_sq_map;
+            size_t m_sq_map_size;
+            void* m_cq_map;
+            size_t m_cq_map_size;
+            void* m_sqes;
+            size_t m_sqes_size;
+
+            uint32_t* m_sq_head;
+            uint32_t* m_sq_tail;
+            uint32_t* m_sq_array;
+            uint32_t m_sq_mask;
+            uint32_t m_sq_entries;
+
+            uint32_t* m_cq_head;
+            uint32_t* m_cq_tail;
+            void* m_cqes;
+            uint32_t m_cq_mask;
+
+            uint32_t m_sqe_tail;         // local sq tail, sqes before this are prepared but maybe not published
+
+        public:
+            Uring();
+            ~Uring();
+
+            EROIL_NO_COPY(Uring)
+            EROIL_NO_MOVE(Uring)
+
+            // true when the running kernel supports everything this wrapper needs
+            static bool supported() noexcept;
+
+            NO_DISCARD SockResult open(uint32_t entries);
+            void close() noexcept;
+            bool is_open() const noexcept { return m_ring_fd != INVALID_SOCKET; }
+
+            // queue operations, false when the submission queue is full (call submit() and retry)
+            bool prep_send(socket_handle handle, const void* data, size_t size, uint64_t user_data) noexcept;
+            bool prep_recv(socket_handle handle, void* data, size_t size, uint64_t user_data) noexcept;
+            bool prep_cancel(uint64_t target_user_data) noexcept;
+
+            // hand queued operations to the kernel and wait up to timeout_ms for at least one completion
+            // a timeout or wake() returns ok with nothing to reap
+            NO_DISCARD SockResult submit_and_wait(int32_t timeout_ms);
+
+            // copies out up to max completions, wake completions are consumed internally
+            size_t reap(UringCompletion* out, size_t max) noexcept;
+            void wake() noexcept;
+
+        private:
+            void* next_sqe() noexcept;
+            void arm_wake() noexcept;
+    };
+}
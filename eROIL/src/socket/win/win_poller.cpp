@@ -0,0 +1,165 @@
+#if defined(EROIL_WIN32)
+#include "socket/poller.h"
+#include "windows_hdr.h"
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#include <algorithm>
+#include <array>
+#include "safe_print.h"
+
+namespace eroil::sock {
+    static constexpr size_t MAX_NATIVE_EVENTS = 64;
+
+    static SOCKET as_native(socket_handle h) noexcept {
+        return static_cast<SOCKET>(h);
+    }
+    static socket_handle from_native(SOCKET h) noexcept {
+        return static_cast<socket_handle>(h);
+    }
+
+    Poller::Poller() : m_poll_handle(INVALID_SOCKET), m_wake_handle(INVALID_SOCKET), m_handles{}, m_keys{}, m_want_write{} {}
+
+    Poller::~Poller() {
+        close();
+    }
+
+    SockResult Poller::open() {
+        if (m_wake_handle != INVALID_SOCKET) {
+            return SockResult{ SockErr::DoubleOpen, SockOp::Open, 0, 0 };
+        }
+
+        // windows has no eventfd, a udp socket connected to itself on loopback
+        // is pollable and wake() just sends it a byte
+        SOCKET sock = ::socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+        if (sock == INVALID_SOCKET) {
+            const int err = ::WSAGetLastError();
+            return SockResult{ map_err(err), SockOp::Open, err, 0 };
+        }
+        m_wake_handle = from_native(sock);
+
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = 0;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        if (::bind(sock, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == SOCKET_ERROR) {
+            const int err = ::WSAGetLastError();
+            close();
+            return SockResult{ map_err(err), SockOp::Bind, err, 0 };
+        }
+
+        int len = sizeof(addr);
+        if (::getsockname(sock, reinterpret_cast<sockaddr*>(&addr), &len) == SOCKET_ERROR ||
+            ::connect(sock, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == SOCKET_ERROR) {
+            const int err = ::WSAGetLastError();
+            close();
+            return SockResult{ map_err(err), SockOp::Connect, err, 0 };
+        }
+
+        u_long nonblocking = 1;
+        if (::ioctlsocket(sock, FIONBIO, &nonblocking) == SOCKET_ERROR) {
+            const int err = ::WSAGetLastError();
+            close();
+            return SockResult{ map_err(err), SockOp::Configure, err, 0 };
+        }
+
+        return SockResult{ SockErr::None, SockOp::Open, 0, 0 };
+    }
+
+    void Poller::close() noexcept {
+        if (m_wake_handle != INVALID_SOCKET) {
+            ::closesocket(as_native(m_wake_handle));
+            m_wake_handle = INVALID_SOCKET;
+        }
+
+        m_handles.clear();
+        m_keys.clear();
+        m_want_write.clear();
+    }
+
+    SockResult Poller::add(socket_handle handle, uint64_t key, bool want_write) {
+        if (m_wake_handle == INVALID_SOCKET) {
+            return SockResult{ SockErr::NotOpen, SockOp::Configure, 0, 0 };
+        }
+
+        if (handle == INVALID_SOCKET) {
+            return SockResult{ SockErr::InvalidArgument, SockOp::Configure, 0, 0 };
+        }
+
+        // slot 0 of the native poll array is the wake socket
+        if (m_handles.size() + 1 >= MAX_NATIVE_EVENTS) {
+            return SockResult{ SockErr::ResourceExhausted, SockOp::Configure, 0, 0 };
+        }
+
+        m_handles.push_back(handle);
+        m_keys.push_back(key);
+        m_want_write.push_back(want_write ? 1 : 0);
+        return SockResult{ SockErr::None, SockOp::Configure, 0, 0 };
+    }
+
+    void Poller::remove(socket_handle handle) noexcept {
+        auto it = std::find(m_handles.begin(), m_handles.end(), handle);
+        if (it == m_handles.end()) return;
+
+        const auto index = static_cast<size_t>(std::distance(m_handles.begin(), it));
+        m_handles.erase(it);
+        m_keys.erase(m_keys.begin() + static_cast<std::ptrdiff_t>(index));
+        m_want_write.erase(m_want_write.begin() + static_cast<std::ptrdiff_t>(index));
+    }
+
+    SockResult Poller::wait(PollEvent* events, size_t max_events, int32_t timeout_ms, size_t& count) {
+        count = 0;
+        if (m_wake_handle == INVALID_SOCKET) {
+            return SockResult{ SockErr::NotOpen, SockOp::Poll, 0, 0 };
+        }
+
+        if (events == nullptr || max_events == 0) {
+            return SockResult{ SockErr::InvalidArgument, SockOp::Poll, 0, 0 };
+        }
+
+        std::array<WSAPOLLFD, MAX_NATIVE_EVENTS> native{};
+        native[0].fd = as_native(m_wake_handle);
+        native[0].events = POLLRDNORM;
+
+        const size_t nfds = m_handles.size() + 1;
+        for (size_t i = 0; i < m_handles.size(); ++i) {
+            native[i + 1].fd = as_native(m_handles[i]);
+            native[i + 1].events = m_want_write[i] != 0 ? (POLLRDNORM | POLLWRNORM) : POLLRDNORM;
+        }
+
+        const int ready = ::WSAPoll(native.data(), static_cast<ULONG>(nfds), timeout_ms);
+        if (ready == SOCKET_ERROR) {
+            const int err = ::WSAGetLastError();
+            return SockResult{ map_err(err), SockOp::Poll, err, 0 };
+        }
+
+        if (ready == 0) {
+            return SockResult{ SockErr::None, SockOp::Poll, 0, 0 };
+        }
+
+        if (native[0].revents != 0) {
+            std::array<char, 64> drain{};
+            while (::recv(as_native(m_wake_handle), drain.data(), static_cast<int>(drain.size()), 0) > 0) {}
+        }
+
+        for (size_t i = 1; i < nfds && count < max_events; ++i) {
+            const SHORT revents = native[i].revents;
+            if (revents == 0) continue;
+
+            PollEvent& out = events[count++];
+            out.key = m_keys[i - 1];
+            out.readable = (revents & POLLRDNORM) != 0;
+            out.writable = (revents & POLLWRNORM) != 0;
+            out.hangup = (revents & (POLLHUP | POLLNVAL)) != 0;
+            out.error = (revents & POLLERR) != 0;
+        }
+
+        return SockResult{ SockErr::None, SockOp::Poll, 0, 0 };
+    }
+
+    void Poller::wake() noexcept {
+        if (m_wake_handle == INVALID_SOCKET) return;
+        const char one = 1;
+        (void)::send(as_native(m_wake_handle), &one, 1, 0);
+    }
+}
+#endif
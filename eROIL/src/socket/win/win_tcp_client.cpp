@@ -15,7 +15,7 @@ namespace eroil::sock {
     //     return static_cast<socket_handle>(handle);
     // }
 
-    TCPClient::TCPClient() : TCPSocket(), m_dest_id(INVALID_NODE) {}
+    TCPClient::TCPClient() : TCPSocket(), m_dest_id(INVALID_NODE), m_zerocopy(false), m_zc_next_seq(0) {}
 
     SockResult TCPClient::connect(const char* ip, uint16_t port) {
         if (!handle_valid()) return SockResult{ SockErr::InvalidHandle, SockOp::Connect, 0, 0 };
@@ -44,6 +44,61 @@ namespace eroil::sock {
         return SockResult{ SockErr::None, SockOp::Connect, 0, 0 };
     }
 
+    SockResult TCPClient::begin_connect(const char* ip, uint16_t port) {
+        if (!handle_valid()) return SockResult{ SockErr::InvalidHandle, SockOp::Connect, 0, 0 };
+        if (is_connected()) return SockResult{ SockErr::AlreadyConnected, SockOp::Connect, 0, 0 };
+
+        if (!ip || *ip == '\0') {
+            return SockResult{ SockErr::InvalidIp, SockOp::Connect, 0, 0 };
+        }
+
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(port);
+
+        if (::inet_pton(AF_INET, ip, &addr.sin_addr) != 1) {
+            return SockResult{ SockErr::InvalidIp, SockOp::Connect, 0, 0 };
+        }
+
+        // non-blocking for the handshake only, finish_connect() puts the socket back
+        u_long nonblocking = 1;
+        if (::ioctlsocket(as_native(m_handle), FIONBIO, &nonblocking) == SOCKET_ERROR) {
+            int err = ::WSAGetLastError();
+            return SockResult{ map_err(err), SockOp::Configure, err, 0 };
+        }
+
+        if (::connect(as_native(m_handle), reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0) {
+            return finish_connect();
+        }
+
+        // WSAEWOULDBLOCK maps to WouldBlock, the handshake is in flight
+        int err = ::WSAGetLastError();
+        return SockResult{ map_err(err), SockOp::Connect, err, 0 };
+    }
+
+    SockResult TCPClient::finish_connect() {
+        if (!handle_valid()) return SockResult{ SockErr::InvalidHandle, SockOp::Connect, 0, 0 };
+        if (is_connected()) return SockResult{ SockErr::AlreadyConnected, SockOp::Connect, 0, 0 };
+
+        int err = 0;
+        int len = sizeof(err);
+        if (::getsockopt(as_native(m_handle), SOL_SOCKET, SO_ERROR, reinterpret_cast<char*>(&err), &len) == SOCKET_ERROR) {
+            err = ::WSAGetLastError();
+        }
+        if (err != 0) {
+            return SockResult{ map_err(err), SockOp::Connect, err, 0 };
+        }
+
+        u_long nonblocking = 0;
+        if (::ioctlsocket(as_native(m_handle), FIONBIO, &nonblocking) == SOCKET_ERROR) {
+            int ferr = ::WSAGetLastError();
+            return SockResult{ map_err(ferr), SockOp::Configure, ferr, 0 };
+        }
+
+        m_connected = true;
+        return SockResult{ SockErr::None, SockOp::Connect, 0, 0 };
+    }
+
     SockResult TCPClient::send(const void* data, const size_t size) {
         if (!is_connected()) {
             return SockResult{ SockErr::NotConnected, SockOp::Send, 0, 0 };
@@ -135,6 +190,56 @@ namespace eroil::sock {
         return SockResult{ SockErr::None, SockOp::Send, 0, static_cast<int>(total) };
     }
 
+    SockResult TCPClient::try_send_all(const void* data, const size_t size) {
+        if (!is_connected()) {
+            return SockResult{ SockErr::NotConnected, SockOp::Send, 0, 0 };
+        }
+
+        if (size <= 0) { 
+            return SockResult{ SockErr::SizeZero, SockOp::Send, 0, 0 };
+        }
+
+        if (size > static_cast<size_t>(INT32_MAX)) {
+            return SockResult{ SockErr::SizeTooLarge, SockOp::Send, 0, 0 };
+        }
+
+        std::unique_lock lock(m_send_mtx, std::try_to_lock);
+        if (!lock.owns_lock()) {
+            return SockResult{ SockErr::WouldBlock, SockOp::Send, 0, 0 };
+        }
+
+        // NOTE: no per call non-blocking send on windows, a full send buffer blocks here
+        size_t total = 0;
+        auto* ptr = static_cast<const char*>(data);
+        while (total < size) {
+            int to_send = static_cast<int>(size - total);
+            int sent_bytes = ::send(as_native(m_handle), ptr + total, to_send, 0);
+
+            if (sent_bytes > 0) {
+                total += static_cast<size_t>(sent_bytes); 
+                continue;
+            }
+
+            if (sent_bytes == 0) {
+                m_connected = false;
+                return SockResult{ SockErr::Closed, SockOp::Send, 0, static_cast<int>(total) };
+            }
+
+            int err = ::WSAGetLastError();
+            if (err == WSAEINTR) {
+                continue; // retry
+            }
+
+            if (is_fatal_send_err(err)) {
+                m_connected = false;
+            }
+
+            return SockResult{ map_err(err), SockOp::Send, err, static_cast<int>(total) };
+        }
+
+        return SockResult{ SockErr::None, SockOp::Send, 0, static_cast<int>(total) };
+    }
+
     SockResult TCPClient::recv(void* data, const size_t size) {
         if (!is_connected()) {
             return SockResult{ SockErr::NotConnected, SockOp::Recv, 0, 0 };
@@ -222,5 +327,62 @@ namespace eroil::sock {
             static_cast<int>(total)
         };
     }
+
+    SockResult TCPClient::try_recv(void* data, const size_t size) {
+        if (!is_connected()) {
+            return SockResult{ SockErr::NotConnected, SockOp::Recv, 0, 0 };
+        }
+
+        if (size == 0) {
+            return SockResult{ SockErr::SizeZero, SockOp::Recv, 0, 0 };
+        }
+
+        if (size > static_cast<size_t>(INT32_MAX)) {
+            return SockResult{ SockErr::SizeTooLarge, SockOp::Recv, 0, 0 };
+        }
+
+        // winsock has no MSG_DONTWAIT, ask how much is buffered instead of flipping the
+        // socket to non-blocking (which would also change the behaviour of send_all)
+        u_long available = 0;
+        if (::ioctlsocket(as_native(m_handle), FIONREAD, &available) != 0) {
+            int err = ::WSAGetLastError();
+            return SockResult{ map_err(err), SockOp::Recv, err, 0 };
+        }
+
+        if (available == 0) {
+            return SockResult{ SockErr::WouldBlock, SockOp::Recv, 0, 0 };
+        }
+
+        const size_t want = (static_cast<size_t>(available) < size) ? static_cast<size_t>(available) : size;
+        int recv_bytes = ::recv(as_native(m_handle), static_cast<char*>(data), static_cast<int>(want), 0);
+        if (recv_bytes > 0) {
+            return SockResult{ SockErr::None, SockOp::Recv, 0, recv_bytes };
+        }
+
+        if (recv_bytes == 0) {
+            // peer performed orderly shutdown
+            m_connected = false;
+            return SockResult{ SockErr::Closed, SockOp::Recv, 0, 0 };
+        }
+
+        int err = ::WSAGetLastError();
+        return SockResult{ map_err(err), SockOp::Recv, err, 0 };
+    }
+    // MSG_ZEROCOPY is linux only, windows always copies
+    SockResult TCPClient::enable_zerocopy() {
+        return SockResult{ SockErr::Unsupported, SockOp::Configure, 0, 0 };
+    }
+
+    SockResult TCPClient::send_all_zerocopy(const void* data, const size_t size, uint32_t& zc_first, uint32_t& zc_count) {
+        zc_first = m_zc_next_seq;
+        zc_count = 0;
+        return send_all(data, size);
+    }
+
+    size_t TCPClient::reap_zerocopy(ZeroCopyRange* out, const size_t max) {
+        (void)out;
+        (void)max;
+        return 0;
+    }
 }
-#endif
\ No newline at end of file
+#endif
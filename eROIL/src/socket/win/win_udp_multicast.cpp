@@ -43,13 +43,12 @@ namespace eroil::sock {
         return *this;
     }
 
-    SockResult UDPMulticastSocket::open_and_join(const cfg::UdpMcastConfig& cfg) {
+    SockResult UDPMulticastSocket::open(const cfg::UdpMcastConfig& cfg) {
         // open
         SockResult result{};
         result.op = SockOp::Open;
 
         if (handle_valid()) { result.code = SockErr::DoubleOpen; return result; }
-        if (cfg.group_ip.empty()) { result.code = SockErr::InvalidIp; return result; }
         if (cfg.bind_ip.empty()) { result.code = SockErr::InvalidIp; return result; }
         if (cfg.port == 0) { result.code = SockErr::InvalidArgument; return result; }
 
@@ -111,37 +110,118 @@ namespace eroil::sock {
         ::setsockopt(as_native(m_handle), IPPROTO_IP, IP_MULTICAST_LOOP,
                     reinterpret_cast<const char*>(&loop), sizeof(loop));
 
-        // join group
+        result.code = SockErr::None;
+        return result;
+    }
+
+    SockResult UDPMulticastSocket::open_and_join(const cfg::UdpMcastConfig& cfg) {
+        if (cfg.group_ip.empty()) {
+            SockResult result{};
+            result.op = SockOp::Open;
+            result.code = SockErr::InvalidIp;
+            return result;
+        }
+
+        SockResult result = open(cfg);
+        if (!result.ok()) return result;
+
+        result = join_group(cfg.group_ip);
+        if (!result.ok()) {
+            close();
+            return result;
+        }
+
+        result.op = SockOp::Open;
+        return result;
+    }
+
+    SockResult UDPMulticastSocket::change_group(const std::string& group_ip, bool join) noexcept {
+        SockResult result{};
         result.op = SockOp::Join;
+
+        if (!is_open()) { result.code = SockErr::NotOpen; return result; }
+
         ip_mreq mreq{};
-        if (::inet_pton(AF_INET, cfg.group_ip.c_str(), &mreq.imr_multiaddr) != 1) {
+        if (::inet_pton(AF_INET, group_ip.c_str(), &mreq.imr_multiaddr) != 1) {
             ERR_PRINT("err ::join()");
-            close();
             result.code = SockErr::InvalidIp;
             return result;
         }
         
         mreq.imr_interface.s_addr = htonl(INADDR_ANY);
 
-        if (::setsockopt(as_native(m_handle), IPPROTO_IP, IP_ADD_MEMBERSHIP,
+        const int opt = join ? IP_ADD_MEMBERSHIP : IP_DROP_MEMBERSHIP;
+        if (::setsockopt(as_native(m_handle), IPPROTO_IP, opt,
                         reinterpret_cast<const char*>(&mreq), sizeof(mreq)) != 0) {
             result.sys_error = ::WSAGetLastError();
             result.code = map_err(result.sys_error);
-            close();
             return result;
         }
 
-        m_joined = true;
+        if (join) m_joined = true;
+        result.code = SockErr::None;
+        return result;
+    }
+
+    SockResult UDPMulticastSocket::join_group(const std::string& group_ip) noexcept {
+        return change_group(group_ip, true);
+    }
+
+    SockResult UDPMulticastSocket::leave_group(const std::string& group_ip) noexcept {
+        return change_group(group_ip, false);
+    }
+
+    SockResult UDPMulticastSocket::set_recv_timeout(uint32_t timeout_ms) noexcept {
+        SockResult result{};
+        result.op = SockOp::Recv;
+
+        if (!is_open()) { result.code = SockErr::NotOpen; return result; }
+
+        DWORD timeout = static_cast<DWORD>(timeout_ms);
+        if (::setsockopt(as_native(m_handle), SOL_SOCKET, SO_RCVTIMEO,
+                        reinterpret_cast<const char*>(&timeout), sizeof(timeout)) != 0) {
+            result.sys_error = ::WSAGetLastError();
+            result.code = map_err(result.sys_error);
+            return result;
+        }
+
+        result.code = SockErr::None;
+        return result;
+    }
+
+    SockResult UDPMulticastSocket::set_recv_buffer(size_t size) noexcept {
+        SockResult result{};
+        result.op = SockOp::Recv;
+
+        if (!is_open()) { result.code = SockErr::NotOpen; return result; }
+
+        int bytes = static_cast<int>(size);
+        if (::setsockopt(as_native(m_handle), SOL_SOCKET, SO_RCVBUF,
+                        reinterpret_cast<const char*>(&bytes), sizeof(bytes)) != 0) {
+            result.sys_error = ::WSAGetLastError();
+            result.code = map_err(result.sys_error);
+            return result;
+        }
+
         result.code = SockErr::None;
-        result.op = SockOp::Open;
         return result;
     }
 
     SockResult UDPMulticastSocket::send_broadcast(const void* data, size_t size) noexcept {
+        if (!m_joined) {
+            SockResult result{};
+            result.op = SockOp::Send;
+            result.code = SockErr::NotOpen;
+            return result;
+        }
+        return send_to(m_cfg.group_ip, data, size);
+    }
+
+    SockResult UDPMulticastSocket::send_to(const std::string& group_ip, const void* data, size_t size) noexcept {
         SockResult result{};
         result.op = SockOp::Send;
 
-        if (!is_open() || !m_joined) { result.code = SockErr::NotOpen; return result; }
+        if (!is_open()) { result.code = SockErr::NotOpen; return result; }
         if (!data) { result.code = SockErr::InvalidArgument; return result; }
         if (size == 0) { result.code = SockErr::SizeZero; return result; }
         if (size > static_cast<size_t>(INT32_MAX)) { result.code = SockErr::SizeTooLarge; return result; }
@@ -150,7 +230,7 @@ namespace eroil::sock {
         dst.sin_family = AF_INET;
         dst.sin_port = htons(m_cfg.port);
 
-        if (::inet_pton(AF_INET, m_cfg.group_ip.c_str(), &dst.sin_addr) != 1) {
+        if (::inet_pton(AF_INET, group_ip.c_str(), &dst.sin_addr) != 1) {
             result.code = SockErr::InvalidIp;
             return result;
         }
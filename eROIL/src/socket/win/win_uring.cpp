@@ -0,0 +1,78 @@
+#if defined(EROIL_WIN32)
+#include "socket/uring.h"
+
+namespace eroil::sock {
+    // io_uring is linux only, every operation reports unsupported so callers
+    // stay on the regular socket path
+
+    Uring::Uring() :
+        m_ring_fd(INVALID_SOCKET),
+        m_wake_fd(INVALID_SOCKET),
+        m_wake_buf(0),
+        m_wake_armed(false),
+        m_sq_map(nullptr),
+        m_sq_map_size(0),
+        m_cq_map(nullptr),
+        m_cq_map_size(0),
+        m_sqes(nullptr),
+        m_sqes_size(0),
+        m_sq_head(nullptr),
+        m_sq_tail(nullptr),
+        m_sq_array(nullptr),
+        m_sq_mask(0),
+        m_sq_entries(0),
+        m_cq_head(nullptr),
+        m_cq_tail(nullptr),
+        m_cqes(nullptr),
+        m_cq_mask(0),
+        m_sqe_tail(0) {}
+
+    Uring::~Uring() {
+        close();
+    }
+
+    bool Uring::supported() noexcept {
+        return false;
+    }
+
+    SockResult Uring::open(uint32_t entries) {
+        (void)entries;
+        return SockResult{ SockErr::NotInitialized, SockOp::Open, 0, 0 };
+    }
+
+    void Uring::close() noexcept {}
+
+    bool Uring::prep_send(socket_handle handle, const void* data, size_t size, uint64_t user_data) noexcept {
+        (void)handle; (void)data; (void)size; (void)user_data;
+        return false;
+    }
+
+    bool Uring::prep_recv(socket_handle handle, void* data, size_t size, uint64_t user_data) noexcept {
+        (void)handle; (void)data; (void)size; (void)user_data;
+        return false;
+    }
+
+    bool Uring::prep_cancel(uint64_t target_user_data) noexcept {
+        (void)target_user_data;
+        return false;
+    }
+
+    SockResult Uring::submit_and_wait(int32_t timeout_ms) {
+        (void)timeout_ms;
+        return SockResult{ SockErr::NotOpen, SockOp::Poll, 0, 0 };
+    }
+
+    size_t Uring::reap(UringCompletion* out, size_t max) noexcept {
+        (void)out; (void)max;
+        return 0;
+    }
+
+    void Uring::wake() noexcept {}
+
+    void* Uring::next_sqe() noexcept {
+        return nullptr;
+    }
+
+    void Uring::arm_wake() noexcept {}
+}
+#endif
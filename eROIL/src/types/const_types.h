@@ -6,6 +6,7 @@
 namespace eroil {
     constexpr std::string_view MANAGE_CONFIG_FILE_PATH = "etc/manager.cfg";
     constexpr std::string_view PEER_IP_FILE_PATH = "etc/peer_ips.cfg";
+    constexpr std::string_view ROUTE_MANIFEST_FILE_PATH = "etc/routes.cfg";
     constexpr std::string_view LOCAL_HOST = "127.0.0.1";
     constexpr std::uint16_t PORT_START = 8080;
 
@@ -16,9 +17,19 @@ namespace eroil {
     static constexpr Label INVALID_LABEL = -1;
     static constexpr NodeId INVALID_NODE = -1;
 
-    static constexpr std::uint32_t MAX_LABELS = 200;
+    // node ids run 0..MAX_NODES-1 (rtos.h knows 20 today), routes keep subscriber nodes in one 64 bit word
+    static constexpr NodeId MAX_NODES = 64;
+
+    // labels a node may have open per direction, manager.cfg max_labels picks within these
+    static constexpr std::uint32_t DEFAULT_MAX_LABELS = 2048;
+    static constexpr std::uint32_t MAX_LABELS_LIMIT = 65536;
+
+    // discovery messages are cut into datagrams of this size so they never rely on ip fragmentation
+    static constexpr std::size_t BROADCAST_DATAGRAM_SIZE = 1400;
+    // same for frames on the multicast data plane, a max size label is ~770 of them
+    static constexpr std::size_t MCAST_DATAGRAM_SIZE = 1400;
     static constexpr std::uint32_t MAGIC_NUM = 0x4C4F5245u; // 'EROL' as ascii bytes
-    static constexpr std::uint16_t VERSION = 1;
+    static constexpr std::uint16_t VERSION = 11;
 
     static constexpr std::size_t KILOBYTE = 1024u;
     static constexpr std::size_t MEGABYTE = 1024u * KILOBYTE;
@@ -26,8 +37,26 @@ namespace eroil {
     static constexpr std::size_t MAX_LABEL_SIZE = 1 * MEGABYTE;
     static_assert(MAX_LABEL_SIZE % 64 == 0);
 
-    static constexpr std::size_t SHM_BLOCK_SIZE = 128 * MEGABYTE;
+    // per node recv ring, picked at creation (manager.cfg) and stored in the block header
+    static constexpr std::size_t SHM_BLOCK_SIZE = 128 * MEGABYTE;      // default
+    static constexpr std::size_t SHM_MIN_BLOCK_SIZE = 32 * MEGABYTE;   // every lane fits a max size label
+    static constexpr std::size_t SHM_MAX_BLOCK_SIZE = 1024 * MEGABYTE;
     static_assert(SHM_BLOCK_SIZE % 64 == 0);
+    static_assert(SHM_MIN_BLOCK_SIZE <= SHM_BLOCK_SIZE && SHM_BLOCK_SIZE <= SHM_MAX_BLOCK_SIZE);
+
+    // tcp connections per remote peer pair. stripe 0 carries control frames and small labels,
+    // labels of at least TCP_STRIPE_BULK_SIZE hash over the others so they never hold up small ones
+    static constexpr std::uint32_t MAX_TCP_STRIPES = 8;
+    static constexpr std::size_t TCP_STRIPE_BULK_SIZE = 64 * KILOBYTE;
+
+    // the recv ring is split into one single producer lane per local source node
+    static constexpr std::uint32_t SHM_MAX_LANES = 16;
+    static constexpr std::size_t SHM_MIN_LANE_SIZE = MAX_LABEL_SIZE + 64 * KILOBYTE; // max label + headers + wrap record
+
+    // per node arena holding the slots of subscribers that let eROIL allocate their recv buffer
+    static constexpr std::uint32_t SHM_ARENA_MAX_ENTRIES = 256;
+    static constexpr std::size_t SHM_MIN_ARENA_SIZE = 1 * MEGABYTE;
+    static constexpr std::size_t SHM_MAX_ARENA_SIZE = 1024 * MEGABYTE;
 
     using std::uint8_t;
     using std::uint16_t;
@@ -1,9 +1,12 @@
 #pragma once
+#include <atomic>
 #include <memory>
 #include <mutex>
 #include "iosb.h"
 #include "const_types.h"
 
+namespace eroil::shm { class ShmMailbox; class ShmArena; }
+
 namespace eroil::hndl {
   
     struct OpenSendData {
@@ -36,14 +39,29 @@ namespace eroil::hndl {
         uint32_t num_iosb;
         size_t iosb_index;
         iosb::SignalMode signal_mode;
-        uint32_t recv_count;
     };
 
+    // slot ring state is split so the application never waits on a delivery:
+    //  - producers (recv workers) serialize on write_mtx, buf/buf_index/iosb_index only change under it
+    //  - recv_count is bumped by the producer after the slot and IOSB are written (release) and
+    //    only ever decreased by the application (recv_dismiss), so a producer that saw room still has it
+    //  - is_idle is a plain flag the producer checks before taking the lock
+    //  - mailbox (OVERWRITE only) is pulled by the application on recv_count, same host publishers
+    //    write it instead of a ring record so updates between two pulls collapse into one
+    //  - arena handles (opened with a null buf) have their slots in the nodes shm arena, same host
+    //    publishers write the slot directly and the recv worker only hands finished tickets over
     struct RecvHandle {
-        std::mutex mtx;
+        std::mutex write_mtx;
         handle_uid uid;
-        bool is_idle;
+        std::atomic<bool> is_idle;
+        std::atomic<uint32_t> recv_count;
         OpenReceiveData data;
-        RecvHandle(uint32_t id, OpenReceiveData d) : uid(id), is_idle(false), data(d) {}
+        std::shared_ptr<shm::ShmMailbox> mailbox = nullptr;
+        uint64_t mailbox_seq = 0;   // last mailbox value taken, under write_mtx
+        std::shared_ptr<shm::ShmArena> arena = nullptr;
+        uint32_t arena_entry = 0;
+        uint64_t arena_next = 0;        // next ticket to hand over, under write_mtx
+        uint64_t arena_stalled_ns = 0;  // when arena_next was first seen claimed but not committed
+        RecvHandle(uint32_t id, OpenReceiveData d) : uid(id), is_idle(false), recv_count(0), data(d) {}
     };
 }
\ No newline at end of file
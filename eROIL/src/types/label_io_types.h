@@ -1,12 +1,20 @@
 #pragma once
-#include <array>
+#include <vector>
 #include "const_types.h"
+#include "memory/crc32c.h"
 #include "safe_print.h"
 
 namespace eroil::io {
+    enum class LabelInfoFlag : uint32_t {
+        Mailbox = 1 << 0,   // every subscriber on the node reads the shm mailbox, local publishers skip the ring
+        Arena = 1 << 1,     // every subscriber on the node has its slots in the nodes shm arena, local publishers write them
+        Multicast = 1 << 2, // node listens on the multicast data plane, remote publishers may send the label there
+    };
+
     struct LabelInfo {
         Label label = INVALID_LABEL;
         uint32_t size = 0;
+        uint32_t flags = 0;
 
         LabelInfo() noexcept = default;
         bool operator<(const LabelInfo& other) const noexcept {
@@ -16,15 +24,96 @@ namespace eroil::io {
 
     struct LabelsSnapshot {
         uint64_t gen = 0;
-        std::array<LabelInfo, MAX_LABELS> labels{};
+        std::vector<LabelInfo> labels{};    // sorted by label
     };
 
-    struct BroadcastMessage {
+    enum class BroadcastKind : uint16_t {
+        Full = 0,       // every label we send and receive, sent on start, on request and as a slow repair
+        Delta = 1,      // recv labels added/changed and removed since our previous broadcast
+        Resync = 2,     // asks target for a full snapshot, it missed a delta of theirs
+    };
+
+    // leads every discovery datagram. a message body (see broadcast_codec.h) is cut into
+    // frag_count datagrams that share seq, the receiver puts them back together by frag
+    struct BroadcastHeader {
+        uint32_t magic = MAGIC_NUM;
+        uint16_t version = VERSION;
+        BroadcastKind kind = BroadcastKind::Full;
         int32_t id = INVALID_NODE;
+        uint32_t seq = 0;
+        uint16_t frag = 0;
+        uint16_t frag_count = 0;
+    };
+    static_assert(sizeof(BroadcastHeader) == 20);
+
+    struct BroadcastMessage {
+        BroadcastHeader hdr{};
         LabelsSnapshot send_labels{};
         LabelsSnapshot recv_labels{};
     };
 
+    struct BroadcastDelta {
+        BroadcastHeader hdr{};
+        uint64_t base_gen = 0;      // recv gen of the broadcast this applies on top of
+        uint64_t gen = 0;
+        std::vector<LabelInfo> added{};     // added or changed, sorted by label
+        std::vector<LabelInfo> removed{};   // sorted by label, only the label is sent
+    };
+
+    struct BroadcastResync {
+        BroadcastHeader hdr{};
+        int32_t target = INVALID_NODE;
+    };
+
+    enum class McastKind : uint16_t {
+        Data = 0,       // fragment of one label frame, LabelHeader + payload as it goes over tcp
+        Heartbeat = 1,  // McastHeartbeat entries for labels gone quiet, shows receivers a lost last frame
+    };
+
+    // leads every multicast data plane datagram. a frame is cut into frag_count datagrams that
+    // share seq, seq counts the frames of one label from one source. session is picked when the
+    // source starts so receivers drop their seq state when it restarts
+    struct McastHeader {
+        uint32_t magic = MAGIC_NUM;
+        uint16_t version = VERSION;
+        McastKind kind = McastKind::Data;
+        int32_t source_id = INVALID_NODE;
+        uint32_t session = 0;
+        int32_t label = INVALID_LABEL;
+        uint32_t seq = 0;
+        uint32_t total_size = 0;    // frame size, or heartbeat body size
+        uint16_t frag = 0;
+        uint16_t frag_count = 0;
+    };
+    static_assert(sizeof(McastHeader) == 32);
+
+    struct McastHeartbeat {
+        int32_t label = INVALID_LABEL;
+        uint32_t seq = 0;           // last frame sent
+    };
+    static_assert(sizeof(McastHeartbeat) == 8);
+
+    // payload of a LabelFlag::Nack frame, asks for frames first_seq..first_seq+count-1 of the label.
+    // the source resends the ones it still holds as LabelFlag::Resend frames on the same socket
+    struct McastNack {
+        uint32_t session = 0;
+        uint32_t first_seq = 0;
+        uint32_t count = 0;
+    };
+    static_assert(sizeof(McastNack) == 12);
+
+    // payload of a LabelFlag::Resend frame, followed by the multicast frame (LabelHeader + payload) it
+    // resends. the receiver drops it if a newer frame of the label was delivered in the meantime
+    struct McastResend {
+        uint32_t session = 0;
+        uint32_t seq = 0;
+    };
+    static_assert(sizeof(McastResend) == 8);
+
+    inline bool has_flag(const LabelInfo& info, const LabelInfoFlag flag) {
+        return (info.flags & static_cast<uint32_t>(flag)) != 0;
+    }
+
     struct LabelHeader {
         uint32_t magic = 0;
         uint16_t version = 0;
@@ -33,16 +122,69 @@ namespace eroil::io {
         int32_t label = INVALID_LABEL;
         uint32_t label_size = 0;
         uint32_t recv_offset = 0;
+        uint32_t checksum = 0;      // crc32c, only valid with LabelFlag::Checksum
     };
+    static_assert(sizeof(LabelHeader) == 32);
 
     enum class LabelFlag : uint16_t {
         Data = 1 << 0,
         Connect = 1 << 1,
         Disconnect = 1 << 2,
         Ping = 1 << 3,
+        Checksum = 1 << 4,
+        Nack = 1 << 5,      // asks the source to resend multicast frames over this socket, see McastNack
+        Relay = 1 << 6,     // a frame wrapped for the host gateways, see RelayHeader
+        Pong = 1 << 7,      // answer to a Ping, echoes its PingBody
+        Resend = 1 << 8,    // a multicast frame resent for a Nack, see McastResend
     };
 
+    // payload of LabelFlag::Ping and LabelFlag::Pong frames. a pong carries the ping body back
+    // unchanged so the pinging node measures the round trip on its own clock
+    struct PingBody {
+        uint64_t sent_ns = 0;
+        uint32_t seq = 0;
+        uint32_t reserved = 0;
+    };
+    static_assert(sizeof(PingBody) == 16);
+
+    // payload of a LabelFlag::Connect frame. a node dials every stripe of a peer at once and sends
+    // one of these on each, the accepting node registers the set once all stripes with the nonce arrived
+    struct ConnectBody {
+        uint64_t nonce = 0;         // same on every stripe of one dial attempt
+        uint32_t stripe = 0;
+        uint32_t stripes = 1;
+    };
+    static_assert(sizeof(ConnectBody) == 16);
+
+    // payload of a LabelFlag::Relay frame, followed by the wrapped frame (LabelHeader + payload) as it
+    // went out of the source. dests are the remote subscribers of the label as a node bitset, a gateway
+    // passes the frame on to the gateways of their hosts and hands it to the ones on its own host
+    struct RelayHeader {
+        uint64_t dests = 0;
+    };
+    static_assert(sizeof(RelayHeader) == 8);
+    static constexpr size_t MAX_RELAY_SIZE = sizeof(RelayHeader) + sizeof(LabelHeader) + MAX_LABEL_SIZE;
+    static constexpr size_t MAX_RESEND_SIZE = sizeof(McastResend) + sizeof(LabelHeader) + MAX_LABEL_SIZE;
+
     inline bool has_flag(const uint16_t flags, const LabelFlag flag) { 
         return flags & static_cast<std::uint16_t>(flag); 
     }
+
+    // crc32c over the header fields and label_size bytes of data
+    // fields are fed one by one so struct padding never ends up in the checksum
+    inline uint32_t label_header_checksum(const LabelHeader& hdr) noexcept {
+        const uint32_t fields[6] = {
+            hdr.magic,
+            static_cast<uint32_t>(hdr.version) | (static_cast<uint32_t>(hdr.flags) << 16),
+            static_cast<uint32_t>(hdr.source_id),
+            static_cast<uint32_t>(hdr.label),
+            hdr.label_size,
+            hdr.recv_offset
+        };
+        return mem::crc32c(fields, sizeof(fields));
+    }
+
+    inline uint32_t label_checksum(const LabelHeader& hdr, const std::byte* data) noexcept {
+        return mem::crc32c(data, hdr.label_size, label_header_checksum(hdr));
+    }
 }
\ No newline at end of file
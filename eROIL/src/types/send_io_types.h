@@ -7,6 +7,8 @@
 #include "rtos.h"
 #include "platform/platform.h"
 #include "shm/shm_send.h"
+#include "shm/shm_mailbox.h"
+#include "shm/shm_arena.h"
 #include "socket/tcp_socket.h"
 #include "handles.h"
 #include "const_types.h"
@@ -15,9 +17,12 @@
 #include "assertion.h"
 #include "comm/write_iosb.h"
 
+namespace eroil::wrk { class McastData; }
+
 namespace eroil::io {
     struct SendBuf {
         void* data_src_addr = nullptr; // where the data was copied from (for send IOSB)
+        const std::byte* src_payload = nullptr; // caller's payload, only valid until send_label returns
         std::unique_ptr<std::byte[]> data = nullptr;
         std::size_t data_size = 0;
         std::size_t total_size = 0;  // size of data + header
@@ -30,6 +35,15 @@ namespace eroil::io {
             total_size = size + sizeof(LabelHeader);
             data = std::make_unique<std::byte[]>(total_size);
         }
+
+        // a whole frame (header included) sent on for another node, no caller buffer behind it
+        explicit SendBuf(const std::size_t frame_size) {
+            DB_ASSERT(frame_size > sizeof(LabelHeader), "relayed frame must carry a payload");
+
+            data_size = frame_size - sizeof(LabelHeader);
+            total_size = frame_size;
+            data = std::make_unique<std::byte[]>(total_size);
+        }
         
         EROIL_NO_COPY(SendBuf)
         EROIL_DEFAULT_MOVE(SendBuf)
@@ -53,6 +67,7 @@ namespace eroil::io {
         Label label;
         SendBuf send_buffer;
         uint32_t seq;
+        uint32_t stripe;    // tcp connection to each remote subscriber, also picks the sender thread
         std::shared_ptr<hndl::SendHandle> publisher;
         
         uint32_t local_failure_count;
@@ -61,17 +76,42 @@ namespace eroil::io {
         uint32_t remote_failure_count;
         std::vector<std::shared_ptr<sock::TCPClient>> remote_recvrs;
 
+        // the multicast data plane, when it stands in for the sockets of the labels multicast subscribers
+        uint32_t mcast_failure_count;
+        std::vector<std::shared_ptr<wrk::McastData>> mcast_recvrs;
+
+        // with host gateways the remote subscribers are served by a second job carrying the frame wrapped
+        // for the gateways. it is handed to the senders next to this one and completes it as one send
+        std::shared_ptr<SendJob> relay;
+        std::shared_ptr<SendJob> parent;    // set on the relay job, cleared once it completed its parent
+        uint32_t relay_failure_count;
+
+        // local subscribers reading the label mailbox, written on the publishing thread
+        std::shared_ptr<shm::ShmMailbox> mailbox;
+
+        // local nodes whose subscribers take the label in their arena, written on the publishing thread
+        std::vector<std::shared_ptr<shm::ShmArena>> arenas;
+
         std::atomic<uint32_t> pending_sends{0};
 
         explicit SendJob(SendBuf&& buf) :
             source_id{INVALID_NODE},
             label{INVALID_LABEL},
             send_buffer(std::move(buf)),
+            seq{0},
+            stripe{0},
             publisher{nullptr},
             local_failure_count{0},
             local_recvrs{},
             remote_failure_count{0},
             remote_recvrs{},
+            mcast_failure_count{0},
+            mcast_recvrs{},
+            relay{nullptr},
+            parent{nullptr},
+            relay_failure_count{0},
+            mailbox{nullptr},
+            arenas{},
             pending_sends{0} {}
 
         EROIL_NO_COPY(SendJob)
@@ -104,13 +144,24 @@ namespace eroil::io {
         }
 
         void finalize_send_iosb() noexcept {
+            const uint32_t failures = local_failure_count + remote_failure_count + mcast_failure_count;
+            if (parent != nullptr) {
+                std::shared_ptr<SendJob> done = std::move(parent);
+                done->relay_failure_count = failures;
+                done->complete_one();
+                return;
+            }
+
+            // frames a gateway relays for someone else have nobody to report to
+            if (publisher == nullptr) return;
+
             std::lock_guard lock(publisher->mtx);
             comm::write_send_iosb(
                 publisher.get(), 
                 source_id, 
                 label, 
                 send_buffer.data_size,
-                local_failure_count + remote_failure_count,
+                failures + relay_failure_count,
                 send_buffer.data_src_addr
             );
             plat::try_signal_sem(publisher->data.sem);
@@ -122,6 +173,9 @@ namespace eroil::io {
         JobCompleteGuard() = delete;
         explicit JobCompleteGuard(std::shared_ptr<SendJob> j) : job(j) {}
         ~JobCompleteGuard() { if (job != nullptr) job->complete_one(); }
+
+        // hand the completion off to someone else (ie a zero copy send still in flight)
+        std::shared_ptr<SendJob> release() noexcept { return std::move(job); }
         EROIL_NO_COPY(JobCompleteGuard)
         EROIL_NO_MOVE(JobCompleteGuard)
     };
@@ -0,0 +1,245 @@
+#include "heartbeat.h"
+#include <algorithm>
+#include <cstring>
+#include "safe_print.h"
+#include "log/evtlog_api.h"
+
+namespace eroil::wrk {
+    static uint64_t now_ns() noexcept {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            Heartbeat::Clock::now().time_since_epoch()).count());
+    }
+
+    Heartbeat::Heartbeat(rt::Router& router, NodeId id, uint32_t interval_ms, uint32_t miss_limit, DeadFn on_dead) :
+        m_router(router),
+        m_id(id),
+        m_interval(interval_ms == 0 ? 1 : interval_ms),
+        m_miss_limit(miss_limit == 0 ? 1 : miss_limit),
+        m_on_dead(std::move(on_dead)) {}
+
+    void Heartbeat::start(const std::vector<addr::NodeAddress>& peers) {
+        if (m_thread.joinable()) {
+            ERR_PRINT("attempted to start a joinable thread (double start or start after stop but before join() called)");
+            return;
+        }
+
+        m_peers.clear();
+        for (const addr::NodeAddress& info : peers) {
+            if (info.id < 0 || info.id >= MAX_NODES || info.id == m_id) continue;
+            Peer peer{};
+            peer.id = info.id;
+            m_peers.push_back(std::move(peer));
+        }
+
+        if (m_peers.empty()) {
+            LOG("no remote peers to heartbeat, heartbeat not started");
+            return;
+        }
+
+        LOG("heartbeat every ", m_interval.count(), "ms, peers are dropped after ", m_miss_limit, " silent intervals");
+        m_stop.store(false, std::memory_order_release);
+        m_thread = std::thread([this] { run(); });
+    }
+
+    void Heartbeat::stop() {
+        {
+            std::lock_guard lock(m_mtx);
+            m_stop.store(true, std::memory_order_release);
+        }
+        m_cv.notify_all();
+        if (m_thread.joinable()) {
+            // do not allow this thread to call join on itself
+            if (std::this_thread::get_id() != m_thread.get_id()) {
+                m_thread.join();
+            }
+        }
+    }
+
+    void Heartbeat::on_ping(NodeId peer, const io::PingBody& body) {
+        {
+            std::lock_guard lock(m_mtx);
+            m_pongs.emplace_back(peer, body);
+        }
+        m_cv.notify_one();
+    }
+
+    void Heartbeat::on_pong(NodeId peer, const io::PingBody& body) {
+        if (peer < 0 || peer >= MAX_NODES) return;
+
+        const uint64_t now = now_ns();
+        if (body.sent_ns == 0 || body.sent_ns > now) return;
+        const uint64_t rtt_us = (now - body.sent_ns) / 1000;
+        m_pongs_recvd.fetch_add(1, std::memory_order_relaxed);
+
+        std::lock_guard lock(m_rtt_mtx);
+        RttWindow& window = m_rtt[static_cast<size_t>(peer)];
+        window.us[window.next] = static_cast<uint32_t>(std::min<uint64_t>(rtt_us, UINT32_MAX));
+        window.next = (window.next + 1) % window.us.size();
+        window.count = std::min(window.count + 1, window.us.size());
+    }
+
+    void Heartbeat::run() {
+        std::vector<std::pair<NodeId, io::PingBody>> pongs{};
+        Clock::time_point next_tick = Clock::now();
+
+        try {
+            while (!stop_requested()) {
+                {
+                    std::unique_lock lock(m_mtx);
+                    m_cv.wait_until(lock, next_tick, [&] { return stop_requested() || !m_pongs.empty(); });
+                    pongs.swap(m_pongs);
+                }
+                if (stop_requested()) break;
+
+                // answer right away, the round trip should not include our tick
+                for (const auto& [peer, body] : pongs) {
+                    std::shared_ptr<sock::TCPClient> sock = m_router.get_socket(peer);
+                    if (sock != nullptr && send(*sock, io::LabelFlag::Pong, body)) {
+                        m_pongs_sent.fetch_add(1, std::memory_order_relaxed);
+                    }
+                }
+                pongs.clear();
+
+                const Clock::time_point now = Clock::now();
+                if (now < next_tick) continue;
+
+                EvtMark mark(elog_cat::Heartbeat);
+                tick(now);
+                next_tick = now + m_interval;
+            }
+        } catch (const std::exception& e) {
+            ERR_PRINT("heartbeat exception: ", e.what());
+        } catch (...) {
+            ERR_PRINT("unknown heartbeat exception");
+        }
+        LOG("heartbeat exits");
+    }
+
+    void Heartbeat::tick(Clock::time_point now) {
+        const auto silent_limit = m_interval * m_miss_limit;
+
+        for (Peer& peer : m_peers) {
+            const size_t index = static_cast<size_t>(peer.id);
+            std::shared_ptr<sock::TCPClient> sock = m_router.get_socket(peer.id);
+            if (sock == nullptr) continue;
+
+            // a new connection gets the full grace period
+            if (sock != peer.sock) {
+                peer.sock = sock;
+                peer.last_heard = now;
+                peer.dropped = false;
+                m_heard[index].store(false, std::memory_order_relaxed);
+            }
+            if (peer.dropped) continue;
+
+            if (m_heard[index].exchange(false, std::memory_order_relaxed)) {
+                peer.last_heard = now;
+            }
+
+            // the peer is only whole with every stripe up, a closed one drops the set
+            bool connected = true;
+            for (const auto& stripe : m_router.get_sockets(peer.id)) {
+                if (stripe == nullptr || !stripe->is_connected()) connected = false;
+            }
+
+            if (!connected || now - peer.last_heard > silent_limit) {
+                const auto silent_ms = std::chrono::duration_cast<std::chrono::milliseconds>(now - peer.last_heard).count();
+                if (connected) {
+                    LOG("heartbeat lost nodeid=", peer.id, ", nothing heard for ", silent_ms, "ms");
+                } else {
+                    LOG("heartbeat found a socket to nodeid=", peer.id, " closed");
+                }
+                evtlog::warn(elog_kind::DeadSocketFound, elog_cat::Heartbeat, peer.id, static_cast<int32_t>(silent_ms));
+
+                peer.dropped = true;
+                m_peers_dropped.fetch_add(1, std::memory_order_relaxed);
+                if (m_on_dead) m_on_dead(peer.id, sock);
+                continue;
+            }
+
+            io::PingBody body{};
+            body.sent_ns = now_ns();
+            body.seq = m_seq++;
+            if (send(*sock, io::LabelFlag::Ping, body)) {
+                m_pings_sent.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    bool Heartbeat::send(sock::TCPClient& sock, io::LabelFlag flag, const io::PingBody& body) {
+        struct {
+            io::LabelHeader hdr;
+            io::PingBody body;
+        } frame{};
+        static_assert(sizeof(frame) == sizeof(io::LabelHeader) + sizeof(io::PingBody));
+
+        frame.hdr.magic = MAGIC_NUM;
+        frame.hdr.version = VERSION;
+        frame.hdr.source_id = m_id;
+        frame.hdr.flags = static_cast<uint16_t>(flag);
+        frame.hdr.label = 0;
+        frame.hdr.label_size = sizeof(io::PingBody);
+        frame.body = body;
+
+        // a frame going out right now is as good as a ping to the peer
+        sock::SockResult result = sock.try_send_all(&frame, sizeof(frame));
+        if (result.code == sock::SockErr::WouldBlock) {
+            m_pings_skipped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        return result.ok();
+    }
+
+    RttStats Heartbeat::get_rtt(NodeId peer) const {
+        RttStats stats{};
+        if (peer < 0 || peer >= MAX_NODES) return stats;
+
+        std::array<uint32_t, 256> samples{};
+        size_t count = 0;
+        {
+            std::lock_guard lock(m_rtt_mtx);
+            const RttWindow& window = m_rtt[static_cast<size_t>(peer)];
+            count = window.count;
+            std::copy_n(window.us.begin(), count, samples.begin());
+        }
+        if (count == 0) return stats;
+
+        uint64_t sum = 0;
+        uint32_t min = UINT32_MAX;
+        for (size_t i = 0; i < count; ++i) {
+            sum += samples[i];
+            min = std::min(min, samples[i]);
+        }
+
+        const size_t p99 = (count * 99 + 99) / 100 - 1;
+        std::nth_element(samples.begin(), samples.begin() + static_cast<std::ptrdiff_t>(p99), samples.begin() + static_cast<std::ptrdiff_t>(count));
+
+        stats.samples = static_cast<uint32_t>(count);
+        stats.min_us = min;
+        stats.avg_us = sum / count;
+        stats.p99_us = samples[p99];
+        return stats;
+    }
+
+    HeartbeatStats Heartbeat::get_stats() const {
+        HeartbeatStats stats{};
+        stats.pings_sent = m_pings_sent.load(std::memory_order_relaxed);
+        stats.pings_skipped = m_pings_skipped.load(std::memory_order_relaxed);
+        stats.pongs_sent = m_pongs_sent.load(std::memory_order_relaxed);
+        stats.pongs_recvd = m_pongs_recvd.load(std::memory_order_relaxed);
+        stats.peers_dropped = m_peers_dropped.load(std::memory_order_relaxed);
+        return stats;
+    }
+
+    void Heartbeat::log_stats() const {
+        HeartbeatStats stats = get_stats();
+        LOG("heartbeat: pings_sent=", stats.pings_sent, " pings_skipped=", stats.pings_skipped, " pongs_sent=", stats.pongs_sent,
+            " pongs_recvd=", stats.pongs_recvd, " peers_dropped=", stats.peers_dropped);
+
+        for (const Peer& peer : m_peers) {
+            RttStats rtt = get_rtt(peer.id);
+            if (rtt.samples == 0) continue;
+            LOG("    nodeid=", peer.id, " rtt_us min=", rtt.min_us, " avg=", rtt.avg_us, " p99=", rtt.p99_us, " samples=", rtt.samples);
+        }
+    }
+}
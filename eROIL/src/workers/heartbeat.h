@@ -0,0 +1,112 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "address/address.h"
+#include "router/router.h"
+#include "socket/tcp_socket.h"
+#include "types/const_types.h"
+#include "types/label_io_types.h"
+#include "macros.h"
+
+namespace eroil::wrk {
+    struct RttStats {
+        uint32_t samples = 0;       // round trips in the window
+        uint64_t min_us = 0;
+        uint64_t avg_us = 0;
+        uint64_t p99_us = 0;
+    };
+
+    struct HeartbeatStats {
+        uint64_t pings_sent = 0;
+        uint64_t pings_skipped = 0;     // ping or pong not sent, a frame held the socket and the peer hears that instead
+        uint64_t pongs_sent = 0;
+        uint64_t pongs_recvd = 0;
+        uint64_t peers_dropped = 0;     // went silent past the miss limit
+    };
+
+    // both ends of every remote connection ping each other each interval and answer the others pings.
+    // anything received from a peer counts as hearing from it, so a saturated link never looks dead.
+    // a peer not heard from for miss_limit intervals is handed to on_dead, pongs only feed the rtt window.
+    // pings and pongs never wait behind a frame being sent, the reactor hands pings over and returns.
+    // they go on stripe 0 of a peer, a closed socket on any of its stripes drops the peer
+    class Heartbeat {
+        public:
+            using Clock = std::chrono::steady_clock;
+            using DeadFn = std::function<void(NodeId, const std::shared_ptr<sock::TCPClient>&)>;
+
+        private:
+            struct Peer {
+                NodeId id = INVALID_NODE;
+                std::shared_ptr<sock::TCPClient> sock{nullptr};    // stripe 0 being watched, a new one restarts the clock
+                Clock::time_point last_heard{};
+                bool dropped = false;                               // on_dead already called for this socket
+            };
+
+            struct RttWindow {
+                std::array<uint32_t, 256> us{};
+                size_t next = 0;
+                size_t count = 0;
+            };
+
+            rt::Router& m_router;
+            NodeId m_id;
+            std::chrono::milliseconds m_interval;
+            uint32_t m_miss_limit;
+            DeadFn m_on_dead;
+            std::vector<Peer> m_peers;      // only touched by the heartbeat thread
+            uint32_t m_seq = 0;
+
+            std::array<std::atomic<bool>, MAX_NODES> m_heard{};
+
+            std::mutex m_mtx;
+            std::condition_variable m_cv;
+            std::vector<std::pair<NodeId, io::PingBody>> m_pongs;   // owed, sent by the heartbeat thread
+
+            mutable std::mutex m_rtt_mtx;
+            std::array<RttWindow, MAX_NODES> m_rtt{};
+
+            std::atomic<uint64_t> m_pings_sent{0};
+            std::atomic<uint64_t> m_pings_skipped{0};
+            std::atomic<uint64_t> m_pongs_sent{0};
+            std::atomic<uint64_t> m_pongs_recvd{0};
+            std::atomic<uint64_t> m_peers_dropped{0};
+
+            std::atomic<bool> m_stop{false};
+            std::thread m_thread;
+
+        public:
+            Heartbeat(rt::Router& router, NodeId id, uint32_t interval_ms, uint32_t miss_limit, DeadFn on_dead);
+            ~Heartbeat() { stop(); }
+
+            EROIL_NO_COPY(Heartbeat)
+            EROIL_NO_MOVE(Heartbeat)
+
+            void start(const std::vector<addr::NodeAddress>& peers);
+            void stop();
+
+            // socket reactor side, called from the io threads
+            void heard(NodeId peer) noexcept {
+                if (peer >= 0 && peer < MAX_NODES) m_heard[static_cast<size_t>(peer)].store(true, std::memory_order_relaxed);
+            }
+            void on_ping(NodeId peer, const io::PingBody& body);
+            void on_pong(NodeId peer, const io::PingBody& body);
+
+            RttStats get_rtt(NodeId peer) const;
+            HeartbeatStats get_stats() const;
+            void log_stats() const;
+
+        private:
+            bool stop_requested() const { return m_stop.load(std::memory_order_acquire); }
+            void run();
+            void tick(Clock::time_point now);
+            bool send(sock::TCPClient& sock, io::LabelFlag flag, const io::PingBody& body);
+    };
+}
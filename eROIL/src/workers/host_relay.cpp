@@ -0,0 +1,147 @@
+#include "host_relay.h"
+#include <cstring>
+#include <vector>
+#include "safe_print.h"
+#include "address/address.h"
+#include "router/router.h"
+#include "log/evtlog_api.h"
+
+namespace eroil::wrk {
+    HostRelay::HostRelay(rt::Router& router, NodeId id, std::function<void(std::shared_ptr<io::SendJob>)> dispatch) :
+        m_router(router),
+        m_id(id),
+        m_dispatch(std::move(dispatch)) {}
+
+    void HostRelay::forward(const io::LabelHeader& hdr, const std::byte* body, size_t size) {
+        rt::NodeSet dests{};
+        io::LabelHeader inner{};
+        if (!unwrap(hdr, body, size, dests, inner)) return;
+
+        // once per host, the source already served every node on ours
+        rt::NodeSet hops{};
+        dests.for_each([&](const NodeId dst) {
+            const NodeId gateway = addr::gateway_of(dst);
+            if (gateway != m_id) hops.add(gateway);
+        });
+        if (hops.empty()) {
+            ERR_PRINT("relay frame for label=", hdr.label, " from nodeid=", hdr.source_id, " has no other host to go to");
+            m_frames_dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        std::shared_ptr<io::SendJob> job = make_job(hdr, nullptr, sizeof(hdr) + size);
+        std::memcpy(job->send_buffer.data.get(), &hdr, sizeof(hdr));
+        std::memcpy(job->send_buffer.data.get() + sizeof(hdr), body, size);
+        job->stripe = m_router.tcp_stripe(inner.label, inner.label_size);
+        hops.for_each([&](const NodeId gateway) {
+            job->remote_recvrs.push_back(m_router.get_socket(gateway, job->stripe));
+        });
+        job->pending_sends.store(job->remote_recvrs.size(), std::memory_order_relaxed);
+
+        m_frames_forwarded.fetch_add(1, std::memory_order_relaxed);
+        m_dispatch(std::move(job));
+    }
+
+    void HostRelay::fan_out(const io::LabelHeader& hdr, const std::byte* body, size_t size) {
+        rt::NodeSet dests{};
+        io::LabelHeader inner{};
+        if (!unwrap(hdr, body, size, dests, inner)) return;
+
+        const std::byte* frame = body + sizeof(io::RelayHeader);
+        const size_t frame_size = size - sizeof(io::RelayHeader);
+
+        bool self = false;
+        std::vector<std::shared_ptr<shm::ShmSend>> locals{};
+        dests.for_each([&](const NodeId dst) {
+            if (addr::gateway_of(dst) != m_id) return;
+            if (dst == m_id) {
+                self = true;
+            } else {
+                locals.push_back(m_router.get_send_shm(dst));
+            }
+        });
+        if (!self && locals.empty()) {
+            ERR_PRINT("relay frame for label=", hdr.label, " from nodeid=", hdr.source_id, " has no destination on our host");
+            m_frames_dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        // same nodes the source would have written, so the frame goes out as it left the source
+        if (!locals.empty()) {
+            std::shared_ptr<io::SendJob> job = make_job(inner, frame, frame_size);
+            job->local_recvrs = std::move(locals);
+            job->pending_sends.store(job->local_recvrs.size(), std::memory_order_relaxed);
+            m_frames_fanned_out.fetch_add(1, std::memory_order_relaxed);
+            m_dispatch(std::move(job));
+        }
+
+        if (self) {
+            const std::byte* payload = frame + sizeof(io::LabelHeader);
+            if (io::has_flag(inner.flags, io::LabelFlag::Checksum) && io::label_checksum(inner, payload) != inner.checksum) {
+                ERR_PRINT("relay dropped frame with bad checksum, label=", inner.label, ", sourceid=", inner.source_id);
+                evtlog::warn(elog_kind::ChecksumMismatch, elog_cat::SocketReactor, inner.label);
+                return;
+            }
+
+            m_router.distribute_recvd_label(
+                static_cast<NodeId>(inner.source_id),
+                static_cast<Label>(inner.label),
+                payload,
+                inner.label_size,
+                static_cast<size_t>(inner.recv_offset)
+            );
+            m_local_deliveries.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    bool HostRelay::unwrap(const io::LabelHeader& hdr, const std::byte* body, size_t size, rt::NodeSet& dests, io::LabelHeader& inner) {
+        constexpr size_t WRAP_SIZE = sizeof(io::RelayHeader) + sizeof(io::LabelHeader);
+        if (size <= WRAP_SIZE || size > io::MAX_RELAY_SIZE) {
+            ERR_PRINT("relay frame of size=", size, " from nodeid=", hdr.source_id, " cannot hold a frame");
+            m_frames_dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        io::RelayHeader relay{};
+        std::memcpy(&relay, body, sizeof(relay));
+        std::memcpy(&inner, body + sizeof(relay), sizeof(inner));
+
+        // the wrapped frame must be the one the outer header announces, whole and nothing else
+        if (inner.magic != MAGIC_NUM || inner.version != VERSION ||
+            !io::has_flag(inner.flags, io::LabelFlag::Data) ||
+            inner.source_id != hdr.source_id || inner.label != hdr.label ||
+            inner.label_size == 0 || WRAP_SIZE + inner.label_size != size) {
+            ERR_PRINT("relay frame for label=", hdr.label, " from nodeid=", hdr.source_id, " wraps a malformed frame");
+            evtlog::warn(elog_kind::MalformedRecv, elog_cat::SocketReactor, hdr.label);
+            m_frames_dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        dests = rt::NodeSet::from_bits(relay.dests);
+        return true;
+    }
+
+    std::shared_ptr<io::SendJob> HostRelay::make_job(const io::LabelHeader& hdr, const std::byte* frame, size_t frame_size) {
+        auto job = std::make_shared<io::SendJob>(io::SendBuf(frame_size));
+        if (frame != nullptr) std::memcpy(job->send_buffer.data.get(), frame, frame_size);
+        job->source_id = hdr.source_id;
+        job->label = hdr.label;
+        job->seq = m_seq.fetch_add(1, std::memory_order_relaxed);
+        return job;
+    }
+
+    RelayStats HostRelay::get_stats() const {
+        RelayStats stats{};
+        stats.frames_forwarded = m_frames_forwarded.load(std::memory_order_relaxed);
+        stats.frames_fanned_out = m_frames_fanned_out.load(std::memory_order_relaxed);
+        stats.local_deliveries = m_local_deliveries.load(std::memory_order_relaxed);
+        stats.frames_dropped = m_frames_dropped.load(std::memory_order_relaxed);
+        return stats;
+    }
+
+    void HostRelay::log_stats() const {
+        RelayStats stats = get_stats();
+        LOG("host relay: frames_forwarded=", stats.frames_forwarded, " frames_fanned_out=", stats.frames_fanned_out,
+            " local_deliveries=", stats.local_deliveries, " frames_dropped=", stats.frames_dropped);
+    }
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include <atomic>
+#include <functional>
+#include <memory>
+#include "types/const_types.h"
+#include "types/label_io_types.h"
+#include "types/send_io_types.h"
+#include "router/node_set.h"
+#include "macros.h"
+
+namespace eroil::rt { class Router; }
+
+namespace eroil::wrk {
+    struct RelayStats {
+        uint64_t frames_forwarded = 0;  // from our host on to other hosts gateways
+        uint64_t frames_fanned_out = 0; // from other hosts on to nodes of ours
+        uint64_t local_deliveries = 0;  // fanned out frames we subscribe to ourselves
+        uint64_t frames_dropped = 0;    // malformed or with no destination we serve
+    };
+
+    // host gateway side of LabelFlag::Relay frames. a node on our host publishing to other hosts hands
+    // us one wrapped frame over shm, it goes on once to the gateway of each host holding a destination.
+    // a wrapped frame from another gateway is unwrapped and handed to the destinations on our host, over
+    // their shm blocks or straight to our own subscribers. the sends go through the regular send workers
+    class HostRelay {
+        private:
+            rt::Router& m_router;
+            NodeId m_id;
+            std::function<void(std::shared_ptr<io::SendJob>)> m_dispatch;
+
+            std::atomic<uint32_t> m_seq{0};
+            std::atomic<uint64_t> m_frames_forwarded{0};
+            std::atomic<uint64_t> m_frames_fanned_out{0};
+            std::atomic<uint64_t> m_local_deliveries{0};
+            std::atomic<uint64_t> m_frames_dropped{0};
+
+        public:
+            HostRelay(rt::Router& router, NodeId id, std::function<void(std::shared_ptr<io::SendJob>)> dispatch);
+
+            EROIL_NO_COPY(HostRelay)
+            EROIL_NO_MOVE(HostRelay)
+
+            // hdr leads the relay frame, body is the RelayHeader and wrapped frame behind it
+            void forward(const io::LabelHeader& hdr, const std::byte* body, size_t size);    // from the shm recv worker
+            void fan_out(const io::LabelHeader& hdr, const std::byte* body, size_t size);    // from the socket reactor
+
+            RelayStats get_stats() const;
+            void log_stats() const;
+
+        private:
+            bool unwrap(const io::LabelHeader& hdr, const std::byte* body, size_t size, rt::NodeSet& dests, io::LabelHeader& inner);
+            std::shared_ptr<io::SendJob> make_job(const io::LabelHeader& hdr, const std::byte* frame, size_t frame_size);
+    };
+}
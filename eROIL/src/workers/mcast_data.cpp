@@ -0,0 +1,710 @@
+#include "mcast_data.h"
+#include <algorithm>
+#include <cstring>
+#include "safe_print.h"
+#include "address/address.h"
+#include "router/router.h"
+#include "log/evtlog_api.h"
+
+namespace eroil::wrk {
+    static_assert((MAX_LABEL_SIZE + sizeof(io::LabelHeader)) / (MCAST_DATAGRAM_SIZE - sizeof(io::McastHeader)) < UINT16_MAX,
+                  "a max size label must fit in frag_count datagrams");
+
+    namespace {
+        // dotted quad to host order
+        bool parse_ipv4(const std::string& ip, uint32_t& out) {
+            uint32_t value = 0;
+            size_t start = 0;
+            for (int32_t part = 0; part < 4; ++part) {
+                const size_t end = part == 3 ? ip.size() : ip.find('.', start);
+                if (end == std::string::npos || end == start || end - start > 3) return false;
+
+                uint32_t octet = 0;
+                for (size_t i = start; i < end; ++i) {
+                    if (ip[i] < '0' || ip[i] > '9') return false;
+                    octet = octet * 10 + static_cast<uint32_t>(ip[i] - '0');
+                }
+                if (octet > 255) return false;
+
+                value = (value << 8) | octet;
+                start = end + 1;
+            }
+            out = value;
+            return true;
+        }
+
+        std::string format_ipv4(uint32_t ip) {
+            return std::to_string((ip >> 24) & 0xFF) + "." + std::to_string((ip >> 16) & 0xFF) + "." +
+                   std::to_string((ip >> 8) & 0xFF) + "." + std::to_string(ip & 0xFF);
+        }
+
+        uint64_t stream_key(NodeId source_id, Label label) noexcept {
+            return (static_cast<uint64_t>(static_cast<uint32_t>(source_id)) << 32) | static_cast<uint32_t>(label);
+        }
+
+        // true when seq comes before other, seqs wrap
+        bool seq_before(uint32_t seq, uint32_t other) noexcept {
+            return static_cast<int32_t>(seq - other) < 0;
+        }
+    }
+
+    McastData::McastData(rt::Router& router, NodeId id, const cfg::McastDataConfig& cfg, const cfg::UdpMcastConfig& sock_cfg) :
+        m_router{router},
+        m_id{id},
+        m_cfg{cfg},
+        m_sock_cfg{sock_cfg},
+        m_session{0},
+        m_groups{},
+        m_sock{} {
+        m_sock_cfg.group_ip = cfg.group_ip;
+        m_sock_cfg.port = cfg.port;
+
+        // receivers drop their seq state for us when this changes, so a restart is never mistaken for old frames
+        const auto now = std::chrono::system_clock::now().time_since_epoch();
+        const uint64_t ns = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(now).count());
+        m_session = static_cast<uint32_t>(ns ^ (ns >> 32)) | 1u;
+
+        uint32_t base = 0;
+        if (!parse_ipv4(cfg.group_ip, base)) {
+            ERR_PRINT("multicast data group ip=", cfg.group_ip, " is not an ipv4 address");
+            return;
+        }
+        m_groups.reserve(cfg.groups);
+        for (uint32_t i = 0; i < cfg.groups; ++i) {
+            m_groups.push_back(format_ipv4(base + i));
+        }
+    }
+
+    bool McastData::start() {
+        if (m_groups.empty()) {
+            ERR_PRINT("multicast data plane has no groups, not started");
+            return false;
+        }
+
+        if (m_recv_thread.joinable()) {
+            ERR_PRINT("attempted to start a joinable thread (double start or start after stop but before join() called)");
+            return false;
+        }
+
+        sock::SockResult result = m_sock.open(m_sock_cfg);
+        if (!result.ok()) {
+            ERR_PRINT("multicast data socket open failed on port=", m_sock_cfg.port);
+            print_socket_result(result);
+            evtlog::error(elog_kind::StartFailed, elog_cat::McastData);
+            return false;
+        }
+
+        // a large frame arrives as a burst of datagrams, not fatal when refused, gaps are nacked
+        result = m_sock.set_recv_buffer(RECV_SOCK_BUF_SIZE);
+        if (!result.ok()) {
+            ERR_PRINT("multicast data socket recv buffer not raised");
+            print_socket_result(result);
+        }
+
+        // recv wakes up this often to heartbeat and follow our recv labels
+        result = m_sock.set_recv_timeout(RECV_TIMEOUT_MS);
+        if (!result.ok()) {
+            ERR_PRINT("multicast data socket recv timeout failed");
+            print_socket_result(result);
+            m_sock.close();
+            return false;
+        }
+
+        m_tx_buf.resize(MCAST_DATAGRAM_SIZE);
+        m_joined.assign(m_groups.size(), 0);
+        m_joined_count = 0;
+
+        m_stop.store(false, std::memory_order_release);
+        m_recv_thread = std::thread([this] { run_recv(); });
+        m_resend_thread = std::thread([this] { run_resend(); });
+        m_running.store(true, std::memory_order_release);
+
+        LOG("multicast data plane on ", m_groups.front(), " +", m_groups.size() - 1, " groups port=", m_sock_cfg.port,
+            " min_subscribers=", m_cfg.min_subscribers, " retain=", m_cfg.retain);
+        return true;
+    }
+
+    void McastData::stop() {
+        m_running.store(false, std::memory_order_release);
+        {
+            std::lock_guard lock(m_resend_mtx);
+            m_stop.store(true, std::memory_order_release);
+        }
+        m_resend_cv.notify_all();
+
+        // do not allow a thread to call join on itself
+        if (m_recv_thread.joinable() && std::this_thread::get_id() != m_recv_thread.get_id()) {
+            m_recv_thread.join();
+        }
+        if (m_resend_thread.joinable() && std::this_thread::get_id() != m_resend_thread.get_id()) {
+            m_resend_thread.join();
+        }
+        m_sock.close();
+    }
+
+    size_t McastData::group_index(Label label) const noexcept {
+        return static_cast<uint32_t>(label) % m_groups.size();
+    }
+
+    const std::string& McastData::group_of(Label label) const noexcept {
+        return m_groups[group_index(label)];
+    }
+
+    bool McastData::publish(const std::shared_ptr<io::SendJob>& job) {
+        if (job == nullptr || !m_sock.is_open()) return false;
+
+        const size_t total = job->send_buffer.total_size;
+        const uint16_t frag_count = static_cast<uint16_t>((total + FRAG_PAYLOAD - 1) / FRAG_PAYLOAD);
+
+        // kept before it goes out, a nack for it can come back before we return
+        uint32_t seq = 0;
+        {
+            std::lock_guard lock(m_pub_mtx);
+            Published& pub = m_published[job->label];
+            if (pub.retained.empty()) {
+                const size_t fit = std::max<size_t>(RETAIN_BYTES / total, 1);
+                pub.retained.resize(std::min<size_t>(m_cfg.retain, fit));
+            }
+            seq = pub.next_seq++;
+            pub.retained[seq % pub.retained.size()] = Retained{ seq, job };
+        }
+
+        io::McastHeader hdr{};
+        hdr.kind = io::McastKind::Data;
+        hdr.source_id = m_id;
+        hdr.session = m_session;
+        hdr.label = job->label;
+        hdr.seq = seq;
+        hdr.total_size = static_cast<uint32_t>(total);
+        hdr.frag_count = frag_count;
+
+        // a fragment that does not go out is a gap receivers nack once our heartbeat names the frame
+        const std::string& group = group_of(job->label);
+        const std::byte* frame = job->send_buffer.data.get();
+        bool ok = true;
+        for (uint16_t frag = 0; frag < frag_count; ++frag) {
+            const size_t offset = static_cast<size_t>(frag) * FRAG_PAYLOAD;
+            const size_t chunk = std::min(FRAG_PAYLOAD, total - offset);
+            hdr.frag = frag;
+            std::memcpy(m_tx_buf.data(), &hdr, sizeof(hdr));
+            std::memcpy(m_tx_buf.data() + sizeof(hdr), frame + offset, chunk);
+
+            sock::SockResult result = m_sock.send_to(group, m_tx_buf.data(), sizeof(hdr) + chunk);
+            if (!result.ok()) {
+                ERR_PRINT("multicast data send for label=", job->label, ", error=", result.code_to_string());
+                ok = false;
+                break;
+            }
+            m_datagrams_sent.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        {
+            std::lock_guard lock(m_pub_mtx);
+            Published& pub = m_published[job->label];
+            pub.last_publish = std::chrono::steady_clock::now();
+            pub.heartbeats_left = HEARTBEAT_REPEATS;
+        }
+
+        m_frames_sent.fetch_add(1, std::memory_order_relaxed);
+        return ok;
+    }
+
+    void McastData::on_nack(NodeId from, Label label, const std::byte* body, size_t size) {
+        if (body == nullptr || size != sizeof(io::McastNack)) return;
+
+        io::McastNack nack{};
+        std::memcpy(&nack, body, sizeof(nack));
+        m_nacks_recvd.fetch_add(1, std::memory_order_relaxed);
+
+        // asked about frames of our previous run, they are gone
+        if (nack.session != m_session || nack.count == 0) return;
+        const uint32_t count = std::min(nack.count, MAX_NACK_SEQS);
+
+        std::vector<Resend> found{};
+        uint32_t misses = 0;
+        {
+            std::lock_guard lock(m_pub_mtx);
+            auto it = m_published.find(label);
+            if (it == m_published.end() || it->second.retained.empty()) {
+                misses = count;
+            } else {
+                const std::vector<Retained>& retained = it->second.retained;
+                for (uint32_t i = 0; i < count; ++i) {
+                    const uint32_t seq = nack.first_seq + i;
+                    const Retained& entry = retained[seq % retained.size()];
+                    if (entry.job != nullptr && entry.seq == seq) {
+                        found.push_back(Resend{ from, seq, entry.job });
+                    } else {
+                        misses += 1;
+                    }
+                }
+            }
+        }
+
+        if (misses > 0) {
+            m_resend_misses.fetch_add(misses, std::memory_order_relaxed);
+        }
+        if (found.empty()) return;
+
+        {
+            std::lock_guard lock(m_resend_mtx);
+            m_resends.insert(m_resends.end(), found.begin(), found.end());
+        }
+        m_resend_cv.notify_one();
+    }
+
+    void McastData::run_resend() {
+        std::vector<Resend> batch{};
+        std::vector<std::byte> wrapped{};
+        while (!stop_requested()) {
+            {
+                std::unique_lock lock(m_resend_mtx);
+                m_resend_cv.wait(lock, [this] { return stop_requested() || !m_resends.empty(); });
+                if (stop_requested()) break;
+                batch.swap(m_resends);
+            }
+
+            // the frame a tcp subscriber gets wrapped with its seq, the receiver checks it against what
+            // it delivered since. one send so it never interleaves with a data frame on the socket
+            EvtMark mark(elog_cat::McastData);
+            for (Resend& resend : batch) {
+                std::shared_ptr<sock::TCPClient> sock = m_router.get_socket(resend.to);
+                if (sock == nullptr || !sock->is_connected()) {
+                    m_resend_misses.fetch_add(1, std::memory_order_relaxed);
+                    continue;
+                }
+
+                constexpr size_t WRAP_SIZE = sizeof(io::LabelHeader) + sizeof(io::McastResend);
+                const io::SendBuf& buf = resend.job->send_buffer;
+                wrapped.resize(WRAP_SIZE + buf.total_size);
+
+                io::LabelHeader hdr{};
+                hdr.magic = MAGIC_NUM;
+                hdr.version = VERSION;
+                hdr.source_id = m_id;
+                hdr.flags = static_cast<uint16_t>(io::LabelFlag::Resend);
+                hdr.label = resend.job->label;
+                hdr.label_size = static_cast<uint32_t>(sizeof(io::McastResend) + buf.total_size);
+
+                io::McastResend body{};
+                body.session = m_session;
+                body.seq = resend.seq;
+
+                std::memcpy(wrapped.data(), &hdr, sizeof(hdr));
+                std::memcpy(wrapped.data() + sizeof(hdr), &body, sizeof(body));
+                std::memcpy(wrapped.data() + WRAP_SIZE, buf.data.get(), buf.total_size);
+                sock::SockResult result = sock->send_all(wrapped.data(), wrapped.size());
+                if (!result.ok()) {
+                    ERR_PRINT("multicast resend for label=", resend.job->label, " to nodeid=", resend.to, ", error=", result.code_to_string());
+                    m_resend_misses.fetch_add(1, std::memory_order_relaxed);
+                    continue;
+                }
+                m_resent.fetch_add(1, std::memory_order_relaxed);
+                evtlog::info(elog_kind::McastResend, elog_cat::McastData, resend.to, resend.job->label);
+            }
+            batch.clear();
+        }
+    }
+
+    void McastData::run_recv() {
+        std::vector<std::byte> buf(RECV_BUF_SIZE);
+        auto next_heartbeat = std::chrono::steady_clock::now();
+        auto next_group_check = next_heartbeat;
+
+        while (!stop_requested()) {
+            const auto now = std::chrono::steady_clock::now();
+            if (now >= next_group_check) {
+                sync_groups();
+                next_group_check = now + GROUP_CHECK_INTERVAL;
+            }
+            if (now >= next_heartbeat) {
+                send_heartbeats();
+                next_heartbeat = now + HEARTBEAT_INTERVAL;
+            }
+
+            // nothing to listen for, the socket would only time out
+            if (m_joined_count == 0) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(RECV_TIMEOUT_MS));
+                continue;
+            }
+
+            sock::SockResult result = m_sock.recv_broadcast(buf.data(), buf.size());
+            if (!result.ok()) {
+                if (result.code == sock::SockErr::WouldBlock || result.code == sock::SockErr::TimedOut) continue;
+                if (stop_requested()) break;
+
+                ERR_PRINT("multicast data recv failed, error=", result.code_to_string());
+                evtlog::warn(elog_kind::RecvFailed, elog_cat::McastData);
+                std::this_thread::sleep_for(std::chrono::milliseconds(100));
+                continue;
+            }
+
+            EvtMark mark(elog_cat::McastData);
+            handle_datagram(buf.data(), static_cast<size_t>(result.bytes));
+        }
+        LOG("multicast data recv thread exiting");
+    }
+
+    void McastData::sync_groups() {
+        const uint64_t gen = m_router.recv_gen();
+        if (gen == m_recv_gen) return;
+        m_recv_gen = gen;
+
+        std::vector<uint8_t> wanted(m_groups.size(), 0);
+        for (const io::LabelInfo& info : m_router.get_recv_labels_snapshot().labels) {
+            wanted[group_index(info.label)] = 1;
+        }
+
+        for (size_t i = 0; i < m_groups.size(); ++i) {
+            if (wanted[i] != 0 && m_joined[i] == 0) {
+                sock::SockResult result = m_sock.join_group(m_groups[i]);
+                if (!result.ok()) {
+                    ERR_PRINT("multicast data join of group=", m_groups[i], " failed, error=", result.code_to_string());
+                    m_recv_gen = 0; // try again on the next check
+                    continue;
+                }
+                m_joined[i] = 1;
+                m_joined_count += 1;
+            } else if (wanted[i] == 0 && m_joined[i] != 0) {
+                (void)m_sock.leave_group(m_groups[i]);
+                m_joined[i] = 0;
+                m_joined_count -= 1;
+            }
+        }
+
+        // streams of labels we stopped taking
+        std::lock_guard lock(m_streams_mtx);
+        for (auto it = m_streams.begin(); it != m_streams.end();) {
+            const Label label = static_cast<Label>(static_cast<uint32_t>(it->first));
+            if (!m_router.has_recv_route(label)) {
+                it = m_streams.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    void McastData::send_heartbeats() {
+        // labels gone quiet since their last frame, a receiver still missing it learns so from this
+        std::vector<std::pair<size_t, io::McastHeartbeat>> beats{};
+        {
+            const auto now = std::chrono::steady_clock::now();
+            std::lock_guard lock(m_pub_mtx);
+            for (auto& [label, pub] : m_published) {
+                if (pub.heartbeats_left == 0 || now - pub.last_publish < HEARTBEAT_INTERVAL) continue;
+                pub.heartbeats_left -= 1;
+                io::McastHeartbeat beat{};
+                beat.label = label;
+                beat.seq = pub.next_seq - 1;
+                beats.emplace_back(group_index(label), beat);
+            }
+        }
+        if (beats.empty()) return;
+
+        // receivers only join the groups of their labels, each entry goes to its labels group
+        std::sort(beats.begin(), beats.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+
+        constexpr size_t PER_DATAGRAM = FRAG_PAYLOAD / sizeof(io::McastHeartbeat);
+        std::byte datagram[MCAST_DATAGRAM_SIZE];
+        io::McastHeader hdr{};
+        hdr.kind = io::McastKind::Heartbeat;
+        hdr.source_id = m_id;
+        hdr.session = m_session;
+        hdr.frag_count = 1;
+
+        size_t i = 0;
+        while (i < beats.size()) {
+            const size_t group = beats[i].first;
+            size_t count = 0;
+            while (i < beats.size() && beats[i].first == group && count < PER_DATAGRAM) {
+                std::memcpy(datagram + sizeof(hdr) + count * sizeof(io::McastHeartbeat), &beats[i].second, sizeof(io::McastHeartbeat));
+                ++count;
+                ++i;
+            }
+
+            hdr.total_size = static_cast<uint32_t>(count * sizeof(io::McastHeartbeat));
+            std::memcpy(datagram, &hdr, sizeof(hdr));
+            sock::SockResult result = m_sock.send_to(m_groups[group], datagram, sizeof(hdr) + hdr.total_size);
+            if (!result.ok()) {
+                ERR_PRINT("multicast heartbeat send failed, error=", result.code_to_string());
+            }
+        }
+    }
+
+    void McastData::handle_datagram(const std::byte* data, size_t size) {
+        if (size < sizeof(io::McastHeader)) {
+            m_datagrams_dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        io::McastHeader hdr{};
+        std::memcpy(&hdr, data, sizeof(hdr));
+        if (hdr.magic != MAGIC_NUM || hdr.version != VERSION) {
+            m_datagrams_dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        // our own frames looped back on a group we also listen on
+        if (hdr.source_id == m_id) return;
+
+        const std::byte* body = data + sizeof(hdr);
+        const size_t body_size = size - sizeof(hdr);
+        std::lock_guard lock(m_streams_mtx);
+        switch (hdr.kind) {
+            case io::McastKind::Data: {
+                handle_data(hdr, body, body_size);
+                break;
+            }
+            case io::McastKind::Heartbeat: {
+                handle_heartbeat(hdr, body, body_size);
+                break;
+            }
+            default: {
+                m_datagrams_dropped.fetch_add(1, std::memory_order_relaxed);
+                break;
+            }
+        }
+    }
+
+    McastData::Stream* McastData::find_stream(NodeId source_id, Label label, uint32_t session) {
+        const uint64_t key = stream_key(source_id, label);
+        auto it = m_streams.find(key);
+        if (it == m_streams.end()) {
+            // labels sharing a group with ours are not for us, same host sources reach us over shm
+            if (!m_router.has_recv_route(label)) return nullptr;
+            if (addr::get_address(source_id).kind != addr::RouteKind::Socket) return nullptr;
+
+            it = m_streams.emplace(key, Stream{}).first;
+            it->second.session = session;
+        }
+
+        Stream& stream = it->second;
+        if (stream.session != session) {
+            // source restarted, its numbering starts over
+            stream.session = session;
+            stream.synced = false;
+            stream.assembling = false;
+            stream.delivered = false;
+        }
+        return &stream;
+    }
+
+    void McastData::handle_data(const io::McastHeader& hdr, const std::byte* body, size_t body_size) {
+        const size_t total = hdr.total_size;
+        if (total <= sizeof(io::LabelHeader) || total > MAX_LABEL_SIZE + sizeof(io::LabelHeader)) {
+            m_datagrams_dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        const size_t offset = static_cast<size_t>(hdr.frag) * FRAG_PAYLOAD;
+        const size_t frag_count = (total + FRAG_PAYLOAD - 1) / FRAG_PAYLOAD;
+        if (hdr.frag_count != frag_count || hdr.frag >= frag_count || body_size != std::min(FRAG_PAYLOAD, total - offset)) {
+            m_datagrams_dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        const NodeId source_id = static_cast<NodeId>(hdr.source_id);
+        const Label label = static_cast<Label>(hdr.label);
+        Stream* stream = find_stream(source_id, label, hdr.session);
+        if (stream == nullptr) return;
+
+        if (!stream->synced) {
+            stream->next_seq = hdr.seq;
+            stream->synced = true;
+        }
+
+        // delivered, or given up on and asked for over tcp
+        if (seq_before(hdr.seq, stream->next_seq)) {
+            m_datagrams_dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        // frames before this one never completed, including any half assembled one
+        if (hdr.seq != stream->next_seq) {
+            give_up(source_id, label, *stream, hdr.seq);
+        }
+
+        if (!stream->assembling) {
+            if (stream->frame.size() < total) stream->frame.resize(total);
+            stream->got.assign(frag_count, 0);
+            stream->frame_size = hdr.total_size;
+            stream->frag_count = hdr.frag_count;
+            stream->frags_got = 0;
+            stream->assembling = true;
+        } else if (stream->frame_size != hdr.total_size) {
+            m_datagrams_dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        if (stream->got[hdr.frag] != 0) return; // duplicate
+        std::memcpy(stream->frame.data() + offset, body, body_size);
+        stream->got[hdr.frag] = 1;
+        stream->frags_got += 1;
+
+        if (stream->frags_got == stream->frag_count) {
+            if (deliver(source_id, label, stream->frame.data(), stream->frame_size)) {
+                stream->delivered = true;
+                stream->delivered_seq = stream->next_seq;
+            }
+            stream->assembling = false;
+            stream->next_seq += 1;
+        }
+    }
+
+    void McastData::handle_heartbeat(const io::McastHeader& hdr, const std::byte* body, size_t body_size) {
+        if (body_size != hdr.total_size || body_size % sizeof(io::McastHeartbeat) != 0) {
+            m_datagrams_dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        const NodeId source_id = static_cast<NodeId>(hdr.source_id);
+        for (size_t offset = 0; offset < body_size; offset += sizeof(io::McastHeartbeat)) {
+            io::McastHeartbeat beat{};
+            std::memcpy(&beat, body + offset, sizeof(beat));
+
+            const Label label = static_cast<Label>(beat.label);
+            Stream* stream = find_stream(source_id, label, hdr.session);
+            if (stream == nullptr) continue;
+
+            // frames up to here went out before we listened
+            if (!stream->synced) {
+                stream->next_seq = beat.seq + 1;
+                stream->synced = true;
+                continue;
+            }
+
+            // the source is done with frames we still wait on, nothing more of them is coming
+            if (!seq_before(beat.seq, stream->next_seq)) {
+                give_up(source_id, label, *stream, beat.seq + 1);
+            }
+        }
+    }
+
+    void McastData::on_resend(NodeId from, Label label, const std::byte* body, size_t size) {
+        if (body == nullptr || size <= sizeof(io::McastResend) + sizeof(io::LabelHeader)) {
+            m_datagrams_dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        io::McastResend resend{};
+        std::memcpy(&resend, body, sizeof(resend));
+
+        std::lock_guard lock(m_streams_mtx);
+        auto it = m_streams.find(stream_key(from, label));
+        if (it == m_streams.end() || it->second.session != resend.session) {
+            // label dropped since, or the source restarted and the stream with it
+            m_resends_late.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        // only frames we gave up on were asked for, and only one newer than anything delivered may
+        // go out. an older value would overwrite the newer one, labels stay in order like over tcp
+        Stream& stream = it->second;
+        if (!seq_before(resend.seq, stream.next_seq) ||
+            (stream.delivered && !seq_before(stream.delivered_seq, resend.seq))) {
+            m_resends_late.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        if (deliver(from, label, body + sizeof(resend), size - sizeof(resend))) {
+            stream.delivered = true;
+            stream.delivered_seq = resend.seq;
+        }
+    }
+
+    bool McastData::deliver(NodeId source_id, Label label, const std::byte* frame, size_t frame_size) {
+        io::LabelHeader lhdr{};
+        std::memcpy(&lhdr, frame, sizeof(lhdr));
+        const std::byte* payload = frame + sizeof(lhdr);
+
+        if (lhdr.magic != MAGIC_NUM || lhdr.version != VERSION ||
+            lhdr.source_id != source_id || lhdr.label != label ||
+            !io::has_flag(lhdr.flags, io::LabelFlag::Data) ||
+            static_cast<size_t>(lhdr.label_size) + sizeof(lhdr) != frame_size) {
+            ERR_PRINT("multicast data frame with a bad label header, label=", label, ", sourceid=", source_id);
+            m_datagrams_dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        if (io::has_flag(lhdr.flags, io::LabelFlag::Checksum) && io::label_checksum(lhdr, payload) != lhdr.checksum) {
+            ERR_PRINT("multicast data dropped frame with bad checksum, label=", label, ", sourceid=", source_id);
+            evtlog::warn(elog_kind::ChecksumMismatch, elog_cat::McastData, label);
+            m_datagrams_dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        m_frames_recvd.fetch_add(1, std::memory_order_relaxed);
+        m_router.distribute_recvd_label(source_id, label, payload, lhdr.label_size, static_cast<size_t>(lhdr.recv_offset));
+        return true;
+    }
+
+    void McastData::give_up(NodeId source_id, Label label, Stream& stream, uint32_t end_seq) {
+        // ask for the newest of the missing frames, the source only retains the last few anyway
+        const uint32_t missing = end_seq - stream.next_seq;
+        const uint32_t nacked = std::min(missing, MAX_NACK_SEQS);
+        uint32_t lost = missing - nacked;
+
+        if (send_nack(source_id, label, stream.session, end_seq - nacked, nacked)) {
+            m_frames_nacked.fetch_add(nacked, std::memory_order_relaxed);
+        } else {
+            lost += nacked;
+        }
+
+        if (lost > 0) {
+            m_frames_lost.fetch_add(lost, std::memory_order_relaxed);
+        }
+        evtlog::warn(elog_kind::McastGap, elog_cat::McastData, source_id, label, missing);
+
+        stream.next_seq = end_seq;
+        stream.assembling = false;
+    }
+
+    bool McastData::send_nack(NodeId source_id, Label label, uint32_t session, uint32_t first_seq, uint32_t count) {
+        std::shared_ptr<sock::TCPClient> sock = m_router.get_socket(source_id);
+        if (sock == nullptr || !sock->is_connected()) return false;
+
+        io::LabelHeader hdr{};
+        hdr.magic = MAGIC_NUM;
+        hdr.version = VERSION;
+        hdr.source_id = m_id;
+        hdr.flags = static_cast<uint16_t>(io::LabelFlag::Nack);
+        hdr.label = label;
+        hdr.label_size = static_cast<uint32_t>(sizeof(io::McastNack));
+
+        io::McastNack nack{};
+        nack.session = session;
+        nack.first_seq = first_seq;
+        nack.count = count;
+
+        // one send so the frame never interleaves with a data frame on the socket
+        std::byte frame[sizeof(hdr) + sizeof(nack)];
+        std::memcpy(frame, &hdr, sizeof(hdr));
+        std::memcpy(frame + sizeof(hdr), &nack, sizeof(nack));
+
+        sock::SockResult result = sock->send_all(frame, sizeof(frame));
+        return result.ok();
+    }
+
+    McastStats McastData::get_stats() const {
+        McastStats stats{};
+        stats.frames_sent = m_frames_sent.load(std::memory_order_relaxed);
+        stats.datagrams_sent = m_datagrams_sent.load(std::memory_order_relaxed);
+        stats.frames_recvd = m_frames_recvd.load(std::memory_order_relaxed);
+        stats.frames_nacked = m_frames_nacked.load(std::memory_order_relaxed);
+        stats.frames_lost = m_frames_lost.load(std::memory_order_relaxed);
+        stats.nacks_recvd = m_nacks_recvd.load(std::memory_order_relaxed);
+        stats.resent = m_resent.load(std::memory_order_relaxed);
+        stats.resend_misses = m_resend_misses.load(std::memory_order_relaxed);
+        stats.resends_late = m_resends_late.load(std::memory_order_relaxed);
+        stats.datagrams_dropped = m_datagrams_dropped.load(std::memory_order_relaxed);
+        return stats;
+    }
+
+    void McastData::log_stats() const {
+        McastStats stats = get_stats();
+        LOG("multicast data: frames_sent=", stats.frames_sent, " datagrams_sent=", stats.datagrams_sent,
+            " frames_recvd=", stats.frames_recvd, " frames_nacked=", stats.frames_nacked, " frames_lost=", stats.frames_lost,
+            " nacks_recvd=", stats.nacks_recvd, " resent=", stats.resent, " resend_misses=", stats.resend_misses,
+            " resends_late=", stats.resends_late, " datagrams_dropped=", stats.datagrams_dropped);
+    }
+}
@@ -0,0 +1,174 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "types/const_types.h"
+#include "types/label_io_types.h"
+#include "types/send_io_types.h"
+#include "config/config.h"
+#include "socket/udp_multicast.h"
+#include "macros.h"
+
+namespace eroil::rt { class Router; }
+
+namespace eroil::wrk {
+    struct McastStats {
+        uint64_t frames_sent = 0;
+        uint64_t datagrams_sent = 0;
+        uint64_t frames_recvd = 0;
+        uint64_t frames_nacked = 0;     // missed here and asked for over tcp
+        uint64_t frames_lost = 0;       // missed here and past the nack limit or no socket to ask on
+        uint64_t nacks_recvd = 0;
+        uint64_t resent = 0;            // frames resent over tcp for a peers nack
+        uint64_t resend_misses = 0;     // nacked frames no longer retained
+        uint64_t resends_late = 0;      // resent frames dropped, a newer frame was delivered first
+        uint64_t datagrams_dropped = 0; // malformed, late or from a restarted source
+    };
+
+    // multicast data plane. a label enough remote subscribers listen for is published once here instead
+    // of once per socket: the tcp frame (LabelHeader + payload) is cut into McastHeader led datagrams and
+    // sent to the group the label hashes onto. frames are numbered per label, a receiver that sees a gap
+    // (a later frame, or a heartbeat naming a frame it never completed) sends the source a LabelFlag::Nack
+    // frame over their tcp socket and the source resends the frames it still retains on that socket.
+    // frames that arrive late are dropped, a frame is delivered once either way. a resend is only
+    // delivered if nothing newer of the label was, so a recovered frame never overwrites a later value
+    //
+    // one socket bound to the data port carries both directions. the recv thread joins the groups of our
+    // recv labels, reassembles and delivers frames and sends heartbeats, a second thread does the resends
+    class McastData {
+        private:
+            struct Retained {
+                uint32_t seq = 0;
+                std::shared_ptr<io::SendJob> job = nullptr;
+            };
+
+            // publish side, per label. only the mcast send worker publishes, nacks read it on the resend path
+            struct Published {
+                uint32_t next_seq = 0;
+                std::vector<Retained> retained;     // frame seq at seq % retain
+                std::chrono::steady_clock::time_point last_publish{};
+                uint32_t heartbeats_left = 0;
+            };
+
+            // receive side, per source and label, under m_streams_mtx
+            struct Stream {
+                uint32_t session = 0;
+                bool synced = false;        // next_seq unknown until a first frame or heartbeat, we may join part way
+                uint32_t next_seq = 0;      // oldest frame not yet delivered or given up on
+                bool assembling = false;    // next_seq is partly here
+                bool delivered = false;     // delivered_seq is valid
+                uint32_t delivered_seq = 0; // newest frame handed to subscribers, older resends are dropped
+                uint32_t frame_size = 0;
+                uint16_t frag_count = 0;
+                uint16_t frags_got = 0;
+                std::vector<std::byte> frame;
+                std::vector<uint8_t> got;   // per fragment
+            };
+
+            struct Resend {
+                NodeId to = INVALID_NODE;
+                uint32_t seq = 0;
+                std::shared_ptr<io::SendJob> job = nullptr;
+            };
+
+            static constexpr size_t FRAG_PAYLOAD = MCAST_DATAGRAM_SIZE - sizeof(io::McastHeader);
+            static constexpr uint32_t RECV_TIMEOUT_MS = 10;
+            static constexpr auto HEARTBEAT_INTERVAL = std::chrono::milliseconds(20);
+            static constexpr uint32_t HEARTBEAT_REPEATS = 3;   // heartbeats per quiet label, one may be lost
+            static constexpr auto GROUP_CHECK_INTERVAL = std::chrono::milliseconds(250);
+            static constexpr uint32_t MAX_NACK_SEQS = 64;       // per gap, older frames are given up on
+            static constexpr size_t RECV_BUF_SIZE = 64 * KILOBYTE;
+            static constexpr size_t RECV_SOCK_BUF_SIZE = 4 * MEGABYTE;
+            static constexpr size_t RETAIN_BYTES = 4 * MEGABYTE;    // per label, large labels retain fewer frames
+
+            rt::Router& m_router;
+            NodeId m_id;
+            cfg::McastDataConfig m_cfg;
+            cfg::UdpMcastConfig m_sock_cfg;
+            uint32_t m_session;
+            std::vector<std::string> m_groups;
+            sock::UDPMulticastSocket m_sock;
+
+            std::mutex m_pub_mtx;
+            std::unordered_map<Label, Published> m_published;
+            std::vector<std::byte> m_tx_buf;    // mcast send worker only
+
+            std::mutex m_resend_mtx;
+            std::condition_variable m_resend_cv;
+            std::vector<Resend> m_resends;
+
+            // streams are fed by the recv thread and by resends arriving on the socket reactor
+            std::mutex m_streams_mtx;
+            std::unordered_map<uint64_t, Stream> m_streams;     // source << 32 | label
+
+            // recv thread only
+            std::vector<uint8_t> m_joined;                      // per group
+            size_t m_joined_count = 0;
+            uint64_t m_recv_gen = 0;
+
+            std::atomic<uint64_t> m_frames_sent{0};
+            std::atomic<uint64_t> m_datagrams_sent{0};
+            std::atomic<uint64_t> m_frames_recvd{0};
+            std::atomic<uint64_t> m_frames_nacked{0};
+            std::atomic<uint64_t> m_frames_lost{0};
+            std::atomic<uint64_t> m_nacks_recvd{0};
+            std::atomic<uint64_t> m_resent{0};
+            std::atomic<uint64_t> m_resend_misses{0};
+            std::atomic<uint64_t> m_resends_late{0};
+            std::atomic<uint64_t> m_datagrams_dropped{0};
+
+            std::atomic<bool> m_running{false};
+            std::atomic<bool> m_stop{false};
+            std::thread m_recv_thread;
+            std::thread m_resend_thread;
+
+        public:
+            McastData(rt::Router& router, NodeId id, const cfg::McastDataConfig& cfg, const cfg::UdpMcastConfig& sock_cfg);
+            ~McastData() { stop(); }
+
+            EROIL_NO_COPY(McastData)
+            EROIL_NO_MOVE(McastData)
+
+            bool start();
+            void stop();
+            bool running() const noexcept { return m_running.load(std::memory_order_acquire); }
+
+            // labels with fewer multicast subscribers than this are sent over their sockets
+            uint32_t min_subscribers() const noexcept { return m_cfg.min_subscribers; }
+
+            // sends the jobs frame to the labels group, called from the mcast send worker
+            bool publish(const std::shared_ptr<io::SendJob>& job);
+
+            // a LabelFlag::Nack frame from a receiver, called from the socket reactor
+            void on_nack(NodeId from, Label label, const std::byte* body, size_t size);
+
+            // a LabelFlag::Resend frame answering one of our nacks, called from the socket reactor
+            void on_resend(NodeId from, Label label, const std::byte* body, size_t size);
+
+            McastStats get_stats() const;
+            void log_stats() const;
+
+        private:
+            bool stop_requested() const { return m_stop.load(std::memory_order_acquire); }
+            const std::string& group_of(Label label) const noexcept;
+            size_t group_index(Label label) const noexcept;
+            void run_recv();
+            void run_resend();
+            void sync_groups();
+            void send_heartbeats();
+            void handle_datagram(const std::byte* data, size_t size);
+            void handle_data(const io::McastHeader& hdr, const std::byte* body, size_t body_size);
+            void handle_heartbeat(const io::McastHeader& hdr, const std::byte* body, size_t body_size);
+            Stream* find_stream(NodeId source_id, Label label, uint32_t session);
+            bool deliver(NodeId source_id, Label label, const std::byte* frame, size_t frame_size);
+            void give_up(NodeId source_id, Label label, Stream& stream, uint32_t end_seq);
+            bool send_nack(NodeId source_id, Label label, uint32_t session, uint32_t first_seq, uint32_t count);
+    };
+}
@@ -0,0 +1,289 @@
+#include "peer_connector.h"
+#include <algorithm>
+#include <array>
+#include "safe_print.h"
+#include "log/evtlog_api.h"
+
+namespace eroil::wrk {
+    static constexpr size_t MAX_EVENTS = 64;
+
+    PeerConnector::PeerConnector(NodeId id, uint32_t stripes, Handoff handoff) :
+        m_id(id),
+        m_stripes(std::clamp<uint32_t>(stripes, 1, MAX_TCP_STRIPES)),
+        m_handoff(std::move(handoff)),
+        m_dials{},
+        m_poller{},
+        m_rng{static_cast<uint32_t>(Clock::now().time_since_epoch().count()) ^ static_cast<uint32_t>(id)} {}
+
+    bool PeerConnector::start(const std::vector<addr::NodeAddress>& peers) {
+        if (m_thread.joinable()) {
+            ERR_PRINT("attempted to start a joinable thread (double start or start after stop but before join() called)");
+            return false;
+        }
+
+        m_start = Clock::now();
+        m_dials.clear();
+        for (const addr::NodeAddress& info : peers) {
+            if (info.id >= m_id) continue;
+            Dial dial{};
+            dial.info = info;
+            dial.next_attempt = m_start;
+            m_dials.push_back(std::move(dial));
+        }
+
+        if (m_dials.empty()) {
+            LOG("no remote peers to connect out to, peer connector not started");
+            return true;
+        }
+
+        sock::SockResult result = m_poller.open();
+        if (!result.ok()) {
+            ERR_PRINT("peer connector could not open its poller");
+            evtlog::error(elog_kind::StartFailed, elog_cat::PeerConnector);
+            print_socket_result(result);
+            return false;
+        }
+
+        m_stop.store(false, std::memory_order_release);
+        m_thread = std::thread([this] { run(); });
+        return true;
+    }
+
+    void PeerConnector::stop() {
+        m_stop.exchange(true, std::memory_order_acq_rel);
+        m_poller.wake();
+        if (m_thread.joinable()) {
+            // do not allow this thread to call join on itself
+            if (std::this_thread::get_id() != m_thread.get_id()) {
+                m_thread.join();
+            }
+        }
+    }
+
+    void PeerConnector::redial(NodeId id) {
+        {
+            std::lock_guard lock(m_redial_mtx);
+            m_redial.push_back(id);
+        }
+        m_poller.wake();
+    }
+
+    void PeerConnector::run() {
+        LOG("peer connector dialing ", m_dials.size(), " remote peers");
+        std::array<sock::PollEvent, MAX_EVENTS> events{};
+
+        try {
+            while (!stop_requested()) {
+                EvtMark mark(elog_cat::PeerConnector);
+                Clock::time_point now = Clock::now();
+                take_redials(now);
+
+                // every peer due for an attempt goes out now, none waits on another's handshake
+                for (size_t i = 0; i < m_dials.size(); ++i) {
+                    const Dial& dial = m_dials[i];
+                    if (!dial.up && !in_flight(i) && dial.next_attempt <= now) {
+                        begin(i, now);
+                    }
+                }
+
+                now = Clock::now();
+                for (size_t i = 0; i < m_dials.size(); ++i) {
+                    const Dial& dial = m_dials[i];
+                    if (in_flight(i) && dial.deadline <= now) {
+                        LOG("connection to nodeid=", dial.info.id, " timed out after ", CONNECT_TIMEOUT_MS, "ms");
+                        evtlog::info(elog_kind::ConnectTimedOut, elog_cat::PeerConnector, dial.info.id);
+                        m_timed_out.fetch_add(1, std::memory_order_relaxed);
+                        fail(i, now, sock::SockResult{ sock::SockErr::TimedOut, sock::SockOp::Connect, 0, 0 });
+                    }
+                }
+
+                size_t count = 0;
+                sock::SockResult result = m_poller.wait(events.data(), events.size(), next_timeout_ms(now), count);
+                if (!result.ok()) {
+                    ERR_PRINT("peer connector poll failed");
+                    print_socket_result(result);
+                    std::this_thread::sleep_for(std::chrono::milliseconds(MIN_BACKOFF_MS));
+                    continue;
+                }
+
+                now = Clock::now();
+                for (size_t e = 0; e < count; ++e) {
+                    const sock::PollEvent& ev = events[e];
+                    const size_t index = static_cast<size_t>(ev.key / MAX_TCP_STRIPES);
+                    const uint32_t stripe = static_cast<uint32_t>(ev.key % MAX_TCP_STRIPES);
+                    if (index >= m_dials.size() || stripe >= m_dials[index].socks.size()) continue;
+                    if (!ev.writable && !ev.error && !ev.hangup) continue;
+                    finish(index, stripe, now);
+                }
+            }
+        } catch (const std::exception& e) {
+            ERR_PRINT("peer connector exception: ", e.what());
+        } catch (...) {
+            ERR_PRINT("unknown peer connector exception");
+        }
+
+        for (size_t i = 0; i < m_dials.size(); ++i) {
+            if (in_flight(i)) abandon(i);
+        }
+        m_poller.close();
+        LOG("peer connector exits");
+    }
+
+    void PeerConnector::take_redials(Clock::time_point now) {
+        std::vector<NodeId> redial{};
+        {
+            std::lock_guard lock(m_redial_mtx);
+            redial.swap(m_redial);
+        }
+
+        for (const NodeId id : redial) {
+            for (Dial& dial : m_dials) {
+                if (dial.info.id != id || !dial.up) continue;
+                dial.up = false;
+                dial.backoff_ms = 0;
+                dial.next_attempt = now;
+                m_peers_up.fetch_sub(1, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    void PeerConnector::begin(size_t index, Clock::time_point now) {
+        Dial& dial = m_dials[index];
+        LOG("attempt connection to nodeid=", dial.info.id, " ip=", dial.info.ip, ":", dial.info.port);
+        evtlog::info(elog_kind::Connect, elog_cat::PeerConnector, dial.info.id);
+        m_attempts.fetch_add(1, std::memory_order_relaxed);
+
+        // every stripe is dialed at once and shares the deadline
+        dial.done_mask = 0;
+        dial.deadline = now + std::chrono::milliseconds(CONNECT_TIMEOUT_MS);
+        dial.socks.resize(m_stripes);
+        for (uint32_t stripe = 0; stripe < m_stripes; ++stripe) {
+            dial.socks[stripe] = std::make_shared<sock::TCPClient>();
+            sock::SockResult result = dial.socks[stripe]->open_and_begin_connect(dial.info.ip.c_str(), dial.info.port);
+            if (result.ok()) {
+                dial.done_mask |= 1u << stripe;
+                continue;
+            }
+
+            if (result.code == sock::SockErr::WouldBlock) {
+                const uint64_t key = static_cast<uint64_t>(index) * MAX_TCP_STRIPES + stripe;
+                result = m_poller.add(dial.socks[stripe]->native_handle(), key, true);
+            }
+            if (!result.ok()) {
+                fail(index, now, result);
+                return;
+            }
+        }
+
+        if (dial.done_mask == (1u << m_stripes) - 1) {
+            complete(index, now);
+        }
+    }
+
+    void PeerConnector::finish(size_t index, uint32_t stripe, Clock::time_point now) {
+        Dial& dial = m_dials[index];
+        if ((dial.done_mask & (1u << stripe)) != 0) return;
+
+        m_poller.remove(dial.socks[stripe]->native_handle());
+        sock::SockResult result = dial.socks[stripe]->finish_connect();
+        if (!result.ok()) {
+            fail(index, now, result);
+            return;
+        }
+
+        dial.done_mask |= 1u << stripe;
+        if (dial.done_mask == (1u << m_stripes) - 1) {
+            complete(index, now);
+        }
+    }
+
+    void PeerConnector::complete(size_t index, Clock::time_point now) {
+        Dial& dial = m_dials[index];
+        std::vector<std::shared_ptr<sock::TCPClient>> socks{};
+        socks.swap(dial.socks);
+        dial.done_mask = 0;
+
+        if (!m_handoff(dial.info.id, std::move(socks))) {
+            fail(index, now, sock::SockResult{ sock::SockErr::NotConnected, sock::SockOp::Send, 0, 0 });
+            return;
+        }
+
+        dial.up = true;
+        dial.backoff_ms = 0;
+        m_connected.fetch_add(1, std::memory_order_relaxed);
+        const uint32_t up = m_peers_up.fetch_add(1, std::memory_order_relaxed) + 1;
+
+        if (!m_all_up_logged && up == m_dials.size()) {
+            m_all_up_logged = true;
+            const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(now - m_start).count();
+            LOG("connected out to all ", up, " remote peers after ", elapsed, "ms");
+        }
+    }
+
+    void PeerConnector::fail(size_t index, Clock::time_point now, const sock::SockResult& result) {
+        abandon(index);
+        m_failed.fetch_add(1, std::memory_order_relaxed);
+
+        // equal jitter, half the backoff is fixed and half random so peers that failed together spread out
+        Dial& dial = m_dials[index];
+        dial.backoff_ms = dial.backoff_ms == 0 ? MIN_BACKOFF_MS : std::min(dial.backoff_ms * 2, MAX_BACKOFF_MS);
+        const uint32_t half = dial.backoff_ms / 2;
+        const uint32_t delay = half + std::uniform_int_distribution<uint32_t>(0, half)(m_rng);
+        dial.next_attempt = now + std::chrono::milliseconds(delay);
+
+        LOG("connection to nodeid=", dial.info.id, " failed with ", result.code_to_string(), ", retry in ", delay, "ms");
+        evtlog::info(elog_kind::ConnectionFailed, elog_cat::PeerConnector, dial.info.id, result.sys_error);
+    }
+
+    void PeerConnector::abandon(size_t index) {
+        Dial& dial = m_dials[index];
+
+        // out of the poller before closing so a reused handle is never mistaken for this one
+        for (uint32_t stripe = 0; stripe < dial.socks.size(); ++stripe) {
+            const std::shared_ptr<sock::TCPClient>& sock = dial.socks[stripe];
+            if (sock == nullptr) continue;
+            if ((dial.done_mask & (1u << stripe)) == 0) m_poller.remove(sock->native_handle());
+            sock->close();
+        }
+        dial.socks.clear();
+        dial.done_mask = 0;
+    }
+
+    int32_t PeerConnector::next_timeout_ms(Clock::time_point now) const {
+        // nothing pending, sleep until a redial or stop wakes us
+        bool pending = false;
+        Clock::time_point next = Clock::time_point::max();
+        for (const Dial& dial : m_dials) {
+            if (!dial.socks.empty()) {
+                next = std::min(next, dial.deadline);
+                pending = true;
+            } else if (!dial.up) {
+                next = std::min(next, dial.next_attempt);
+                pending = true;
+            }
+        }
+        if (!pending) return -1;
+        if (next <= now) return 0;
+
+        // round up so we never wake a hair before the deadline and spin
+        const auto wait = std::chrono::duration_cast<std::chrono::milliseconds>(next - now).count() + 1;
+        return static_cast<int32_t>(std::min<int64_t>(wait, MAX_BACKOFF_MS));
+    }
+
+    ConnectorStats PeerConnector::get_stats() const {
+        ConnectorStats stats{};
+        stats.attempts = m_attempts.load(std::memory_order_relaxed);
+        stats.connected = m_connected.load(std::memory_order_relaxed);
+        stats.failed = m_failed.load(std::memory_order_relaxed);
+        stats.timed_out = m_timed_out.load(std::memory_order_relaxed);
+        stats.peers_up = m_peers_up.load(std::memory_order_relaxed);
+        stats.peers = static_cast<uint32_t>(m_dials.size());
+        return stats;
+    }
+
+    void PeerConnector::log_stats() const {
+        ConnectorStats stats = get_stats();
+        LOG("peer connector: peers_up=", stats.peers_up, "/", stats.peers, " attempts=", stats.attempts,
+            " connected=", stats.connected, " failed=", stats.failed, " timed_out=", stats.timed_out);
+    }
+}
@@ -0,0 +1,101 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+#include "address/address.h"
+#include "socket/poller.h"
+#include "socket/tcp_socket.h"
+#include "types/const_types.h"
+#include "macros.h"
+
+namespace eroil::wrk {
+    struct ConnectorStats {
+        uint64_t attempts = 0;          // connects issued
+        uint64_t connected = 0;         // connects handed off as live socket sets
+        uint64_t failed = 0;            // refused, unreachable, or the handoff failed
+        uint64_t timed_out = 0;         // handshake did not finish before its deadline
+        uint32_t peers_up = 0;          // outbound peers currently connected
+        uint32_t peers = 0;             // outbound peers we dial
+    };
+
+    // dials the remote peers we connect out to (ids lower than ours). every connect is non-blocking and
+    // in flight at once, one thread polls for their completions. each attempt has a deadline, a failed or
+    // expired attempt is retried after a jittered exponential backoff kept per peer. with tcp stripes a
+    // peer is one attempt over all its connections, any stripe failing fails the set. the handoff sends
+    // our id and registers the sockets, returning false puts the peer back on the backoff schedule
+    class PeerConnector {
+        public:
+            using Clock = std::chrono::steady_clock;
+            using Handoff = std::function<bool(NodeId, std::vector<std::shared_ptr<sock::TCPClient>>)>;
+
+        private:
+            struct Dial {
+                addr::NodeAddress info{};
+                std::vector<std::shared_ptr<sock::TCPClient>> socks{};  // one per stripe while a connect is in flight
+                uint32_t done_mask = 0;                                 // stripes whose connect finished
+                bool up = false;
+                Clock::time_point next_attempt{};
+                Clock::time_point deadline{};
+                uint32_t backoff_ms = 0;
+            };
+
+            NodeId m_id;
+            uint32_t m_stripes;
+            Handoff m_handoff;
+            std::vector<Dial> m_dials;          // only touched by the connector thread
+            sock::Poller m_poller;
+            std::mt19937 m_rng;
+            Clock::time_point m_start{};
+            bool m_all_up_logged = false;
+
+            std::mutex m_redial_mtx;
+            std::vector<NodeId> m_redial;       // peers whose socket was found dead, dial again now
+
+            std::atomic<uint64_t> m_attempts{0};
+            std::atomic<uint64_t> m_connected{0};
+            std::atomic<uint64_t> m_failed{0};
+            std::atomic<uint64_t> m_timed_out{0};
+            std::atomic<uint32_t> m_peers_up{0};
+
+            std::atomic<bool> m_stop{false};
+            std::thread m_thread;
+
+            static constexpr uint32_t CONNECT_TIMEOUT_MS = 1000;    // per attempt handshake deadline
+            static constexpr uint32_t MIN_BACKOFF_MS = 100;
+            static constexpr uint32_t MAX_BACKOFF_MS = 5000;
+
+        public:
+            PeerConnector(NodeId id, uint32_t stripes, Handoff handoff);
+            ~PeerConnector() { stop(); }
+
+            EROIL_NO_COPY(PeerConnector)
+            EROIL_NO_MOVE(PeerConnector)
+
+            // peers ids at or above ours are skipped, they connect to us
+            bool start(const std::vector<addr::NodeAddress>& peers);
+            void stop();
+
+            // thread safe, the socket to id was dropped, dial it again right away
+            void redial(NodeId id);
+
+            ConnectorStats get_stats() const;
+            void log_stats() const;
+
+        private:
+            bool stop_requested() const { return m_stop.load(std::memory_order_acquire); }
+            void run();
+            void take_redials(Clock::time_point now);
+            bool in_flight(size_t index) const noexcept { return !m_dials[index].socks.empty(); }
+            void begin(size_t index, Clock::time_point now);
+            void finish(size_t index, uint32_t stripe, Clock::time_point now);
+            void complete(size_t index, Clock::time_point now);
+            void fail(size_t index, Clock::time_point now, const sock::SockResult& result);
+            void abandon(size_t index);
+            int32_t next_timeout_ms(Clock::time_point now) const;
+    };
+}
@@ -1,5 +1,7 @@
 #pragma once
 #include "types/send_io_types.h"
+#include "workers/zerocopy_tracker.h"
+#include "workers/mcast_data.h"
 
 namespace eroil::wrk {
     struct ShmSendPlan {
@@ -8,7 +10,7 @@ namespace eroil::wrk {
         static bool is_local() noexcept { return true; }
         static bool is_remote() noexcept { return false; }
 
-        static bool send_one(shm::ShmSend& shm, io::SendJob& job) noexcept {
+        static bool send_one(shm::ShmSend& shm, io::SendJob& job, io::JobCompleteGuard&) noexcept {
             shm::ShmSendResult result = shm.send(
                 job.source_id, 
                 job.label, 
@@ -32,12 +34,32 @@ namespace eroil::wrk {
         static bool is_local() noexcept { return false; }
         static bool is_remote() noexcept { return true; }
 
-        static bool send_one(sock::TCPClient& sock, io::SendJob& job) noexcept {
+        // optional MSG_ZEROCOPY for large frames, the job then completes when the kernel
+        // releases the buffer instead of when send() returns
+        ZeroCopyTracker* zc = nullptr;
+        size_t zc_threshold = 0;
+
+        bool send_one(sock::TCPClient& sock, io::SendJob& job, io::JobCompleteGuard& guard) noexcept {
             if (!sock.is_connected()) return false; // re-connection is being attempted in the background
-            sock::SockResult result = sock.send(
-                job.send_buffer.data.get(),
-                job.send_buffer.total_size
-            );
+
+            const size_t size = job.send_buffer.total_size;
+            if (zc == nullptr || size < zc_threshold || !sock.zerocopy_enabled()) {
+                if (zc != nullptr) zc->add_copied(size);
+                sock::SockResult result = sock.send(job.send_buffer.data.get(), size);
+                if (!result.ok()) {
+                    // TODO: is there something to handle here?
+                    ERR_PRINT("socket send for label=", job.label, ", error=", result.code_to_string());
+                }
+                return result.ok();
+            }
+
+            uint32_t zc_first = 0;
+            uint32_t zc_count = 0;
+            sock::SockResult result = sock.send_all_zerocopy(job.send_buffer.data.get(), size, zc_first, zc_count);
+            if (zc_count > 0) {
+                // kernel may still hold the buffer even if the send failed part way
+                zc->track(sock, zc_first, zc_count, size, guard.release());
+            }
             
             if (!result.ok()) {
                 // TODO: is there something to handle here?
@@ -47,4 +69,16 @@ namespace eroil::wrk {
             return result.ok();
         }
     };
+
+    struct McastSendPlan {
+        static const auto& receivers(const io::SendJob& job) noexcept { return job.mcast_recvrs; }
+        static auto& fail_count(io::SendJob& job) noexcept { return job.mcast_failure_count; }
+        static bool is_local() noexcept { return false; }
+        static bool is_remote() noexcept { return true; }
+
+        // the data plane keeps the job to resend it on a nack, the guard still completes it here
+        static bool send_one(McastData& mcast, io::SendJob&, io::JobCompleteGuard& guard) {
+            return mcast.publish(guard.job);
+        }
+    };
 }
\ No newline at end of file
@@ -15,6 +15,7 @@ namespace eroil::wrk {
     template <class SendPlan>
     class SendWorker {
         private:
+            SendPlan m_plan;
             std::queue<std::shared_ptr<io::SendJob>> m_send_q;
             evt::Semaphore m_sem;
             std::mutex m_mtx;
@@ -24,6 +25,7 @@ namespace eroil::wrk {
 
         public:
             explicit SendWorker() = default;
+            explicit SendWorker(SendPlan plan) : m_plan(plan) {}
             ~SendWorker() { stop(); };
 
             EROIL_NO_COPY(SendWorker)
@@ -110,7 +112,7 @@ namespace eroil::wrk {
                             for (const auto& recvr : SendPlan::receivers(*job)) {
                                 io::JobCompleteGuard job_complete_guard{job};
                                 if (recvr == nullptr) continue;
-                                if (!SendPlan::send_one(*recvr, *job)) {
+                                if (!m_plan.send_one(*recvr, *job, job_complete_guard)) {
                                     evtlog::warn(elog_kind::SendFailed, elog_cat::SendWorker, job->label);
                                     ++SendPlan::fail_count(*job);
                                 }
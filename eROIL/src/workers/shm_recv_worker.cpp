@@ -1,12 +1,13 @@
 #include "shm_recv_worker.h"
+#include <algorithm>
 #include "safe_print.h"
 #include "types/const_types.h"
 #include "log/evtlog_api.h"
 #include "time/timer.h"
 
 namespace eroil::wrk {
-    ShmRecvWorker::ShmRecvWorker(rt::Router& router, NodeId id) : 
-        m_router{router}, m_id{id}, m_shm{nullptr} {
+    ShmRecvWorker::ShmRecvWorker(rt::Router& router, NodeId id, size_t max_ring_size, uint32_t stuck_writer_ms, HostRelay* relay) : 
+        m_router{router}, m_id{id}, m_shm{nullptr}, m_relay{relay}, m_stuck_writer_ms{stuck_writer_ms}, m_max_ring_size{max_ring_size} {
     }
 
     void ShmRecvWorker::start() {
@@ -44,9 +45,10 @@ namespace eroil::wrk {
             // set up a temp buffer that can hold label header + max label size
             // set recv buffer size to max possible size since we recv the label header
             // and label data in one recv call and we want to always ensure we have enough
-            // space for the entire record in the buffer to avoid partial recv issues
+            // space for the entire record in the buffer to avoid partial recv issues.
+            // a gateway also takes frames wrapped for other hosts, a little larger
             std::vector<std::byte> recv_buf;
-            recv_buf.resize(MAX_LABEL_SIZE + sizeof(io::LabelHeader));
+            recv_buf.resize((m_relay != nullptr ? io::MAX_RELAY_SIZE : MAX_LABEL_SIZE) + sizeof(io::LabelHeader));
             uint32_t wait_err_count = 0;
 
             while (!stop_requested()) {
@@ -68,6 +70,7 @@ namespace eroil::wrk {
                 }
 
                 EvtMark mark(elog_cat::ShmRecvWorker);
+                check_ring_pressure();
 
                 // consume data until no records
                 while (true) {
@@ -87,14 +90,27 @@ namespace eroil::wrk {
                         continue;
                     }
 
-                    if (hdr->label_size > MAX_LABEL_SIZE) {
-                        ERR_PRINT("shm recv got header that indicates label size is > ", MAX_LABEL_SIZE);
+                    const bool relay = io::has_flag(hdr->flags, io::LabelFlag::Relay);
+                    const size_t max_size = relay ? io::MAX_RELAY_SIZE : MAX_LABEL_SIZE;
+                    if (hdr->label_size > max_size || hdr->label_size + sizeof(io::LabelHeader) > record.buf_size) {
+                        ERR_PRINT("shm recv got header that indicates label size is > ", max_size);
                         ERR_PRINT("    label=", hdr->label, ", sourceid=", hdr->source_id);
                         evtlog::error(elog_kind::InvalidLabelSize, elog_cat::ShmRecvWorker, hdr->label, hdr->label_size);
                         break;
                     }
 
                     auto* data_ptr = record.recv_buf + sizeof(io::LabelHeader);
+
+                    // a node on our host publishing to other hosts, we pass it on as their gateway
+                    if (relay) {
+                        if (m_relay != nullptr) {
+                            m_relay->forward(*hdr, data_ptr, static_cast<size_t>(hdr->label_size));
+                        } else {
+                            ERR_PRINT("shm recv got relay frame but we are no host gateway, sourceid=", hdr->source_id);
+                        }
+                        continue;
+                    }
+
                     m_router.distribute_recvd_label(
                         static_cast<NodeId>(hdr->source_id),
                         static_cast<Label>(hdr->label),
@@ -104,6 +120,15 @@ namespace eroil::wrk {
                     );
                     evtlog::info(elog_kind::DataDistributed, elog_cat::ShmRecvWorker);
                 }
+
+                // arena subscribers had their slots written by the publishers, hand the finished ones over
+                const uint32_t skipped = m_router.drain_arena(m_stuck_writer_ms);
+                if (skipped != 0) {
+                    evtlog::warn(elog_kind::ArenaTicketSkipped, elog_cat::ShmRecvWorker, skipped);
+                }
+
+                // ring can only be resized while it is empty, which is right after a full drain
+                if (m_grow_pending) grow_ring();
             }
         } catch (const std::exception& e) {
             ERR_PRINT("shm recv worker got exception, worker stopping: ", e.what());
@@ -162,6 +187,12 @@ namespace eroil::wrk {
                     return { false, data };
                 }
             
+                // only the bad record was consumed, the rest of the backlog is still good
+                case shm::ShmRecvErr::ChecksumMismatch: {
+                    evtlog::warn(elog_kind::ChecksumMismatch, elog_cat::ShmRecvWorker);
+                    continue;
+                }
+
                 case shm::ShmRecvErr::UnknownError: { 
                     ERR_PRINT("shm recv worker re-initializing shared memory block due to unknown error");
                     m_shm->reinit();
@@ -177,4 +208,47 @@ namespace eroil::wrk {
             }
         }
     }
+
+    void ShmRecvWorker::check_ring_pressure() {
+        if (m_max_ring_size == 0 || m_grow_pending) return;
+        if (m_shm->total_size() >= m_max_ring_size) return;
+
+        // a writer found the ring full since we last looked, grow right away
+        const uint64_t full = m_shm->full_count();
+        if (full != m_last_full_count) {
+            m_last_full_count = full;
+            m_grow_pending = true;
+            return;
+        }
+
+        // otherwise grow once the ring sits over half full for a while
+        if (m_shm->backlog_bytes() * 2 > m_shm->capacity()) {
+            m_busy_wakes += 1;
+            if (m_busy_wakes >= BUSY_WAKES_TO_GROW) m_grow_pending = true;
+        } else {
+            m_busy_wakes = 0;
+        }
+    }
+
+    void ShmRecvWorker::grow_ring() {
+        const size_t current = m_shm->total_size();
+        const size_t target = std::min(current * 2, m_max_ring_size);
+
+        // writers may have refilled the ring since the drain, try again next wake
+        if (m_shm->backlog_bytes() != 0) return;
+
+        m_grow_pending = false;
+        m_busy_wakes = 0;
+        m_last_full_count = 0;
+        if (!m_shm->grow(target)) {
+            // platform cannot resize (windows) or the resize failed, stop trying
+            LOG("shm recv ring stays at size=", current, ", growth disabled");
+            m_max_ring_size = 0;
+            return;
+        }
+
+        LOG("shm recv ring grown from size=", current, " to size=", target);
+        evtlog::info(elog_kind::ShmRingGrown, elog_cat::ShmRecvWorker,
+            static_cast<uint32_t>(current / MEGABYTE), static_cast<uint32_t>(target / MEGABYTE));
+    }
 }
\ No newline at end of file
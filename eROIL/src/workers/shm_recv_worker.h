@@ -4,6 +4,7 @@
 #include <utility>
 #include "router/router.h"
 #include "shm/shm_recv.h"
+#include "workers/host_relay.h"
 #include "types/const_types.h"
 #include "macros.h"
 
@@ -13,14 +14,24 @@ namespace eroil::wrk {
             rt::Router& m_router;
             NodeId m_id;
             std::shared_ptr<shm::ShmRecv> m_shm;
+            HostRelay* m_relay;             // optional, set when we are a host gateway
+
+            uint32_t m_stuck_writer_ms;     // an arena ticket held longer without a commit is skipped
+
+            // ring growth, only touched by the worker thread
+            size_t m_max_ring_size;         // 0 = never grow
+            uint64_t m_last_full_count = 0;
+            uint32_t m_busy_wakes = 0;      // consecutive wakes that found the ring over half full
+            bool m_grow_pending = false;
 
             std::atomic<bool> m_stop{false};
             std::thread m_thread;
             
             const int64_t MAX_TIMEOUT_MS = 50;
+            const uint32_t BUSY_WAKES_TO_GROW = 8;
 
         public:
-            ShmRecvWorker(rt::Router& router, NodeId id);
+            ShmRecvWorker(rt::Router& router, NodeId id, size_t max_ring_size, uint32_t stuck_writer_ms, HostRelay* relay = nullptr);
             ~ShmRecvWorker() { stop(); }
 
             EROIL_NO_COPY(ShmRecvWorker)
@@ -33,5 +44,7 @@ namespace eroil::wrk {
             bool stop_requested() const { return m_stop.load(std::memory_order_acquire); }
             void run();
             std::pair<bool, shm::ShmRecvData> get_next_record(std::byte* recv_buf, const size_t recv_buf_size);
+            void check_ring_pressure();
+            void grow_ring();
     };
 }
\ No newline at end of file
@@ -0,0 +1,706 @@
+#include "socket_reactor.h"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstring>
+#include "safe_print.h"
+#include "log/evtlog_api.h"
+
+namespace eroil::wrk {
+    SocketReactor::SocketReactor(rt::Router& router, NodeId id, size_t num_threads, ZeroCopyTracker* zc,
+                                 McastData* mcast, HostRelay* relay, Heartbeat* heartbeat) :
+        m_router(router),
+        m_zc(zc),
+        m_mcast(mcast),
+        m_relay(relay),
+        m_heartbeat(heartbeat),
+        m_id(id),
+        m_num_threads(num_threads == 0 ? 1 : num_threads),
+        m_use_uring(false),
+        m_threads{},
+        m_assignment{} {}
+
+    bool SocketReactor::start(bool use_uring) {
+        if (!m_threads.empty()) {
+            ERR_PRINT("socket reactor already started");
+            return false;
+        }
+
+        m_stop.store(false, std::memory_order_release);
+        m_use_uring = use_uring;
+        for (size_t i = 0; i < m_num_threads; ++i) {
+            auto t = std::make_unique<IoThread>();
+            t->index = i;
+
+            if (m_use_uring) {
+                sock::SockResult ring_result = t->ring.open(RING_ENTRIES);
+                if (ring_result.ok()) {
+                    m_threads.push_back(std::move(t));
+                    continue;
+                }
+
+                // a kernel that passed the probe can still refuse a ring (memlock limits etc)
+                LOG("socket reactor could not open io_uring, falling back to poller, sys_error=", ring_result.sys_error);
+                for (auto& opened : m_threads) {
+                    opened->ring.close();
+                }
+                m_threads.clear();
+                m_use_uring = false;
+                return start(false);
+            }
+
+            sock::SockResult result = t->poller.open();
+            if (!result.ok()) {
+                ERR_PRINT("socket reactor failed to open poller for io thread ", i);
+                evtlog::error(elog_kind::StartFailed, elog_cat::SocketReactor, static_cast<int32_t>(i));
+                print_socket_result(result);
+                stop();
+                return false;
+            }
+            m_threads.push_back(std::move(t));
+        }
+
+        for (auto& t : m_threads) {
+            IoThread* raw = t.get();
+            if (m_use_uring) {
+                t->thread = std::thread([this, raw] { run_uring(*raw); });
+            } else {
+                t->thread = std::thread([this, raw] { run(*raw); });
+            }
+        }
+
+        LOG("socket reactor for nodeid=", m_id, " started with ", m_num_threads,
+            " io threads, backend=", m_use_uring ? "io_uring" : "poller");
+        return true;
+    }
+
+    void SocketReactor::stop() {
+        m_stop.store(true, std::memory_order_release);
+        for (auto& t : m_threads) {
+            wake(*t);
+        }
+
+        for (auto& t : m_threads) {
+            if (t->thread.joinable()) {
+                t->thread.join();
+            }
+        }
+        m_threads.clear();
+    }
+
+    void SocketReactor::add_peer(NodeId peer_id, std::shared_ptr<sock::TCPClient> sock, uint32_t stripe) {
+        if (sock == nullptr || stripe >= MAX_TCP_STRIPES) return;
+        enqueue(Command{ CommandKind::Add, peer_id, stripe, std::move(sock) });
+    }
+
+    void SocketReactor::remove_peer(NodeId peer_id) {
+        for (uint32_t stripe = 0; stripe < MAX_TCP_STRIPES; ++stripe) {
+            enqueue(Command{ CommandKind::Remove, peer_id, stripe, nullptr });
+        }
+    }
+
+    void SocketReactor::enqueue(Command cmd) {
+        if (m_threads.empty()) {
+            ERR_PRINT("socket reactor not started, dropped command for nodeid=", cmd.peer_id);
+            return;
+        }
+
+        const ConnKey key = conn_key(cmd.peer_id, cmd.stripe);
+        size_t index = 0;
+        {
+            std::lock_guard lock(m_assign_mtx);
+            auto it = m_assignment.find(key);
+            if (it != m_assignment.end()) {
+                index = it->second;
+            } else {
+                if (cmd.kind == CommandKind::Remove) return; // never registered, nothing to remove
+
+                // new connections go to the io thread with the fewest connections
+                for (size_t i = 1; i < m_threads.size(); ++i) {
+                    if (m_threads[i]->assigned.load(std::memory_order_relaxed) <
+                        m_threads[index]->assigned.load(std::memory_order_relaxed)) {
+                        index = i;
+                    }
+                }
+                m_assignment.emplace(key, index);
+                m_threads[index]->assigned.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+
+        IoThread& t = *m_threads[index];
+        {
+            std::lock_guard lock(t.cmd_mtx);
+            t.cmds.push_back(std::move(cmd));
+        }
+        wake(t);
+    }
+
+    void SocketReactor::wake(IoThread& t) noexcept {
+        if (m_use_uring) {
+            t.ring.wake();
+        } else {
+            t.poller.wake();
+        }
+    }
+
+    void SocketReactor::run(IoThread& t) {
+        std::array<sock::PollEvent, MAX_EVENTS> events{};
+
+        try {
+            while (!stop_requested()) {
+                process_commands(t);
+
+                size_t count = 0;
+                sock::SockResult result = t.poller.wait(events.data(), events.size(), WAIT_TIMEOUT_MS, count);
+                if (!result.ok()) {
+                    ERR_PRINT("socket reactor poll failed on io thread ", t.index);
+                    evtlog::error(elog_kind::WaitError, elog_cat::SocketReactor, static_cast<int32_t>(t.index), result.sys_error);
+                    print_socket_result(result);
+                    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+                    continue;
+                }
+
+                if (count == 0 || stop_requested()) continue;
+
+                EvtMark mark(elog_cat::SocketReactor);
+                const auto start = std::chrono::steady_clock::now();
+
+                for (size_t i = 0; i < count; ++i) {
+                    const sock::PollEvent& ev = events[i];
+                    const ConnKey key = static_cast<ConnKey>(ev.key);
+
+                    auto it = t.peers.find(key);
+                    if (it == t.peers.end()) continue; // removed earlier in this batch
+
+                    // zero copy completions are reported through the socket error queue
+                    bool zc_reaped = false;
+                    if (ev.error && m_zc != nullptr) {
+                        zc_reaped = m_zc->reap(*it->second.sock);
+                    }
+
+                    // drain what is readable first, a hangup can arrive alongside the last frames
+                    bool alive = true;
+                    if (ev.readable) {
+                        alive = handle_readable(t, it->second);
+                    } else if (ev.hangup || (ev.error && !zc_reaped)) {
+                        alive = false;
+                    }
+
+                    if (!alive) {
+                        LOG("socket reactor dropped connection to nodeid=", it->second.peer_id, " stripe=", it->second.stripe);
+                        unregister_peer(t, key, true);
+                    }
+                }
+
+                record_loop(t, count, start);
+            }
+        } catch (const std::exception& e) {
+            ERR_PRINT("socket reactor exception: ", e.what());
+        } catch (...) {
+            ERR_PRINT("unknown socket reactor exception");
+        }
+
+        // sockets belong to the router, unregister without closing them
+        while (!t.peers.empty()) {
+            unregister_peer(t, t.peers.begin()->first, false);
+        }
+
+        evtlog::info(elog_kind::Exit, elog_cat::SocketReactor, static_cast<int32_t>(t.index));
+        PRINT("socket reactor io thread ", t.index, " exits");
+    }
+
+    void SocketReactor::run_uring(IoThread& t) {
+        std::array<sock::UringCompletion, MAX_EVENTS> done{};
+
+        try {
+            while (!stop_requested()) {
+                process_commands(t);
+
+                // keep one recv in flight per connection, all of them go to the kernel in one submit
+                for (auto& [key, conn] : t.peers) {
+                    if (conn.recv_in_flight) continue;
+
+                    auto [dst, want] = recv_target(conn);
+                    if (!t.ring.prep_recv(conn.handle, dst, want, conn.serial)) break; // sq full, rest go next loop
+                    conn.recv_in_flight = true;
+                    t.recv_calls.fetch_add(1, std::memory_order_relaxed);
+                }
+
+                sock::SockResult result = t.ring.submit_and_wait(WAIT_TIMEOUT_MS);
+                if (!result.ok()) {
+                    ERR_PRINT("socket reactor io_uring wait failed on io thread ", t.index);
+                    evtlog::error(elog_kind::WaitError, elog_cat::SocketReactor, static_cast<int32_t>(t.index), result.sys_error);
+                    print_socket_result(result);
+                    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+                    continue;
+                }
+
+                const size_t count = t.ring.reap(done.data(), done.size());
+                if (count == 0 || stop_requested()) continue;
+
+                EvtMark mark(elog_cat::SocketReactor);
+                const auto start = std::chrono::steady_clock::now();
+
+                for (size_t i = 0; i < count; ++i) {
+                    const sock::UringCompletion& c = done[i];
+
+                    PeerConn* conn = find_by_serial(t, c.user_data);
+                    if (conn == nullptr) {
+                        // completion for a connection that was unregistered while its recv was in flight
+                        t.retired.erase(c.user_data);
+                        continue;
+                    }
+                    conn->recv_in_flight = false;
+
+                    bool alive = true;
+                    if (c.res > 0) {
+                        size_t frames = 0;
+                        alive = consume_recv(t, *conn, static_cast<size_t>(c.res), frames);
+                    } else if (c.res == 0) {
+                        LOG("socket reactor peer closed connection, nodeid=", conn->peer_id);
+                        alive = false;
+                    } else {
+                        ERR_PRINT("socket reactor recv failed, nodeid=", conn->peer_id, " sys_error=", -c.res);
+                        evtlog::error(elog_kind::RecvError, elog_cat::SocketReactor, conn->peer_id, -c.res);
+                        alive = false;
+                    }
+
+                    if (!alive) {
+                        LOG("socket reactor dropped connection to nodeid=", conn->peer_id, " stripe=", conn->stripe);
+                        unregister_peer(t, conn_key(conn->peer_id, conn->stripe), true);
+                    }
+                }
+
+                record_loop(t, count, start);
+            }
+        } catch (const std::exception& e) {
+            ERR_PRINT("socket reactor exception: ", e.what());
+        } catch (...) {
+            ERR_PRINT("unknown socket reactor exception");
+        }
+
+        // sockets belong to the router, unregister without closing them
+        while (!t.peers.empty()) {
+            unregister_peer(t, t.peers.begin()->first, false);
+        }
+
+        // the kernel may still write into retired buffers until their recv completes or is cancelled
+        std::array<sock::UringCompletion, MAX_EVENTS> drain{};
+        for (int32_t attempts = 0; !t.retired.empty() && attempts < 10; ++attempts) {
+            if (!t.ring.submit_and_wait(WAIT_TIMEOUT_MS).ok()) break;
+            const size_t count = t.ring.reap(drain.data(), drain.size());
+            for (size_t i = 0; i < count; ++i) {
+                t.retired.erase(drain[i].user_data);
+            }
+        }
+        t.ring.close();
+        t.retired.clear();
+
+        evtlog::info(elog_kind::Exit, elog_cat::SocketReactor, static_cast<int32_t>(t.index));
+        PRINT("socket reactor io thread ", t.index, " exits");
+    }
+
+    void SocketReactor::record_loop(IoThread& t, size_t events, std::chrono::steady_clock::time_point start) noexcept {
+        const uint64_t busy_ns = static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - start
+            ).count()
+        );
+
+        t.loops.fetch_add(1, std::memory_order_relaxed);
+        t.events.fetch_add(events, std::memory_order_relaxed);
+        t.busy_ns_total.fetch_add(busy_ns, std::memory_order_relaxed);
+        if (busy_ns > t.busy_ns_max.load(std::memory_order_relaxed)) {
+            t.busy_ns_max.store(busy_ns, std::memory_order_relaxed);
+        }
+    }
+
+    SocketReactor::PeerConn* SocketReactor::find_by_serial(IoThread& t, uint64_t serial) noexcept {
+        for (auto& [key, conn] : t.peers) {
+            if (conn.serial == serial) return &conn;
+        }
+        return nullptr;
+    }
+
+    void SocketReactor::process_commands(IoThread& t) {
+        std::vector<Command> cmds;
+        {
+            std::lock_guard lock(t.cmd_mtx);
+            if (t.cmds.empty()) return;
+            cmds.swap(t.cmds);
+        }
+
+        for (Command& cmd : cmds) {
+            switch (cmd.kind) {
+                case CommandKind::Add: {
+                    register_peer(t, cmd.peer_id, cmd.stripe, std::move(cmd.sock));
+                    break;
+                }
+                case CommandKind::Remove: {
+                    unregister_peer(t, conn_key(cmd.peer_id, cmd.stripe), false);
+                    break;
+                }
+                default: break;
+            }
+        }
+    }
+
+    void SocketReactor::register_peer(IoThread& t, NodeId peer_id, uint32_t stripe, std::shared_ptr<sock::TCPClient> sock) {
+        // reconnect handoff, the old socket is already dead or about to be closed by whoever replaced it
+        const ConnKey key = conn_key(peer_id, stripe);
+        unregister_peer(t, key, false);
+
+        const socket_handle handle = sock->native_handle();
+        if (handle == INVALID_SOCKET || !sock->is_connected()) {
+            ERR_PRINT("socket reactor got a closed socket for nodeid=", peer_id);
+            return;
+        }
+
+        // a handle we still track for another connection means that socket was closed elsewhere
+        // and the os reused its handle, the old registration is gone so forget it
+        std::vector<ConnKey> stale;
+        for (const auto& [other_key, other] : t.peers) {
+            if (other.handle == handle) stale.push_back(other_key);
+        }
+        for (ConnKey other_key : stale) {
+            unregister_peer(t, other_key, false);
+        }
+
+        // the io_uring loop arms recvs itself, nothing to register up front
+        if (!m_use_uring) {
+            sock::SockResult result = t.poller.add(handle, static_cast<uint64_t>(key));
+            if (!result.ok()) {
+                ERR_PRINT("socket reactor failed to register socket for nodeid=", peer_id);
+                evtlog::error(elog_kind::StartFailed, elog_cat::SocketReactor, peer_id);
+                print_socket_result(result);
+                sock->disconnect();
+                return;
+            }
+        }
+
+        PeerConn conn{};
+        conn.serial = t.next_serial++;
+        conn.peer_id = peer_id;
+        conn.stripe = stripe;
+        conn.sock = std::move(sock);
+        conn.handle = handle;
+        conn.rx_buf.resize(RX_BUF_SIZE);
+        t.peers.emplace(key, std::move(conn));
+        evtlog::info(elog_kind::NewConnection, elog_cat::SocketReactor, peer_id, static_cast<int32_t>(t.index));
+    }
+
+    void SocketReactor::unregister_peer(IoThread& t, ConnKey key, bool disconnect) {
+        auto it = t.peers.find(key);
+        if (it == t.peers.end()) return;
+
+        // remove from the poller before closing so a reused handle is never mistaken for this one
+        if (!m_use_uring) {
+            t.poller.remove(it->second.handle);
+        }
+
+        if (disconnect && it->second.sock != nullptr) {
+            it->second.sock->disconnect();
+        }
+
+        // nobody reaps this socket's error queue anymore, let go of its zero copy sends
+        if (m_zc != nullptr && it->second.sock != nullptr) {
+            m_zc->forget(*it->second.sock);
+        }
+
+        // an in flight recv still points at this connection's buffers, park them until it completes
+        if (it->second.recv_in_flight) {
+            (void)t.ring.prep_cancel(it->second.serial);
+            const uint64_t serial = it->second.serial;
+            t.retired.emplace(serial, std::move(it->second));
+        }
+        t.peers.erase(it);
+    }
+
+    bool SocketReactor::handle_readable(IoThread& t, PeerConn& conn) {
+        size_t frames = 0;
+        while (frames < MAX_FRAMES_PER_EVENT) {
+            auto [dst, want] = recv_target(conn);
+
+            sock::SockResult result = conn.sock->try_recv(dst, want);
+            t.recv_calls.fetch_add(1, std::memory_order_relaxed);
+            switch (result.code) {
+                case sock::SockErr::None: break;
+                case sock::SockErr::WouldBlock: return true;
+                case sock::SockErr::Closed: {
+                    LOG("socket reactor peer closed connection, nodeid=", conn.peer_id);
+                    return false;
+                }
+                default: {
+                    ERR_PRINT("socket reactor recv failed, nodeid=", conn.peer_id);
+                    evtlog::error(elog_kind::RecvError, elog_cat::SocketReactor, conn.peer_id, result.sys_error);
+                    print_socket_result(result);
+                    return false;
+                }
+            }
+
+            if (result.bytes <= 0) return false; // should never happen
+
+            const size_t bytes = static_cast<size_t>(result.bytes);
+            if (!consume_recv(t, conn, bytes, frames)) return false;
+
+            // short read means the socket is drained, skip the recv that would just say WouldBlock
+            if (bytes < want) return true;
+        }
+        return true;
+    }
+
+    std::pair<std::byte*, size_t> SocketReactor::recv_target(PeerConn& conn) noexcept {
+        // a frame too large for the rx buffer reads straight into the payload buffer
+        if (conn.in_payload) {
+            return { conn.payload.data() + conn.payload_recvd, conn.payload.size() - conn.payload_recvd };
+        }
+
+        // buffer full with a partial frame at the back, slide it to the front
+        if (conn.rx_tail == conn.rx_buf.size() && conn.rx_head > 0) {
+            const size_t pending = conn.rx_tail - conn.rx_head;
+            std::memmove(conn.rx_buf.data(), conn.rx_buf.data() + conn.rx_head, pending);
+            conn.rx_head = 0;
+            conn.rx_tail = pending;
+        }
+        return { conn.rx_buf.data() + conn.rx_tail, conn.rx_buf.size() - conn.rx_tail };
+    }
+
+    bool SocketReactor::consume_recv(IoThread& t, PeerConn& conn, size_t bytes, size_t& frames) {
+        // any bytes at all, part of a large frame included, mean the peer is alive
+        if (m_heartbeat != nullptr) {
+            m_heartbeat->heard(conn.peer_id);
+        }
+
+        if (!conn.in_payload) {
+            conn.rx_tail += bytes;
+            return parse_frames(t, conn, frames);
+        }
+
+        conn.payload_recvd += bytes;
+        if (conn.payload_recvd < conn.payload.size()) return true;
+
+        deliver_frame(t, conn, conn.payload.data());
+
+        conn.payload_recvd = 0;
+        conn.in_payload = false;
+        frames += 1;
+        t.frames.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    bool SocketReactor::parse_frames(IoThread& t, PeerConn& conn, size_t& frames) {
+        constexpr size_t HDR_SIZE = sizeof(io::LabelHeader);
+
+        while (conn.rx_tail - conn.rx_head >= HDR_SIZE) {
+            const std::byte* frame = conn.rx_buf.data() + conn.rx_head;
+            const size_t avail = conn.rx_tail - conn.rx_head;
+
+            // copy out, the header is not guaranteed to be aligned inside the stream
+            std::memcpy(&conn.hdr, frame, HDR_SIZE);
+            const FrameKind kind = check_header(conn);
+            if (kind == FrameKind::Invalid) return false;
+
+            const size_t frame_size = HDR_SIZE + conn.hdr.label_size;
+
+            // heartbeats, a ping is answered by the heartbeat thread and a pong is a round trip sample
+            if (kind == FrameKind::Ping || kind == FrameKind::Pong) {
+                if (avail < frame_size) break;
+                if (m_heartbeat != nullptr) {
+                    io::PingBody body{};
+                    std::memcpy(&body, frame + HDR_SIZE, sizeof(body));
+                    if (kind == FrameKind::Ping) {
+                        m_heartbeat->on_ping(conn.peer_id, body);
+                    } else {
+                        m_heartbeat->on_pong(conn.peer_id, body);
+                    }
+                }
+                conn.rx_head += frame_size;
+                frames += 1;
+                t.frames.fetch_add(1, std::memory_order_relaxed);
+                continue;
+            }
+
+            // a receiver missed multicast frames of ours, small enough to always wait for whole
+            if (kind == FrameKind::Nack) {
+                if (avail < frame_size) break;
+                if (m_mcast != nullptr) {
+                    m_mcast->on_nack(static_cast<NodeId>(conn.hdr.source_id), static_cast<Label>(conn.hdr.label),
+                                     frame + HDR_SIZE, conn.hdr.label_size);
+                }
+                conn.rx_head += frame_size;
+                frames += 1;
+                t.frames.fetch_add(1, std::memory_order_relaxed);
+                continue;
+            }
+
+            if (frame_size > conn.rx_buf.size()) {
+                // never fits, move what we have of the payload out and read the rest directly
+                const size_t have = avail - HDR_SIZE;
+                conn.payload.resize(conn.hdr.label_size);
+                std::memcpy(conn.payload.data(), frame + HDR_SIZE, have);
+                conn.payload_recvd = have;
+                conn.in_payload = true;
+                conn.rx_head = 0;
+                conn.rx_tail = 0;
+                return true;
+            }
+
+            if (avail < frame_size) break; // rest of the frame has not arrived yet
+
+            deliver_frame(t, conn, frame + HDR_SIZE);
+
+            conn.rx_head += frame_size;
+            frames += 1;
+            t.frames.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        if (conn.rx_head == conn.rx_tail) {
+            conn.rx_head = 0;
+            conn.rx_tail = 0;
+        }
+        return true;
+    }
+
+    bool SocketReactor::verify_frame(IoThread& t, const PeerConn& conn, const std::byte* payload) {
+        if (!io::has_flag(conn.hdr.flags, io::LabelFlag::Checksum)) return true;
+        if (io::label_checksum(conn.hdr, payload) == conn.hdr.checksum) return true;
+
+        // framing is intact (size came from a header we already accepted), drop just this frame
+        ERR_PRINT("socket reactor dropped frame with bad checksum, label=", conn.hdr.label, ", sourceid=", conn.hdr.source_id);
+        evtlog::warn(elog_kind::ChecksumMismatch, elog_cat::SocketReactor, conn.hdr.label);
+        t.checksum_failures.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    void SocketReactor::deliver_frame(IoThread& t, const PeerConn& conn, const std::byte* payload) {
+        // another hosts gateway wrapped it for the nodes of ours that subscribe
+        if (io::has_flag(conn.hdr.flags, io::LabelFlag::Relay)) {
+            if (m_relay != nullptr) {
+                m_relay->fan_out(conn.hdr, payload, conn.hdr.label_size);
+            } else {
+                ERR_PRINT("socket reactor got relay frame but we are no host gateway, sourceid=", conn.hdr.source_id);
+            }
+            return;
+        }
+
+        // one of our multicast nacks answered
+        if (io::has_flag(conn.hdr.flags, io::LabelFlag::Resend)) {
+            if (m_mcast != nullptr) {
+                m_mcast->on_resend(static_cast<NodeId>(conn.hdr.source_id), static_cast<Label>(conn.hdr.label),
+                                   payload, conn.hdr.label_size);
+            }
+            return;
+        }
+
+        if (verify_frame(t, conn, payload)) {
+            m_router.distribute_recvd_label(
+                static_cast<NodeId>(conn.hdr.source_id),
+                static_cast<Label>(conn.hdr.label),
+                payload,
+                conn.hdr.label_size,
+                static_cast<size_t>(conn.hdr.recv_offset)
+            );
+        }
+    }
+
+    SocketReactor::FrameKind SocketReactor::check_header(const PeerConn& conn) {
+        const io::LabelHeader& hdr = conn.hdr;
+        if (hdr.magic != MAGIC_NUM || hdr.version != VERSION) {
+            // we cannot figure out how to drain this socket, disconnect it and monitor thread will re-establish comms
+            evtlog::error(elog_kind::InvalidHeader, elog_cat::SocketReactor, conn.peer_id);
+            ERR_PRINT("socket reactor got a header that did not have the correct magic and/or version");
+            return FrameKind::Invalid;
+        }
+
+        const bool relay = io::has_flag(hdr.flags, io::LabelFlag::Relay);
+        const bool resend = io::has_flag(hdr.flags, io::LabelFlag::Resend);
+        const size_t max_size = relay ? io::MAX_RELAY_SIZE : resend ? io::MAX_RESEND_SIZE : MAX_LABEL_SIZE;
+        if (hdr.label_size > max_size) {
+            ERR_PRINT("socket reactor got header that indicates label size is > ", max_size);
+            ERR_PRINT("    label=", hdr.label, ", sourceid=", hdr.source_id);
+            evtlog::error(elog_kind::InvalidLabelSize, elog_cat::SocketReactor, hdr.label, hdr.label_size);
+            return FrameKind::Invalid;
+        }
+
+        // wrapped frame, checked as it is unwrapped
+        if (relay) {
+            if (hdr.label_size == 0) {
+                ERR_PRINT("socket reactor got relay frame without payload, sourceid=", hdr.source_id);
+                evtlog::error(elog_kind::InvalidLabelSize, elog_cat::SocketReactor, hdr.label, hdr.label_size);
+                return FrameKind::Invalid;
+            }
+            return FrameKind::Relay;
+        }
+
+        // wrapped multicast frame, mcast data checks it against what it already delivered
+        if (resend) {
+            if (hdr.label_size <= sizeof(io::McastResend) + sizeof(io::LabelHeader)) {
+                ERR_PRINT("socket reactor got resend frame of size=", hdr.label_size, ", sourceid=", hdr.source_id);
+                evtlog::error(elog_kind::InvalidLabelSize, elog_cat::SocketReactor, hdr.label, hdr.label_size);
+                return FrameKind::Invalid;
+            }
+            return FrameKind::Resend;
+        }
+
+        if (!io::has_flag(hdr.flags, io::LabelFlag::Data)) {
+            if (io::has_flag(hdr.flags, io::LabelFlag::Ping) || io::has_flag(hdr.flags, io::LabelFlag::Pong)) {
+                if (hdr.label_size != sizeof(io::PingBody)) {
+                    ERR_PRINT("socket reactor got heartbeat frame of size=", hdr.label_size, ", sourceid=", hdr.source_id);
+                    evtlog::error(elog_kind::InvalidLabelSize, elog_cat::SocketReactor, hdr.label, hdr.label_size);
+                    return FrameKind::Invalid;
+                }
+                return io::has_flag(hdr.flags, io::LabelFlag::Ping) ? FrameKind::Ping : FrameKind::Pong;
+            }
+
+            if (io::has_flag(hdr.flags, io::LabelFlag::Nack)) {
+                if (hdr.label_size != sizeof(io::McastNack)) {
+                    ERR_PRINT("socket reactor got nack frame of size=", hdr.label_size, ", sourceid=", hdr.source_id);
+                    evtlog::error(elog_kind::InvalidLabelSize, elog_cat::SocketReactor, hdr.label, hdr.label_size);
+                    return FrameKind::Invalid;
+                }
+                return FrameKind::Nack;
+            }
+
+            // not a heartbeat or nack, something is wrong
+            ERR_PRINT("socket reactor got header that indicates neither ping, pong, nack or data");
+            ERR_PRINT("    label=", hdr.label, ", sourceid=", hdr.source_id, " flags=", hdr.flags);
+            evtlog::error(elog_kind::InvalidFlags, elog_cat::SocketReactor, hdr.label, hdr.flags);
+            return FrameKind::Invalid;
+        }
+
+        if (hdr.label_size == 0) {
+            ERR_PRINT("socket reactor got header that indicates label size is 0");
+            ERR_PRINT("    label=", hdr.label, ", sourceid=", hdr.source_id);
+            evtlog::error(elog_kind::InvalidLabelSize, elog_cat::SocketReactor, hdr.label, hdr.label_size);
+            return FrameKind::Invalid;
+        }
+
+        return FrameKind::Data;
+    }
+
+    ReactorStats SocketReactor::get_stats() const {
+        ReactorStats stats{};
+        for (const auto& t : m_threads) {
+            stats.peers += t->assigned.load(std::memory_order_relaxed);
+            stats.loops += t->loops.load(std::memory_order_relaxed);
+            stats.events += t->events.load(std::memory_order_relaxed);
+            stats.frames += t->frames.load(std::memory_order_relaxed);
+            stats.recv_calls += t->recv_calls.load(std::memory_order_relaxed);
+            stats.checksum_failures += t->checksum_failures.load(std::memory_order_relaxed);
+            stats.busy_ns_total += t->busy_ns_total.load(std::memory_order_relaxed);
+            stats.busy_ns_max = std::max(stats.busy_ns_max, t->busy_ns_max.load(std::memory_order_relaxed));
+        }
+        return stats;
+    }
+
+    void SocketReactor::log_stats() const {
+        ReactorStats stats = get_stats();
+        const uint64_t avg_ns = stats.loops == 0 ? 0 : stats.busy_ns_total / stats.loops;
+        const uint64_t recv_per_100_frames = stats.frames == 0 ? 0 : (stats.recv_calls * 100) / stats.frames;
+        LOG("socket reactor: backend=", m_use_uring ? "io_uring" : "poller", " threads=", m_num_threads, " peers=", stats.peers,
+            " loops=", stats.loops, " events=", stats.events, " frames=", stats.frames,
+            " recv_calls=", stats.recv_calls, " recv_per_100_frames=", recv_per_100_frames,
+            " checksum_failures=", stats.checksum_failures,
+            " loop_avg_us=", avg_ns / 1000, " loop_max_us=", stats.busy_ns_max / 1000);
+    }
+}
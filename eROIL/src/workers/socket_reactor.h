@@ -0,0 +1,167 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "types/const_types.h"
+#include "types/label_io_types.h"
+#include "router/router.h"
+#include "socket/tcp_socket.h"
+#include "socket/poller.h"
+#include "socket/uring.h"
+#include "workers/zerocopy_tracker.h"
+#include "workers/mcast_data.h"
+#include "workers/host_relay.h"
+#include "workers/heartbeat.h"
+#include "macros.h"
+
+namespace eroil::wrk {
+    struct ReactorStats {
+        uint64_t peers = 0;
+        uint64_t loops = 0;          // poller wakeups that had at least one event
+        uint64_t events = 0;         // readiness events handled
+        uint64_t frames = 0;         // complete frames parsed (data + ping + pong + nack)
+        uint64_t recv_calls = 0;     // recv syscalls issued, compare against frames for syscalls per message
+        uint64_t checksum_failures = 0; // frames dropped for a bad crc32c
+        uint64_t busy_ns_total = 0;  // time spent handling events, per loop
+        uint64_t busy_ns_max = 0;
+    };
+
+    // receives from all remote peer sockets on a small fixed pool of io threads
+    // each io thread owns a poller and the peers assigned to it, sockets are drained
+    // with non-blocking recvs and frames are reassembled per connection so a slow
+    // peer never blocks the others on the same thread
+    //
+    // two backends, picked at start():
+    //  poller -> readiness events then non-blocking recvs until the socket is drained
+    //  io_uring -> one recv kept in flight per connection, submitted and reaped in batches
+    //
+    // add_peer/remove_peer are safe to call from any thread, they are queued to the
+    // owning io thread and take effect on its next loop
+    class SocketReactor {
+        private:
+            // one per connection, a peer has one connection per stripe
+            using ConnKey = uint32_t;
+            static ConnKey conn_key(NodeId peer_id, uint32_t stripe) noexcept {
+                return static_cast<ConnKey>(peer_id) * MAX_TCP_STRIPES + stripe;
+            }
+
+            struct PeerConn {
+                uint64_t serial = 0;            // unique per io thread, io_uring user_data
+                NodeId peer_id = INVALID_NODE;
+                uint32_t stripe = 0;
+                std::shared_ptr<sock::TCPClient> sock;
+                socket_handle handle = INVALID_SOCKET;
+                bool recv_in_flight = false;    // io_uring only
+
+                // stream bytes land here, frames are parsed in place between head and tail
+                std::vector<std::byte> rx_buf;
+                size_t rx_head = 0;
+                size_t rx_tail = 0;
+
+                // current header, and the payload of a frame too large for rx_buf
+                io::LabelHeader hdr{};
+                std::vector<std::byte> payload;
+                size_t payload_recvd = 0;
+                bool in_payload = false;
+            };
+
+            enum class CommandKind : uint8_t { Add, Remove };
+            enum class FrameKind : uint8_t { Invalid, Ping, Pong, Nack, Relay, Resend, Data };
+
+            struct Command {
+                CommandKind kind;
+                NodeId peer_id;
+                uint32_t stripe;
+                std::shared_ptr<sock::TCPClient> sock;
+            };
+
+            struct IoThread {
+                size_t index = 0;
+                sock::Poller poller;
+                sock::Uring ring;
+
+                std::mutex cmd_mtx;
+                std::vector<Command> cmds;
+
+                // only touched by the io thread
+                std::unordered_map<ConnKey, PeerConn> peers;
+                std::unordered_map<uint64_t, PeerConn> retired; // unregistered with a recv still in flight
+                uint64_t next_serial = 1;
+
+                std::atomic<size_t> assigned{0};
+                std::atomic<uint64_t> loops{0};
+                std::atomic<uint64_t> events{0};
+                std::atomic<uint64_t> frames{0};
+                std::atomic<uint64_t> recv_calls{0};
+                std::atomic<uint64_t> checksum_failures{0};
+                std::atomic<uint64_t> busy_ns_total{0};
+                std::atomic<uint64_t> busy_ns_max{0};
+
+                std::thread thread;
+            };
+
+            static constexpr int32_t WAIT_TIMEOUT_MS = 100;
+            static constexpr size_t MAX_EVENTS = 32;
+            static constexpr size_t MAX_FRAMES_PER_EVENT = 64; // fairness cap, level triggered so leftovers fire again
+            static constexpr size_t RX_BUF_SIZE = 256 * 1024;  // per connection, frames larger than this are read directly
+            static constexpr uint32_t RING_ENTRIES = 256;
+
+            rt::Router& m_router;
+            ZeroCopyTracker* m_zc;      // optional, set when large sends use MSG_ZEROCOPY
+            McastData* m_mcast;         // optional, set when the multicast data plane takes nacks
+            HostRelay* m_relay;         // optional, set when we are a host gateway
+            Heartbeat* m_heartbeat;     // optional, answers pings and tracks when peers were last heard
+            NodeId m_id;
+            size_t m_num_threads;
+            bool m_use_uring;
+            std::vector<std::unique_ptr<IoThread>> m_threads;
+
+            std::mutex m_assign_mtx;
+            std::unordered_map<ConnKey, size_t> m_assignment; // connection -> io thread index, sticky once assigned
+
+            std::atomic<bool> m_stop{false};
+
+        public:
+            SocketReactor(rt::Router& router, NodeId id, size_t num_threads, ZeroCopyTracker* zc = nullptr,
+                          McastData* mcast = nullptr, HostRelay* relay = nullptr, Heartbeat* heartbeat = nullptr);
+            ~SocketReactor() { stop(); }
+
+            EROIL_NO_COPY(SocketReactor)
+            EROIL_NO_MOVE(SocketReactor)
+
+            bool start(bool use_uring);
+            void stop();
+
+            // registers the socket for a peer stripe, replacing any socket already registered for it.
+            // stripes of a peer are spread over the io threads, remove_peer drops all of them
+            void add_peer(NodeId peer_id, std::shared_ptr<sock::TCPClient> sock, uint32_t stripe = 0);
+            void remove_peer(NodeId peer_id);
+
+            ReactorStats get_stats() const;
+            void log_stats() const;
+
+        private:
+            bool stop_requested() const { return m_stop.load(std::memory_order_acquire); }
+            void run(IoThread& t);
+            void run_uring(IoThread& t);
+            void record_loop(IoThread& t, size_t events, std::chrono::steady_clock::time_point start) noexcept;
+            void wake(IoThread& t) noexcept;
+            void enqueue(Command cmd);
+            void process_commands(IoThread& t);
+            void register_peer(IoThread& t, NodeId peer_id, uint32_t stripe, std::shared_ptr<sock::TCPClient> sock);
+            void unregister_peer(IoThread& t, ConnKey key, bool disconnect);
+            PeerConn* find_by_serial(IoThread& t, uint64_t serial) noexcept;
+            bool handle_readable(IoThread& t, PeerConn& conn);
+            std::pair<std::byte*, size_t> recv_target(PeerConn& conn) noexcept;
+            bool consume_recv(IoThread& t, PeerConn& conn, size_t bytes, size_t& frames);
+            bool parse_frames(IoThread& t, PeerConn& conn, size_t& frames);
+            bool verify_frame(IoThread& t, const PeerConn& conn, const std::byte* payload);
+            void deliver_frame(IoThread& t, const PeerConn& conn, const std::byte* payload);
+            FrameKind check_header(const PeerConn& conn);
+    };
+}
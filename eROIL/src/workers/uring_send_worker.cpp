@@ -0,0 +1,287 @@
+#include "uring_send_worker.h"
+#include <array>
+#include <chrono>
+#include <vector>
+#include "safe_print.h"
+#include "log/evtlog_api.h"
+
+namespace eroil::wrk {
+    bool UringSendWorker::start() {
+        if (m_thread.joinable()) return true;
+
+        sock::SockResult result = m_ring.open(RING_ENTRIES);
+        if (!result.ok()) {
+            ERR_PRINT("uring send worker could not open io_uring");
+            print_socket_result(result);
+            return false;
+        }
+
+        m_stop.store(false, std::memory_order_release);
+        m_thread = std::thread([this] { run(); });
+        return true;
+    }
+
+    void UringSendWorker::stop() {
+        // NOTE: like the other send workers this is expected to live for the lifetime of the application
+        bool was_stopping = m_stop.exchange(true, std::memory_order_acq_rel);
+        if (!was_stopping) {
+            m_ring.wake();
+        }
+
+        if (m_thread.joinable()) {
+            // do not allow this thread to call join on itself
+            if (std::this_thread::get_id() != m_thread.get_id()) {
+                m_thread.join();
+            }
+        }
+
+        // pop all remaining data entries
+        std::lock_guard lock(m_mtx);
+        while (!m_send_q.empty()) m_send_q.pop();
+    }
+
+    void UringSendWorker::enqueue(std::shared_ptr<io::SendJob> job) {
+        if (stop_requested()) return;
+
+        {
+            std::lock_guard lock(m_mtx);
+            m_send_q.push(std::move(job));
+        }
+        m_ring.wake();
+    }
+
+    void UringSendWorker::run() {
+        std::array<sock::UringCompletion, MAX_COMPLETIONS> done{};
+
+        try {
+            while (!stop_requested()) {
+                take_jobs();
+
+                bool waiting_on_lock = false;
+                const size_t queued = submit_ready(waiting_on_lock);
+                if (queued > 0) {
+                    m_sends.fetch_add(queued, std::memory_order_relaxed);
+                    m_submits.fetch_add(1, std::memory_order_relaxed);
+                }
+
+                // a lane blocked on a ping holding the send lock is retried shortly, otherwise
+                // sleep until a completion or a new job arrives
+                const int32_t timeout = waiting_on_lock ? LOCK_RETRY_MS : WAIT_TIMEOUT_MS;
+                sock::SockResult result = m_ring.submit_and_wait(timeout);
+                if (!result.ok()) {
+                    ERR_PRINT("uring send worker wait failed");
+                    print_socket_result(result);
+                    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+                    continue;
+                }
+
+                EvtMark mark(elog_cat::SendWorker);
+                const size_t count = m_ring.reap(done.data(), done.size());
+                for (size_t i = 0; i < count; ++i) {
+                    on_completion(done[i]);
+                }
+
+                // drop idle lanes so sockets replaced on reconnect are released
+                for (auto it = m_lanes.begin(); it != m_lanes.end(); ) {
+                    if (!it->second.in_flight && it->second.q.empty()) {
+                        it = m_lanes.erase(it);
+                    } else {
+                        ++it;
+                    }
+                }
+            }
+        } catch (const std::exception& e) {
+            ERR_PRINT("uring send worker exception: ", e.what());
+        } catch (...) {
+            ERR_PRINT("uring send worker unknown exception");
+        }
+
+        // the kernel still references job buffers of in flight sends. cancel them and reap every
+        // completion, only then close the ring and let go of the buffers and send locks
+        if (!drain_in_flight()) {
+            // never handed back by the kernel, their buffers stay allocated for good
+            ERR_PRINT("uring send worker could not reap every in flight send, leaking their frames");
+            auto* stuck = new std::vector<Lane>();
+            for (auto it = m_lanes.begin(); it != m_lanes.end(); ) {
+                if (it->second.in_flight) {
+                    it->second.sock->disconnect();
+                    stuck->push_back(std::move(it->second));
+                    it = m_lanes.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+        }
+        m_ring.close();
+
+        for (auto& [key, lane] : m_lanes) {
+            // part of a frame went out, nothing else may follow it on this stream
+            if (lane.locked && !lane.q.empty() && lane.q.front().offset > 0) {
+                lane.sock->disconnect();
+            }
+            fail_lane(lane);
+        }
+        m_lanes.clear();
+
+        PRINT("uring send worker exits");
+    }
+
+    bool UringSendWorker::drain_in_flight() {
+        std::array<sock::UringCompletion, MAX_COMPLETIONS> done{};
+        for (int32_t attempts = 0; attempts < DRAIN_ATTEMPTS; ++attempts) {
+            bool any_in_flight = false;
+            for (const auto& [key, lane] : m_lanes) {
+                if (!lane.in_flight) continue;
+                any_in_flight = true;
+                (void)m_ring.prep_cancel(reinterpret_cast<uint64_t>(key)); // a full queue cancels it next round
+            }
+            if (!any_in_flight) return true;
+
+            if (!m_ring.submit_and_wait(WAIT_TIMEOUT_MS).ok()) continue;
+            const size_t count = m_ring.reap(done.data(), done.size());
+            for (size_t i = 0; i < count; ++i) {
+                auto it = m_lanes.find(reinterpret_cast<sock::TCPClient*>(done[i].user_data));
+                if (it == m_lanes.end()) continue;
+
+                // no resubmit, a short or cancelled frame stays at the front holding the send lock
+                Lane& lane = it->second;
+                lane.in_flight = false;
+                if (lane.q.empty()) continue;
+                PendingSend& front = lane.q.front();
+                if (done[i].res > 0) front.offset += static_cast<size_t>(done[i].res);
+                if (front.offset >= front.job->send_buffer.total_size) finish_front(lane, true);
+            }
+        }
+
+        for (const auto& [key, lane] : m_lanes) {
+            if (lane.in_flight) return false;
+        }
+        return true;
+    }
+
+    void UringSendWorker::take_jobs() {
+        std::queue<std::shared_ptr<io::SendJob>> jobs;
+        {
+            std::lock_guard lock(m_mtx);
+            jobs.swap(m_send_q);
+        }
+
+        while (!jobs.empty()) {
+            std::shared_ptr<io::SendJob> job = std::move(jobs.front());
+            jobs.pop();
+
+            for (const auto& recvr : job->remote_recvrs) {
+                if (recvr == nullptr) {
+                    job->complete_one();
+                    continue;
+                }
+
+                Lane& lane = m_lanes[recvr.get()];
+                if (lane.sock == nullptr) lane.sock = recvr;
+                lane.q.push_back(PendingSend{ job, 0 });
+            }
+        }
+    }
+
+    size_t UringSendWorker::submit_ready(bool& waiting_on_lock) {
+        size_t queued = 0;
+        for (auto& [key, lane] : m_lanes) {
+            if (lane.in_flight || lane.q.empty()) continue;
+
+            // re-connection is being attempted in the background, same as TcpSendPlan
+            if (!lane.sock->is_connected()) {
+                fail_lane(lane);
+                continue;
+            }
+
+            if (!lane.locked) {
+                if (!lane.sock->try_lock_send()) {
+                    waiting_on_lock = true;
+                    continue;
+                }
+                lane.locked = true;
+            }
+
+            PendingSend& front = lane.q.front();
+            const io::SendBuf& buf = front.job->send_buffer;
+            const bool prepped = m_ring.prep_send(
+                lane.sock->native_handle(),
+                buf.data.get() + front.offset,
+                buf.total_size - front.offset,
+                reinterpret_cast<uint64_t>(key)
+            );
+            if (!prepped) break; // submission queue full, the rest go next loop
+
+            lane.in_flight = true;
+            queued += 1;
+        }
+        return queued;
+    }
+
+    void UringSendWorker::on_completion(const sock::UringCompletion& c) {
+        auto it = m_lanes.find(reinterpret_cast<sock::TCPClient*>(c.user_data));
+        if (it == m_lanes.end()) return;
+
+        Lane& lane = it->second;
+        lane.in_flight = false;
+        if (lane.q.empty()) return;
+
+        PendingSend& front = lane.q.front();
+        if (c.res <= 0) {
+            ERR_PRINT("uring socket send for label=", front.job->label, ", sys_error=", -c.res);
+            lane.sock->mark_send_error(-c.res);
+            finish_front(lane, false);
+            return;
+        }
+
+        // short send, the rest of the frame goes out next loop while we still hold the send lock
+        front.offset += static_cast<size_t>(c.res);
+        if (front.offset < front.job->send_buffer.total_size) return;
+
+        finish_front(lane, true);
+    }
+
+    void UringSendWorker::finish_front(Lane& lane, bool ok) {
+        std::shared_ptr<io::SendJob> job = std::move(lane.q.front().job);
+        lane.q.pop_front();
+
+        // let pings through between frames
+        if (lane.locked) {
+            lane.sock->unlock_send();
+            lane.locked = false;
+        }
+
+        if (ok) {
+            m_completed.fetch_add(1, std::memory_order_relaxed);
+        } else {
+            evtlog::warn(elog_kind::SendFailed, elog_cat::SendWorker, job->label);
+            ++job->remote_failure_count;
+            m_failed.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        // send IOSB is written by which ever sender completes last
+        job->complete_one();
+    }
+
+    void UringSendWorker::fail_lane(Lane& lane) {
+        while (!lane.q.empty()) {
+            finish_front(lane, false);
+        }
+    }
+
+    UringSendStats UringSendWorker::get_stats() const {
+        UringSendStats stats{};
+        stats.sends = m_sends.load(std::memory_order_relaxed);
+        stats.submits = m_submits.load(std::memory_order_relaxed);
+        stats.completed = m_completed.load(std::memory_order_relaxed);
+        stats.failed = m_failed.load(std::memory_order_relaxed);
+        return stats;
+    }
+
+    void UringSendWorker::log_stats() const {
+        UringSendStats stats = get_stats();
+        const uint64_t sends_per_submit = stats.submits == 0 ? 0 : stats.sends / stats.submits;
+        LOG("uring send worker: sends=", stats.sends, " submits=", stats.submits,
+            " sends_per_submit=", sends_per_submit, " completed=", stats.completed, " failed=", stats.failed);
+    }
+}
@@ -0,0 +1,87 @@
+#pragma once
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <unordered_map>
+#include "types/const_types.h"
+#include "types/send_io_types.h"
+#include "socket/tcp_socket.h"
+#include "socket/uring.h"
+#include "macros.h"
+
+namespace eroil::wrk {
+    struct UringSendStats {
+        uint64_t sends = 0;         // send sqes submitted, includes resubmits after a short send
+        uint64_t submits = 0;       // io_uring_enter calls that carried at least one send
+        uint64_t completed = 0;     // frames fully sent
+        uint64_t failed = 0;
+    };
+
+    // io_uring replacement for SendWorker<TcpSendPlan>
+    // jobs are fanned out into one lane per socket, each lane keeps a single frame in
+    // flight (so frames never interleave on the stream) and every ready lane is submitted
+    // in one batch. a job's receiver is completed (SendJob::complete_one) when its
+    // completion is reaped, not when the send is queued
+    class UringSendWorker {
+        private:
+            struct PendingSend {
+                std::shared_ptr<io::SendJob> job;
+                size_t offset = 0;
+            };
+
+            struct Lane {
+                std::shared_ptr<sock::TCPClient> sock;
+                std::deque<PendingSend> q;
+                bool in_flight = false;
+                bool locked = false;    // holding the socket's send lock for the frame at the front
+            };
+
+            static constexpr uint32_t RING_ENTRIES = 256;
+            static constexpr size_t MAX_COMPLETIONS = 64;
+            static constexpr int32_t WAIT_TIMEOUT_MS = 100;
+            static constexpr int32_t LOCK_RETRY_MS = 1;
+            static constexpr int32_t DRAIN_ATTEMPTS = 50;   // WAIT_TIMEOUT_MS each, cancelled sends complete long before
+
+            std::queue<std::shared_ptr<io::SendJob>> m_send_q;
+            std::mutex m_mtx;
+            sock::Uring m_ring;
+
+            // only touched by the worker thread
+            std::unordered_map<sock::TCPClient*, Lane> m_lanes;
+
+            std::atomic<uint64_t> m_sends{0};
+            std::atomic<uint64_t> m_submits{0};
+            std::atomic<uint64_t> m_completed{0};
+            std::atomic<uint64_t> m_failed{0};
+
+            std::atomic<bool> m_stop{false};
+            std::thread m_thread;
+
+        public:
+            UringSendWorker() = default;
+            ~UringSendWorker() { stop(); }
+
+            EROIL_NO_COPY(UringSendWorker)
+            EROIL_NO_MOVE(UringSendWorker)
+
+            bool start();
+            void stop();
+            void enqueue(std::shared_ptr<io::SendJob> job);
+
+            UringSendStats get_stats() const;
+            void log_stats() const;
+
+        private:
+            bool stop_requested() const { return m_stop.load(std::memory_order_acquire); }
+            void run();
+            bool drain_in_flight();
+            void take_jobs();
+            size_t submit_ready(bool& waiting_on_lock);
+            void on_completion(const sock::UringCompletion& c);
+            void finish_front(Lane& lane, bool ok);
+            void fail_lane(Lane& lane);
+    };
+}
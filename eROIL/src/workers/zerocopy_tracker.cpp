@@ -0,0 +1,132 @@
+#include "zerocopy_tracker.h"
+#include <algorithm>
+#include <array>
+#include "safe_print.h"
+
+namespace eroil::wrk {
+    void ZeroCopyTracker::track(const sock::TCPClient& sock, uint32_t first, uint32_t count, size_t bytes, std::shared_ptr<io::SendJob> job) {
+        m_zerocopy_bytes.fetch_add(bytes, std::memory_order_relaxed);
+        if (count == 0 || job == nullptr) {
+            if (job != nullptr) job->complete_one();
+            return;
+        }
+
+        Pending p{};
+        p.first = first;
+        p.last = first + (count - 1);
+        p.outstanding = count;
+        p.job = std::move(job);
+
+        {
+            std::lock_guard lock(m_mtx);
+            SockState& state = m_socks[&sock];
+
+            // notifications that raced ahead of us
+            for (auto it = state.early.begin(); it != state.early.end(); ) {
+                p.outstanding -= std::min(p.outstanding, overlap(it->lo, it->hi, p.first, p.last));
+                if (it->hi <= p.last) {
+                    it = state.early.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+
+            if (p.outstanding != 0) {
+                state.pending.push_back(std::move(p));
+                return;
+            }
+        }
+
+        // everything was already reported
+        p.job->complete_one();
+    }
+
+    bool ZeroCopyTracker::reap(sock::TCPClient& sock) {
+        std::array<sock::ZeroCopyRange, MAX_REAP> ranges{};
+        std::vector<std::shared_ptr<io::SendJob>> done;
+        bool any = false;
+
+        while (true) {
+            const size_t count = sock.reap_zerocopy(ranges.data(), ranges.size());
+            if (count == 0) break;
+            any = true;
+
+            m_notifications.fetch_add(count, std::memory_order_relaxed);
+            std::lock_guard lock(m_mtx);
+            SockState& state = m_socks[&sock];
+
+            for (size_t i = 0; i < count; ++i) {
+                const sock::ZeroCopyRange& r = ranges[i];
+                if (r.copied) m_kernel_copied.fetch_add(1, std::memory_order_relaxed);
+
+                uint32_t matched = 0;
+                for (auto it = state.pending.begin(); it != state.pending.end(); ) {
+                    const uint32_t n = std::min(it->outstanding, overlap(r.lo, r.hi, it->first, it->last));
+                    matched += n;
+                    it->outstanding -= n;
+                    if (it->outstanding == 0) {
+                        done.push_back(std::move(it->job));
+                        it = state.pending.erase(it);
+                    } else {
+                        ++it;
+                    }
+                }
+
+                // the sending thread has not tracked (part of) this range yet
+                if (matched < (r.hi - r.lo) + 1) {
+                    state.early.push_back(r);
+                }
+            }
+
+            if (count < ranges.size()) break;
+        }
+
+        // complete outside the lock, the last completion writes the send IOSB
+        for (auto& job : done) {
+            job->complete_one();
+        }
+        return any;
+    }
+
+    void ZeroCopyTracker::forget(const sock::TCPClient& sock) {
+        std::vector<Pending> pending;
+        {
+            std::lock_guard lock(m_mtx);
+            auto it = m_socks.find(&sock);
+            if (it == m_socks.end()) return;
+            pending = std::move(it->second.pending);
+            m_socks.erase(it);
+        }
+
+        for (auto& p : pending) {
+            p.job->complete_one();
+        }
+    }
+
+    uint32_t ZeroCopyTracker::overlap(uint32_t lo, uint32_t hi, uint32_t first, uint32_t last) noexcept {
+        const uint32_t a = std::max(lo, first);
+        const uint32_t b = std::min(hi, last);
+        return a > b ? 0 : (b - a) + 1;
+    }
+
+    ZeroCopyStats ZeroCopyTracker::get_stats() const {
+        ZeroCopyStats stats{};
+        stats.zerocopy_bytes = m_zerocopy_bytes.load(std::memory_order_relaxed);
+        stats.copied_bytes = m_copied_bytes.load(std::memory_order_relaxed);
+        stats.notifications = m_notifications.load(std::memory_order_relaxed);
+        stats.kernel_copied = m_kernel_copied.load(std::memory_order_relaxed);
+
+        std::lock_guard lock(m_mtx);
+        for (const auto& [sock, state] : m_socks) {
+            stats.pending_jobs += state.pending.size();
+        }
+        return stats;
+    }
+
+    void ZeroCopyTracker::log_stats() const {
+        ZeroCopyStats stats = get_stats();
+        LOG("zero copy: zc_bytes=", stats.zerocopy_bytes, " copied_bytes=", stats.copied_bytes,
+            " notifications=", stats.notifications, " kernel_copied=", stats.kernel_copied,
+            " pending_jobs=", stats.pending_jobs);
+    }
+}
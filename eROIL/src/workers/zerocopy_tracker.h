@@ -0,0 +1,73 @@
+#pragma once
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include "types/const_types.h"
+#include "types/send_io_types.h"
+#include "socket/tcp_socket.h"
+#include "macros.h"
+
+namespace eroil::wrk {
+    struct ZeroCopyStats {
+        uint64_t zerocopy_bytes = 0;    // bytes handed to the kernel with MSG_ZEROCOPY
+        uint64_t copied_bytes = 0;      // bytes sent the regular way (below threshold or zero copy off)
+        uint64_t notifications = 0;     // completion ranges read from socket error queues
+        uint64_t kernel_copied = 0;     // completion ranges where the kernel fell back to copying anyway
+        uint64_t pending_jobs = 0;
+    };
+
+    // holds send jobs whose buffers were sent with MSG_ZEROCOPY until the kernel reports
+    // it no longer references them (socket error queue notifications), then completes them
+    //
+    // the send worker calls track() after each zero copy send, the reactor io thread that
+    // owns the socket calls reap() when the socket signals an error queue event
+    class ZeroCopyTracker {
+        private:
+            struct Pending {
+                uint32_t first = 0;         // zero copy sequence range [first, last] used by this job
+                uint32_t last = 0;
+                uint32_t outstanding = 0;   // sends in the range not yet reported
+                std::shared_ptr<io::SendJob> job;
+            };
+
+            struct SockState {
+                std::vector<Pending> pending;
+                std::vector<sock::ZeroCopyRange> early; // reaped before the sending thread tracked them
+            };
+
+            static constexpr size_t MAX_REAP = 32;
+
+            mutable std::mutex m_mtx;
+            std::unordered_map<const sock::TCPClient*, SockState> m_socks;
+
+            std::atomic<uint64_t> m_zerocopy_bytes{0};
+            std::atomic<uint64_t> m_copied_bytes{0};
+            std::atomic<uint64_t> m_notifications{0};
+            std::atomic<uint64_t> m_kernel_copied{0};
+
+        public:
+            ZeroCopyTracker() = default;
+            ~ZeroCopyTracker() = default;
+
+            EROIL_NO_COPY(ZeroCopyTracker)
+            EROIL_NO_MOVE(ZeroCopyTracker)
+
+            // job completes once all count sends starting at first are reported
+            void track(const sock::TCPClient& sock, uint32_t first, uint32_t count, size_t bytes, std::shared_ptr<io::SendJob> job);
+            void add_copied(size_t bytes) noexcept { m_copied_bytes.fetch_add(bytes, std::memory_order_relaxed); }
+
+            // drains the socket error queue, true if any zero copy notification was read
+            bool reap(sock::TCPClient& sock);
+
+            // socket is going away, completes everything still pending on it
+            void forget(const sock::TCPClient& sock);
+
+            ZeroCopyStats get_stats() const;
+            void log_stats() const;
+
+        private:
+            static uint32_t overlap(uint32_t lo, uint32_t hi, uint32_t first, uint32_t last) noexcept;
+    };
+}